@@ -1,6 +1,7 @@
 // Custom backend example demonstrating:
 //   1. A minimal custom backend (in-memory buffer)
-//   2. Using lumberjack::WriteBuffer and TimestampCache for high-performance output
+//   2. Using lumberjack::WriteBuffer and TimestampCache for high-performance output,
+//      with a v2 log_write_batch callback fed by core batching
 
 #include <lumberjack/lumberjack.h>
 #include <lumberjack/utils.h>
@@ -92,6 +93,24 @@ void log_write(lumberjack::LogLevel level, const char* message) {
     g_buf.write(g_file, line, static_cast<size_t>(len));
 }
 
+// v2 callback: one lock and one timestamp per batch. Records carry their
+// length, so the text is copied without strlen, and their call site.
+void log_write_batch(const lumberjack::LogRecord* records, size_t count) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    const char* ts = g_ts.get();
+    for (size_t i = 0; i < count; i++) {
+        const lumberjack::LogRecord& r = records[i];
+        char line[1280];
+        int len = snprintf(line, sizeof(line), "[%s] [%s] %.*s (%s:%d)\n",
+                           ts, g_levels[r.level], static_cast<int>(r.length), r.message,
+                           r.file ? r.file : "?", r.line);
+        if (len < 0) continue;
+        if (static_cast<size_t>(len) >= sizeof(line)) len = sizeof(line) - 1;
+        g_buf.write(g_file, line, static_cast<size_t>(len));
+    }
+}
+
 void* span_begin(lumberjack::LogLevel, const char*) { return nullptr; }
 
 void span_end(void*, lumberjack::LogLevel level,
@@ -107,7 +126,7 @@ void flush() {
 }
 
 lumberjack::LogBackend backend = {
-    "fast_file", init, shutdown, log_write, span_begin, span_end
+    "fast_file", init, shutdown, log_write, span_begin, span_end, log_write_batch
 };
 
 } // namespace fast_file_backend
@@ -136,6 +155,7 @@ int main() {
     // --- Example 2: Fast file backend ---
     printf("=== Example 2: Fast File Backend (WriteBuffer + TimestampCache) ===\n");
     lumberjack::set_backend(&fast_file_backend::backend);
+    lumberjack::set_batching(true);   // deliver lines through log_write_batch
 
     LOG_INFO("Switched to fast file backend");
     LOG_ERROR("Example error: %s", "disk full");
@@ -149,6 +169,7 @@ int main() {
         for (volatile int i = 0; i < 500000; i++) {}
     }
 
+    lumberjack::set_batching(false);  // delivers what is still batched
     fast_file_backend::flush();
 
     // Switch back to builtin to print final message to stderr
@@ -0,0 +1,109 @@
+// builtin_logger.h — Independent instances of the built-in backend.
+//
+// A BuiltinLogger has everything the built-in backend has: output stream,
+// write buffer, timestamp cache, lock, flight recorder, rotation, queue and
+// group-commit flusher. Each instance has its own copy of all of it, so an
+// access log, an audit log and a debug log do not share a lock or a buffer
+// and scale independently. The process-wide built-in backend is itself an
+// instance, builtin_logger(); the builtin_set_*() functions configure it.
+//
+// An instance is used in either of two ways:
+//   - as the target for one subsystem, logging through log() / LOG_TO(),
+//     gated by the instance's own level rather than set_level();
+//   - as the active backend, via set_backend(logger.backend()).
+//
+// Usage:
+//   lumberjack::BuiltinLogger audit("audit");
+//   audit.set_rotation("audit.log");
+//   audit.set_durability(lumberjack::DURABILITY_FDATASYNC);
+//   LOG_TO(audit, lumberjack::LOG_LEVEL_INFO, "user %s logged in", name);
+//   audit.log_and_wait_durable(lumberjack::LOG_LEVEL_INFO, "transfer %d", id);
+//
+// The LogBackend interface carries no context pointer, so each instance's
+// backend() is bound to one of MAX_INSTANCES preset callback slots. All
+// instances are covered by the crash handler.
+//
+// Thread safety: logging and configuration calls may come from any thread.
+// An instance must outlive its use as the active backend.
+
+#ifndef LUMBERJACK_BUILTIN_LOGGER_H
+#define LUMBERJACK_BUILTIN_LOGGER_H
+
+#include "lumberjack/lumberjack.h"
+#include <memory>
+
+namespace lumberjack {
+
+class BuiltinLogger {
+public:
+    // Instances that can exist at once. Construction beyond this still
+    // works, but backend() returns nullptr and the crash handler does not
+    // flush the instance.
+    static constexpr int MAX_INSTANCES = 32;
+
+    // name becomes the LogBackend name (not copied; keep it alive).
+    explicit BuiltinLogger(const char* name = "builtin");
+
+    // Drains the queue, stops the flusher and flushes the output.
+    ~BuiltinLogger();
+
+    BuiltinLogger(const BuiltinLogger&) = delete;
+    BuiltinLogger& operator=(const BuiltinLogger&) = delete;
+
+    // This instance as a backend for set_backend(), or nullptr if all
+    // callback slots are taken.
+    LogBackend* backend();
+
+    // Most verbose level log() writes (default LOG_LEVEL_INFO). Does not
+    // affect lines arriving through backend().
+    void set_level(LogLevel level);
+    LogLevel level() const;
+
+    // Formats and writes one line if level passes set_level().
+    void log(LogLevel level, const char* fmt, ...);
+
+    // Writes an already formatted message, without the level check.
+    void write(LogLevel level, const char* message);
+
+    // Like log(), then waits for the line to be durable (see
+    // log_and_wait_durable() in lumberjack.h).
+    bool log_and_wait_durable(LogLevel level, const char* fmt, ...);
+
+    // Configuration; each matches the builtin_set_*() function of the same
+    // name in lumberjack.h.
+    void set_output(FILE* file);
+    void set_buffered(bool enabled, size_t buffer_size = 8192);
+    void flush();
+    void set_timestamp_cache(unsigned int interval_ms, bool seq = false);
+    bool set_flight_recorder(const char* path, size_t capacity = 4 * 1024 * 1024);
+    void set_output_level(LogLevel level);
+    bool set_rotation(const char* path, const RotationOptions& options = RotationOptions());
+    bool set_queued(bool enabled, const QueueOptions& options = QueueOptions());
+    QueueStats queue_stats();
+    void set_global_sequence(bool enabled);
+    void set_durability(Durability durability);
+    DurabilityStats durability_stats();
+    void set_flush_level(LogLevel level);
+    bool set_pattern(const char* pattern);
+    void set_output_format(OutputFormat format);
+
+    struct State;
+
+private:
+    friend struct DefaultAutoStop;   // stops the default instance at exit
+
+    std::unique_ptr<State> m_state;
+};
+
+// The instance behind builtin_backend() and the builtin_set_*() functions.
+// Created on first use and never destroyed; at exit its queue and flusher
+// are drained and stopped, and a rotated file is closed, finishing pending
+// renames and compression (later lines go to stderr).
+BuiltinLogger& builtin_logger();
+
+} // namespace lumberjack
+
+// Logs to a specific BuiltinLogger, gated by its own level.
+#define LOG_TO(logger, level, fmt, ...) (logger).log(level, fmt, ##__VA_ARGS__)
+
+#endif // LUMBERJACK_BUILTIN_LOGGER_H
@@ -0,0 +1,65 @@
+// context.h — Thread-local context fields (MDC) for every line of a scope.
+//
+// A LogContext attaches key-value fields to every line the current thread
+// logs while it is alive:
+//
+//   void handle(const Request& req) {
+//       lumberjack::LogContext ctx("req", req.id);
+//       lumberjack::LogContext more({ kv("tenant", req.tenant), kv("shard", req.shard) });
+//       LOG_INFO("handled in %d us", us);
+//       // [2026-02-24 10:15:03.042] [INFO ] req=42 tenant=acme shard=7 handled in 117 us
+//   }
+//
+// The fields are rendered once, when the scope opens, onto the end of a
+// per-thread prefix (in logfmt and in JSON form); nested scopes append to
+// it and each scope cuts it back to where it started when it closes. Every
+// record captured on the thread points at the prefix (LogRecord::context),
+// and the built-in backend copies it into the line with memcpy: through
+// %X in a pattern (part of the default layout), or as logfmt pairs / JSON
+// members ahead of msg. Nothing about the context is formatted per line.
+//
+// Scopes must nest: destroy them in reverse order of construction, on the
+// thread that created them (a plain local variable does both). Fields that
+// no longer fit in a thread's 512-byte prefix are left out.
+//
+// v1 backends see only the message; v2 backends find the fields in
+// LogRecord::context.
+
+#ifndef LUMBERJACK_CONTEXT_H
+#define LUMBERJACK_CONTEXT_H
+
+#include "lumberjack/lumberjack.h"
+#include "lumberjack/structured.h"
+#include <cstddef>
+#include <initializer_list>
+
+namespace lumberjack {
+
+class LogContext {
+public:
+    // One field, typed as kv() would type it.
+    template <typename T>
+    LogContext(const char* key, T value) : LogContext({ kv(key, value) }) {}
+
+    // Several fields at once.
+    explicit LogContext(std::initializer_list<LogField> fields);
+
+    // Unwinds the prefix to where this scope found it. With set_batching(),
+    // the thread's batch is delivered first, while its records' context is
+    // still in place.
+    ~LogContext();
+
+    LogContext(const LogContext&) = delete;
+    LogContext& operator=(const LogContext&) = delete;
+
+private:
+    size_t m_logfmtLength;   // prefix lengths when the scope opened
+    size_t m_jsonLength;
+};
+
+// The calling thread's context, as it would be stamped on a record now.
+RecordContext current_context();
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_CONTEXT_H
@@ -0,0 +1,77 @@
+// escalation.h — Temporary verbosity escalation after errors.
+//
+// With escalation on, a line at trigger_level or more severe raises the
+// effective level to a more verbose one for a while, so the DEBUG detail
+// around a failure is written, and then lowers it back on its own:
+//
+//   lumberjack::EscalationOptions options;
+//   options.window_ms = 30000;       // DEBUG for 30 s after an ERROR...
+//   options.max_lines = 5000;        // ...or 5000 extra lines, if sooner
+//   lumberjack::set_escalation(true, options);
+//
+// set_escalation() points the trigger levels' table entries at variants
+// that start an escalation before logging the line, so the other levels,
+// and every level while escalation is off, log exactly as without it.
+// Raising and lowering rewire the dispatch tables as set_level() does, so
+// outside an escalation the extra levels stay plain no-op calls. The
+// levels the escalation turned on point at counting variants that spend
+// the line budget and check the window; the first line past either limit
+// is dropped and lowers the level. A window with no such lines ends at
+// the next one, so get_level() may report the escalated level until then.
+//
+// ESCALATE_PROCESS rewires the global tables; a set_level() call ends the
+// escalation. ESCALATE_THREAD gives the thread that logged the trigger a
+// level override (see set_thread_level()) and then restores the override
+// it had, or none; set_thread_level(), clear_thread_level() and a new
+// ThreadLevelOverride end it. Triggers logged while the escalation is
+// running do not extend it.
+//
+// Only LOG_* and LOG_*_KV lines trigger an escalation, and only they are
+// escalated: spans (LOG_SPAN and friends) stay at the level before the
+// escalation, since a span opened during one could not spend the budget
+// and would log after it had ended. Process escalation
+// rewires the global tables from whichever thread logged the trigger; like
+// set_level(), that stores each table entry once, and a call racing with
+// it takes the old or the new entry.
+
+#ifndef LUMBERJACK_ESCALATION_H
+#define LUMBERJACK_ESCALATION_H
+
+#include "lumberjack/lumberjack.h"
+#include <cstddef>
+
+namespace lumberjack {
+
+enum EscalationScope {
+    ESCALATE_PROCESS,   // every thread following the global level
+    ESCALATE_THREAD     // the thread that logged the trigger
+};
+
+// Settings for set_escalation().
+//   trigger_level — a line this severe or more starts an escalation
+//                   (default LOG_LEVEL_ERROR).
+//   level         — the level while escalated (default LOG_LEVEL_DEBUG).
+//   window_ms     — longest an escalation lasts.
+//   max_lines     — lines more verbose than the level before it that an
+//                   escalation may log.
+//   scope         — what is escalated.
+struct EscalationOptions {
+    LogLevel        trigger_level = LOG_LEVEL_ERROR;
+    LogLevel        level         = LOG_LEVEL_DEBUG;
+    unsigned        window_ms     = 10000;
+    size_t          max_lines     = 1000;
+    EscalationScope scope         = ESCALATE_PROCESS;
+};
+
+// Enables or disables escalation, ending a running process escalation;
+// thread escalations end at their thread's next escalated line if
+// escalation is disabled, and otherwise run their course. Other threads'
+// level overrides keep the triggers they had until they are next set.
+void set_escalation(bool enabled, const EscalationOptions& options = EscalationOptions());
+
+// Returns true if the calling thread is logging at an escalated level.
+bool escalated();
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_ESCALATION_H
@@ -14,7 +14,10 @@
 #ifndef LUMBERJACK_H
 #define LUMBERJACK_H
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <chrono>
 
 namespace lumberjack {
@@ -48,11 +51,45 @@ namespace Level {
 // Backend interface
 // ----------------------------------------------------------------------------
 
+// Context fields of a record, rendered when their LogContext scopes
+// opened: logfmt holds " key=value" pairs, json ",\"key\":value" members.
+// Both are empty when the thread has no context. The bytes stay valid for
+// the duration of the backend call, like the message.
+struct RecordContext {
+    const char* logfmt        = "";
+    size_t      logfmt_length = 0;
+    const char* json          = "";
+    size_t      json_length   = 0;
+};
+
+// One log line as the core hands it to a v2 backend.
+//   message      — the formatted text, length bytes long. It is also
+//                  NUL-terminated, so it can be passed on as a C string.
+//   timestamp_ns — capture time, system_clock nanoseconds since the epoch.
+//   thread_id    — kernel thread ID of the logging thread.
+//   file, line   — call site of the LOG_* macro; nullptr and 0 when the
+//                  line did not come through a macro.
+//   context      — the logging thread's LogContext fields (context.h).
+struct LogRecord {
+    LogLevel      level;
+    const char*   message;
+    size_t        length;
+    int64_t       timestamp_ns;
+    uint64_t      thread_id;
+    const char*   file;
+    int           line;
+    RecordContext context;
+};
+
+// A typed key-value pair of a structured line (see structured.h).
+struct LogField;
+
 // A pluggable logging destination. Implement this struct to route log output
 // to a custom sink (file, network, in-memory buffer, etc.).
 //
-// All function pointers must be non-null. Backends that don't need certain
-// functionality should provide no-op implementations.
+// Version 1 backends provide the first six callbacks, all non-null.
+// Backends that don't need certain functionality should provide no-op
+// implementations.
 //
 //   name       — Human-readable identifier, used for diagnostics.
 //   init       — Called once when the backend is activated via set_backend().
@@ -62,6 +99,26 @@ namespace Level {
 //                (or nullptr) that will be passed back to span_end.
 //   span_end   — Called when a Span is destroyed. Receives the handle from
 //                span_begin, the span name, and elapsed time in microseconds.
+//
+// Version 2 adds log_write_batch, which receives count records at once:
+// with set_batching() each call carries a thread's batch, otherwise one
+// record per call. Records carry their length, capture time, thread and
+// call site, so the backend needs no strlen, clock read or per-line lock.
+// LOG_* lines reach a v2 backend through log_write_batch only; log_write,
+// if set, is left for callers that hold just a string (get_backend()
+// users, BuiltinLogger::write). A v2 backend may leave log_write null; the
+// core then passes those single lines (span output, forwarded lines) as
+// one-record batches. A v1 backend keeps working unchanged: the core
+// unpacks batches into log_write calls.
+//
+// log_write_kv, if set, receives LOG_*_KV lines (structured.h) as a record
+// whose message is the constant text, plus its typed fields, without any
+// formatting. Such lines bypass set_batching(): the calling thread's batch
+// is delivered first, so its lines stay in order. Backends that leave it
+// null get the line as text, the fields appended as key=value.
+//
+// LogContext fields (context.h) reach v2 backends as LogRecord::context;
+// log_write gets the message alone.
 struct LogBackend {
     const char* name;
     void (*init)();
@@ -69,6 +126,8 @@ struct LogBackend {
     void (*log_write)(LogLevel level, const char* message);
     void* (*span_begin)(LogLevel level, const char* name);
     void (*span_end)(void* handle, LogLevel level, const char* name, long long elapsed_us);
+    void (*log_write_batch)(const LogRecord* records, size_t count) = nullptr;
+    void (*log_write_kv)(const LogRecord* record, const LogField* fields, size_t count) = nullptr;
 };
 
 // ----------------------------------------------------------------------------
@@ -80,27 +139,101 @@ struct LogBackend {
 void init();
 
 // Sets the active log level. Levels above this threshold become no-ops.
-// Takes effect immediately for all subsequent log calls and spans.
+// Takes effect immediately for all subsequent log calls and spans, and
+// ends a running process escalation (escalation.h).
 void set_level(LogLevel level);
 
 // Returns the current active log level.
 LogLevel get_level();
 
-// Installs a new backend, shutting down the previous one first.
+// Gives the calling thread its own level for the LOG_* and LOG_*_KV
+// macros, in a thread-local copy of the dispatch tables; other threads and
+// the global tables are untouched. set_level() does not change a thread
+// with an override. Spans and direct g_logFunctions calls keep following
+// the global level.
+void set_thread_level(LogLevel level);
+
+// Drops the calling thread's override; it follows set_level() again.
+void clear_thread_level();
+
+// Returns the calling thread's override, or the global level if it has
+// none.
+LogLevel get_thread_level();
+
+// Sets a thread level override for the enclosing scope and restores the
+// previous one, or none, on exit:
+//
+//   {
+//       lumberjack::ThreadLevelOverride verbose(lumberjack::LOG_LEVEL_DEBUG);
+//       replay(request);   // this thread logs DEBUG lines
+//   }
+class ThreadLevelOverride {
+public:
+    explicit ThreadLevelOverride(LogLevel level);
+    ~ThreadLevelOverride();
+
+    ThreadLevelOverride(const ThreadLevelOverride&) = delete;
+    ThreadLevelOverride& operator=(const ThreadLevelOverride&) = delete;
+
+private:
+    LogLevel m_previous;
+    bool     m_hadPrevious;
+};
+
+// Installs a new backend, shutting down the previous one first. Batched
+// records still waiting go to the previous backend before it shuts down.
 // The backend pointer is copied — the caller retains ownership of the
 // LogBackend struct but must keep it alive for the duration of use.
-// Silently returns if backend or any of its function pointers are null.
+// Silently returns if backend or any required function pointer is null
+// (log_write may be null when log_write_batch is set).
 void set_backend(LogBackend* backend);
 
 // Returns a pointer to the currently active backend (never null after init).
 LogBackend* get_backend();
 
+// Core batching settings for set_batching().
+//   records     — records a thread collects before delivering them
+//                 (1 to 256).
+//   interval_ms — longest a record waits: a flusher thread delivers
+//                 batches older than this.
+//   flush_level — records this severe or more deliver their batch at once,
+//                 so an ERROR is never held back (default LOG_LEVEL_ERROR).
+struct BatchOptions {
+    size_t   records     = 64;
+    unsigned interval_ms = 100;
+    LogLevel flush_level = LOG_LEVEL_ERROR;
+};
+
+// Enables or disables core batching. Each thread formats its lines into a
+// thread-local batch, which is delivered with one log_write_batch() call
+// (or, for v1 backends, a run of log_write() calls) when it fills, on a
+// flush_level line, after interval_ms, on flush_batches() and when the
+// thread exits. Lines of different threads reach the backend in batches,
+// so they interleave by batch; each record keeps its capture time.
+// Disabling delivers every pending batch.
+void set_batching(bool enabled, const BatchOptions& options = BatchOptions());
+
+// Delivers every thread's pending batch to the active backend.
+void flush_batches();
+
+// Returns the next value of the process-wide log sequence, starting at 0.
+// One relaxed atomic increment, so any thread, buffer or backend can stamp
+// its records cheaply; numbers are unique and increase in the order they
+// are taken. Files written from different buffers can then be put back in
+// one total order with merge_log_files() (merge.h) or lumberjack-merge.
+uint64_t next_sequence();
+
+// Kernel thread ID of the calling thread (as in LogRecord::thread_id),
+// looked up once per thread.
+uint64_t current_thread_id();
+
 // ----------------------------------------------------------------------------
 // Built-in backend
 // ----------------------------------------------------------------------------
 
 // Returns the built-in stderr logging backend. This is the default backend
-// installed by init(). Output format: [timestamp] [LEVEL] message
+// installed by init(). Output format: [timestamp] [LEVEL] message, or the
+// layout set with builtin_set_pattern().
 LogBackend* builtin_backend();
 
 // Redirects built-in backend output to the given FILE stream.
@@ -131,6 +264,229 @@ void builtin_flush();
 // Output format becomes: [timestamp] [LEVEL] #N message
 void builtin_set_timestamp_cache(unsigned int interval_ms, bool seq = false);
 
+// Mirrors every line the built-in backend formats into a crash-surviving
+// flight recorder ring of capacity bytes at path (see flight_recorder.h).
+// Lines reach the recorder before the write buffer, so they survive the
+// process being killed with output still buffered. Recover them with the
+// lumberjack-recover tool. Pass nullptr to stop recording.
+// Returns false if the file cannot be created or mapped.
+bool builtin_set_flight_recorder(const char* path, size_t capacity = 4 * 1024 * 1024);
+
+// Sets the most verbose level the built-in backend writes to its output
+// stream (default LOG_LEVEL_DEBUG, i.e. everything that passes set_level).
+// More verbose lines still go to the flight recorder, so combining
+// set_level(LOG_LEVEL_DEBUG) with builtin_set_output_level(LOG_LEVEL_INFO)
+// keeps DEBUG detail in the recorder without writing it out.
+void builtin_set_output_level(LogLevel level);
+
+// Numbers every built-in backend line with next_sequence():
+//   [timestamp] [LEVEL] #N message
+// Unlike the counter of builtin_set_timestamp_cache(), N never resets and
+// is shared with every other user of next_sequence() in the process. It is
+// taken where the line's order is fixed — under the backend's lock, or on
+// entering the queue — so each output file is in ascending order. In
+// queued mode it also numbers the lines of priority lanes.
+void builtin_set_global_sequence(bool enabled);
+
+// What log_and_wait_durable() waits for before it returns.
+//   NONE      — nothing: the line is written like any other.
+//   FLUSH     — the line has left the write buffer and stdio for the kernel,
+//               so it survives the process but not the machine crashing.
+//   FDATASYNC — the output file has been fdatasync'ed past the line.
+enum Durability {
+    DURABILITY_NONE      = 0,
+    DURABILITY_FLUSH     = 1,
+    DURABILITY_FDATASYNC = 2
+};
+
+// Group commit counters since the process started.
+struct DurabilityStats {
+    uint64_t records;   // lines covered by a commit
+    uint64_t commits;   // flushes (and fdatasyncs) run by the flusher
+    uint64_t errors;    // commits whose fdatasync failed
+};
+
+// Sets the built-in backend's durability level. FLUSH and FDATASYNC start
+// a flusher thread that commits in groups: every line written while one
+// fdatasync runs is covered by the next, and all producers waiting on a
+// group wake together. So throughput grows with the number of concurrent
+// waiters rather than being capped at one line per fdatasync. Rotation
+// syncs the old file before switching when the level is FDATASYNC.
+// Plain LOG_* calls never wait, but their lines are committed with the
+// group they fall in.
+void builtin_set_durability(Durability durability);
+
+// Returns the group commit counters.
+DurabilityStats builtin_durability_stats();
+
+// Logs a printf-style line through the built-in backend and waits until it
+// is durable at the level set with builtin_set_durability(). The line is
+// written directly even in queued mode, so it can land ahead of lines the
+// calling thread queued earlier. Returns false if the commit failed or the
+// built-in backend is not active (the line then goes to the active backend
+// without waiting). A disabled level logs nothing and returns true.
+bool log_and_wait_durable(LogLevel level, const char* fmt, ...);
+
+// Sets the least severe level whose lines flush the write buffer as soon as
+// they are written (default LOG_LEVEL_NONE: nothing forces a flush). With
+// builtin_set_flush_level(LOG_LEVEL_ERROR), ERROR lines reach the output
+// stream immediately — together with any buffered lines before them —
+// while INFO and DEBUG stay buffered. In queued mode the writer flushes at
+// the end of the batch holding such a line.
+void builtin_set_flush_level(LogLevel level);
+
+// Rotation settings for builtin_set_rotation() (and FileRotator in rotation.h).
+//   max_bytes  — rotate before a line would push the file past this size
+//                (0 = no size limit).
+//   interval_s — rotate at every multiple of this many seconds of wall-clock
+//                time, e.g. 3600 for the top of each hour (0 = never).
+//   keep       — rotated segments kept on disk; older ones are deleted
+//                (0 = keep all).
+//   compress   — gzip rotated segments. Ignored when built without zlib.
+struct RotationOptions {
+    size_t   max_bytes  = 0;
+    unsigned interval_s = 0;
+    unsigned keep       = 10;
+    bool     compress   = true;
+};
+
+// Writes built-in backend output to path and rotates it by size and/or time.
+// The next file is opened ahead of time, so the switch under the backend's
+// lock is a pointer swap; closing, renaming to path.NNNNNN, compressing and
+// pruning old segments happen on a background thread. Replaces any output
+// set with builtin_set_output(). Pass nullptr to stop rotating: the file is
+// closed and output returns to stderr.
+// Returns false if path cannot be opened.
+bool builtin_set_rotation(const char* path, const RotationOptions& options = RotationOptions());
+
+// What a producer does when the built-in backend's queue is full.
+//   BLOCK         — wait up to block_timeout_ms for the writer to make room,
+//                   then drop the new record.
+//   DROP_NEWEST   — drop the new record.
+//   DROP_OLDEST   — evict the oldest queued record to make room.
+//   DROP_BY_LEVEL — evict the oldest queued record of the most verbose level
+//                   that is more verbose than the new one (DEBUG goes before
+//                   INFO before WARN); drop the new record if there is none.
+//   SPILL         — format the new record on the calling thread and append
+//                   it to spill_path instead of the output.
+enum BackpressurePolicy {
+    BACKPRESSURE_BLOCK         = 0,
+    BACKPRESSURE_DROP_NEWEST   = 1,
+    BACKPRESSURE_DROP_OLDEST   = 2,
+    BACKPRESSURE_DROP_BY_LEVEL = 3,
+    BACKPRESSURE_SPILL         = 4
+};
+
+// Queue settings for builtin_set_queued().
+//   capacity         — records the queue holds before the policy applies.
+//                      Each record takes about 1 KB.
+//   policy           — see BackpressurePolicy.
+//   block_timeout_ms — longest a producer waits under BACKPRESSURE_BLOCK.
+//   spill_path       — file appended to under BACKPRESSURE_SPILL.
+//   report_drops     — have the writer log "dropped N DEBUG messages" (at
+//                      WARN) after records were dropped.
+//   priority_lanes   — have the writer drain the most severe queued level
+//                      first, so an ERROR is written after at most the batch
+//                      in progress rather than behind every queued DEBUG line.
+//                      Lines can then leave capture order (even within one
+//                      thread), so each carries its queue position as #N:
+//                      sort by N to restore the order.
+struct QueueOptions {
+    size_t             capacity         = 4096;
+    BackpressurePolicy policy           = BACKPRESSURE_DROP_BY_LEVEL;
+    unsigned           block_timeout_ms = 10;
+    const char*        spill_path       = nullptr;
+    bool               report_drops     = true;
+    bool               priority_lanes   = false;
+};
+
+// Counters since the queue was last enabled. Drops are indexed by LogLevel.
+struct QueueStats {
+    uint64_t enqueued;
+    uint64_t dropped[LOG_COUNT];
+    uint64_t spilled;
+    uint64_t blocked;          // producers that had to wait for room
+};
+
+// Enables or disables queued mode. Producers copy the message and its
+// capture time into a bounded queue and return; a writer thread formats the
+// lines (with the capture time) and writes them through the usual path —
+// flight recorder, output level, rotation and write buffer. Without
+// buffered mode the writer flushes once per batch rather than per line.
+// builtin_flush() and shutdown wait for the queue to drain. Disabling
+// drains the queue and stops the writer. On a crash the crash handler
+// writes the records still queued after the write buffer; a batch the
+// writer thread has already taken may be lost, and a line it was writing
+// may appear twice.
+// Returns false if the spill file cannot be opened.
+bool builtin_set_queued(bool enabled, const QueueOptions& options = QueueOptions());
+
+// Returns the queue counters. Drop counters are lock-free atomics, so this
+// is cheap to poll.
+QueueStats builtin_queue_stats();
+
+// Line formats of the built-in backend.
+//   TEXT   — the pattern layout (builtin_set_pattern()); structured fields
+//            follow the message as key=value.
+//   LOGFMT — time="..." level=info msg="..." key=value ...
+//   JSON   — {"time":"...","level":"info","msg":"...","key":value,...}
+// With a sequence number (builtin_set_timestamp_cache() seq, or the global
+// sequence) LOGFMT and JSON add seq=N / "seq":N before msg.
+enum OutputFormat {
+    OUTPUT_TEXT,
+    OUTPUT_LOGFMT,
+    OUTPUT_JSON
+};
+
+// Sets the built-in backend's line format (default OUTPUT_TEXT). Applies to
+// every line, structured or not; messages are escaped as the format needs.
+void builtin_set_output_format(OutputFormat format);
+
+// Sets the built-in backend's line layout, e.g. "%T %L [%t] %s:%l %m" for
+// timestamp, level, thread ID, file:line and message (directives in
+// pattern.h). The pattern is compiled once into a list of copy and
+// number-append steps, so rendering a line runs no format parsing. The
+// default, "[%T] [%L] %n%X%m", prints [timestamp] [LEVEL] #N message as
+// before, with the LogContext fields (context.h) ahead of the message;
+// pass nullptr to restore it. Lines logged through LOG_* carry
+// their call site; lines that arrive as plain strings (spans, write())
+// print "?" for it. The spill file keeps the default layout.
+// Returns false, keeping the current layout, on an unknown directive.
+bool builtin_set_pattern(const char* pattern);
+
+// ----------------------------------------------------------------------------
+// Crash handling
+// ----------------------------------------------------------------------------
+
+// Signature for crash flush hooks. Hooks run inside a signal handler on the
+// crashing thread, so they may only use async-signal-safe calls (write,
+// pwrite — no stdio, locks or allocation). See the helpers in utils.h.
+using CrashFlushFunction = void (*)(int signo);
+
+// Installs an opt-in handler for SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT.
+// On a crash it runs every registered flush hook, then restores the handlers
+// that were installed before and re-raises the signal, so they (or the
+// default action, e.g. a core dump) still run. The hooks run once, on the
+// first thread to crash; any other thread crashing meanwhile waits for them
+// to finish before re-raising its own signal.
+//
+// The built-in backend registers a hook that writes its pending write buffer
+// and a final "[timestamp] [ERROR] crashed with signal N" line to its output
+// descriptor, which makes large buffers safe to use in production. The
+// async file sink writes its queued blocks the same way.
+//
+// Returns false if a handler could not be installed. Calling it again while
+// installed is a no-op.
+bool install_crash_handler();
+
+// Restores the signal handlers that were active before install_crash_handler().
+void uninstall_crash_handler();
+
+// Adds a hook for the crash handler to run, in registration order. Custom
+// backends use this to dump their own buffers. Registering a hook twice is a
+// no-op. Returns false when the hook table (16 entries) is full.
+bool register_crash_flush(CrashFlushFunction hook);
+
 // ----------------------------------------------------------------------------
 // Function pointer types (public for macro / Span use)
 // ----------------------------------------------------------------------------
@@ -138,16 +494,95 @@ void builtin_set_timestamp_cache(unsigned int interval_ms, bool seq = false);
 // Signature for log dispatch functions. Accepts printf-style format + args.
 using LogFunction = void (*)(LogLevel, const char*, ...);
 
+// Log dispatch with the call site, as used by the LOG_* macros.
+using LogSiteFunction = void (*)(LogLevel, const char* file, int line, const char*, ...);
+
+// Dispatch for argument-less messages without '%': text is written as-is,
+// len bytes long (and NUL-terminated), with no formatting.
+using LogLiteralFunction = void (*)(LogLevel, const char* file, int line, const char* text, size_t len);
+
+// Dispatch for structured lines: a constant message and count typed fields.
+using LogKvFunction = void (*)(LogLevel, const char* file, int line, const char* message,
+                               const LogField* fields, size_t count);
+
 // Signature for clock read functions. Returns a steady_clock time_point
 // (or a zero time_point for the no-op path).
 using ClockFunction = std::chrono::steady_clock::time_point (*)();
 
-// Dispatch tables indexed by LogLevel. Active levels point to real
-// implementations; inactive levels point to no-ops. The macros below
-// index directly into these arrays for branchless dispatch.
+// Forces a helper into its call site, so the compiler sees the literal
+// format string it was passed.
+#if defined(__GNUC__)
+#define LUMBERJACK_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define LUMBERJACK_ALWAYS_INLINE inline
+#endif
+
+// True if the compiler knows x at compile time, after inlining; x itself is
+// not evaluated. Without the builtin nothing is known, and callers take
+// their general path.
+#if defined(__GNUC__)
+#define LUMBERJACK_CONSTANT_P(x) __builtin_constant_p(x)
+#else
+#define LUMBERJACK_CONSTANT_P(x) 0
+#endif
+
+// Thread-local storage for plain pointers. GCC and Clang's __thread
+// compiles to a direct thread-pointer load; an extern C++ thread_local
+// would call an initialization wrapper on every access.
+#if defined(__GNUC__)
+#define LUMBERJACK_THREAD_LOCAL __thread
+#else
+#define LUMBERJACK_THREAD_LOCAL thread_local
+#endif
+
+// The tables the LOG_* and LOG_*_KV macros dispatch through, indexed by
+// LogLevel. Active levels point to real implementations; inactive levels
+// point to no-ops.
+struct DispatchTable {
+    LogSiteFunction    site[LOG_COUNT];
+    LogLiteralFunction literal[LOG_COUNT];
+    LogKvFunction      kv[LOG_COUNT];
+};
+
+// The process-wide tables, rewired by set_level().
+extern DispatchTable g_dispatch;
+
+// The calling thread's tables: &g_dispatch, or the thread's own while a
+// ThreadLevelOverride is in place. The macros load this pointer and make
+// one indexed indirect call through it, so a thread without an override
+// pays one thread-local load over indexing g_dispatch directly.
+extern LUMBERJACK_THREAD_LOCAL const DispatchTable* t_dispatch;
+
+// Dispatch tables indexed by LogLevel, for direct use. g_logFunctions and
+// g_clockFunctions follow set_level() only; the other three name the
+// arrays of g_dispatch.
 extern LogFunction g_logFunctions[LOG_COUNT];
+extern LogSiteFunction (&g_logSiteFunctions)[LOG_COUNT];
+extern LogLiteralFunction (&g_logLiteralFunctions)[LOG_COUNT];
+extern LogKvFunction (&g_logKvFunctions)[LOG_COUNT];
 extern ClockFunction g_clockFunctions[LOG_COUNT];
 
+// Picks the dispatch table for a LOG_* call. Whether there are arguments is
+// known from the pack size. For an argument-less string literal the compiler
+// folds strchr() and strlen(), so a message without '%' costs one table call
+// with a constant pointer and length: no varargs, vsnprintf or strlen. A
+// message with '%' goes through vsnprintf, so "100%% done" still prints
+// "100% done". A format the compiler cannot see (a runtime string, or any
+// call in an unoptimized build) skips the check and goes to site[], so
+// strchr() and strlen() never run at the call.
+template <typename... Args>
+LUMBERJACK_ALWAYS_INLINE void log_site(LogLevel level, const char* file, int line,
+                                       const char* fmt, Args... args) {
+    const DispatchTable* table = t_dispatch;
+    if constexpr (sizeof...(Args) == 0) {
+        if (LUMBERJACK_CONSTANT_P(std::strlen(fmt)) && !std::strchr(fmt, '%')) {
+            table->literal[level](level, file, line, fmt, std::strlen(fmt));
+            return;
+        }
+    }
+    table->site[level](level, file, line, fmt, args...);
+}
+
 // ----------------------------------------------------------------------------
 // Span — RAII timing measurement
 // ----------------------------------------------------------------------------
@@ -198,19 +633,21 @@ private:
 
 // Log at a specific level with printf-style formatting.
 // These index directly into the dispatch table — inactive levels are no-ops.
+// The call site travels with the line as __FILE__ and __LINE__ constants,
+// and argument-less literals skip formatting (see log_site()).
 #define LOG_ERROR(fmt, ...) \
-    lumberjack::g_logFunctions[lumberjack::LOG_LEVEL_ERROR](lumberjack::LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+    lumberjack::log_site(lumberjack::LOG_LEVEL_ERROR, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
 #define LOG_WARN(fmt, ...) \
-    lumberjack::g_logFunctions[lumberjack::LOG_LEVEL_WARN](lumberjack::LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+    lumberjack::log_site(lumberjack::LOG_LEVEL_WARN, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
 #define LOG_INFO(fmt, ...) \
-    lumberjack::g_logFunctions[lumberjack::LOG_LEVEL_INFO](lumberjack::LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+    lumberjack::log_site(lumberjack::LOG_LEVEL_INFO, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
 #define LOG_DEBUG(fmt, ...) \
-    lumberjack::g_logFunctions[lumberjack::LOG_LEVEL_DEBUG](lumberjack::LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+    lumberjack::log_site(lumberjack::LOG_LEVEL_DEBUG, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
 // Log at a dynamic level — useful when the level is a runtime variable.
 //   LogLevel lvl = compute_level();
 //   LOG_AT(lvl, "something happened: %s", detail);
 #define LOG_AT(level, fmt, ...) \
-    lumberjack::g_logFunctions[level](level, fmt, ##__VA_ARGS__)
+    lumberjack::log_site(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
 
 // Creates an RAII Span scoped to the enclosing block. The span name appears
 // in backend output along with the elapsed time when the block exits.
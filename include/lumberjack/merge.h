@@ -0,0 +1,57 @@
+// merge.h — Restores one total order across several lumberjack log files.
+//
+// Output that is split across buffers — per-thread or per-category files,
+// several BuiltinLogger outputs, recovered flight recorder records — is
+// each in order on its own. merge_log_files() interleaves them with a
+// k-way merge, reading every input once and holding one record per input.
+//
+// Records are ordered by one key for the whole merge: their #N sequence
+// number if every record of every input carries one (see next_sequence()
+// and builtin_set_global_sequence()), and otherwise their timestamp, which
+// has millisecond resolution; ties keep input order. Lines that do not
+// start with '[' continue the record before them and move with it.
+//
+// A first pass checks that each input is ascending in that key. One that
+// is not — a queued file with priority lanes, whose #N are queue positions
+// written out of order — is sorted in memory (stably) before the merge.
+// #N values from different counters cannot be told apart: merge by #N
+// only files numbered by the same process-wide counter, or one priority
+// lane file on its own.
+//
+// Usage:
+//   const char* files[] = { "worker0.log", "worker1.log", "audit.log" };
+//   merge_log_files(files, 3, stdout);
+//
+// Or from the shell:
+//   lumberjack-merge -o merged.log worker0.log worker1.log audit.log
+
+#ifndef LUMBERJACK_MERGE_H
+#define LUMBERJACK_MERGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace lumberjack {
+
+// Ordering key of one formatted line: "[timestamp] [LEVEL] #N message",
+// with any number of bracketed fields between the timestamp and #N.
+struct LineOrder {
+    char     timestamp[32];   // empty when the line has none
+    bool     has_seq;
+    uint64_t seq;
+};
+
+// Parses the ordering key of line. Returns false if the line does not
+// start with a bracketed timestamp (a continuation line).
+bool parse_line_order(const char* line, size_t len, LineOrder* order);
+
+// Merges the files at paths into out. Inputs are read twice, so they must
+// be regular files. Returns the number of records written, or -1 if an
+// input cannot be opened or an out-of-order input cannot be sorted into a
+// temporary file (nothing is written then).
+long merge_log_files(const char* const* paths, size_t count, FILE* out);
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_MERGE_H
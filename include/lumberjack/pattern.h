@@ -0,0 +1,103 @@
+// pattern.h — Line layouts compiled into flat render programs.
+//
+// A PatternLayout turns a pattern such as "%T %L [%t] %s:%l %m" into a list
+// of steps once: copy a literal, copy the timestamp, copy the level tag,
+// append a number, copy the message. Rendering a line then runs those
+// steps: a few memcpy calls and digit loops, and no format string parsing
+// or snprintf per line.
+//
+// Directives:
+//   %T  timestamp as given (e.g. from TimestampCache)
+//   %L  level tag, padded to five characters ("INFO ", "ERROR")
+//   %t  kernel thread ID
+//   %s  source file name (without directories), "?" when unknown
+//   %l  source line, "?" when unknown
+//   %n  "#N " when the line is numbered, nothing otherwise
+//   %X  context fields (context.h) as "key=value ", nothing without any
+//   %m  message
+//   %%  a literal '%'
+// Every rendered line ends with '\n', which the pattern leaves out.
+//
+// Usage:
+//   PatternLayout layout;
+//   if (!layout.compile("%T %L [%t] %s:%l %m")) { /* unknown directive */ }
+//   PatternFields fields = { ts, level, message, message_len, tid, file, line, -1,
+//                            ctx, ctx_len };
+//   size_t len = layout.render(line, sizeof(line), fields);
+//
+// Thread safety: render() may run concurrently; compile() must not run
+// while another thread renders.
+
+#ifndef LUMBERJACK_PATTERN_H
+#define LUMBERJACK_PATTERN_H
+
+#include "lumberjack/lumberjack.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lumberjack {
+
+// The layout the built-in backend uses unless builtin_set_pattern() changes
+// it: "[timestamp] [LEVEL] #N context message".
+constexpr const char* DEFAULT_PATTERN = "[%T] [%L] %n%X%m";
+
+// Values one line is rendered from. seq below 0 means not numbered; file
+// nullptr and line 0 mean no call site. context holds " key=value" pairs
+// (RecordContext::logfmt), or is empty.
+struct PatternFields {
+    const char* timestamp;
+    LogLevel    level;
+    const char* message;
+    size_t      message_len;
+    uint64_t    thread_id;
+    const char* file;
+    int         line;
+    long long   seq;
+    const char* context     = "";
+    size_t      context_len = 0;
+};
+
+class PatternLayout {
+public:
+    PatternLayout();   // compiled from DEFAULT_PATTERN
+
+    // Compiles pattern, replacing the current program. Returns false (and
+    // keeps the current program) on an unknown directive or a trailing '%'.
+    bool compile(const char* pattern);
+
+    // Renders one line into out, always '\n'-terminated when capacity > 0.
+    // A line that does not fit is cut before the newline. Returns the
+    // number of bytes written (no NUL is added).
+    size_t render(char* out, size_t capacity, const PatternFields& fields) const;
+
+    const char* pattern() const { return m_pattern.c_str(); }
+
+private:
+    enum Op : uint8_t {
+        OP_LITERAL,
+        OP_TIMESTAMP,
+        OP_LEVEL,
+        OP_THREAD,
+        OP_FILE,
+        OP_LINE,
+        OP_SEQ,
+        OP_CONTEXT,
+        OP_MESSAGE
+    };
+
+    struct Step {
+        Op       op;
+        uint32_t offset;   // OP_LITERAL: into m_literals
+        uint32_t length;
+    };
+
+    std::vector<Step> m_steps;
+    std::string       m_literals;
+    std::string       m_pattern;
+};
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_PATTERN_H
@@ -0,0 +1,116 @@
+// rotation.h — Size- and time-based rotation of a log file.
+//
+// A FileRotator owns the file being written at `path` and keeps the next
+// file already open (as `path.next`) so switching is a pointer swap: no
+// open(), rename() or close() happens on the writer's side. A background
+// thread then closes the retired file, renames it to `path.NNNNNN` and the
+// pre-opened file to `path`, gzips the segment (when built with zlib),
+// deletes segments beyond `keep`, and opens the following `path.next`.
+//
+// Segment numbers increase with age order, so the highest number is the
+// newest; numbering continues from the segments already on disk.
+//
+// Usage (the caller serializes writes with its own lock):
+//   FileRotator rot;
+//   rot.open("app.log", options);
+//   if (rot.should_rotate(len)) { flush pending output; rot.rotate(); }
+//   fwrite(line, 1, len, rot.file());
+//   rot.add_bytes(len);
+//
+// If the background thread has not finished preparing the next file when a
+// rotation is due, the rotation is simply retried on a later write.
+
+#ifndef LUMBERJACK_ROTATION_H
+#define LUMBERJACK_ROTATION_H
+
+#include "lumberjack/lumberjack.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace lumberjack {
+
+class FileRotator {
+public:
+    FileRotator() = default;
+    ~FileRotator();
+
+    FileRotator(const FileRotator&) = delete;
+    FileRotator& operator=(const FileRotator&) = delete;
+
+    // True when rotated segments can be gzipped (the library found zlib).
+    static bool compression_supported();
+
+    // Opens path for appending and starts the background thread. Bytes
+    // already in the file count toward max_bytes. Returns false on failure.
+    bool open(const char* path, const RotationOptions& options);
+
+    // Closes the current file and waits for pending background work.
+    void close();
+
+    bool is_open() const { return m_current != nullptr; }
+
+    // The file to write to. Changes only in rotate().
+    FILE* file() const { return m_current; }
+
+    // True when the size limit or interval has been reached, something was
+    // written since the last switch, and the next file is ready. Never blocks.
+    bool should_rotate(size_t len);
+
+    // Switches to the pre-opened file and queues the current one for the
+    // background thread. The caller must have flushed its own buffers into
+    // the current file first. Returns false if no next file is ready.
+    bool rotate();
+
+    // Accounts for bytes written to file().
+    void add_bytes(size_t len) { m_bytes += len; }
+
+    // Blocks until retired files are renamed, compressed and pruned and the
+    // next file is open.
+    void wait_idle();
+
+    // Number of rotations since open().
+    uint64_t rotations() const { return m_rotations; }
+
+private:
+    void run();
+    std::string retire(FILE* file);
+    void finish_segment(const std::string& segment);
+    void prune();
+    std::string segment_path(unsigned index) const;
+
+    // Writer side — serialized by the caller.
+    FILE*    m_current   = nullptr;
+    uint64_t m_bytes     = 0;
+    uint64_t m_rotations = 0;
+    size_t   m_maxBytes  = 0;
+
+    std::atomic<FILE*> m_next{nullptr};
+    std::atomic<bool>  m_due{false};
+
+    // Background side — guarded by m_mutex.
+    std::mutex              m_mutex;
+    std::condition_variable m_cv;
+    std::deque<FILE*>       m_retired;
+    std::deque<std::string> m_finishing;   // renamed, not yet compressed
+    bool                    m_busy = false;
+    bool                    m_nextFailed = false;
+    bool                    m_stopping = false;
+    std::thread             m_thread;
+
+    std::string m_path;
+    std::string m_nextPath;
+    unsigned    m_interval  = 0;
+    unsigned    m_keep      = 0;
+    bool        m_compress  = false;
+    unsigned    m_nextIndex = 1;
+};
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_ROTATION_H
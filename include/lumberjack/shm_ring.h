@@ -0,0 +1,119 @@
+// shm_ring.h — Shared-memory log ring between a process and a drain.
+//
+// The shared-memory sink (see sinks.h) writes raw records — level, wall
+// clock timestamp and message text — into a ring in a POSIX shared memory
+// object. A separate process (lumberjack-drain, or anything built on
+// ShmRingReader) formats and writes them, so the producing process never
+// formats timestamps, touches a file descriptor or waits on a consumer.
+//
+// Object layout:
+//   [ShmRingHeader, padded to 4096 bytes][ring: capacity bytes, power of 2]
+//
+// Producers claim space with a CAS on write_pos that fails when the ring
+// does not have room; the record is then dropped and counted, so a stalled
+// drain never blocks a producer. Each record is 8-byte aligned:
+//   uint32 size_flags — total record bytes; 0 until committed (release
+//                       store); RECORD_PAD marks filler up to the ring end
+//   uint16 level
+//   uint16 length     — message bytes
+//   uint64 timestamp  — wall clock, nanoseconds since the epoch
+//   message, padded to a multiple of 8
+//
+// The reader zeroes consumed bytes before advancing read_pos, so a
+// non-zero size word always belongs to the current lap.
+//
+// Wakeups: a drain with nothing to read sets consumer_sleeping and waits
+// on it with futex(2). A producer only issues FUTEX_WAKE when it sees that
+// flag set, so a busy drain costs producers no syscalls at all.
+
+#ifndef LUMBERJACK_SHM_RING_H
+#define LUMBERJACK_SHM_RING_H
+
+#include "lumberjack/lumberjack.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lumberjack {
+
+struct ShmRingHeader {
+    char     magic[8];                    // "LJSHMRNG"
+    uint32_t version;
+    uint32_t header_size;                 // offset of the ring in the object
+    uint64_t capacity;                    // ring bytes, a power of two
+    uint32_t producer_pid;
+    uint32_t reserved;
+    alignas(64) std::atomic<uint64_t> write_pos;   // next byte producers reserve
+    alignas(64) std::atomic<uint64_t> read_pos;    // next byte the reader consumes
+    // First position written by the current producer. A reader stuck on a
+    // record that a previous, crashed producer never committed skips here.
+    std::atomic<uint64_t> restart_pos;
+    std::atomic<uint64_t> dropped;                 // records that did not fit
+    alignas(64) std::atomic<uint32_t> consumer_sleeping;  // futex word
+};
+
+// One record as seen by the reader. text points into the ring and stays
+// valid until ShmRingReader::release().
+struct ShmRecord {
+    LogLevel    level;
+    uint64_t    timestamp_ns;
+    const char* text;
+    size_t      length;
+};
+
+class ShmRingReader {
+public:
+    static constexpr uint32_t VERSION     = 1;
+    static constexpr size_t   HEADER_SIZE = 4096;
+    static constexpr uint32_t RECORD_PAD  = 0x80000000u;
+
+    ShmRingReader() = default;
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    // Attaches to the shared memory object created by shm_ring_open().
+    // Returns false if it does not exist or is not a lumberjack ring.
+    bool open(const char* name);
+
+    // Detaches. Unconsumed records stay in the ring.
+    void close();
+
+    bool is_open() const { return m_header != nullptr; }
+
+    // Returns the next committed record, or false if none is ready.
+    // Records returned since the last release() stay readable until then.
+    bool next(ShmRecord* record);
+
+    // Frees the space of all records returned by next() for producers.
+    void release();
+
+    // Records producers have dropped because the ring was full.
+    uint64_t dropped() const;
+
+    // PID of the process that last opened the ring for writing.
+    uint32_t producer_pid() const;
+
+    // Blocks until a producer commits to any of the readers' rings, or
+    // timeout_ms elapses. Returns immediately if a record is already
+    // waiting. Uses futex_waitv() to wait on several rings at once where
+    // the kernel supports it, and short timed waits otherwise.
+    static void wait(ShmRingReader* const* readers, size_t count, int timeout_ms);
+
+private:
+    // Whether a committed record (or padding) is at the read cursor.
+    bool ready() const;
+
+    ShmRingHeader* m_header   = nullptr;
+    char*          m_ring     = nullptr;
+    uint64_t       m_mask     = 0;
+    size_t         m_mapLen   = 0;
+    uint64_t       m_cursor   = 0;    // read position including unreleased records
+    uint64_t       m_stuckPos = ~0ull;
+    uint64_t       m_stuckSince = 0;
+};
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_SHM_RING_H
@@ -0,0 +1,472 @@
+// sinks.h — Additional output backends for the lumberjack logging library.
+//
+// Each sink follows the same shape as the built-in backend: an accessor that
+// returns a LogBackend* for set_backend(), plus free functions to configure
+// it. Unless stated otherwise, sinks write the built-in line format:
+//   [timestamp] [LEVEL] message
+
+#ifndef LUMBERJACK_SINKS_H
+#define LUMBERJACK_SINKS_H
+
+#include "lumberjack/lumberjack.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace lumberjack {
+
+// ----------------------------------------------------------------------------
+// Async file sink
+// ----------------------------------------------------------------------------
+
+// Writes log lines to a file without blocking the logging thread on I/O.
+// Lines are accumulated in fixed-size blocks; a full block is handed to a
+// background writer and the producer carries on in the next free block.
+//
+// On Linux the writer submits blocks to an io_uring instance, using buffers
+// registered with the kernel (WRITE_FIXED) when possible, and keeps up to
+// block_count writes in flight. Each block returns to the free pool when
+// its completion arrives. When io_uring is unavailable (old kernel, seccomp
+// policy, non-Linux build) a pool of writer threads issues pwrite() instead.
+//
+// Every block is assigned its file offset at hand-off, so concurrent
+// completions never reorder lines in the file. A producer only waits when
+// all blocks are in flight, i.e. the disk is slower than the producers for
+// a sustained period.
+
+enum AsyncFileEngine {
+    ASYNC_FILE_ENGINE_NONE     = 0,  // no file open
+    ASYNC_FILE_ENGINE_IO_URING = 1,
+    ASYNC_FILE_ENGINE_THREADS  = 2
+};
+
+struct AsyncFileOptions {
+    size_t   block_size         = 64 * 1024;  // bytes per block
+    unsigned block_count        = 8;          // blocks in the pool (max in flight)
+    unsigned fallback_threads   = 2;          // writers for the pwrite() fallback
+    bool     force_fallback     = false;      // skip io_uring even if available
+    unsigned timestamp_cache_ms = 0;          // see builtin_set_timestamp_cache()
+};
+
+// Counters since the file was opened. Completion latency is measured from
+// the moment a block is handed to the writer until its write completes.
+struct AsyncFileStats {
+    uint64_t blocks_written;
+    uint64_t bytes_written;
+    uint64_t write_errors;
+    uint64_t producer_waits;     // times a producer found no free block
+    uint64_t completion_ns_total;
+    uint64_t completion_ns_max;
+};
+
+// Returns the async file backend. Log calls are dropped until a file has
+// been opened with async_file_open().
+LogBackend* async_file_backend();
+
+// Opens (or creates) path for appending and starts the writer. Any file
+// already open is flushed and closed first. Returns false on failure.
+bool async_file_open(const char* path, const AsyncFileOptions& options = AsyncFileOptions());
+
+// Flushes all pending data, stops the writer and closes the file.
+void async_file_close();
+
+// Hands off the partially filled block and waits until every submitted
+// write has completed. Also called by the backend's shutdown callback.
+void async_file_flush();
+
+// Returns the engine in use for the currently open file.
+AsyncFileEngine async_file_engine();
+
+// Returns a snapshot of the sink's counters.
+AsyncFileStats async_file_stats();
+
+// ----------------------------------------------------------------------------
+// Memory-mapped file sink
+// ----------------------------------------------------------------------------
+
+// Writes log lines straight into a memory-mapped, preallocated file. A
+// producer reserves space with one atomic fetch-add on the segment's write
+// offset and copies its line into the mapping — no locks and no write
+// syscalls on the logging path. The kernel writes dirty pages back on its
+// own schedule, and the data survives a process crash (not a power loss)
+// as soon as the memcpy completes.
+//
+// Output is split into segment files named <path>.000000, <path>.000001,
+// ... each segment_size bytes. The producer whose reservation crosses the
+// end of a segment swaps in the next one, which a background thread has
+// already created and preallocated, and truncates the finished file to its
+// used length. If the next segment is not ready yet, that producer (and
+// any that reach the end after it) waits for it. If it could not be
+// created (a full disk, say), lines are dropped and counted until a retry
+// once a second succeeds. A segment that was still open when the process
+// died keeps its zero-filled tail.
+//
+// Timestamps are cached per thread, so timestamp_cache_ms also bounds how
+// far apart two threads' clocks can drift in the output.
+
+struct MmapFileOptions {
+    size_t   segment_size       = 64 * 1024 * 1024;  // bytes per segment file
+    unsigned timestamp_cache_ms = 10;                // per-thread cache interval
+};
+
+// Counters since the file was opened.
+struct MmapFileStats {
+    uint64_t segments_created;
+    uint64_t segment_failures;   // segments that could not be created
+    uint64_t lines_dropped;      // lines logged while no segment was open
+};
+
+// Returns the mmap file backend. Log calls are dropped until
+// mmap_file_open() succeeds.
+LogBackend* mmap_file_backend();
+
+// Creates the first segment <path>.000000 (truncating any existing file of
+// that name) and starts accepting lines. Any previous file set is closed
+// first. Returns false if the segment cannot be created or mapped.
+bool mmap_file_open(const char* path, const MmapFileOptions& options = MmapFileOptions());
+
+// Stops accepting lines, waits for in-progress copies, and truncates the
+// current segment to its used length.
+void mmap_file_close();
+
+// Synchronously writes the current segment's dirty pages to disk (msync).
+void mmap_file_sync();
+
+// Returns the index of the segment currently receiving lines.
+unsigned mmap_file_segment_index();
+
+// Returns the sink's counters.
+MmapFileStats mmap_file_stats();
+
+// ----------------------------------------------------------------------------
+// Compressed file sink
+// ----------------------------------------------------------------------------
+
+// Writes log lines as a stream of independently compressed frames, for
+// verbose logs that are mostly repeated prefixes and format text. Lines
+// fill a block of block_size bytes; a full block is queued for a worker
+// thread that compresses it and appends one frame to the file, so the
+// logging thread never runs the codec. A producer only waits when
+// queue_depth blocks are already waiting for the worker.
+//
+// Frame layout (little-endian):
+//   uint32 magic        — "LJZF"
+//   uint8  codec        — CompressionCodec used for this frame
+//   uint8  reserved[3]
+//   uint32 raw_size     — bytes of log text in the frame
+//   uint32 stored_size  — bytes of payload following the header
+//   uint32 checksum     — FNV-1a of the raw text
+//   uint32 reserved
+//   uint64 first_us     — wall-clock time of the first line (us since epoch)
+//   uint64 last_us      — wall-clock time of the last line
+//   payload
+//
+// Every frame is decodable on its own. Alongside the data file, <path>.idx
+// receives one {first_us, last_us, offset} record (3 x uint64) per frame,
+// so a reader can seek to a time range without scanning the file. Blocks
+// that do not shrink are stored uncompressed.
+//
+// A frame whose write fails (disk full, file size limit) is dropped and
+// counted, and whatever part of it reached the file is truncated away, so
+// the next frame starts where the last complete one ended.
+
+enum CompressionCodec {
+    COMPRESSION_CODEC_NONE = 0,  // stored as-is
+    COMPRESSION_CODEC_LZ   = 1,  // built-in LZ77 codec, no dependencies
+    COMPRESSION_CODEC_ZLIB = 2   // deflate; only when built with zlib
+};
+
+struct CompressedFileOptions {
+    size_t           block_size         = 256 * 1024;            // raw bytes per frame
+    unsigned         queue_depth        = 4;                     // full blocks awaiting the worker
+    CompressionCodec codec              = COMPRESSION_CODEC_LZ;  // ZLIB falls back to LZ if unavailable
+    unsigned         timestamp_cache_ms = 10;                    // see builtin_set_timestamp_cache()
+};
+
+struct CompressedFileStats {
+    uint64_t frames_written;
+    uint64_t raw_bytes;          // log text before compression
+    uint64_t stored_bytes;       // frame payload bytes written
+    uint64_t producer_waits;     // times a producer found the queue full
+    uint64_t frames_dropped;     // blocks lost to a failed write
+};
+
+// Returns the compressed file backend. Log calls are dropped until
+// compressed_file_open() succeeds.
+LogBackend* compressed_file_backend();
+
+// Opens (or creates) path and its index for appending and starts the
+// worker. Any file already open is flushed and closed first. Returns false
+// on failure.
+bool compressed_file_open(const char* path,
+                          const CompressedFileOptions& options = CompressedFileOptions());
+
+// Writes out all pending lines, stops the worker and closes the files.
+void compressed_file_close();
+
+// Queues the partially filled block and waits until the worker has written
+// every queued frame. Also called by the backend's shutdown callback.
+void compressed_file_flush();
+
+// True if frames can be written and read with codec in this build.
+bool compressed_file_codec_supported(CompressionCodec codec);
+
+// Returns a snapshot of the sink's counters.
+CompressedFileStats compressed_file_stats();
+
+// Decodes the frames of a compressed log file whose time range overlaps
+// [from_us, to_us] (microseconds since the epoch) and writes their text to
+// out, oldest first. Uses <path>.idx to seek when present; filtering is per
+// frame, so lines just outside the range may be included. Decoding stops at
+// the first damaged frame (e.g. the tail of a crashed process). Returns the
+// number of frames written, or -1 if path cannot be opened.
+long compressed_file_decode(const char* path, FILE* out,
+                            uint64_t from_us = 0, uint64_t to_us = UINT64_MAX);
+
+// ----------------------------------------------------------------------------
+// Shared-memory sink
+// ----------------------------------------------------------------------------
+
+// Moves all formatting and I/O out of the process. Each log call copies the
+// level, a wall-clock timestamp and the message into a ring in a POSIX
+// shared memory object (layout in shm_ring.h); the lumberjack-drain tool
+// formats the records and writes them to a file or stdout, with rotation.
+// One drain can serve the rings of several processes.
+//
+// Producers never block: space is claimed with a CAS, and a record that
+// does not fit because the drain has fallen behind is dropped and counted.
+// The drain is only woken (futex) when it has gone to sleep on an empty
+// ring, so a busy drain costs the producer no syscalls.
+
+struct ShmRingOptions {
+    size_t capacity = 4 * 1024 * 1024;  // ring bytes, rounded up to a power of two
+};
+
+// Returns the shared-memory backend. Log calls are dropped until
+// shm_ring_open() succeeds.
+LogBackend* shm_ring_backend();
+
+// Creates (or reattaches to) the shared memory object name, e.g.
+// "/lumberjack.myapp". An existing ring of the same capacity keeps its
+// unconsumed records. Any ring already open is closed first. Returns false
+// if the object cannot be created or mapped.
+bool shm_ring_open(const char* name, const ShmRingOptions& options = ShmRingOptions());
+
+// Waits for in-progress writes and unmaps the ring. The object stays, so
+// the drain can finish reading it; remove it with shm_ring_remove().
+void shm_ring_close();
+
+// Removes the shared memory object name (shm_unlink). Mappings that are
+// still open remain valid.
+bool shm_ring_remove(const char* name);
+
+// Records dropped because the ring was full, since it was created.
+uint64_t shm_ring_dropped();
+
+// ----------------------------------------------------------------------------
+// Pipe sink
+// ----------------------------------------------------------------------------
+
+// Writes log lines to a pipe (e.g. the stdin of a local log shipper) without
+// the kernel copying the text. Lines fill page-aligned buffers; when one is
+// full its whole pages are handed to the pipe with vmsplice(SPLICE_F_GIFT),
+// which maps them into the pipe instead of copying them. Any partial page
+// at the end is carried into the next buffer.
+//
+// A spliced page stays referenced by the pipe until the reader consumes it,
+// so buffers are reused round-robin from a pool sized from the pipe's
+// capacity at open: between two uses of a buffer, at least twice as many
+// pages are spliced as the pipe can hold, so its earlier pages must have
+// been read. This assumes the reader copies data out with read(); a reader
+// that splices the pages onward may keep them longer than that.
+//
+// Flushes write the partially filled buffer with write(2). The sink uses
+// write(2) throughout when fd is not a pipe, vmsplice() is unavailable, or
+// force_write is set.
+//
+// SIGPIPE is blocked on the logging thread around each write() and
+// vmsplice(), so a reader that goes away does not kill the process: the
+// call fails with EPIPE, the signal it raised is consumed, and the sink
+// drops the unwritten bytes and every later line, counting both, until it
+// is opened again.
+
+struct PipeSinkOptions {
+    size_t   buffer_size        = 64 * 1024;  // rounded up to whole pages
+    unsigned buffer_count       = 0;          // raised to cover twice the pipe capacity
+    bool     force_write        = false;      // never use vmsplice()
+    unsigned timestamp_cache_ms = 10;         // see builtin_set_timestamp_cache()
+};
+
+struct PipeSinkStats {
+    uint64_t spliced_bytes;      // handed to the pipe by vmsplice()
+    uint64_t written_bytes;      // copied with write()
+    uint64_t buffers;            // size of the buffer pool
+    uint64_t dropped_bytes;      // not delivered because the pipe broke
+    uint64_t dropped_lines;      // logged after the pipe broke
+};
+
+// Returns the pipe sink backend. Log calls are dropped until
+// pipe_sink_open() succeeds.
+LogBackend* pipe_sink_backend();
+
+// Starts writing to fd, which stays owned by the caller and is not closed
+// by pipe_sink_close(). Any sink already open is flushed first. Returns
+// false if the buffers cannot be allocated.
+bool pipe_sink_open(int fd, const PipeSinkOptions& options = PipeSinkOptions());
+
+// Flushes pending lines and releases the buffers.
+void pipe_sink_close();
+
+// Writes the partially filled buffer to the pipe. Also called by the
+// backend's shutdown callback.
+void pipe_sink_flush();
+
+// True if full buffers are currently being handed over with vmsplice().
+bool pipe_sink_zero_copy();
+
+// Returns a snapshot of the sink's counters.
+PipeSinkStats pipe_sink_stats();
+
+// ----------------------------------------------------------------------------
+// Syslog sink
+// ----------------------------------------------------------------------------
+
+// Sends log records to the local syslog daemon or journald over a Unix
+// datagram socket, in the daemon's own protocol instead of going through
+// syslog(3) (one syscall per line):
+//   RFC 5424:  <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID - - MESSAGE
+//   journald:  PRIORITY=N / SYSLOG_IDENTIFIER / SYSLOG_PID / SYSLOG_FACILITY
+//              / MESSAGE fields (binary-safe encoding for multi-line text)
+// The constant parts of each datagram (priority prefix per level, host,
+// app name and pid) are formatted once at open and sent by scatter/gather.
+//
+// Records are queued in a batch of batch_size and sent with one sendmmsg()
+// call when the batch fills, or by a background thread every
+// flush_interval_ms. Sends never block: if the daemon's socket buffer is
+// full, unsent records stay queued, and a record that finds the queue still
+// full is dropped and counted. If the daemon restarts, the sink reconnects.
+
+enum SyslogFormat {
+    SYSLOG_FORMAT_RFC5424  = 0,  // /dev/log
+    SYSLOG_FORMAT_JOURNALD = 1   // /run/systemd/journal/socket
+};
+
+struct SyslogSinkOptions {
+    SyslogFormat format            = SYSLOG_FORMAT_RFC5424;
+    const char*  socket_path       = nullptr;  // nullptr = the format's default socket
+    const char*  app_name          = nullptr;  // nullptr = program name
+    int          facility          = 1;        // 1 = user; 16-23 = local0-local7
+    unsigned     batch_size        = 64;       // records per sendmmsg() call
+    unsigned     flush_interval_ms = 50;       // longest a record waits in the batch
+};
+
+struct SyslogSinkStats {
+    uint64_t records_sent;
+    uint64_t send_calls;         // sendmmsg() calls that sent at least one record
+    uint64_t dropped;            // records dropped because the queue stayed full
+};
+
+// Returns the syslog backend. Log calls are dropped until syslog_sink_open()
+// succeeds.
+LogBackend* syslog_sink_backend();
+
+// Connects to the daemon's socket and starts the flush thread. Any sink
+// already open is closed first. Returns false if the socket cannot be
+// connected.
+bool syslog_sink_open(const SyslogSinkOptions& options = SyslogSinkOptions());
+
+// Sends queued records, waiting up to a second for a full socket buffer to
+// drain, then disconnects. Records still unsent are counted as dropped.
+void syslog_sink_close();
+
+// Sends queued records without blocking. Also called by the backend's
+// shutdown callback.
+void syslog_sink_flush();
+
+// Returns a snapshot of the sink's counters.
+SyslogSinkStats syslog_sink_stats();
+
+// ----------------------------------------------------------------------------
+// Network sink
+// ----------------------------------------------------------------------------
+
+// Ships log lines straight to a remote collector. Lines are packed into
+// frames of up to frame_size bytes; full frames (and, every
+// flush_interval_ms, the partial one) are queued for a sender thread, so
+// the logging thread never touches the socket. A producer only waits when
+// queue_depth frames are already waiting for the sender.
+//
+// Framing within the byte stream (TCP) or datagram (UDP):
+//   NEWLINE        — "[timestamp] [LEVEL] message\n" per record
+//   LENGTH_PREFIX  — uint32 big-endian length, then the record without "\n"
+//
+// TCP: if the connection fails, the sender reconnects with exponential
+// backoff between reconnect_min_ms and reconnect_max_ms. While it is down,
+// frames are appended to spill_path (when set, up to spill_max_bytes;
+// beyond that they are dropped and counted) and replayed in order after
+// reconnecting, before any newer frame. A frame cut short by a failing
+// connection is resent whole, so delivery is at-least-once.
+//
+// UDP: each frame is one datagram, so frame_size is capped at 65000 bytes.
+// Datagrams that cannot be sent are dropped and counted; there is no spill.
+
+enum NetworkProtocol {
+    NETWORK_PROTOCOL_TCP = 0,
+    NETWORK_PROTOCOL_UDP = 1
+};
+
+enum NetworkFraming {
+    NETWORK_FRAMING_NEWLINE       = 0,
+    NETWORK_FRAMING_LENGTH_PREFIX = 1
+};
+
+struct NetworkSinkOptions {
+    NetworkProtocol protocol           = NETWORK_PROTOCOL_TCP;
+    NetworkFraming  framing            = NETWORK_FRAMING_NEWLINE;
+    size_t          frame_size         = 64 * 1024;
+    unsigned        queue_depth        = 16;                 // full frames awaiting the sender
+    unsigned        flush_interval_ms  = 100;                // longest a line waits in a frame
+    unsigned        reconnect_min_ms   = 100;
+    unsigned        reconnect_max_ms   = 10000;
+    const char*     spill_path         = nullptr;            // nullptr = drop while disconnected
+    size_t          spill_max_bytes    = 64 * 1024 * 1024;
+    unsigned        timestamp_cache_ms = 10;                 // see builtin_set_timestamp_cache()
+};
+
+struct NetworkSinkStats {
+    uint64_t frames_sent;
+    uint64_t bytes_sent;         // including replayed spill data
+    uint64_t connects;           // successful (re)connections
+    uint64_t spilled_bytes;      // written to the spill file
+    uint64_t dropped_frames;     // neither sent nor spilled
+    uint64_t producer_waits;     // times a producer found the queue full
+};
+
+// Returns the network backend. Log calls are dropped until
+// network_sink_open() succeeds.
+LogBackend* network_sink_backend();
+
+// Starts the sender for host:port (name or numeric address). The first
+// connection is made by the sender thread, so a collector that is down at
+// startup is handled like any outage. Any sink already open is closed
+// first. Returns false if host cannot be resolved or the spill file cannot
+// be opened.
+bool network_sink_open(const char* host, unsigned port,
+                       const NetworkSinkOptions& options = NetworkSinkOptions());
+
+// Sends (or spills) all pending lines and stops the sender. A spill file
+// that could not be replayed is kept for the next open.
+void network_sink_close();
+
+// Queues the partial frame and waits until the sender has sent, spilled or
+// dropped every queued frame. Also called by the backend's shutdown callback.
+void network_sink_flush();
+
+// True while the sender has a live TCP connection (always true for UDP).
+bool network_sink_connected();
+
+// Returns a snapshot of the sink's counters.
+NetworkSinkStats network_sink_stats();
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_SINKS_H
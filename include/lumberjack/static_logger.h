@@ -0,0 +1,101 @@
+// static_logger.h — Loggers bound to their backend at compile time.
+//
+// The LOG_* macros make two indirect calls per enabled line: the dispatch
+// table entry, then the active backend's log_write. Neither can be inlined,
+// even in a binary that only ever uses one backend. StaticLogger<Backend>
+// takes the backend as a type instead: the level check, the formatting call
+// and Backend::write are ordinary calls the compiler can inline and
+// specialize, and a disabled line costs one load and a predictable branch
+// without evaluating its arguments.
+//
+// A backend is any type with a static write function:
+//
+//   struct MyBackend {
+//       static void write(lumberjack::LogLevel level, const char* message, size_t length);
+//   };
+//
+// message is NUL-terminated and length bytes long. Backends handle their
+// own thread safety, like LogBackend implementations.
+//
+// Usage:
+//   using AppLog = lumberjack::StaticLogger<MyBackend>;
+//   AppLog::set_level(lumberjack::LOG_LEVEL_DEBUG);
+//   SLOG_INFO(AppLog, "listening on port %d", port);
+//
+// The level is per logger type, independent of set_level(). Lines do not
+// pass through the runtime backend, batching or the builtin_set_*()
+// configuration unless the backend forwards them (BuiltinStaticBackend,
+// ActiveStaticBackend).
+
+#ifndef LUMBERJACK_STATIC_LOGGER_H
+#define LUMBERJACK_STATIC_LOGGER_H
+
+#include "lumberjack/lumberjack.h"
+#include "lumberjack/builtin_logger.h"
+#include <atomic>
+#include <cstdio>
+
+namespace lumberjack {
+
+template <typename Backend>
+class StaticLogger {
+public:
+    // Most verbose level written (default LOG_LEVEL_INFO).
+    static void set_level(LogLevel level) { s_level.store(level, std::memory_order_relaxed); }
+    static LogLevel level() { return static_cast<LogLevel>(s_level.load(std::memory_order_relaxed)); }
+
+    static bool enabled(LogLevel level) {
+        return level <= s_level.load(std::memory_order_relaxed) && level > LOG_LEVEL_NONE;
+    }
+
+    // Formats and writes one line if level is enabled.
+    template <typename... Args>
+    LUMBERJACK_ALWAYS_INLINE static void log(LogLevel level, const char* fmt, Args... args) {
+        if (enabled(level)) write_formatted(level, fmt, args...);
+    }
+
+    // Formats and writes one line without the level check; the SLOG_*
+    // macros call it after checking enabled() themselves.
+    template <typename... Args>
+    LUMBERJACK_ALWAYS_INLINE static void write_formatted(LogLevel level, const char* fmt, Args... args) {
+        char buffer[1024];
+        int len = snprintf(buffer, sizeof(buffer), fmt, args...);
+        if (len < 0) return;
+        if (static_cast<size_t>(len) >= sizeof(buffer)) len = sizeof(buffer) - 1;
+        Backend::write(level, buffer, static_cast<size_t>(len));
+    }
+
+private:
+    static inline std::atomic<int> s_level{LOG_LEVEL_INFO};
+};
+
+// Writes to the default built-in instance (builtin_logger()), with its
+// output, buffering and queue settings. One direct call into the library.
+struct BuiltinStaticBackend {
+    static void write(LogLevel level, const char* message, size_t) {
+        builtin_logger().write(level, message);
+    }
+};
+
+// Writes to whichever backend set_backend() installed: the runtime path
+// without the dispatch table.
+struct ActiveStaticBackend {
+    static void write(LogLevel level, const char* message, size_t) {
+        get_backend()->log_write(level, message);
+    }
+};
+
+} // namespace lumberjack
+
+// Log through a StaticLogger type (use an alias for template arguments).
+// Arguments are only evaluated when the level is enabled.
+#define SLOG_AT(logger, level, fmt, ...) \
+    do { \
+        if (logger::enabled(level)) logger::write_formatted(level, fmt, ##__VA_ARGS__); \
+    } while (0)
+#define SLOG_ERROR(logger, fmt, ...) SLOG_AT(logger, lumberjack::LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define SLOG_WARN(logger, fmt, ...)  SLOG_AT(logger, lumberjack::LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define SLOG_INFO(logger, fmt, ...)  SLOG_AT(logger, lumberjack::LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define SLOG_DEBUG(logger, fmt, ...) SLOG_AT(logger, lumberjack::LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+
+#endif // LUMBERJACK_STATIC_LOGGER_H
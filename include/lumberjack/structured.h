@@ -0,0 +1,151 @@
+// structured.h — Key-value logging with typed fields.
+//
+// LOG_*_KV lines carry a constant message and a list of typed fields
+// instead of a printf format:
+//
+//   LOG_INFO_KV("request done", kv("status", code), kv("latency_us", us));
+//
+// The fields reach the backend as LogField values — integers, doubles,
+// booleans and strings, each with its key — so nothing is formatted into a
+// string and parsed back downstream. Backends that set log_write_kv get the
+// record and its fields as they are. Every other backend gets the line as
+// text, "request done status=200 latency_us=17", through the usual path
+// (batching included). The built-in backend writes fields in its output
+// format (builtin_set_output_format()): appended to the message as
+// key=value, as logfmt, or as JSON members.
+//
+// Numbers are written straight into the output buffer with dedicated
+// integer and shortest-round-trip double routines; no format string is
+// parsed for a field.
+//
+// String fields are not copied when the line is logged: keep them alive
+// for the duration of the LOG_*_KV call. A temporary std::string passed to
+// kv() is fine, since it lives until the end of the LOG_*_KV statement;
+// a LogField kept past that must not point into one.
+
+#ifndef LUMBERJACK_STRUCTURED_H
+#define LUMBERJACK_STRUCTURED_H
+
+#include "lumberjack/lumberjack.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace lumberjack {
+
+enum FieldType : uint8_t {
+    FIELD_INT,
+    FIELD_UINT,
+    FIELD_DOUBLE,
+    FIELD_BOOL,
+    FIELD_STRING
+};
+
+// One key-value pair. key is written as is and should be a plain
+// identifier; string values are escaped as the output format requires.
+struct LogField {
+    const char* key;
+    FieldType   type;
+    union {
+        long long          i;
+        unsigned long long u;
+        double             d;
+        bool               b;
+        struct {
+            const char* data;
+            size_t      length;
+        } s;
+    } value;
+};
+
+// kv() builds a LogField, picking the type from the value.
+template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+inline LogField kv(const char* key, T value) {
+    LogField field = { key, FIELD_INT, {} };
+    field.value.i = value;
+    return field;
+}
+
+template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                                              !std::is_same<T, bool>::value, int>::type = 0>
+inline LogField kv(const char* key, T value) {
+    LogField field = { key, FIELD_UINT, {} };
+    field.value.u = value;
+    return field;
+}
+
+inline LogField kv(const char* key, double value) {
+    LogField field = { key, FIELD_DOUBLE, {} };
+    field.value.d = value;
+    return field;
+}
+
+inline LogField kv(const char* key, bool value) {
+    LogField field = { key, FIELD_BOOL, {} };
+    field.value.b = value;
+    return field;
+}
+
+inline LogField kv(const char* key, std::string_view value) {
+    LogField field = { key, FIELD_STRING, {} };
+    field.value.s.data = value.data();
+    field.value.s.length = value.size();
+    return field;
+}
+
+inline LogField kv(const char* key, const char* value) {
+    return kv(key, value ? std::string_view(value) : std::string_view("(null)"));
+}
+
+inline LogField kv(const char* key, const std::string& value) {
+    return kv(key, std::string_view(value));
+}
+
+inline LogField kv(const char* key, float value) {
+    return kv(key, static_cast<double>(value));
+}
+
+// Appends each field to out in format: " key=value" for OUTPUT_TEXT and
+// OUTPUT_LOGFMT, ",\"key\":value" for OUTPUT_JSON. Strings are quoted and
+// escaped where the format needs it; doubles that are NaN or infinite are
+// written as NaN / +Inf / -Inf (null in JSON). Fields that do not fit in
+// capacity are left out whole. Returns the bytes written; no NUL is added.
+size_t render_fields(char* out, size_t capacity, OutputFormat format, const LogField* fields, size_t count);
+
+// Writes text as a value in format: unchanged for OUTPUT_TEXT, quoted when
+// it contains spaces, '=', quotes or control bytes for OUTPUT_LOGFMT, and
+// always quoted for OUTPUT_JSON. Text that does not fit is cut, never
+// inside an escape sequence, and the closing quote is kept.
+// Returns the bytes written.
+size_t render_string(char* out, size_t capacity, OutputFormat format, const char* text, size_t length);
+
+// Picks the KV dispatch table entry for a LOG_*_KV call. The fields are
+// laid out in an array on the caller's stack; a disabled level costs one
+// table call, and building the fields copies their values but formats
+// nothing.
+template <typename... Fields>
+LUMBERJACK_ALWAYS_INLINE void log_kv(LogLevel level, const char* file, int line,
+                                     const char* message, const Fields&... fields) {
+    if constexpr (sizeof...(Fields) == 0) {
+        t_dispatch->kv[level](level, file, line, message, nullptr, 0);
+    } else {
+        const LogField array[] = { fields... };
+        t_dispatch->kv[level](level, file, line, message, array, sizeof...(Fields));
+    }
+}
+
+} // namespace lumberjack
+
+// Structured logging macros: a constant message, then kv() fields.
+#define LOG_ERROR_KV(message, ...) \
+    lumberjack::log_kv(lumberjack::LOG_LEVEL_ERROR, __FILE__, __LINE__, message, ##__VA_ARGS__)
+#define LOG_WARN_KV(message, ...) \
+    lumberjack::log_kv(lumberjack::LOG_LEVEL_WARN, __FILE__, __LINE__, message, ##__VA_ARGS__)
+#define LOG_INFO_KV(message, ...) \
+    lumberjack::log_kv(lumberjack::LOG_LEVEL_INFO, __FILE__, __LINE__, message, ##__VA_ARGS__)
+#define LOG_DEBUG_KV(message, ...) \
+    lumberjack::log_kv(lumberjack::LOG_LEVEL_DEBUG, __FILE__, __LINE__, message, ##__VA_ARGS__)
+
+#endif // LUMBERJACK_STRUCTURED_H
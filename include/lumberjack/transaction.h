@@ -0,0 +1,83 @@
+// transaction.h — Request-scoped buffering with keep-on-error tail sampling.
+//
+// A LogTransaction holds back every line its thread logs while it is open,
+// at any level — DEBUG included, even when set_level() leaves DEBUG off —
+// in a thread-local buffer. When the scope ends the lines are either
+// dropped, or handed to the active backend as one run of records with
+// their original capture times, call sites and context:
+//
+//   void handle(const Request& req) {
+//       lumberjack::LogTransaction tx;
+//       LOG_DEBUG("parsed %zu headers", n);    // held
+//       if (!authorize(req)) LOG_ERROR("denied");   // the lines are kept
+//   }   // kept: delivered now; otherwise dropped
+//
+// A transaction is kept when it saw a line at keep_level or more severe,
+// when it lasted slow_us or longer, when it ends because an exception is
+// unwinding the stack, or when keep() was called. Successful requests then
+// cost a copy of each line into memory and no I/O.
+//
+// Lines that do not fit in max_bytes are dropped; a kept transaction ends
+// with a WARN line saying how many. A transaction opened while another is
+// open on the thread joins it: its lines, keep() and exit conditions go to
+// the outer one, which decides.
+//
+// Only the thread's LOG_* lines are held. Span output, BuiltinLogger and
+// StaticLogger lines pass straight through. LOG_*_KV lines are held (and
+// committed) as text, "message key=value ...".
+//
+// The first LogTransaction points the disabled levels of the dispatch
+// tables at capture functions, which return at once on threads without a
+// transaction; before that, disabled lines stay plain no-op calls.
+
+#ifndef LUMBERJACK_TRANSACTION_H
+#define LUMBERJACK_TRANSACTION_H
+
+#include "lumberjack/lumberjack.h"
+#include <chrono>
+#include <cstddef>
+
+namespace lumberjack {
+
+// Settings for a LogTransaction.
+//   keep_level    — a line this severe or more keeps the transaction
+//                   (default LOG_LEVEL_ERROR).
+//   slow_us       — a transaction open this long or longer is kept; 0
+//                   turns the check off.
+//   capture_level — most verbose level held; lines beyond it are neither
+//                   held nor (if disabled) logged.
+//   max_bytes     — buffer size; lines beyond it are dropped.
+struct TransactionOptions {
+    LogLevel  keep_level    = LOG_LEVEL_ERROR;
+    long long slow_us       = 0;
+    LogLevel  capture_level = LOG_LEVEL_DEBUG;
+    size_t    max_bytes     = 64 * 1024;
+};
+
+class LogTransaction {
+public:
+    explicit LogTransaction(const TransactionOptions& options = TransactionOptions());
+
+    // Delivers the held lines if the transaction is kept, drops them
+    // otherwise.
+    ~LogTransaction();
+
+    // Keeps the transaction whatever happens next.
+    void keep();
+
+    LogTransaction(const LogTransaction&) = delete;
+    LogTransaction& operator=(const LogTransaction&) = delete;
+
+    struct State;
+
+private:
+    State*    m_state;
+    bool      m_owner;        // false when joined to an enclosing transaction
+    int       m_exceptions;   // std::uncaught_exceptions() when opened
+    long long m_slowUs;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_TRANSACTION_H
@@ -1,12 +1,16 @@
 #ifndef LUMBERJACK_UTILS_H
 #define LUMBERJACK_UTILS_H
 
+#include "lumberjack/lumberjack.h"
+#include <cerrno>
 #include <cstdio>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <chrono>
 #include <mutex>
+#include <unistd.h>
 
 namespace lumberjack {
 
@@ -15,7 +19,7 @@ namespace lumberjack {
 // ----------------------------------------------------------------------------
 
 // Caches a formatted timestamp string and only refreshes when the configured
-// interval has elapsed. Avoids calling localtime() + strftime() on every
+// interval has elapsed. Avoids calling localtime_r() + strftime() on every
 // log line in high-throughput scenarios.
 //
 // Usage:
@@ -38,14 +42,16 @@ public:
     // Returns the cached value if still fresh, otherwise recomputes.
     // Sets did_refresh to true when the timestamp was recomputed.
     const char* get(bool* did_refresh = nullptr) {
-        if (m_interval_ms == 0) {
-            refresh();
-            if (did_refresh) *did_refresh = true;
-            return m_buf;
-        }
-        auto now = std::chrono::steady_clock::now();
-        if (now >= m_expiry) {
-            refresh();
+        return get_at(std::chrono::system_clock::now(), did_refresh);
+    }
+
+    // Same as get(), for a time the caller already read (e.g. a
+    // LogRecord's capture time). A time before the cached one recomputes,
+    // so the clock stepping back or an older record is never stamped late.
+    const char* get_at(std::chrono::system_clock::time_point now, bool* did_refresh = nullptr) {
+        if (m_interval_ms == 0 || now >= m_expiry || now < m_stamped) {
+            refresh(now);
+            m_stamped = now;
             m_expiry = now + std::chrono::milliseconds(m_interval_ms);
             if (did_refresh) *did_refresh = true;
         } else {
@@ -54,19 +60,39 @@ public:
         return m_buf;
     }
 
+    // Returns the most recently formatted timestamp without refreshing it
+    // (empty before the first get()). Safe to call from a signal handler.
+    const char* last() const { return m_buf; }
+
 private:
     unsigned int m_interval_ms = 0;
     char m_buf[32] = {};
-    std::chrono::steady_clock::time_point m_expiry = {};
+    std::chrono::system_clock::time_point m_stamped = {};
+    std::chrono::system_clock::time_point m_expiry = {};
+
+    std::time_t m_second = -1;   // second whose date m_buf holds
 
-    void refresh() {
-        auto now = std::chrono::system_clock::now();
+    // localtime_r() + strftime() run once per second; within a second only
+    // the three millisecond digits change. localtime_r, because caches of
+    // different loggers and sinks refresh under different locks.
+    void refresh(std::chrono::system_clock::time_point now) {
         auto tt  = std::chrono::system_clock::to_time_t(now);
         auto ms  = std::chrono::duration_cast<std::chrono::milliseconds>(
             now.time_since_epoch()) % 1000;
-        char date[24];
-        std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&tt));
-        snprintf(m_buf, sizeof(m_buf), "%s.%03lld", date, static_cast<long long>(ms.count()));
+        if (tt != m_second) {
+            char date[24];
+            std::tm tm;
+            localtime_r(&tt, &tm);
+            std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm);
+            snprintf(m_buf, sizeof(m_buf), "%s.%03lld", date, static_cast<long long>(ms.count()));
+            m_second = tt;
+            return;
+        }
+        size_t len = strlen(m_buf);
+        int value = static_cast<int>(ms.count());
+        m_buf[len - 3] = static_cast<char>('0' + value / 100);
+        m_buf[len - 2] = static_cast<char>('0' + value / 10 % 10);
+        m_buf[len - 1] = static_cast<char>('0' + value % 10);
     }
 };
 
@@ -152,6 +178,11 @@ public:
 
     bool is_enabled() const { return m_enabled; }
 
+    // Buffered bytes not yet flushed. Used by crash flush hooks, which write
+    // them with write(2) since stdio is not async-signal-safe.
+    const char* data() const { return m_buf; }
+    size_t pending() const { return m_pos; }
+
 private:
     bool   m_enabled = false;
     char*  m_buf     = nullptr;
@@ -159,6 +190,189 @@ private:
     size_t m_pos     = 0;
 };
 
+// ----------------------------------------------------------------------------
+// Crash-safe output helpers
+// ----------------------------------------------------------------------------
+
+// Helpers for crash flush hooks (see install_crash_handler()). They only use
+// async-signal-safe calls — no stdio, no allocation, no locks.
+
+// Writes all len bytes to fd, retrying on short writes and EINTR.
+// Returns false if the descriptor reports an error.
+inline bool crash_write(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Formats ms since the epoch, shifted by gmtoff seconds, as
+// "YYYY-MM-DD HH:MM:SS.mmm" into out (at least 24 bytes). Pure arithmetic,
+// so it is safe in a signal handler, where localtime_r() is not; the
+// caller supplies the UTC offset from an earlier localtime_r().
+inline size_t format_epoch_ms(char* out, long long ms, long gmtoff) {
+    long long secs = ms / 1000 + gmtoff;
+    long long days = secs / 86400;
+    long long rem = secs % 86400;
+    if (rem < 0) {
+        rem += 86400;
+        days--;
+    }
+    // Civil date from days since 1970-01-01 (proleptic Gregorian).
+    long long z = days + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    long long day = doy - (153 * mp + 2) / 5 + 1;
+    long long month = mp < 10 ? mp + 3 : mp - 9;
+    long long year = yoe + era * 400 + (month <= 2);
+
+    auto put = [&](size_t pos, long long value, int width) {
+        for (int i = width - 1; i >= 0; i--) {
+            out[pos + i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    };
+    put(0, year, 4);
+    out[4] = '-';
+    put(5, month, 2);
+    out[7] = '-';
+    put(8, day, 2);
+    out[10] = ' ';
+    put(11, rem / 3600, 2);
+    out[13] = ':';
+    put(14, rem / 60 % 60, 2);
+    out[16] = ':';
+    put(17, rem % 60, 2);
+    out[19] = '.';
+    put(20, ms % 1000, 3);
+    out[23] = '\0';
+    return 23;
+}
+
+// Formats "[timestamp] [ERROR] crashed with signal N\n" into out (which
+// should hold at least 96 bytes) and returns its length. An empty timestamp
+// is replaced by "-".
+inline size_t format_crash_line(char* out, size_t size, const char* timestamp, int signo) {
+    size_t pos = 0;
+    auto put = [&](const char* s) {
+        while (*s && pos + 1 < size) out[pos++] = *s++;
+    };
+    char digits[12];
+    size_t nd = 0;
+    unsigned value = signo < 0 ? 0u : static_cast<unsigned>(signo);
+    do {
+        digits[nd++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value && nd < sizeof(digits));
+
+    put("[");
+    put(timestamp && *timestamp ? timestamp : "-");
+    put("] [ERROR] crashed with signal ");
+    while (nd > 0 && pos + 1 < size) out[pos++] = digits[--nd];
+    put("\n");
+    if (size > 0) out[pos] = '\0';
+    return pos;
+}
+
+// ----------------------------------------------------------------------------
+// Level tags
+// ----------------------------------------------------------------------------
+
+// Level tags, padded to five characters, as the text sinks, the %L pattern
+// field and lumberjack-drain write them.
+inline constexpr const char* LEVEL_STRINGS[LOG_COUNT] = {
+    "NONE ", "ERROR", "WARN ", "INFO ", "DEBUG"
+};
+
+// ----------------------------------------------------------------------------
+// Number formatting
+// ----------------------------------------------------------------------------
+
+// Writes value in decimal at out, which must have room for 20 bytes, and
+// returns the digit count. Two digits per division, no locale and no NUL;
+// used by pattern layouts and structured fields in place of snprintf.
+inline size_t format_uint(char* out, uint64_t value) {
+    static const char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char digits[20];
+    size_t pos = sizeof(digits);
+    while (value >= 100) {
+        unsigned pair = static_cast<unsigned>(value % 100) * 2;
+        value /= 100;
+        digits[--pos] = pairs[pair + 1];
+        digits[--pos] = pairs[pair];
+    }
+    if (value >= 10) {
+        unsigned pair = static_cast<unsigned>(value) * 2;
+        digits[--pos] = pairs[pair + 1];
+        digits[--pos] = pairs[pair];
+    } else {
+        digits[--pos] = static_cast<char>('0' + value);
+    }
+    size_t n = sizeof(digits) - pos;
+    memcpy(out, digits + pos, n);
+    return n;
+}
+
+// As format_uint() for a signed value; out needs room for 20 bytes.
+inline size_t format_int(char* out, int64_t value) {
+    if (value >= 0) return format_uint(out, static_cast<uint64_t>(value));
+    out[0] = '-';
+    return 1 + format_uint(out + 1, 0 - static_cast<uint64_t>(value));
+}
+
+// ----------------------------------------------------------------------------
+// Escaping kernels
+// ----------------------------------------------------------------------------
+
+// Scanning for bytes that need escaping runs over every byte of every
+// JSON or logfmt message, so it is vectorized: 32 bytes per step with
+// AVX2, 16 with SSE2, picked for the CPU on first use, with a scalar
+// fallback elsewhere. Runs of clean bytes are copied with memcpy; only the
+// bytes found are handled one at a time. The built-in backend's JSON and
+// logfmt output uses these; custom backends can too.
+
+enum EscapeKernel {
+    ESCAPE_SCALAR,
+    ESCAPE_SSE2,
+    ESCAPE_AVX2
+};
+
+// Index of the first byte of text that needs an escape inside a JSON (or
+// quoted logfmt) string — a control byte below 0x20, DEL, '"' or '\\' —
+// or length if there is none.
+size_t find_escape(const char* text, size_t length);
+
+// Index of the first control byte (below 0x20, or DEL), or length.
+size_t find_control(const char* text, size_t length);
+
+// Writes text escaped for the inside of a JSON string: \" \\ \n \r \t,
+// and \u00XX for other control bytes and DEL. Stops when out is full,
+// never inside an escape sequence; *consumed (if given) is set to the
+// number of input bytes written. Returns the bytes written; no NUL or
+// quotes are added.
+size_t escape_json(char* out, size_t capacity, const char* text, size_t length, size_t* consumed = nullptr);
+
+// Replaces every control byte and DEL in text with a space, making it safe
+// to write as one line. Returns the number of bytes replaced.
+size_t sanitize_control(char* text, size_t length);
+
+// The kernel in use, and a way to pick one (for tests and benchmarks).
+// set_escape_kernel() returns false, changing nothing, if the CPU or the
+// build lacks the instruction set. Calls escaping on other threads at the
+// same time use the old or the new kernel.
+EscapeKernel escape_kernel();
+bool set_escape_kernel(EscapeKernel kernel);
+
 } // namespace lumberjack
 
 #endif // LUMBERJACK_UTILS_H
@@ -0,0 +1,614 @@
+// async_file.cpp — Block-based asynchronous file sink.
+//
+// Producers format lines into the current block under a mutex. A full block
+// is stamped with its file offset and queued for the writer; the producer
+// immediately continues in a block taken from the free pool. The writer is
+// either a single io_uring submitter/reaper thread or a small pool of
+// pwrite() threads. Completed blocks return to the free pool.
+
+#include "lumberjack/sinks.h"
+#include "lumberjack/utils.h"
+#include "sink_common.h"
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define LUMBERJACK_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace lumberjack {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Block {
+    char*                 data   = nullptr;
+    size_t                len    = 0;  // bytes filled by producers
+    size_t                done   = 0;  // bytes confirmed written
+    uint64_t              offset = 0;  // file offset assigned at hand-off
+    unsigned              index  = 0;  // registered buffer index
+    volatile sig_atomic_t queued = 0;  // offset assigned, not yet recycled
+    Clock::time_point     handed_off;
+    struct iovec          iov;         // used by the unregistered io_uring path
+};
+
+#ifdef LUMBERJACK_HAVE_IO_URING
+
+// ---------------------------------------------------------------------------
+// Minimal io_uring wrapper over the raw syscalls (no liburing dependency).
+// Only the writer thread touches the rings, so no locking is needed.
+// ---------------------------------------------------------------------------
+class UringRing {
+public:
+    ~UringRing() { close(); }
+
+    bool open(unsigned entries) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        if (fd < 0) return false;
+        m_fd = fd;
+
+        m_sqLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_cqLen = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) m_sqLen = m_cqLen = (m_sqLen > m_cqLen ? m_sqLen : m_cqLen);
+
+        m_sqMap = mmap(nullptr, m_sqLen, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        if (m_sqMap == MAP_FAILED) { m_sqMap = nullptr; close(); return false; }
+        if (single) {
+            m_cqMap = m_sqMap;
+        } else {
+            m_cqMap = mmap(nullptr, m_cqLen, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+            if (m_cqMap == MAP_FAILED) { m_cqMap = nullptr; close(); return false; }
+        }
+        m_sqesLen = p.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, m_sqesLen, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) { close(); return false; }
+        m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(m_sqMap);
+        char* cq = static_cast<char*>(m_cqMap);
+        m_sqHead  = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        m_sqTail  = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        m_sqMask  = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        m_cqHead  = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        m_cqTail  = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        m_cqMask  = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        m_cqes    = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        m_entries = p.sq_entries;
+        return true;
+    }
+
+    void close() {
+        if (m_sqes)  munmap(m_sqes, m_sqesLen);
+        if (m_cqMap && m_cqMap != m_sqMap) munmap(m_cqMap, m_cqLen);
+        if (m_sqMap) munmap(m_sqMap, m_sqLen);
+        if (m_fd >= 0) ::close(m_fd);
+        m_sqes = nullptr;
+        m_sqMap = m_cqMap = nullptr;
+        m_fd = -1;
+    }
+
+    bool register_buffers(const struct iovec* iovs, unsigned count) {
+        return syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS,
+                       iovs, count) == 0;
+    }
+
+    // Stages a write of [data, data+len) at offset. Returns false when the
+    // submission queue is full (cannot happen while in-flight <= entries).
+    bool prep_write(int fd, Block* b, const char* data, unsigned len,
+                    uint64_t offset, bool fixed) {
+        unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        unsigned tail = *m_sqTail + m_staged;
+        if (tail - head >= m_entries) return false;
+
+        unsigned idx = tail & m_sqMask;
+        io_uring_sqe* sqe = &m_sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = fd;
+        sqe->off = offset;
+        sqe->user_data = reinterpret_cast<uint64_t>(b);
+        if (fixed) {
+            sqe->opcode    = IORING_OP_WRITE_FIXED;
+            sqe->addr      = reinterpret_cast<uint64_t>(data);
+            sqe->len       = len;
+            sqe->buf_index = static_cast<uint16_t>(b->index);
+        } else {
+            b->iov.iov_base = const_cast<char*>(data);
+            b->iov.iov_len  = len;
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr   = reinterpret_cast<uint64_t>(&b->iov);
+            sqe->len    = 1;
+        }
+        m_sqArray[idx] = idx;
+        m_staged++;
+        return true;
+    }
+
+    // Publishes staged SQEs and optionally waits for at least one completion.
+    bool submit(bool wait) {
+        unsigned to_submit = m_staged;
+        if (to_submit) {
+            __atomic_store_n(m_sqTail, *m_sqTail + to_submit, __ATOMIC_RELEASE);
+            m_staged = 0;
+        }
+        if (!to_submit && !wait) return true;
+        unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+        for (;;) {
+            long r = syscall(__NR_io_uring_enter, m_fd, to_submit, wait ? 1u : 0u,
+                             flags, nullptr, 0);
+            if (r >= 0) return true;
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) return false;
+            if (errno == EINTR && !wait) return true;
+        }
+    }
+
+    // Calls fn(block, result) for every available completion.
+    template <typename Fn>
+    void reap(Fn&& fn) {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+            fn(reinterpret_cast<Block*>(cqe.user_data), cqe.res);
+            head++;
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    int           m_fd      = -1;
+    void*         m_sqMap   = nullptr;
+    void*         m_cqMap   = nullptr;
+    size_t        m_sqLen   = 0;
+    size_t        m_cqLen   = 0;
+    size_t        m_sqesLen = 0;
+    io_uring_sqe* m_sqes    = nullptr;
+    unsigned*     m_sqHead  = nullptr;
+    unsigned*     m_sqTail  = nullptr;
+    unsigned*     m_sqArray = nullptr;
+    unsigned      m_sqMask  = 0;
+    unsigned*     m_cqHead  = nullptr;
+    unsigned*     m_cqTail  = nullptr;
+    unsigned      m_cqMask  = 0;
+    io_uring_cqe* m_cqes    = nullptr;
+    unsigned      m_entries = 0;
+    unsigned      m_staged  = 0;
+};
+
+#endif // LUMBERJACK_HAVE_IO_URING
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// State
+// ---------------------------------------------------------------------------
+
+// Producer side — guarded by g_mutex.
+static std::mutex     g_mutex;
+static TimestampCache g_tsCache;
+static Block*         g_current = nullptr;
+static size_t         g_blockSize = 0;
+static bool           g_open = false;
+
+// Writer side — guarded by g_queueMutex.
+static std::mutex              g_queueMutex;
+static std::condition_variable g_readyCv;   // writers wait for work
+static std::condition_variable g_freeCv;    // producers/flushers wait for blocks
+static std::deque<Block*>      g_ready;
+static std::vector<Block*>     g_free;
+static std::vector<Block>      g_blocks;
+static uint64_t                g_nextOffset = 0;
+static bool                    g_stopping = false;
+
+// Set while the pool and file are valid; checked by the crash flush hook.
+static volatile sig_atomic_t g_crashFlushReady = 0;
+
+static std::vector<std::thread> g_writers;
+static int                      g_fd = -1;
+static AsyncFileEngine          g_engine = ASYNC_FILE_ENGINE_NONE;
+
+#ifdef LUMBERJACK_HAVE_IO_URING
+static UringRing g_ring;
+static bool      g_fixedBuffers = false;
+#endif
+
+static std::atomic<uint64_t> g_statBlocks{0};
+static std::atomic<uint64_t> g_statBytes{0};
+static std::atomic<uint64_t> g_statErrors{0};
+static std::atomic<uint64_t> g_statWaits{0};
+static std::atomic<uint64_t> g_statLatencyTotal{0};
+static std::atomic<uint64_t> g_statLatencyMax{0};
+
+// Joins the writer threads at exit if the application never closed the
+// file — destroying a joinable std::thread would terminate the process.
+static CloseAtExit<async_file_close> g_autoClose;
+
+// ---------------------------------------------------------------------------
+// Block pool
+// ---------------------------------------------------------------------------
+
+// Returns a finished block to the pool and records its completion latency.
+static void recycle(Block* b, bool ok) {
+    auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - b->handed_off).count());
+    if (ok) {
+        g_statBlocks.fetch_add(1, std::memory_order_relaxed);
+        g_statBytes.fetch_add(b->len, std::memory_order_relaxed);
+    } else {
+        g_statErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    g_statLatencyTotal.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t prev = g_statLatencyMax.load(std::memory_order_relaxed);
+    while (ns > prev && !g_statLatencyMax.compare_exchange_weak(prev, ns)) {}
+
+    std::lock_guard<std::mutex> lock(g_queueMutex);
+    b->queued = 0;
+    b->len = 0;
+    b->done = 0;
+    g_free.push_back(b);
+    g_freeCv.notify_all();
+}
+
+// Takes a free block, waiting for a completion if the pool is exhausted.
+// Caller holds g_mutex.
+static Block* acquire_block() {
+    std::unique_lock<std::mutex> lock(g_queueMutex);
+    if (g_free.empty()) {
+        g_statWaits.fetch_add(1, std::memory_order_relaxed);
+        g_freeCv.wait(lock, [] { return !g_free.empty(); });
+    }
+    Block* b = g_free.back();
+    g_free.pop_back();
+    return b;
+}
+
+// Assigns the next file offset to the current block and queues it.
+// Caller holds g_mutex.
+static void hand_off_current() {
+    Block* b = g_current;
+    g_current = nullptr;
+    if (!b) return;
+    if (b->len == 0) {
+        std::lock_guard<std::mutex> lock(g_queueMutex);
+        g_free.push_back(b);
+        return;
+    }
+    b->handed_off = Clock::now();
+    std::lock_guard<std::mutex> lock(g_queueMutex);
+    b->offset = g_nextOffset;
+    b->queued = 1;
+    g_nextOffset += b->len;
+    g_ready.push_back(b);
+    g_readyCv.notify_one();
+}
+
+// ---------------------------------------------------------------------------
+// Writers
+// ---------------------------------------------------------------------------
+
+// Writes a block synchronously at its preassigned offset and recycles it.
+static void write_sync(Block* b) {
+    bool ok = true;
+    while (b->done < b->len) {
+        ssize_t n = pwrite(g_fd, b->data + b->done, b->len - b->done,
+                           static_cast<off_t>(b->offset + b->done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { ok = false; break; }
+        b->done += static_cast<size_t>(n);
+    }
+    recycle(b, ok);
+}
+
+// pwrite() fallback: each thread takes the oldest ready block and writes it
+// at its preassigned offset.
+static void thread_writer() {
+    for (;;) {
+        Block* b;
+        {
+            std::unique_lock<std::mutex> lock(g_queueMutex);
+            g_readyCv.wait(lock, [] { return !g_ready.empty() || g_stopping; });
+            if (g_ready.empty()) return;
+            b = g_ready.front();
+            g_ready.pop_front();
+        }
+        write_sync(b);
+    }
+}
+
+#ifdef LUMBERJACK_HAVE_IO_URING
+
+// io_uring writer: submits every ready block, then reaps completions. When
+// nothing new is ready but writes are in flight it blocks in the kernel for
+// the next completion; when idle it sleeps on the condition variable. If
+// the ring fails outright, in-flight and later blocks are written with
+// pwrite() from this thread instead.
+static void uring_writer() {
+    std::deque<Block*> batch;
+    std::vector<Block*> inflight;
+    bool broken = false;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(g_queueMutex);
+            if (inflight.empty()) {
+                g_readyCv.wait(lock, [] { return !g_ready.empty() || g_stopping; });
+                if (g_ready.empty()) return;
+            }
+            batch.swap(g_ready);
+        }
+
+        if (broken) {
+            for (Block* b : batch) write_sync(b);
+            batch.clear();
+            continue;
+        }
+        for (Block* b : batch) {
+            g_ring.prep_write(g_fd, b, b->data, static_cast<unsigned>(b->len),
+                              b->offset, g_fixedBuffers);
+            inflight.push_back(b);
+        }
+        batch.clear();
+
+        broken = !g_ring.submit(!inflight.empty());
+        g_ring.reap([&](Block* b, int res) {
+            if (res > 0) b->done += static_cast<size_t>(res);
+            if (res > 0 && b->done < b->len) {
+                // Short write — resubmit the remainder from the same buffer.
+                g_ring.prep_write(g_fd, b, b->data + b->done,
+                                  static_cast<unsigned>(b->len - b->done),
+                                  b->offset + b->done, g_fixedBuffers);
+                return;
+            }
+            for (size_t i = 0; i < inflight.size(); i++) {
+                if (inflight[i] == b) {
+                    inflight[i] = inflight.back();
+                    inflight.pop_back();
+                    break;
+                }
+            }
+            recycle(b, res > 0);
+        });
+        if (broken) {
+            for (Block* b : inflight) write_sync(b);
+            inflight.clear();
+        }
+    }
+}
+
+#endif // LUMBERJACK_HAVE_IO_URING
+
+// Chooses the engine and starts the writer thread(s). Caller holds g_mutex.
+static void start_writers(const AsyncFileOptions& options) {
+    g_stopping = false;
+#ifdef LUMBERJACK_HAVE_IO_URING
+    if (!options.force_fallback && g_ring.open(static_cast<unsigned>(g_blocks.size()))) {
+        std::vector<struct iovec> iovs(g_blocks.size());
+        for (size_t i = 0; i < g_blocks.size(); i++) {
+            iovs[i].iov_base = g_blocks[i].data;
+            iovs[i].iov_len  = g_blockSize;
+        }
+        // Registration pins the pool in memory; it can fail under a low
+        // RLIMIT_MEMLOCK, in which case plain WRITEV submissions are used.
+        g_fixedBuffers = g_ring.register_buffers(iovs.data(),
+                                                 static_cast<unsigned>(iovs.size()));
+        g_engine = ASYNC_FILE_ENGINE_IO_URING;
+        g_writers.emplace_back(uring_writer);
+        return;
+    }
+#endif
+    unsigned threads = options.fallback_threads ? options.fallback_threads : 1;
+    g_engine = ASYNC_FILE_ENGINE_THREADS;
+    for (unsigned i = 0; i < threads; i++) g_writers.emplace_back(thread_writer);
+}
+
+// Waits until every block is back in the free pool. Caller holds g_mutex
+// and has already handed off the current block.
+static void wait_idle() {
+    std::unique_lock<std::mutex> lock(g_queueMutex);
+    g_freeCv.wait(lock, [] { return g_free.size() == g_blocks.size(); });
+}
+
+// Stops the writers and releases the pool and file. Caller holds g_mutex.
+static void close_locked() {
+    if (!g_open) return;
+    g_crashFlushReady = 0;
+    hand_off_current();
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(g_queueMutex);
+        g_stopping = true;
+        g_readyCv.notify_all();
+    }
+    for (auto& t : g_writers) t.join();
+    g_writers.clear();
+#ifdef LUMBERJACK_HAVE_IO_URING
+    g_ring.close();
+    g_fixedBuffers = false;
+#endif
+    for (auto& b : g_blocks) free(b.data);
+    g_blocks.clear();
+    g_free.clear();
+    ::close(g_fd);
+    g_fd = -1;
+    g_open = false;
+    g_engine = ASYNC_FILE_ENGINE_NONE;
+}
+
+// ---------------------------------------------------------------------------
+// Crash flush
+// ---------------------------------------------------------------------------
+
+// pwrite() loop usable from a signal handler.
+static bool crash_pwrite(const char* data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = pwrite(g_fd, data, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+// Runs inside the crash handler. Every block that has an offset but may not
+// be on disk yet is written again with pwrite() — rewriting bytes a writer
+// already completed is harmless — followed by the partially filled current
+// block and the crash line. No locks: the crashing thread may hold them.
+static void async_crash_flush(int signo) {
+    if (!g_crashFlushReady) return;
+    for (Block& b : g_blocks) {
+        if (b.queued) crash_pwrite(b.data, b.len, b.offset);
+    }
+
+    uint64_t offset = g_nextOffset;
+    Block* current = g_current;
+    if (current && current->len > 0 && crash_pwrite(current->data, current->len, offset)) {
+        offset += current->len;
+    }
+    char line[96];
+    size_t len = format_crash_line(line, sizeof(line), g_tsCache.last(), signo);
+    crash_pwrite(line, len, offset);
+}
+
+// ---------------------------------------------------------------------------
+// Backend callbacks
+// ---------------------------------------------------------------------------
+
+static void async_init() {}
+
+static void async_shutdown() {
+    async_file_flush();
+}
+
+static void async_log_write(LogLevel level, const char* message) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_open) return;
+
+    char line[1280];
+    int len = snprintf(line, sizeof(line), "[%s] [%s] %s\n",
+                       g_tsCache.get(), LEVEL_STRINGS[level], message);
+    if (len < 0) return;
+    if (static_cast<size_t>(len) >= sizeof(line)) len = sizeof(line) - 1;
+    size_t n = static_cast<size_t>(len);
+    if (n > g_blockSize) n = g_blockSize;
+
+    if (g_current && g_current->len + n > g_blockSize) hand_off_current();
+    if (!g_current) g_current = acquire_block();
+    memcpy(g_current->data + g_current->len, line, n);
+    g_current->len += n;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+LogBackend* async_file_backend() {
+    static LogBackend backend = {
+        "async_file",
+        async_init,
+        async_shutdown,
+        async_log_write,
+        span_begin_stateless,
+        span_end_as_line<async_log_write>
+    };
+    return &backend;
+}
+
+bool async_file_open(const char* path, const AsyncFileOptions& options) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    close_locked();
+    if (!path || options.block_size == 0 || options.block_count == 0) return false;
+
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    off_t end = lseek(fd, 0, SEEK_END);
+
+    // Page-aligned blocks so they can be registered as fixed buffers.
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (options.block_size + page - 1) / page * page;
+    g_blocks.resize(options.block_count);
+    for (unsigned i = 0; i < options.block_count; i++) {
+        void* mem = nullptr;
+        if (posix_memalign(&mem, page, size) != 0) {
+            for (unsigned j = 0; j < i; j++) free(g_blocks[j].data);
+            g_blocks.clear();
+            ::close(fd);
+            return false;
+        }
+        g_blocks[i].data  = static_cast<char*>(mem);
+        g_blocks[i].index = i;
+    }
+    g_free.clear();
+    for (auto& b : g_blocks) g_free.push_back(&b);
+
+    g_fd = fd;
+    g_blockSize = size;
+    g_nextOffset = end < 0 ? 0 : static_cast<uint64_t>(end);
+    g_current = nullptr;
+    g_tsCache.set_interval_ms(options.timestamp_cache_ms);
+    g_statBlocks = 0;
+    g_statBytes = 0;
+    g_statErrors = 0;
+    g_statWaits = 0;
+    g_statLatencyTotal = 0;
+    g_statLatencyMax = 0;
+    start_writers(options);
+    g_open = true;
+    register_crash_flush(async_crash_flush);
+    g_crashFlushReady = 1;
+    return true;
+}
+
+void async_file_close() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    close_locked();
+}
+
+void async_file_flush() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_open) return;
+    hand_off_current();
+    wait_idle();
+}
+
+AsyncFileEngine async_file_engine() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_engine;
+}
+
+AsyncFileStats async_file_stats() {
+    return {
+        g_statBlocks.load(std::memory_order_relaxed),
+        g_statBytes.load(std::memory_order_relaxed),
+        g_statErrors.load(std::memory_order_relaxed),
+        g_statWaits.load(std::memory_order_relaxed),
+        g_statLatencyTotal.load(std::memory_order_relaxed),
+        g_statLatencyMax.load(std::memory_order_relaxed)
+    };
+}
+
+} // namespace lumberjack
@@ -1,115 +1,1198 @@
 #include "lumberjack/lumberjack.h"
+#include "lumberjack/builtin_logger.h"
 #include "lumberjack/utils.h"
+#include "lumberjack/flight_recorder.h"
+#include "lumberjack/rotation.h"
+#include "lumberjack/pattern.h"
+#include "lumberjack/structured.h"
+#include "lumberjack/context.h"
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdarg>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
 #include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
 
 namespace lumberjack {
 
+static const char* const g_levelNames[LOG_COUNT] = {
+    "NONE", "ERROR", "WARN", "INFO", "DEBUG"
+};
+
+// Level values of the logfmt and JSON formats
+static const char* const g_levelKeys[LOG_COUNT] = {
+    "none", "error", "warn", "info", "debug"
+};
+
+// ---------------------------------------------------------------------------
+// Queued records
+// ---------------------------------------------------------------------------
+
+struct QueuedRecord {
+    uint64_t    seq;            // queue position, or next_sequence() if global
+    bool        numbered;       // print seq as #N
+    long long   time_ms;        // capture time, ms since the epoch
+    LogLevel    level;
+    uint64_t    thread_id;
+    const char* file;           // call site; __FILE__ literals live forever
+    int         line;
+    size_t      context_length; // context bytes at the start of text
+    size_t      length;         // message bytes after the context
+    size_t      fields_length;  // rendered fields after the message
+    uint8_t     format;         // OutputFormat context and fields are in
+    char        text[1024];
+};
+
+// Formats capture times as "YYYY-MM-DD HH:MM:SS.mmm". localtime_r runs once
+// per second of log time; changed reports a new millisecond, which restarts
+// the #N counter the way a TimestampCache refresh does. gmtoff keeps the
+// UTC offset of the last second formatted, for format_epoch_ms().
+struct StampFormatter {
+    time_t    second  = -1;
+    long long last_ms = -1;
+    long      gmtoff  = 0;
+    char      date[24] = {};
+    char      buf[32]  = {};
+
+    const char* format(long long ms, bool* changed) {
+        *changed = ms != last_ms;
+        if (!*changed) return buf;
+        last_ms = ms;
+        time_t tt = static_cast<time_t>(ms / 1000);
+        if (tt != second) {
+            struct tm tm;
+            localtime_r(&tt, &tm);
+            strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm);
+            second = tt;
+            gmtoff = tm.tm_gmtoff;
+        }
+        snprintf(buf, sizeof(buf), "%s.%03lld", date, ms % 1000);
+        return buf;
+    }
+};
+
+static const size_t WRITER_BATCH = 64;
+
+static long long now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// A record for a line that arrived as a plain string: captured now on the
+// calling thread, with its context but without a call site.
+static LogRecord make_record(LogLevel level, const char* message) {
+    LogRecord record;
+    record.level = level;
+    record.message = message;
+    record.length = strlen(message);
+    record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.thread_id = current_thread_id();
+    record.file = nullptr;
+    record.line = 0;
+    record.context = current_context();
+    return record;
+}
+
+static std::chrono::system_clock::time_point record_time(const LogRecord& record) {
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::nanoseconds(record.timestamp_ns)));
+}
+
+// The values a record's line is rendered from, its context in format's form.
+static PatternFields pattern_fields(const LogRecord& record, OutputFormat format, const char* ts, long long seq) {
+    const RecordContext& context = record.context;
+    bool json = format == OUTPUT_JSON;
+    return { ts, record.level, record.message, record.length, record.thread_id, record.file, record.line, seq,
+             json ? context.json : context.logfmt, json ? context.json_length : context.logfmt_length };
+}
+
+// Renders one line in format. fields.message is followed directly by
+// fields_len bytes of fields already rendered for that format. TEXT runs
+// layout over message and fields together; LOGFMT and JSON write time,
+// level, seq, the context and the escaped message, then the fields. The
+// line always ends in '\n' (JSON in "}\n").
+static size_t render_line(char* out, size_t capacity, OutputFormat format, const PatternLayout& layout,
+                          PatternFields fields, size_t fields_len) {
+    if (format == OUTPUT_TEXT) {
+        fields.message_len += fields_len;
+        return layout.render(out, capacity, fields);
+    }
+
+    bool json = format == OUTPUT_JSON;
+    size_t limit = capacity - (json ? 2 : 1);   // room for "}\n"
+    size_t pos = 0;
+    auto copy = [&](const char* data, size_t len) {
+        if (len > limit - pos) len = limit - pos;
+        memcpy(out + pos, data, len);
+        pos += len;
+    };
+    auto copy_str = [&](const char* text) { copy(text, strlen(text)); };
+
+    copy_str(json ? "{\"time\":\"" : "time=\"");
+    copy_str(fields.timestamp);
+    copy_str(json ? "\",\"level\":\"" : "\" level=");
+    copy_str(g_levelKeys[fields.level]);
+    if (json) copy_str("\"");
+    if (fields.seq >= 0) {
+        char digits[20];
+        copy_str(json ? ",\"seq\":" : " seq=");
+        copy(digits, format_uint(digits, static_cast<uint64_t>(fields.seq)));
+    }
+    copy(fields.context, fields.context_len);
+    copy_str(json ? ",\"msg\":" : " msg=");
+    pos += render_string(out + pos, limit - pos, format, fields.message, fields.message_len);
+    copy(fields.message + fields.message_len, fields_len);
+    if (json) out[pos++] = '}';
+    out[pos++] = '\n';
+    return pos;
+}
+
+// fdatasync on a pipe, socket or terminal fails with EINVAL: there is no
+// stable storage behind it, so handing the data over is all there is.
+static bool sync_output(int fd) {
+    if (fd < 0) return false;
+    return fdatasync(fd) == 0 || errno == EINVAL || errno == EROFS;
+}
+
 // ---------------------------------------------------------------------------
 // State
+//
+// Everything one built-in logger owns. The output side (stream, write
+// buffer, timestamp cache, pattern, recorder, rotation) is guarded by
+// m_mutex. Every line is rendered from a LogRecord by m_pattern; lines that
+// arrive as plain strings get a record without a call site.
+//
+// Queued mode: producers copy the message, its capture time, thread and
+// call site into a fixed record and push it onto the lane for its level; the writer thread
+// pops records in capture order (lowest seq across the lane heads) — or,
+// with priority lanes, from the most severe non-empty lane first — formats
+// them and writes them under m_mutex. Lanes share one pool of capacity
+// records, so the overload policy can shed the most verbose level first.
+// The pool holds WRITER_BATCH spare records for the batch the writer is
+// working on, so a producer always finds a free record while fewer than
+// capacity are queued.
+//
+// Group commit: log_and_wait_durable() writes its line, notes
+// m_linesWritten as its ticket and waits until m_committed reaches it. The
+// flusher thread flushes the output under m_mutex, notes how many lines
+// that covered, runs fdatasync without the lock — so lines keep arriving
+// and form the next group — then wakes every waiter the group covered.
 // ---------------------------------------------------------------------------
-static FILE*          g_output = stderr;
-static std::mutex     g_mutex;
-static TimestampCache g_tsCache;
-static WriteBuffer    g_writeBuf;
-static bool           g_seqEnabled = false;
-static unsigned long  g_seqCounter = 0;
 
-static const char* const g_levelStrings[LOG_COUNT] = {
-    "NONE ", "ERROR", "WARN ", "INFO ", "DEBUG"
+struct BuiltinLogger::State {
+    // Output, under m_mutex
+    FILE*             m_output = stderr;
+    std::mutex        m_mutex;
+    TimestampCache    m_tsCache;
+    WriteBuffer       m_writeBuf;
+    bool              m_seqEnabled = false;
+    unsigned long     m_seqCounter = 0;
+    FlightRecorder    m_recorder;
+    LogLevel          m_outputLevel = LOG_LEVEL_DEBUG;
+    LogLevel          m_flushLevel = LOG_LEVEL_NONE;
+    uint64_t          m_linesWritten = 0;     // lines handed to the output
+    Durability        m_durability = DURABILITY_NONE;
+    FileRotator       m_rotator;
+    PatternLayout     m_pattern;
+    std::atomic<int>  m_format{OUTPUT_TEXT};  // read by queued producers
+
+    std::atomic<int>  m_level{LOG_LEVEL_INFO};  // gates BuiltinLogger::log()
+    std::atomic<bool> m_globalSeq{false};
+    LogBackend        m_backend = {};
+    int               m_slot = -1;
+
+    // Read by the crash flush hook, which cannot call fileno() or take m_mutex.
+    volatile sig_atomic_t m_outputFd = STDERR_FILENO;
+    volatile sig_atomic_t m_active = 0;
+    volatile sig_atomic_t m_crashing = 0;   // the writer stops writing
+
+    // Queued mode. m_queueEnabled is checked by producers without a lock.
+    std::atomic<bool>          m_queueEnabled{false};
+    std::mutex                 m_queueMutex;
+    std::condition_variable    m_queueCv;      // writer waits for records
+    std::condition_variable    m_spaceCv;      // blocked producers, flushers
+    std::deque<QueuedRecord*>  m_lanes[LOG_COUNT];
+    std::vector<QueuedRecord>  m_pool;
+    std::vector<QueuedRecord*> m_freeRecords;
+    size_t                     m_queued = 0;
+    size_t                     m_inFlight = 0;  // popped, not yet written
+    uint64_t                   m_nextSeq = 0;
+    bool                       m_queueOpen = false;
+    bool                       m_writerSleeping = false;
+    QueueOptions               m_queueOptions;
+    std::thread                m_writer;
+    StampFormatter             m_queueStamp;    // writer only; the crash hook reads gmtoff
+
+    std::mutex                 m_spillMutex;
+    FILE*                      m_spill = nullptr;
+    StampFormatter             m_spillStamp;
+    PatternLayout              m_spillLayout;   // always the default
+
+    std::atomic<uint64_t>      m_enqueued{0};
+    std::atomic<uint64_t>      m_spilled{0};
+    std::atomic<uint64_t>      m_blocked{0};
+    std::atomic<uint64_t>      m_dropped[LOG_COUNT] = {};
+    std::atomic<uint64_t>      m_unreported[LOG_COUNT] = {};  // drained by the writer
+
+    // Group commit
+    std::mutex                 m_commitMutex;
+    std::condition_variable    m_commitCv;       // flusher waits for requests
+    std::condition_variable    m_committedCv;    // producers wait for commits
+    uint64_t                   m_commitRequested = 0;
+    uint64_t                   m_committed = 0;
+    bool                       m_flusherStop = false;
+    bool                       m_flusherRunning = false;
+    std::thread                m_flusher;
+    DurabilityStats            m_durabilityStats = {};
+
+    // Output
+    void rotate_if_due(size_t len);
+    void write_line_locked(const LogRecord& record, size_t fields_len, OutputFormat format,
+                           const char* ts, bool refreshed, bool defer_flush, long long seq = -1);
+    void log_write(LogLevel level, const char* message);
+    void log_write_batch(const LogRecord* records, size_t count);
+    void log_write_kv(const LogRecord* record, const LogField* fields, size_t count);
+    bool log_durable(LogLevel level, const char* message);
+    void shutdown();
+    void crash_flush(int signo);
+    void crash_flush_queue();
+
+    // Queued mode
+    void count_drop(LogLevel level);
+    void evict_head(int lane);
+    int  oldest_lane();
+    int  severest_lane();
+    void spill(const LogRecord& record, size_t fields_len, OutputFormat format);
+    bool queue_push(const LogRecord& source, size_t fields_len, OutputFormat format);
+    void report_drops_locked();
+    void write_batch(QueuedRecord* const* batch, size_t n);
+    void writer_main();
+    void queue_wait_idle();
+    void queue_stop();
+    bool queue_start(const QueueOptions& options);
+
+    // Group commit
+    void flusher_main();
+    void flusher_stop();
+    void flusher_start();
+    bool wait_committed(uint64_t ticket);
 };
 
 // ---------------------------------------------------------------------------
-// Backend callbacks
+// Output
 // ---------------------------------------------------------------------------
 
-static void builtin_init() {}
+// Switches to the rotator's next file when a rotation is due. Pending
+// buffered output goes to the old file first. Caller holds m_mutex.
+void BuiltinLogger::State::rotate_if_due(size_t len) {
+    if (!m_rotator.should_rotate(len)) return;
+    m_writeBuf.flush(m_output);
+    // Committed lines must not be left behind unsynced in the old file.
+    if (m_durability == DURABILITY_FDATASYNC) fdatasync(m_outputFd);
+    if (m_rotator.rotate()) {
+        m_output = m_rotator.file();
+        m_outputFd = fileno(m_output);
+    }
+}
+
+// Renders one line in format (TEXT through m_pattern) and sends it to the
+// recorder and (level permitting) the output. fields_len bytes of rendered
+// fields follow the record's message. ts is the line's timestamp; refreshed restarts
+// the #N counter. A seq of 0 or more is printed as #seq in place of that
+// counter. Lines at or above m_flushLevel flush the write buffer. With
+// defer_flush, both that flush and unbuffered output's per-line fflush are
+// left to the caller (the queue writer or the flusher). Caller holds
+// m_mutex.
+void BuiltinLogger::State::write_line_locked(const LogRecord& record, size_t fields_len, OutputFormat format,
+                                             const char* ts, bool refreshed, bool defer_flush, long long seq) {
+    LogLevel level = record.level;
+    if (seq < 0 && m_seqEnabled) {
+        if (refreshed) m_seqCounter = 0;
+        seq = static_cast<long long>(m_seqCounter++);
+    }
+    PatternFields fields = pattern_fields(record, format, ts, seq);
+
+    char line[1280];
+    size_t len = render_line(line, sizeof(line), format, m_pattern, fields, fields_len);
 
-static void builtin_shutdown() {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    g_writeBuf.flush(g_output);
-    g_output = stderr;
+    m_recorder.append(line, len);
+    if (level <= m_outputLevel) {
+        if (m_rotator.is_open()) {
+            rotate_if_due(len);
+            m_rotator.add_bytes(len);
+        }
+        m_linesWritten++;
+        if (defer_flush && !m_writeBuf.is_enabled()) {
+            fwrite(line, 1, len, m_output);
+        } else {
+            m_writeBuf.write(m_output, line, len);
+            if (level <= m_flushLevel && !defer_flush) m_writeBuf.flush(m_output);
+        }
+    }
 }
 
-static void builtin_log_write(LogLevel level, const char* message) {
-    std::lock_guard<std::mutex> lock(g_mutex);
+void BuiltinLogger::State::log_write(LogLevel level, const char* message) {
+    LogRecord record = make_record(level, message);
+    log_write_batch(&record, 1);
+}
 
-    const char* level_str = g_levelStrings[level];
+// Writes records under one lock acquisition, stamped with their capture
+// times. In queued mode the records join the queue instead.
+void BuiltinLogger::State::log_write_batch(const LogRecord* records, size_t count) {
+    OutputFormat format = static_cast<OutputFormat>(m_format.load(std::memory_order_relaxed));
+    size_t i = 0;
+    if (m_queueEnabled.load(std::memory_order_acquire)) {
+        while (i < count && queue_push(records[i], 0, format)) i++;
+        if (i == count) return;
+    }
 
-    char line[1280];
-    int len;
-    if (g_seqEnabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool global = m_globalSeq.load(std::memory_order_relaxed);
+    bool urgent = false;
+    for (; i < count; i++) {
+        const LogRecord& record = records[i];
         bool refreshed = false;
-        const char* ts = g_tsCache.get(&refreshed);
-        if (refreshed) g_seqCounter = 0;
-        len = snprintf(line, sizeof(line), "[%s] [%s] #%lu %s\n",
-                       ts, level_str, g_seqCounter++, message);
-    } else {
-        const char* ts = g_tsCache.get();
-        len = snprintf(line, sizeof(line), "[%s] [%s] %s\n", ts, level_str, message);
+        const char* ts = m_tsCache.get_at(record_time(record), &refreshed);
+        long long seq = global ? static_cast<long long>(next_sequence()) : -1;
+        write_line_locked(record, 0, format, ts, refreshed, true, seq);
+        urgent |= record.level <= m_flushLevel && record.level <= m_outputLevel;
     }
-    if (len < 0) return;
-    if (static_cast<size_t>(len) >= sizeof(line)) len = sizeof(line) - 1;
+    if (urgent) m_writeBuf.flush(m_output);
+    if (!m_writeBuf.is_enabled() && m_output) fflush(m_output);
+}
+
+// Renders the fields once, in the current format (logfmt style for TEXT),
+// right behind a copy of the message; the line is then written or queued
+// like any other. Fields that do not fit in the 1023-byte text are left out.
+void BuiltinLogger::State::log_write_kv(const LogRecord* record, const LogField* fields, size_t count) {
+    OutputFormat format = static_cast<OutputFormat>(m_format.load(std::memory_order_relaxed));
+    char text[1024];
+    LogRecord line = *record;
+    line.length = record->length < sizeof(text) - 1 ? record->length : sizeof(text) - 1;
+    memcpy(text, record->message, line.length);
+    size_t fields_len = render_fields(text + line.length, sizeof(text) - 1 - line.length,
+                                      format == OUTPUT_JSON ? OUTPUT_JSON : OUTPUT_LOGFMT, fields, count);
+    text[line.length + fields_len] = '\0';
+    line.message = text;
 
-    g_writeBuf.write(g_output, line, static_cast<size_t>(len));
+    if (m_queueEnabled.load(std::memory_order_acquire) && queue_push(line, fields_len, format)) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool refreshed = false;
+    const char* ts = m_tsCache.get_at(record_time(line), &refreshed);
+    long long seq = m_globalSeq.load(std::memory_order_relaxed)
+                        ? static_cast<long long>(next_sequence()) : -1;
+    write_line_locked(line, fields_len, format, ts, refreshed, false, seq);
 }
 
-static void* builtin_span_begin(LogLevel, const char*) {
-    return nullptr;
+// Writes the line directly (even in queued mode) and waits for the commit
+// that covers it.
+bool BuiltinLogger::State::log_durable(LogLevel level, const char* message) {
+    LogRecord record = make_record(level, message);
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool refreshed = false;
+        const char* ts = m_tsCache.get_at(record_time(record), &refreshed);
+        long long seq = m_globalSeq.load(std::memory_order_relaxed)
+                            ? static_cast<long long>(next_sequence()) : -1;
+        uint64_t before = m_linesWritten;
+        write_line_locked(record, 0, static_cast<OutputFormat>(m_format.load(std::memory_order_relaxed)),
+                          ts, refreshed, m_durability != DURABILITY_NONE, seq);
+        if (m_durability == DURABILITY_NONE || m_linesWritten == before) return true;
+        ticket = m_linesWritten;
+    }
+    return wait_committed(ticket);
+}
+
+void BuiltinLogger::State::shutdown() {
+    queue_wait_idle();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_writeBuf.flush(m_output);
+    m_rotator.close();
+    m_output = stderr;
+    m_outputFd = STDERR_FILENO;
+    m_active = 0;
+}
+
+// Runs inside the crash handler: writes whatever the write buffer holds
+// straight to the output descriptor, then the records still queued, then
+// the crash line if this logger is the active backend. Neither m_mutex nor
+// m_queueMutex is taken — the crashing thread may already own them.
+void BuiltinLogger::State::crash_flush(int signo) {
+    if (m_outputFd < 0) return;
+    crash_write(m_outputFd, m_writeBuf.data(), m_writeBuf.pending());
+    m_crashing = 1;
+    if (m_queueOpen) crash_flush_queue();
+    if (!m_active) return;
+    char line[96];
+    size_t len = format_crash_line(line, sizeof(line), m_tsCache.last(), signo);
+    crash_write(m_outputFd, line, len);
+}
+
+// Writes the queued records in capture order (lowest seq across the lane
+// heads), rendered like the writer would but with async-signal-safe calls
+// only: the timestamp comes from format_epoch_ms() with the writer's last
+// UTC offset. Once m_crashing is set the writer stops at its next record
+// and pops no more, and producers drop their lines; a record the writer
+// was writing at that moment may appear twice.
+void BuiltinLogger::State::crash_flush_queue() {
+    size_t next[LOG_COUNT] = {};
+    for (;;) {
+        int lane = -1;
+        for (int i = 0; i < LOG_COUNT; i++) {
+            if (next[i] >= m_lanes[i].size()) continue;
+            if (lane < 0 || m_lanes[i][next[i]]->seq < m_lanes[lane][next[lane]]->seq) lane = i;
+        }
+        if (lane < 0) return;
+        const QueuedRecord* record = m_lanes[lane][next[lane]++];
+        if (record->level > m_outputLevel) continue;
+
+        char ts[24];
+        format_epoch_ms(ts, record->time_ms, m_queueStamp.gmtoff);
+        long long seq = record->numbered ? static_cast<long long>(record->seq) : -1;
+        const char* context = record->text;
+        size_t context_len = record->context_length;
+        LogRecord line = { record->level, record->text + context_len, record->length, 0,
+                           record->thread_id, record->file, record->line,
+                           { context, context_len, context, context_len } };
+        OutputFormat format = static_cast<OutputFormat>(record->format);
+        char out[1280];
+        size_t len = render_line(out, sizeof(out), format, m_pattern, pattern_fields(line, format, ts, seq),
+                                 record->fields_length);
+        crash_write(m_outputFd, out, len);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Queued mode
+// ---------------------------------------------------------------------------
+
+void BuiltinLogger::State::count_drop(LogLevel level) {
+    m_dropped[level].fetch_add(1, std::memory_order_relaxed);
+    if (m_queueOptions.report_drops) m_unreported[level].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Removes the head of lane as a drop. Caller holds m_queueMutex.
+void BuiltinLogger::State::evict_head(int lane) {
+    QueuedRecord* record = m_lanes[lane].front();
+    m_lanes[lane].pop_front();
+    m_queued--;
+    count_drop(record->level);
+    m_freeRecords.push_back(record);
+}
+
+// Index of the lane whose head was captured first, or -1 if all are empty.
+// Caller holds m_queueMutex.
+int BuiltinLogger::State::oldest_lane() {
+    int best = -1;
+    for (int lane = 0; lane < LOG_COUNT; lane++) {
+        if (m_lanes[lane].empty()) continue;
+        if (best < 0 || m_lanes[lane].front()->seq < m_lanes[best].front()->seq) best = lane;
+    }
+    return best;
+}
+
+// Index of the most severe non-empty lane, or -1 if all are empty. Caller
+// holds m_queueMutex.
+int BuiltinLogger::State::severest_lane() {
+    for (int lane = 0; lane < LOG_COUNT; lane++) {
+        if (!m_lanes[lane].empty()) return lane;
+    }
+    return -1;
+}
+
+// Formats the record on the calling thread and appends it to the spill file.
+// The spill file keeps the default layout whatever the pattern, so tools
+// replaying it need not know the configuration; format still applies.
+void BuiltinLogger::State::spill(const LogRecord& record, size_t fields_len, OutputFormat format) {
+    std::lock_guard<std::mutex> lock(m_spillMutex);
+    if (!m_spill) return;
+    bool changed;
+    const char* ts = m_spillStamp.format(record.timestamp_ns / 1000000, &changed);
+    PatternFields fields = pattern_fields(record, format, ts, -1);
+    char line[1280];
+    size_t len = render_line(line, sizeof(line), format, m_spillLayout, fields, fields_len);
+    fwrite(line, 1, len, m_spill);
+    m_spilled.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Queues one record, applying the overload policy when the queue is full.
+// Returns false if queued mode was switched off meanwhile; the caller then
+// writes the line itself.
+bool BuiltinLogger::State::queue_push(const LogRecord& source, size_t fields_len, OutputFormat format) {
+    LogLevel level = source.level;
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    if (!m_queueOpen) return false;
+    if (m_crashing) {
+        count_drop(level);
+        return true;
+    }
+
+    if (m_queued >= m_queueOptions.capacity) {
+        switch (m_queueOptions.policy) {
+        case BACKPRESSURE_BLOCK:
+            m_blocked.fetch_add(1, std::memory_order_relaxed);
+            m_spaceCv.wait_for(lock, std::chrono::milliseconds(m_queueOptions.block_timeout_ms), [this] {
+                return !m_queueOpen || m_queued < m_queueOptions.capacity;
+            });
+            if (!m_queueOpen) return false;
+            if (m_queued >= m_queueOptions.capacity) {
+                count_drop(level);
+                return true;
+            }
+            break;
+        case BACKPRESSURE_DROP_NEWEST:
+            count_drop(level);
+            return true;
+        case BACKPRESSURE_DROP_OLDEST:
+            evict_head(oldest_lane());
+            break;
+        case BACKPRESSURE_DROP_BY_LEVEL: {
+            int lane = LOG_COUNT - 1;
+            while (lane > level && m_lanes[lane].empty()) lane--;
+            if (lane <= level) {
+                count_drop(level);
+                return true;
+            }
+            evict_head(lane);
+            break;
+        }
+        case BACKPRESSURE_SPILL:
+            lock.unlock();
+            spill(source, fields_len, format);
+            return true;
+        }
+    }
+
+    QueuedRecord* record = m_freeRecords.back();
+    m_freeRecords.pop_back();
+    bool global = m_globalSeq.load(std::memory_order_relaxed);
+    record->seq = global ? next_sequence() : m_nextSeq++;
+    record->numbered = global || m_queueOptions.priority_lanes;
+    record->time_ms = source.timestamp_ns / 1000000;
+    record->level = level;
+    record->thread_id = source.thread_id;
+    record->file = source.file;
+    record->line = source.line;
+    bool json = format == OUTPUT_JSON;
+    const char* context = json ? source.context.json : source.context.logfmt;
+    size_t room = sizeof(record->text) - 1;
+    size_t context_len = json ? source.context.json_length : source.context.logfmt_length;
+    if (context_len > room) context_len = room;
+    size_t len = source.length < room - context_len ? source.length : room - context_len;
+    size_t fields = fields_len < room - context_len - len ? fields_len : room - context_len - len;
+    memcpy(record->text, context, context_len);
+    memcpy(record->text + context_len, source.message, len + fields);
+    record->text[context_len + len + fields] = '\0';
+    record->context_length = context_len;
+    record->length = len;
+    record->fields_length = fields;
+    record->format = static_cast<uint8_t>(format);
+    m_lanes[level].push_back(record);
+    m_queued++;
+    m_enqueued.fetch_add(1, std::memory_order_relaxed);
+
+    bool wake = m_writerSleeping;
+    m_writerSleeping = false;
+    lock.unlock();
+    if (wake) m_queueCv.notify_one();
+    return true;
+}
+
+// Logs "dropped N DEBUG messages" at WARN for every level that lost records
+// since the last report. Caller holds m_mutex.
+void BuiltinLogger::State::report_drops_locked() {
+    for (int level = LOG_LEVEL_ERROR; level < LOG_COUNT; level++) {
+        uint64_t n = m_unreported[level].exchange(0, std::memory_order_relaxed);
+        if (n == 0) continue;
+        char message[64];
+        snprintf(message, sizeof(message), "dropped %llu %s messages",
+                 static_cast<unsigned long long>(n), g_levelNames[level]);
+        bool changed;
+        const char* ts = m_queueStamp.format(now_ms(), &changed);
+        write_line_locked(make_record(LOG_LEVEL_WARN, message), 0,
+                          static_cast<OutputFormat>(m_format.load(std::memory_order_relaxed)), ts, changed, true);
+    }
+}
+
+void BuiltinLogger::State::write_batch(QueuedRecord* const* batch, size_t n) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool urgent = false;
+    for (size_t i = 0; i < n && !m_crashing; i++) {
+        const QueuedRecord* record = batch[i];
+        bool changed;
+        const char* ts = m_queueStamp.format(record->time_ms, &changed);
+        long long seq = record->numbered ? static_cast<long long>(record->seq) : -1;
+        // The context was copied in the record's format; either view will do.
+        const char* context = record->text;
+        size_t context_len = record->context_length;
+        LogRecord line = { record->level, record->text + context_len, record->length, 0,
+                           record->thread_id, record->file, record->line,
+                           { context, context_len, context, context_len } };
+        write_line_locked(line, record->fields_length, static_cast<OutputFormat>(record->format),
+                          ts, changed, true, seq);
+        urgent |= record->level <= m_flushLevel && record->level <= m_outputLevel;
+    }
+    report_drops_locked();
+    if (urgent) m_writeBuf.flush(m_output);
+    if (!m_writeBuf.is_enabled() && m_output) fflush(m_output);
+}
+
+void BuiltinLogger::State::writer_main() {
+    QueuedRecord* batch[WRITER_BATCH];
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    for (;;) {
+        while (m_queued == 0 && m_queueOpen) {
+            m_writerSleeping = true;
+            m_queueCv.wait(lock);
+        }
+        // The crash hook is walking the lanes; leave them alone.
+        while (m_crashing) m_queueCv.wait(lock);
+        if (m_queued == 0) break;
+
+        size_t n = 0;
+        while (n < WRITER_BATCH && m_queued > 0) {
+            int lane = m_queueOptions.priority_lanes ? severest_lane() : oldest_lane();
+            batch[n++] = m_lanes[lane].front();
+            m_lanes[lane].pop_front();
+            m_queued--;
+        }
+        m_inFlight = n;
+        lock.unlock();
+        m_spaceCv.notify_all();
+
+        write_batch(batch, n);
+
+        lock.lock();
+        m_freeRecords.insert(m_freeRecords.end(), batch, batch + n);
+        m_inFlight = 0;
+        if (m_queued == 0) m_spaceCv.notify_all();
+    }
+}
+
+// Waits until every queued record has been written.
+void BuiltinLogger::State::queue_wait_idle() {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_spaceCv.wait(lock, [this] { return !m_queueOpen || (m_queued == 0 && m_inFlight == 0); });
 }
 
-static void builtin_span_end(void*, LogLevel level,
-                              const char* name, long long elapsed_us) {
-    char message[256];
-    snprintf(message, sizeof(message), "SPAN '%s' took %lld us", name, elapsed_us);
-    builtin_log_write(level, message);
+// Drains the queue and stops the writer. Producers that arrive meanwhile
+// write their lines directly.
+void BuiltinLogger::State::queue_stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (!m_writer.joinable()) return;
+        m_queueOpen = false;
+    }
+    m_queueEnabled.store(false, std::memory_order_release);
+    m_queueCv.notify_one();
+    m_spaceCv.notify_all();
+    m_writer.join();
+
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_freeRecords.clear();
+    m_pool.clear();
+    m_pool.shrink_to_fit();
+    std::lock_guard<std::mutex> spill_lock(m_spillMutex);
+    if (m_spill) {
+        fclose(m_spill);
+        m_spill = nullptr;
+    }
+}
+
+bool BuiltinLogger::State::queue_start(const QueueOptions& options) {
+    FILE* spill_file = nullptr;
+    if (options.policy == BACKPRESSURE_SPILL) {
+        if (!options.spill_path) return false;
+        spill_file = fopen(options.spill_path, "a");
+        if (!spill_file) return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_queueOptions = options;
+    if (m_queueOptions.capacity == 0) m_queueOptions.capacity = 1;
+    m_queueOptions.spill_path = nullptr;   // not owned; only needed by fopen
+    m_pool = std::vector<QueuedRecord>(m_queueOptions.capacity + WRITER_BATCH);
+    m_freeRecords.reserve(m_pool.size());
+    for (QueuedRecord& record : m_pool) m_freeRecords.push_back(&record);
+    m_queued = 0;
+    m_inFlight = 0;
+    m_nextSeq = 0;
+    m_writerSleeping = false;
+    m_enqueued = 0;
+    m_spilled = 0;
+    m_blocked = 0;
+    for (int level = 0; level < LOG_COUNT; level++) {
+        m_dropped[level] = 0;
+        m_unreported[level] = 0;
+    }
+    {
+        std::lock_guard<std::mutex> spill_lock(m_spillMutex);
+        m_spill = spill_file;
+    }
+    m_queueOpen = true;
+    time_t now = time(nullptr);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    m_queueStamp.gmtoff = tm.tm_gmtoff;   // until the writer formats a line
+    m_writer = std::thread(&State::writer_main, this);
+    m_queueEnabled.store(true, std::memory_order_release);
+    return true;
 }
 
 // ---------------------------------------------------------------------------
-// Public backend accessor
+// Group commit
 // ---------------------------------------------------------------------------
 
-LogBackend* builtin_backend() {
-    static LogBackend backend = {
-        "builtin",
-        builtin_init,
-        builtin_shutdown,
-        builtin_log_write,
-        builtin_span_begin,
-        builtin_span_end
+void BuiltinLogger::State::flusher_main() {
+    std::unique_lock<std::mutex> lock(m_commitMutex);
+    for (;;) {
+        m_commitCv.wait(lock, [this] { return m_flusherStop || m_commitRequested > m_committed; });
+        if (m_commitRequested <= m_committed) {
+            m_flusherRunning = false;
+            m_committedCv.notify_all();
+            return;
+        }
+        lock.unlock();
+
+        uint64_t target;
+        int fd;
+        Durability durability;
+        {
+            std::lock_guard<std::mutex> output_lock(m_mutex);
+            m_writeBuf.flush(m_output);
+            if (m_output) fflush(m_output);
+            target = m_linesWritten;
+            fd = m_outputFd;
+            durability = m_durability;
+        }
+        bool ok = durability != DURABILITY_FDATASYNC || sync_output(fd);
+
+        lock.lock();
+        if (target > m_committed) {
+            m_durabilityStats.records += target - m_committed;
+            m_committed = target;
+        }
+        m_durabilityStats.commits++;
+        if (!ok) m_durabilityStats.errors++;
+        m_committedCv.notify_all();
+    }
+}
+
+void BuiltinLogger::State::flusher_stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_commitMutex);
+        if (!m_flusher.joinable()) return;
+        m_flusherStop = true;
+    }
+    m_commitCv.notify_one();
+    m_flusher.join();
+    std::lock_guard<std::mutex> lock(m_commitMutex);
+    m_flusherStop = false;
+}
+
+// Starts the flusher, counting only lines written from now on.
+void BuiltinLogger::State::flusher_start() {
+    uint64_t written;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        written = m_linesWritten;
+    }
+    std::lock_guard<std::mutex> lock(m_commitMutex);
+    m_committed = m_commitRequested = written;
+    m_flusherRunning = true;
+    m_flusher = std::thread(&State::flusher_main, this);
+}
+
+// Waits until the first ticket lines written are committed. Returns false
+// if the commit covering them failed.
+bool BuiltinLogger::State::wait_committed(uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(m_commitMutex);
+    if (!m_flusherRunning) return false;
+    uint64_t errors = m_durabilityStats.errors;
+    if (ticket > m_commitRequested) {
+        m_commitRequested = ticket;
+        m_commitCv.notify_one();
+    }
+    m_committedCv.wait(lock, [this, ticket] { return m_committed >= ticket || !m_flusherRunning; });
+    return m_committed >= ticket && m_durabilityStats.errors == errors;
+}
+
+// ---------------------------------------------------------------------------
+// Backend slots
+//
+// LogBackend callbacks take no context pointer, so each instance borrows a
+// slot: a set of callbacks compiled for that slot index, which look the
+// instance up in g_instances.
+// ---------------------------------------------------------------------------
+
+static std::atomic<BuiltinLogger::State*> g_instances[BuiltinLogger::MAX_INSTANCES];
+
+template <int N>
+struct SlotCallbacks {
+    static BuiltinLogger::State* state() { return g_instances[N].load(std::memory_order_acquire); }
+
+    static void init() { state()->m_active = 1; }
+    static void shutdown() { state()->shutdown(); }
+    static void log_write(LogLevel level, const char* message) { state()->log_write(level, message); }
+    static void log_write_batch(const LogRecord* records, size_t count) { state()->log_write_batch(records, count); }
+    static void log_write_kv(const LogRecord* record, const LogField* fields, size_t count) {
+        state()->log_write_kv(record, fields, count);
+    }
+    static void* span_begin(LogLevel, const char*) { return nullptr; }
+
+    static void span_end(void*, LogLevel level, const char* name, long long elapsed_us) {
+        char message[256];
+        snprintf(message, sizeof(message), "SPAN '%s' took %lld us", name, elapsed_us);
+        state()->log_write(level, message);
+    }
+};
+
+template <size_t... N>
+static constexpr LogBackend make_slot(size_t index, std::index_sequence<N...>) {
+    constexpr LogBackend slots[] = {
+        { "builtin", SlotCallbacks<N>::init, SlotCallbacks<N>::shutdown, SlotCallbacks<N>::log_write,
+          SlotCallbacks<N>::span_begin, SlotCallbacks<N>::span_end, SlotCallbacks<N>::log_write_batch,
+          SlotCallbacks<N>::log_write_kv }...
     };
-    return &backend;
+    return slots[index];
 }
 
+static LogBackend slot_backend(int index) {
+    return make_slot(static_cast<size_t>(index),
+                     std::make_index_sequence<BuiltinLogger::MAX_INSTANCES>());
+}
+
+// The instance whose slot callbacks backend uses, or nullptr.
+static BuiltinLogger::State* instance_of(const LogBackend* backend) {
+    for (int i = 0; i < BuiltinLogger::MAX_INSTANCES; i++) {
+        BuiltinLogger::State* state = g_instances[i].load(std::memory_order_acquire);
+        if (state && state->m_backend.log_write == backend->log_write) return state;
+    }
+    return nullptr;
+}
+
+// Flushes every instance's write buffer from the crash handler.
+static void builtin_crash_flush(int signo) {
+    for (int i = 0; i < BuiltinLogger::MAX_INSTANCES; i++) {
+        BuiltinLogger::State* state = g_instances[i].load(std::memory_order_acquire);
+        if (state) state->crash_flush(signo);
+    }
+}
+
+static const bool g_crashFlushRegistered = register_crash_flush(builtin_crash_flush);
+
 // ---------------------------------------------------------------------------
-// Configuration API
+// BuiltinLogger
 // ---------------------------------------------------------------------------
 
-void builtin_set_output(FILE* file) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    g_writeBuf.flush(g_output);
-    g_output = file;
+BuiltinLogger::BuiltinLogger(const char* name)
+    : m_state(new State())
+{
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        State* expected = nullptr;
+        if (g_instances[i].compare_exchange_strong(expected, m_state.get())) {
+            m_state->m_slot = i;
+            m_state->m_backend = slot_backend(i);
+            m_state->m_backend.name = name;
+            break;
+        }
+    }
 }
 
-void builtin_set_buffered(bool enabled, size_t buffer_size) {
-    std::lock_guard<std::mutex> lock(g_mutex);
+BuiltinLogger::~BuiltinLogger() {
+    m_state->queue_stop();
+    m_state->flusher_stop();
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_mutex);
+        m_state->m_writeBuf.flush(m_state->m_output);
+        m_state->m_rotator.close();
+    }
+    if (m_state->m_slot >= 0) g_instances[m_state->m_slot].store(nullptr, std::memory_order_release);
+}
+
+LogBackend* BuiltinLogger::backend() {
+    return m_state->m_slot >= 0 ? &m_state->m_backend : nullptr;
+}
+
+void BuiltinLogger::set_level(LogLevel level) {
+    m_state->m_level.store(level, std::memory_order_relaxed);
+}
+
+LogLevel BuiltinLogger::level() const {
+    return static_cast<LogLevel>(m_state->m_level.load(std::memory_order_relaxed));
+}
+
+void BuiltinLogger::log(LogLevel level, const char* fmt, ...) {
+    if (level <= LOG_LEVEL_NONE || level >= LOG_COUNT ||
+        level > m_state->m_level.load(std::memory_order_relaxed)) {
+        return;
+    }
+    char message[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+    m_state->log_write(level, message);
+}
+
+void BuiltinLogger::write(LogLevel level, const char* message) {
+    m_state->log_write(level, message);
+}
+
+bool BuiltinLogger::log_and_wait_durable(LogLevel level, const char* fmt, ...) {
+    if (level <= LOG_LEVEL_NONE || level >= LOG_COUNT ||
+        level > m_state->m_level.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    char message[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+    return m_state->log_durable(level, message);
+}
+
+void BuiltinLogger::set_output(FILE* file) {
+    m_state->queue_wait_idle();
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    m_state->m_writeBuf.flush(m_state->m_output);
+    m_state->m_rotator.close();
+    m_state->m_output = file;
+    m_state->m_outputFd = file ? fileno(file) : -1;
+}
+
+void BuiltinLogger::set_buffered(bool enabled, size_t buffer_size) {
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
     if (enabled) {
-        g_writeBuf.enable(g_output, buffer_size);
+        m_state->m_writeBuf.enable(m_state->m_output, buffer_size);
     } else {
-        g_writeBuf.disable(g_output);
+        m_state->m_writeBuf.disable(m_state->m_output);
+    }
+}
+
+void BuiltinLogger::flush() {
+    m_state->queue_wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_spillMutex);
+        if (m_state->m_spill) fflush(m_state->m_spill);
+    }
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    m_state->m_writeBuf.flush(m_state->m_output);
+}
+
+void BuiltinLogger::set_timestamp_cache(unsigned int interval_ms, bool seq) {
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    m_state->m_tsCache.set_interval_ms(interval_ms);
+    m_state->m_seqEnabled = seq;
+    m_state->m_seqCounter = 0;
+}
+
+bool BuiltinLogger::set_flight_recorder(const char* path, size_t capacity) {
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    if (!path) {
+        m_state->m_recorder.close();
+        return true;
+    }
+    return m_state->m_recorder.open(path, capacity);
+}
+
+void BuiltinLogger::set_output_level(LogLevel level) {
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    m_state->m_outputLevel = level;
+}
+
+bool BuiltinLogger::set_rotation(const char* path, const RotationOptions& options) {
+    m_state->queue_wait_idle();
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    m_state->m_writeBuf.flush(m_state->m_output);
+    m_state->m_rotator.close();
+    m_state->m_output = stderr;
+    m_state->m_outputFd = STDERR_FILENO;
+    if (!path) return true;
+    if (!m_state->m_rotator.open(path, options)) return false;
+    m_state->m_output = m_state->m_rotator.file();
+    m_state->m_outputFd = fileno(m_state->m_output);
+    return true;
+}
+
+bool BuiltinLogger::set_queued(bool enabled, const QueueOptions& options) {
+    m_state->queue_stop();
+    if (!enabled) return true;
+    return m_state->queue_start(options);
+}
+
+QueueStats BuiltinLogger::queue_stats() {
+    QueueStats stats = {};
+    stats.enqueued = m_state->m_enqueued.load(std::memory_order_relaxed);
+    for (int level = 0; level < LOG_COUNT; level++) {
+        stats.dropped[level] = m_state->m_dropped[level].load(std::memory_order_relaxed);
+    }
+    stats.spilled = m_state->m_spilled.load(std::memory_order_relaxed);
+    stats.blocked = m_state->m_blocked.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void BuiltinLogger::set_global_sequence(bool enabled) {
+    m_state->m_globalSeq.store(enabled, std::memory_order_relaxed);
+}
+
+void BuiltinLogger::set_durability(Durability durability) {
+    m_state->flusher_stop();
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_mutex);
+        m_state->m_durability = durability;
     }
+    if (durability != DURABILITY_NONE) m_state->flusher_start();
+}
+
+DurabilityStats BuiltinLogger::durability_stats() {
+    std::lock_guard<std::mutex> lock(m_state->m_commitMutex);
+    return m_state->m_durabilityStats;
+}
+
+void BuiltinLogger::set_flush_level(LogLevel level) {
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    m_state->m_flushLevel = level;
+}
+
+void BuiltinLogger::set_output_format(OutputFormat format) {
+    m_state->m_format.store(format, std::memory_order_relaxed);
+}
+
+bool BuiltinLogger::set_pattern(const char* pattern) {
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    return m_state->m_pattern.compile(pattern ? pattern : DEFAULT_PATTERN);
+}
+
+// ---------------------------------------------------------------------------
+// Default instance
+// ---------------------------------------------------------------------------
+
+static BuiltinLogger* g_default = nullptr;
+
+BuiltinLogger& builtin_logger() {
+    static BuiltinLogger* logger = g_default = new BuiltinLogger("builtin");
+    return *logger;
+}
+
+// Drains the default instance's queue, commits its waiters and closes a
+// rotated file at exit, so the background renames and compression finish;
+// the instance itself stays alive for logging from later static
+// destructors, which then go to stderr.
+struct DefaultAutoStop {
+    ~DefaultAutoStop() {
+        if (!g_default) return;
+        g_default->set_queued(false);
+        g_default->set_durability(DURABILITY_NONE);
+
+        BuiltinLogger::State& state = *g_default->m_state;
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        if (!state.m_rotator.is_open()) return;
+        state.m_writeBuf.flush(state.m_output);
+        state.m_rotator.close();
+        state.m_output = stderr;
+        state.m_outputFd = STDERR_FILENO;
+    }
+};
+
+static DefaultAutoStop g_defaultAutoStop;
+
+// ---------------------------------------------------------------------------
+// Public backend accessor and configuration API
+// ---------------------------------------------------------------------------
+
+LogBackend* builtin_backend() {
+    return builtin_logger().backend();
+}
+
+void builtin_set_output(FILE* file) {
+    builtin_logger().set_output(file);
+}
+
+void builtin_set_buffered(bool enabled, size_t buffer_size) {
+    builtin_logger().set_buffered(enabled, buffer_size);
 }
 
 void builtin_flush() {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    g_writeBuf.flush(g_output);
+    builtin_logger().flush();
 }
 
 void builtin_set_timestamp_cache(unsigned int interval_ms, bool seq) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    g_tsCache.set_interval_ms(interval_ms);
-    g_seqEnabled = seq;
-    g_seqCounter = 0;
+    builtin_logger().set_timestamp_cache(interval_ms, seq);
+}
+
+bool builtin_set_flight_recorder(const char* path, size_t capacity) {
+    return builtin_logger().set_flight_recorder(path, capacity);
+}
+
+bool builtin_set_rotation(const char* path, const RotationOptions& options) {
+    return builtin_logger().set_rotation(path, options);
+}
+
+void builtin_set_output_level(LogLevel level) {
+    builtin_logger().set_output_level(level);
+}
+
+void builtin_set_global_sequence(bool enabled) {
+    builtin_logger().set_global_sequence(enabled);
+}
+
+void builtin_set_durability(Durability durability) {
+    builtin_logger().set_durability(durability);
+}
+
+DurabilityStats builtin_durability_stats() {
+    return builtin_logger().durability_stats();
+}
+
+void builtin_set_flush_level(LogLevel level) {
+    builtin_logger().set_flush_level(level);
+}
+
+bool builtin_set_queued(bool enabled, const QueueOptions& options) {
+    return builtin_logger().set_queued(enabled, options);
+}
+
+QueueStats builtin_queue_stats() {
+    return builtin_logger().queue_stats();
+}
+
+void builtin_set_output_format(OutputFormat format) {
+    builtin_logger().set_output_format(format);
+}
+
+bool builtin_set_pattern(const char* pattern) {
+    return builtin_logger().set_pattern(pattern);
+}
+
+bool log_and_wait_durable(LogLevel level, const char* fmt, ...) {
+    if (level <= LOG_LEVEL_NONE || level >= LOG_COUNT || level > get_level()) return true;
+
+    char message[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+
+    LogBackend* backend = get_backend();
+    BuiltinLogger::State* state = instance_of(backend);
+    if (!state) {
+        backend->log_write(level, message);
+        return false;
+    }
+    return state->log_durable(level, message);
 }
 
 } // namespace lumberjack
@@ -0,0 +1,624 @@
+// compressed_file.cpp — Block-compressed file sink, codecs and decoder.
+//
+// Producers append formatted lines to the current block under a mutex. A
+// full block goes onto a bounded queue; one worker thread compresses each
+// block and appends a self-describing frame to the data file plus a record
+// to the index file. Blocks cycle through a fixed pool, so the only
+// allocation is at open().
+
+#include "lumberjack/sinks.h"
+#include "lumberjack/utils.h"
+#include "sink_common.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef LUMBERJACK_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace lumberjack {
+
+namespace {
+
+const uint32_t FRAME_MAGIC = 0x465A4A4C;  // "LJZF" little-endian
+
+struct FrameHeader {
+    uint32_t magic;
+    uint8_t  codec;
+    uint8_t  reserved[3];
+    uint32_t raw_size;
+    uint32_t stored_size;
+    uint32_t checksum;
+    uint32_t reserved2;
+    uint64_t first_us;
+    uint64_t last_us;
+};
+static_assert(sizeof(FrameHeader) == 40, "frame header layout");
+
+struct IndexRecord {
+    uint64_t first_us;
+    uint64_t last_us;
+    uint64_t offset;
+};
+
+struct Block {
+    char*    data     = nullptr;
+    size_t   len      = 0;
+    uint64_t first_us = 0;
+    uint64_t last_us  = 0;
+};
+
+uint32_t fnv1a(const uint8_t* data, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// ---------------------------------------------------------------------------
+// Built-in LZ codec
+// ---------------------------------------------------------------------------
+//
+// LZ77 with a 64 KB window, in the LZ4 block style: each sequence is a token
+// byte (literal count in the high nibble, match length - 4 in the low
+// nibble; 15 means "more length bytes follow", each adding up to 255), the
+// literals, then a 2-byte little-endian match offset and any extra match
+// length bytes. The final sequence has literals only. Matches are found with
+// a single-entry hash table of 4-byte prefixes.
+
+const int    LZ_HASH_BITS  = 14;
+const size_t LZ_TABLE_SIZE = static_cast<size_t>(1) << LZ_HASH_BITS;
+const size_t LZ_MIN_MATCH  = 4;
+const size_t LZ_MAX_OFFSET = 65535;
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint8_t* write_length(uint8_t* op, size_t n) {
+    while (n >= 255) {
+        *op++ = 255;
+        n -= 255;
+    }
+    *op++ = static_cast<uint8_t>(n);
+    return op;
+}
+
+size_t lz_bound(size_t n) {
+    return n + n / 255 + 16;
+}
+
+uint8_t* lz_emit(uint8_t* op, const uint8_t* literals, size_t lit_len,
+                 size_t offset, size_t match_len) {
+    uint8_t* token = op++;
+    uint8_t lit_nibble = static_cast<uint8_t>(lit_len < 15 ? lit_len : 15);
+    if (lit_len >= 15) op = write_length(op, lit_len - 15);
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+    if (match_len == 0) {
+        *token = static_cast<uint8_t>(lit_nibble << 4);
+        return op;
+    }
+    *op++ = static_cast<uint8_t>(offset & 0xFF);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    size_t extra = match_len - LZ_MIN_MATCH;
+    uint8_t match_nibble = static_cast<uint8_t>(extra < 15 ? extra : 15);
+    if (extra >= 15) op = write_length(op, extra - 15);
+    *token = static_cast<uint8_t>((lit_nibble << 4) | match_nibble);
+    return op;
+}
+
+// Compresses n bytes of src into dst, which must hold lz_bound(n) bytes,
+// using table (LZ_TABLE_SIZE entries) as the match finder's scratch space.
+// Returns the compressed size.
+size_t lz_compress(const uint8_t* src, size_t n, uint8_t* dst, uint32_t* table) {
+    uint8_t* op = dst;
+    size_t anchor = 0;
+    if (n > 12) {
+        // Matches never start in the last 12 bytes nor reach the last 5,
+        // which keeps the match search within bounds.
+        const size_t match_start_limit = n - 12;
+        const size_t match_end_limit = n - 5;
+        memset(table, 0, LZ_TABLE_SIZE * sizeof(uint32_t));
+        size_t ip = 0;
+        while (ip < match_start_limit) {
+            uint32_t seq = read32(src + ip);
+            uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+            size_t ref = table[h];  // stored as position + 1
+            table[h] = static_cast<uint32_t>(ip + 1);
+            if (ref == 0 || ip - (ref - 1) > LZ_MAX_OFFSET || read32(src + ref - 1) != seq) {
+                // Skip faster through data that does not compress.
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            ref -= 1;
+            size_t len = LZ_MIN_MATCH;
+            while (ip + len < match_end_limit && src[ref + len] == src[ip + len]) len++;
+            op = lz_emit(op, src + anchor, ip - anchor, ip - ref, len);
+            ip += len;
+            anchor = ip;
+        }
+    }
+    op = lz_emit(op, src + anchor, n - anchor, 0, 0);
+    return static_cast<size_t>(op - dst);
+}
+
+// Decompresses exactly raw_size bytes into dst. Returns false on malformed
+// input instead of reading or writing out of bounds.
+bool lz_decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t raw_size) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + n;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + raw_size;
+
+    auto read_length = [&](size_t* len) {
+        uint8_t b;
+        do {
+            if (ip >= iend) return false;
+            b = *ip++;
+            *len += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !read_length(&lit_len)) return false;
+        if (lit_len > static_cast<size_t>(iend - ip) || lit_len > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip == iend) break;
+
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t match_len = token & 15;
+        if (match_len == 15 && !read_length(&match_len)) return false;
+        match_len += LZ_MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst) ||
+            match_len > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        const uint8_t* match = op - offset;
+        if (offset >= match_len) {
+            memcpy(op, match, match_len);
+        } else {
+            for (size_t i = 0; i < match_len; i++) op[i] = match[i];  // overlapping run
+        }
+        op += match_len;
+    }
+    return op == oend;
+}
+
+// ---------------------------------------------------------------------------
+// Frame encode / decode
+// ---------------------------------------------------------------------------
+
+bool codec_supported(CompressionCodec codec) {
+    switch (codec) {
+    case COMPRESSION_CODEC_NONE:
+    case COMPRESSION_CODEC_LZ:
+        return true;
+    case COMPRESSION_CODEC_ZLIB:
+#ifdef LUMBERJACK_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+size_t compress_bound(CompressionCodec codec, size_t n) {
+#ifdef LUMBERJACK_HAVE_ZLIB
+    if (codec == COMPRESSION_CODEC_ZLIB) return compressBound(static_cast<uLong>(n));
+#endif
+    return codec == COMPRESSION_CODEC_LZ ? lz_bound(n) : n;
+}
+
+// Per-worker output buffer and match table, sized once at startup.
+struct Scratch {
+    std::vector<uint8_t>  out;
+    std::vector<uint32_t> table;
+};
+
+// Compresses src into scratch.out. Returns the stored size, or 0 if the
+// codec failed or did not shrink the data.
+size_t compress_block(CompressionCodec codec, const uint8_t* src, size_t n, Scratch& scratch) {
+    uint8_t* dst = scratch.out.data();
+    size_t out = 0;
+    if (codec == COMPRESSION_CODEC_LZ) {
+        out = lz_compress(src, n, dst, scratch.table.data());
+    }
+#ifdef LUMBERJACK_HAVE_ZLIB
+    if (codec == COMPRESSION_CODEC_ZLIB) {
+        uLongf len = compressBound(static_cast<uLong>(n));
+        if (compress2(dst, &len, src, static_cast<uLong>(n), 1) == Z_OK) out = len;
+    }
+#endif
+    return out < n ? out : 0;
+}
+
+bool decompress_block(uint8_t codec, const uint8_t* src, size_t n, uint8_t* dst, size_t raw_size) {
+    switch (codec) {
+    case COMPRESSION_CODEC_NONE:
+        if (n != raw_size) return false;
+        memcpy(dst, src, n);
+        return true;
+    case COMPRESSION_CODEC_LZ:
+        return lz_decompress(src, n, dst, raw_size);
+#ifdef LUMBERJACK_HAVE_ZLIB
+    case COMPRESSION_CODEC_ZLIB: {
+        uLongf len = static_cast<uLongf>(raw_size);
+        return uncompress(dst, &len, src, static_cast<uLong>(n)) == Z_OK && len == raw_size;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+bool write_fully(int fd, const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = ::write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+uint64_t now_us() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// State
+// ---------------------------------------------------------------------------
+
+// Producer side — guarded by g_mutex.
+static std::mutex     g_mutex;
+static TimestampCache g_tsCache;
+static Block*         g_current = nullptr;
+static size_t         g_blockSize = 0;
+static bool           g_open = false;
+
+// Worker side — guarded by g_queueMutex.
+static std::mutex              g_queueMutex;
+static std::condition_variable g_readyCv;   // worker waits for blocks
+static std::condition_variable g_freeCv;    // producers/flushers wait for free blocks
+static std::deque<Block*>      g_ready;
+static std::vector<Block*>     g_free;
+static std::vector<Block>      g_blocks;
+static bool                    g_stopping = false;
+
+// Owned by the worker while it runs.
+static std::thread      g_worker;
+static int              g_fd = -1;
+static int              g_indexFd = -1;
+static uint64_t         g_offset = 0;
+static CompressionCodec g_codec = COMPRESSION_CODEC_LZ;
+
+static std::atomic<uint64_t> g_statFrames{0};
+static std::atomic<uint64_t> g_statRaw{0};
+static std::atomic<uint64_t> g_statStored{0};
+static std::atomic<uint64_t> g_statWaits{0};
+static std::atomic<uint64_t> g_statDropped{0};
+
+// Joins the worker at exit if the application never closed the file.
+static CloseAtExit<compressed_file_close> g_autoClose;
+
+// ---------------------------------------------------------------------------
+// Block pool and worker
+// ---------------------------------------------------------------------------
+
+// Takes a free block, waiting for the worker if all are queued.
+// Caller holds g_mutex.
+static Block* acquire_block() {
+    std::unique_lock<std::mutex> lock(g_queueMutex);
+    if (g_free.empty()) {
+        g_statWaits.fetch_add(1, std::memory_order_relaxed);
+        g_freeCv.wait(lock, [] { return !g_free.empty(); });
+    }
+    Block* b = g_free.back();
+    g_free.pop_back();
+    return b;
+}
+
+// Queues the current block for the worker. Caller holds g_mutex.
+static void hand_off_current() {
+    Block* b = g_current;
+    g_current = nullptr;
+    if (!b) return;
+    std::lock_guard<std::mutex> lock(g_queueMutex);
+    if (b->len == 0) {
+        g_free.push_back(b);
+        return;
+    }
+    g_ready.push_back(b);
+    g_readyCv.notify_one();
+}
+
+// Compresses one block and appends its frame and index record.
+static void write_frame(Block* b, Scratch& scratch) {
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(b->data);
+    size_t stored = compress_block(g_codec, raw, b->len, scratch);
+
+    FrameHeader header = {};
+    header.magic       = FRAME_MAGIC;
+    header.codec       = static_cast<uint8_t>(stored ? g_codec : COMPRESSION_CODEC_NONE);
+    header.raw_size    = static_cast<uint32_t>(b->len);
+    header.stored_size = static_cast<uint32_t>(stored ? stored : b->len);
+    header.checksum    = fnv1a(raw, b->len);
+    header.first_us    = b->first_us;
+    header.last_us     = b->last_us;
+    const void* payload = stored ? static_cast<const void*>(scratch.out.data()) : b->data;
+
+    if (!write_fully(g_fd, &header, sizeof(header)) ||
+        !write_fully(g_fd, payload, header.stored_size)) {
+        // Cut off the partial frame so later frames follow the last good
+        // one. If that fails, step past it: the index still finds the
+        // frames after it, but a sequential decode stops there.
+        if (ftruncate(g_fd, static_cast<off_t>(g_offset)) != 0) {
+            off_t end = lseek(g_fd, 0, SEEK_END);
+            if (end >= 0) g_offset = static_cast<uint64_t>(end);
+        }
+        g_statDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    IndexRecord record = { b->first_us, b->last_us, g_offset };
+    g_offset += sizeof(header) + header.stored_size;
+    if (g_indexFd >= 0) write_fully(g_indexFd, &record, sizeof(record));
+
+    g_statFrames.fetch_add(1, std::memory_order_relaxed);
+    g_statRaw.fetch_add(b->len, std::memory_order_relaxed);
+    g_statStored.fetch_add(header.stored_size, std::memory_order_relaxed);
+}
+
+static void worker() {
+    Scratch scratch;
+    scratch.out.resize(compress_bound(g_codec, g_blockSize));
+    scratch.table.resize(LZ_TABLE_SIZE);
+    for (;;) {
+        Block* b;
+        {
+            std::unique_lock<std::mutex> lock(g_queueMutex);
+            g_readyCv.wait(lock, [] { return !g_ready.empty() || g_stopping; });
+            if (g_ready.empty()) return;
+            b = g_ready.front();
+            g_ready.pop_front();
+        }
+        write_frame(b, scratch);
+
+        std::lock_guard<std::mutex> lock(g_queueMutex);
+        b->len = 0;
+        g_free.push_back(b);
+        g_freeCv.notify_all();
+    }
+}
+
+// Waits until every block is back in the free pool. Caller holds g_mutex
+// and has already handed off the current block.
+static void wait_idle() {
+    std::unique_lock<std::mutex> lock(g_queueMutex);
+    g_freeCv.wait(lock, [] { return g_free.size() == g_blocks.size(); });
+}
+
+// Stops the worker and releases the pool and files. Caller holds g_mutex.
+static void close_locked() {
+    if (!g_open) return;
+    hand_off_current();
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(g_queueMutex);
+        g_stopping = true;
+        g_readyCv.notify_all();
+    }
+    g_worker.join();
+    for (auto& b : g_blocks) free(b.data);
+    g_blocks.clear();
+    g_free.clear();
+    ::close(g_fd);
+    if (g_indexFd >= 0) ::close(g_indexFd);
+    g_fd = -1;
+    g_indexFd = -1;
+    g_open = false;
+}
+
+// ---------------------------------------------------------------------------
+// Backend callbacks
+// ---------------------------------------------------------------------------
+
+static void compressed_init() {}
+
+static void compressed_shutdown() {
+    compressed_file_flush();
+}
+
+static void compressed_log_write(LogLevel level, const char* message) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_open) return;
+
+    char line[1280];
+    int len = snprintf(line, sizeof(line), "[%s] [%s] %s\n",
+                       g_tsCache.get(), LEVEL_STRINGS[level], message);
+    if (len < 0) return;
+    if (static_cast<size_t>(len) >= sizeof(line)) len = sizeof(line) - 1;
+    size_t n = static_cast<size_t>(len);
+    if (n > g_blockSize) n = g_blockSize;
+
+    uint64_t us = now_us();
+    if (g_current && g_current->len + n > g_blockSize) hand_off_current();
+    if (!g_current) {
+        g_current = acquire_block();
+        g_current->first_us = us;
+    }
+    memcpy(g_current->data + g_current->len, line, n);
+    g_current->len += n;
+    g_current->last_us = us;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+LogBackend* compressed_file_backend() {
+    static LogBackend backend = {
+        "compressed_file",
+        compressed_init,
+        compressed_shutdown,
+        compressed_log_write,
+        span_begin_stateless,
+        span_end_as_line<compressed_log_write>
+    };
+    return &backend;
+}
+
+bool compressed_file_open(const char* path, const CompressedFileOptions& options) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    close_locked();
+    if (!path || options.block_size == 0 || options.block_size > UINT32_MAX) return false;
+
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    off_t end = lseek(fd, 0, SEEK_END);
+    std::string index_path = std::string(path) + ".idx";
+    g_indexFd = ::open(index_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    unsigned count = options.queue_depth + 1;  // queued blocks plus the one being filled
+    g_blocks.resize(count);
+    for (auto& b : g_blocks) {
+        b.data = static_cast<char*>(malloc(options.block_size));
+        if (!b.data) {
+            for (auto& allocated : g_blocks) free(allocated.data);
+            g_blocks.clear();
+            ::close(fd);
+            if (g_indexFd >= 0) ::close(g_indexFd);
+            g_indexFd = -1;
+            return false;
+        }
+    }
+    g_free.clear();
+    for (auto& b : g_blocks) g_free.push_back(&b);
+
+    g_fd = fd;
+    g_offset = end < 0 ? 0 : static_cast<uint64_t>(end);
+    g_blockSize = options.block_size;
+    g_codec = codec_supported(options.codec) ? options.codec : COMPRESSION_CODEC_LZ;
+    g_current = nullptr;
+    g_tsCache.set_interval_ms(options.timestamp_cache_ms);
+    g_statFrames = 0;
+    g_statRaw = 0;
+    g_statStored = 0;
+    g_statWaits = 0;
+    g_statDropped = 0;
+    g_stopping = false;
+    g_worker = std::thread(worker);
+    g_open = true;
+    return true;
+}
+
+void compressed_file_close() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    close_locked();
+}
+
+void compressed_file_flush() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_open) return;
+    hand_off_current();
+    wait_idle();
+}
+
+bool compressed_file_codec_supported(CompressionCodec codec) {
+    return codec_supported(codec);
+}
+
+CompressedFileStats compressed_file_stats() {
+    return {
+        g_statFrames.load(std::memory_order_relaxed),
+        g_statRaw.load(std::memory_order_relaxed),
+        g_statStored.load(std::memory_order_relaxed),
+        g_statWaits.load(std::memory_order_relaxed),
+        g_statDropped.load(std::memory_order_relaxed)
+    };
+}
+
+// ---------------------------------------------------------------------------
+// Decoder
+// ---------------------------------------------------------------------------
+
+// Returns the data file offset of the first indexed frame that ends at or
+// after from_us, or 0 if there is no usable index.
+static uint64_t seek_offset(const char* path, uint64_t from_us) {
+    if (from_us == 0) return 0;
+    std::string index_path = std::string(path) + ".idx";
+    FILE* f = fopen(index_path.c_str(), "rb");
+    if (!f) return 0;
+    IndexRecord record;
+    uint64_t offset = 0;
+    while (fread(&record, sizeof(record), 1, f) == 1) {
+        offset = record.offset;
+        if (record.last_us >= from_us) break;
+    }
+    fclose(f);
+    return offset;
+}
+
+long compressed_file_decode(const char* path, FILE* out, uint64_t from_us, uint64_t to_us) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, static_cast<long>(seek_offset(path, from_us)), SEEK_SET);
+
+    std::vector<uint8_t> stored;
+    std::vector<uint8_t> raw;
+    long frames = 0;
+    FrameHeader header;
+    while (fread(&header, sizeof(header), 1, f) == 1) {
+        if (header.magic != FRAME_MAGIC) break;
+        if (header.first_us > to_us) break;
+        if (header.last_us < from_us) {
+            if (fseek(f, header.stored_size, SEEK_CUR) != 0) break;
+            continue;
+        }
+        stored.resize(header.stored_size);
+        raw.resize(header.raw_size);
+        if (fread(stored.data(), 1, stored.size(), f) != stored.size() ||
+            !decompress_block(header.codec, stored.data(), stored.size(),
+                              raw.data(), raw.size()) ||
+            fnv1a(raw.data(), raw.size()) != header.checksum) {
+            break;
+        }
+        fwrite(raw.data(), 1, raw.size(), out);
+        frames++;
+    }
+    fclose(f);
+    return frames;
+}
+
+} // namespace lumberjack
@@ -7,9 +7,21 @@
 // hot path is a single indirect call with no branch.
 
 #include "lumberjack/lumberjack.h"
+#include "lumberjack/structured.h"
+#include "lumberjack/context.h"
+#include "lumberjack/transaction.h"
+#include "lumberjack/escalation.h"
+#include <atomic>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 namespace lumberjack {
 
@@ -19,6 +31,24 @@ namespace lumberjack {
 
 static void log_noop(LogLevel level, const char* fmt, ...);
 static void log_dispatch(LogLevel level, const char* fmt, ...);
+static void log_site_noop(LogLevel level, const char* file, int line, const char* fmt, ...);
+static void log_site_dispatch(LogLevel level, const char* file, int line, const char* fmt, ...);
+static void log_literal_noop(LogLevel level, const char* file, int line, const char* text, size_t len);
+static void log_literal_dispatch(LogLevel level, const char* file, int line, const char* text, size_t len);
+static void log_kv_noop(LogLevel level, const char* file, int line, const char* message,
+                        const LogField* fields, size_t count);
+static void log_kv_dispatch(LogLevel level, const char* file, int line, const char* message,
+                            const LogField* fields, size_t count);
+static void log_capture(LogLevel level, const char* fmt, ...);
+static void log_site_capture(LogLevel level, const char* file, int line, const char* fmt, ...);
+static void log_literal_capture(LogLevel level, const char* file, int line, const char* text, size_t len);
+static void log_kv_capture(LogLevel level, const char* file, int line, const char* message,
+                           const LogField* fields, size_t count);
+static void log_escalated(LogLevel level, const char* fmt, ...);
+static void log_site_escalated(LogLevel level, const char* file, int line, const char* fmt, ...);
+static void log_literal_escalated(LogLevel level, const char* file, int line, const char* text, size_t len);
+static void log_kv_escalated(LogLevel level, const char* file, int line, const char* message,
+                             const LogField* fields, size_t count);
 static void* span_begin_noop(LogLevel level, const char* name);
 static void* span_begin_dispatch(LogLevel level, const char* name);
 static void span_end_noop(void* handle, LogLevel level, const char* name, long long elapsed_us);
@@ -32,6 +62,7 @@ static void backend_noop_shutdown() {}
 static void backend_noop_log_write(LogLevel, const char*) {}
 static void* backend_noop_span_begin(LogLevel, const char*) { return nullptr; }
 static void backend_noop_span_end(void*, LogLevel, const char*, long long) {}
+static void backend_noop_log_write_batch(const LogRecord*, size_t) {}
 
 // Internal function pointer types for span dispatch.
 using SpanBeginFunction = void* (*)(LogLevel, const char*);
@@ -52,6 +83,18 @@ LogFunction g_logFunctions[LOG_COUNT] = {
     log_noop   // LOG_LEVEL_DEBUG
 };
 
+DispatchTable g_dispatch = {
+    { log_site_noop, log_site_noop, log_site_noop, log_site_noop, log_site_noop },
+    { log_literal_noop, log_literal_noop, log_literal_noop, log_literal_noop, log_literal_noop },
+    { log_kv_noop, log_kv_noop, log_kv_noop, log_kv_noop, log_kv_noop }
+};
+
+LUMBERJACK_THREAD_LOCAL const DispatchTable* t_dispatch = &g_dispatch;
+
+LogSiteFunction (&g_logSiteFunctions)[LOG_COUNT] = g_dispatch.site;
+LogLiteralFunction (&g_logLiteralFunctions)[LOG_COUNT] = g_dispatch.literal;
+LogKvFunction (&g_logKvFunctions)[LOG_COUNT] = g_dispatch.kv;
+
 ClockFunction g_clockFunctions[LOG_COUNT] = {
     clock_noop,
     clock_noop,
@@ -86,24 +129,407 @@ static LogBackend g_activeBackend = {
     backend_noop_shutdown,
     backend_noop_log_write,
     backend_noop_span_begin,
-    backend_noop_span_end
+    backend_noop_span_end,
+    backend_noop_log_write_batch
 };
 
+// ----------------------------------------------------------------------------
+// Line delivery
+//
+// Formatted lines leave the dispatch functions through g_deliver, which
+// set_backend() and set_batching() point at the right path — the same
+// rewiring the dispatch tables use instead of a branch per call:
+//   deliver_v1     — log_write(level, text), for v1 backends.
+//   deliver_record — a one-record log_write_batch() for v2 backends, which
+//                    then see the call site, thread and capture time.
+//   deliver_batch  — the calling thread's batch (set_batching).
+// Structured lines leave through g_deliverKv, set by set_backend():
+//   deliver_kv_native — log_write_kv(record, fields), for backends that
+//                       have it.
+//   deliver_kv_text   — the fields rendered as key=value after the message,
+//                       then g_deliver like any other line.
+// ----------------------------------------------------------------------------
+
+using DeliverFunction = void (*)(LogLevel, const char* file, int line, const char* text, size_t len);
+
+static void deliver_v1(LogLevel level, const char* file, int line, const char* text, size_t len);
+static void deliver_record(LogLevel level, const char* file, int line, const char* text, size_t len);
+static void deliver_batch(LogLevel level, const char* file, int line, const char* text, size_t len);
+
+using DeliverKvFunction = void (*)(LogLevel, const char* file, int line, const char* message,
+                                   const LogField* fields, size_t count);
+
+static void deliver_kv_native(LogLevel level, const char* file, int line, const char* message,
+                              const LogField* fields, size_t count);
+static void deliver_kv_text(LogLevel level, const char* file, int line, const char* message,
+                            const LogField* fields, size_t count);
+
+static DeliverFunction g_deliver = deliver_v1;
+static DeliverKvFunction g_deliverKv = deliver_kv_text;
+static std::atomic<bool> g_batching{false};
+
+static void flush_thread_batch();
+
+uint64_t current_thread_id() {
+    static thread_local uint64_t id = static_cast<uint64_t>(syscall(SYS_gettid));
+    return id;
+}
+
+// The thread's LogContext prefix in both forms. Plain arrays, so records a
+// batch still holds can point into it until the thread is gone.
+static const size_t CONTEXT_BYTES = 512;
+
+struct ThreadContext {
+    char   logfmt[CONTEXT_BYTES];
+    char   json[CONTEXT_BYTES];
+    size_t logfmt_length;
+    size_t json_length;
+};
+
+static thread_local ThreadContext t_context;
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static void fill_record(LogRecord* record, LogLevel level, const char* file, int line,
+                        const char* text, size_t len) {
+    record->level = level;
+    record->message = text;
+    record->length = len;
+    record->timestamp_ns = now_ns();
+    record->thread_id = current_thread_id();
+    record->file = file;
+    record->line = line;
+    record->context = current_context();
+}
+
+static void deliver_v1(LogLevel level, const char*, int, const char* text, size_t) {
+    g_activeBackend.log_write(level, text);
+}
+
+static void deliver_record(LogLevel level, const char* file, int line, const char* text, size_t len) {
+    LogRecord record;
+    fill_record(&record, level, file, line, text, len);
+    g_activeBackend.log_write_batch(&record, 1);
+}
+
+static void deliver_kv_native(LogLevel level, const char* file, int line, const char* message,
+                              const LogField* fields, size_t count) {
+    if (g_batching.load(std::memory_order_relaxed)) flush_thread_batch();
+    LogRecord record;
+    fill_record(&record, level, file, line, message, strlen(message));
+    g_activeBackend.log_write_kv(&record, fields, count);
+}
+
+// Renders "message key=value ..." (logfmt values) into a 1024-byte
+// buffer; fields that do not fit in 1023 bytes are left out.
+static size_t render_kv_text(char* buffer, const char* message, const LogField* fields, size_t count) {
+    size_t len = strnlen(message, 1023);
+    memcpy(buffer, message, len);
+    len += render_fields(buffer + len, 1023 - len, OUTPUT_LOGFMT, fields, count);
+    buffer[len] = '\0';
+    return len;
+}
+
+static void deliver_kv_text(LogLevel level, const char* file, int line, const char* message,
+                            const LogField* fields, size_t count) {
+    char buffer[1024];
+    size_t len = render_kv_text(buffer, message, fields, count);
+    g_deliver(level, file, line, buffer, len);
+}
+
+// log_write for v2 backends that leave it null: span output and lines
+// forwarded through get_backend() arrive as one-record batches.
+static void adapter_log_write(LogLevel level, const char* message) {
+    deliver_record(level, nullptr, 0, message, strlen(message));
+}
+
+// log_write_batch for v1 backends: unpacks the batch into log_write calls.
+// Set on the installed copy, so get_backend()->log_write_batch always works.
+static void adapter_log_write_batch(const LogRecord* records, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        g_activeBackend.log_write(records[i].level, records[i].message);
+    }
+}
+
+// Formats into a fixed buffer and returns the message length, which
+// vsnprintf reports untruncated.
+static size_t format_message(char* buffer, size_t size, const char* fmt, va_list args) {
+    int len = vsnprintf(buffer, size, fmt, args);
+    if (len < 0) {
+        buffer[0] = '\0';
+        return 0;
+    }
+    return static_cast<size_t>(len) < size ? static_cast<size_t>(len) : size - 1;
+}
+
+// ----------------------------------------------------------------------------
+// Transactions
+//
+// t_transaction is the thread's open LogTransaction, or null. Dispatch
+// functions offer each line to it before delivering it, and lines it holds
+// are copied into its arena instead. Once a transaction has been opened,
+// set_level() points the disabled levels at the *_capture functions, which
+// do the same for lines that would otherwise be dropped.
+// ----------------------------------------------------------------------------
+
+// A held line. The arena holds its message, a NUL, then its context in
+// logfmt and in JSON form.
+struct HeldRecord {
+    LogLevel    level;
+    int64_t     timestamp_ns;
+    const char* file;
+    int         line;
+    size_t      offset;
+    size_t      length;
+    size_t      logfmt_length;
+    size_t      json_length;
+};
+
+struct LogTransaction::State {
+    TransactionOptions      options;
+    bool                    keep = false;
+    size_t                  dropped = 0;
+    std::vector<char>       arena;      // at least max_bytes; kept between transactions
+    size_t                  used = 0;
+    std::vector<HeldRecord> records;
+};
+
+static thread_local LogTransaction::State* t_transaction = nullptr;
+static std::atomic<bool> g_transactionsUsed{false};
+
+// Copies a line into the transaction. Returns false, holding nothing, for
+// lines more verbose than its capture_level.
+static bool hold(LogTransaction::State* tx, LogLevel level, const char* file, int line,
+                 const char* text, size_t len) {
+    if (level > tx->options.capture_level) return false;
+    if (level <= tx->options.keep_level) tx->keep = true;
+
+    const ThreadContext& context = t_context;
+    size_t need = len + 1 + context.logfmt_length + context.json_length;
+    if (need > tx->options.max_bytes - tx->used) {
+        tx->dropped++;
+        return true;
+    }
+    char* out = tx->arena.data() + tx->used;
+    memcpy(out, text, len);
+    out[len] = '\0';
+    memcpy(out + len + 1, context.logfmt, context.logfmt_length);
+    memcpy(out + len + 1 + context.logfmt_length, context.json, context.json_length);
+    tx->records.push_back({ level, now_ns(), file, line, tx->used, len,
+                            context.logfmt_length, context.json_length });
+    tx->used += need;
+    return true;
+}
+
+// The level that starts an escalation, or LOG_LEVEL_NONE, which no line
+// has, while escalation is off. The wiring reads it to give the levels
+// this severe the trigger variants, so a line pays nothing for it.
+static std::atomic<int> g_escalationTrigger{LOG_LEVEL_NONE};
+
+static void escalate();
+static bool spend_escalated_line();
+
+// Where formatted lines go: into the thread's transaction, or g_deliver.
+static inline void deliver_line(LogLevel level, const char* file, int line, const char* text, size_t len) {
+    LogTransaction::State* tx = t_transaction;
+    if (tx && hold(tx, level, file, line, text, len)) return;
+    g_deliver(level, file, line, text, len);
+}
+
+static const size_t COMMIT_RECORDS = 64;
+
+// Hands the held lines to the backend as records, COMMIT_RECORDS at a
+// time, after the thread's pending batch.
+static void commit_transaction(const LogTransaction::State& tx) {
+    if (g_batching.load(std::memory_order_relaxed)) flush_thread_batch();
+    LogRecord batch[COMMIT_RECORDS];
+    size_t n = 0;
+    uint64_t thread_id = current_thread_id();
+    for (const HeldRecord& held : tx.records) {
+        const char* text = tx.arena.data() + held.offset;
+        const char* logfmt = text + held.length + 1;
+        LogRecord& record = batch[n++];
+        record = { held.level, text, held.length, held.timestamp_ns, thread_id, held.file, held.line,
+                   { logfmt, held.logfmt_length, logfmt + held.logfmt_length, held.json_length } };
+        if (n == COMMIT_RECORDS) {
+            g_activeBackend.log_write_batch(batch, n);
+            n = 0;
+        }
+    }
+    char message[80];
+    if (tx.dropped > 0) {
+        int len = snprintf(message, sizeof(message), "transaction buffer full, %zu lines dropped", tx.dropped);
+        LogRecord& record = batch[n++];
+        fill_record(&record, LOG_LEVEL_WARN, nullptr, 0, message, static_cast<size_t>(len));
+    }
+    if (n > 0) g_activeBackend.log_write_batch(batch, n);
+}
+
 // ----------------------------------------------------------------------------
 // No-op implementations — immediate return, no work
 // ----------------------------------------------------------------------------
 
 static void log_noop(LogLevel, const char*, ...) {}
 
+static void log_site_noop(LogLevel, const char*, int, const char*, ...) {}
+
+static void log_literal_noop(LogLevel, const char*, int, const char*, size_t) {}
+
 // Formats the message via vsnprintf and forwards to the active backend.
 static void log_dispatch(LogLevel level, const char* fmt, ...) {
     char buffer[1024];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    size_t len = format_message(buffer, sizeof(buffer), fmt, args);
     va_end(args);
 
-    g_activeBackend.log_write(level, buffer);
+    deliver_line(level, nullptr, 0, buffer, len);
+}
+
+// As log_dispatch, keeping the call site for the record.
+static void log_site_dispatch(LogLevel level, const char* file, int line, const char* fmt, ...) {
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    size_t len = format_message(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    deliver_line(level, file, line, buffer, len);
+}
+
+// Hands an argument-less message to the backend as it is. Messages longer
+// than a formatted one could be are cut to the same 1023 bytes.
+static void log_literal_dispatch(LogLevel level, const char* file, int line, const char* text, size_t len) {
+    char buffer[1024];
+    if (len >= sizeof(buffer)) {
+        len = sizeof(buffer) - 1;
+        memcpy(buffer, text, len);
+        buffer[len] = '\0';
+        text = buffer;
+    }
+    deliver_line(level, file, line, text, len);
+}
+
+static void log_kv_noop(LogLevel, const char*, int, const char*, const LogField*, size_t) {}
+
+// Hands a structured line to the active backend: natively, or as text.
+// A transaction holds it as text.
+static void log_kv_dispatch(LogLevel level, const char* file, int line, const char* message,
+                            const LogField* fields, size_t count) {
+    LogTransaction::State* tx = t_transaction;
+    if (tx && level <= tx->options.capture_level) {
+        char buffer[1024];
+        hold(tx, level, file, line, buffer, render_kv_text(buffer, message, fields, count));
+        return;
+    }
+    g_deliverKv(level, file, line, message, fields, count);
+}
+
+// Capture variants, for disabled levels once transactions are in use:
+// format and hold the line if the thread's transaction takes it, else
+// return like the no-ops.
+static void log_capture(LogLevel level, const char* fmt, ...) {
+    LogTransaction::State* tx = t_transaction;
+    if (!tx || level > tx->options.capture_level) return;
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    size_t len = format_message(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    hold(tx, level, nullptr, 0, buffer, len);
+}
+
+static void log_site_capture(LogLevel level, const char* file, int line, const char* fmt, ...) {
+    LogTransaction::State* tx = t_transaction;
+    if (!tx || level > tx->options.capture_level) return;
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    size_t len = format_message(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    hold(tx, level, file, line, buffer, len);
+}
+
+static void log_literal_capture(LogLevel level, const char* file, int line, const char* text, size_t len) {
+    LogTransaction::State* tx = t_transaction;
+    if (!tx) return;
+    hold(tx, level, file, line, text, len < 1023 ? len : 1023);
+}
+
+static void log_kv_capture(LogLevel level, const char* file, int line, const char* message,
+                           const LogField* fields, size_t count) {
+    LogTransaction::State* tx = t_transaction;
+    if (!tx || level > tx->options.capture_level) return;
+    char buffer[1024];
+    hold(tx, level, file, line, buffer, render_kv_text(buffer, message, fields, count));
+}
+
+// Escalated variants, for the levels an escalation turned on: spend one
+// line of its budget, or drop the line and lower the level if the budget
+// or the window is spent, before dispatching as usual.
+static void log_escalated(LogLevel level, const char* fmt, ...) {
+    if (!spend_escalated_line()) return;
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    size_t len = format_message(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    deliver_line(level, nullptr, 0, buffer, len);
+}
+
+static void log_site_escalated(LogLevel level, const char* file, int line, const char* fmt, ...) {
+    if (!spend_escalated_line()) return;
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    size_t len = format_message(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    deliver_line(level, file, line, buffer, len);
+}
+
+static void log_literal_escalated(LogLevel level, const char* file, int line, const char* text, size_t len) {
+    if (spend_escalated_line()) log_literal_dispatch(level, file, line, text, len);
+}
+
+static void log_kv_escalated(LogLevel level, const char* file, int line, const char* message,
+                             const LogField* fields, size_t count) {
+    if (spend_escalated_line()) log_kv_dispatch(level, file, line, message, fields, count);
+}
+
+// Trigger variants, for the enabled levels at or above the trigger level
+// while escalation is on: start an escalation, then dispatch as usual.
+static void log_triggered(LogLevel level, const char* fmt, ...) {
+    escalate();
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    size_t len = format_message(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    deliver_line(level, nullptr, 0, buffer, len);
+}
+
+static void log_site_triggered(LogLevel level, const char* file, int line, const char* fmt, ...) {
+    escalate();
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    size_t len = format_message(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    deliver_line(level, file, line, buffer, len);
+}
+
+static void log_literal_triggered(LogLevel level, const char* file, int line, const char* text, size_t len) {
+    escalate();
+    log_literal_dispatch(level, file, line, text, len);
+}
+
+static void log_kv_triggered(LogLevel level, const char* file, int line, const char* message,
+                             const LogField* fields, size_t count) {
+    escalate();
+    log_kv_dispatch(level, file, line, message, fields, count);
 }
 
 static void* span_begin_noop(LogLevel, const char*) {
@@ -141,18 +567,67 @@ void init() {
     set_level(LOG_LEVEL_INFO);
 }
 
-// Rewires all four dispatch tables so that levels [1..level] point to real
-// implementations and everything else points to no-ops. Index 0 (NONE) is
-// always a no-op.
-void set_level(LogLevel level) {
+// Wires a DispatchTable so that levels [1..level] point to real
+// implementations and everything else points to no-ops, or to the capture
+// variants when capture is set. Levels an escalation turned on, (base..
+// level], get the escalated variants, and enabled levels at or above the
+// escalation trigger the trigger variants. Index 0 (NONE) is always a
+// no-op.
+static void wire_table(DispatchTable& table, LogLevel level, LogLevel base, bool capture) {
+    int trigger = g_escalationTrigger.load(std::memory_order_relaxed);
+    for (int i = 0; i < LOG_COUNT; i++) {
+        if (i > 0 && i <= base) {
+            table.site[i]    = i <= trigger ? log_site_triggered : log_site_dispatch;
+            table.literal[i] = i <= trigger ? log_literal_triggered : log_literal_dispatch;
+            table.kv[i]      = i <= trigger ? log_kv_triggered : log_kv_dispatch;
+        } else if (i > 0 && i <= level) {
+            table.site[i]    = log_site_escalated;
+            table.literal[i] = log_literal_escalated;
+            table.kv[i]      = log_kv_escalated;
+        } else if (i > 0 && capture) {
+            table.site[i]    = log_site_capture;
+            table.literal[i] = log_literal_capture;
+            table.kv[i]      = log_kv_capture;
+        } else {
+            table.site[i]    = log_site_noop;
+            table.literal[i] = log_literal_noop;
+            table.kv[i]      = log_kv_noop;
+        }
+    }
+}
+
+// Rewires all global dispatch tables so that levels [1..level] point to
+// real implementations and everything else points to no-ops — or, once
+// transactions are in use, the log tables' disabled levels to the capture
+// variants. base is below level while a process escalation runs. Threads
+// with a level override keep their own tables.
+//
+// Spans and the clock follow base: a span cannot spend the line budget at
+// its start, and one opened during an escalation would still log after it
+// had ended, so escalation leaves them alone.
+static void wire_global(LogLevel level, LogLevel base) {
     g_currentLevel = level;
+    bool capture = g_transactionsUsed.load(std::memory_order_relaxed);
+
+    int trigger = g_escalationTrigger.load(std::memory_order_relaxed);
 
+    wire_table(g_dispatch, level, base, capture);
     for (int i = 0; i < LOG_COUNT; i++) {
-        if (i > 0 && i <= level) {
-            g_logFunctions[i]       = log_dispatch;
+        if (i > 0 && i <= base) {
+            g_logFunctions[i]       = i <= trigger ? log_triggered : log_dispatch;
             g_clockFunctions[i]     = clock_real;
             g_spanBeginFunctions[i] = span_begin_dispatch;
             g_spanEndFunctions[i]   = span_end_dispatch;
+        } else if (i > 0 && i <= level) {
+            g_logFunctions[i]       = log_escalated;
+            g_clockFunctions[i]     = clock_noop;
+            g_spanBeginFunctions[i] = span_begin_noop;
+            g_spanEndFunctions[i]   = span_end_noop;
+        } else if (i > 0 && capture) {
+            g_logFunctions[i]       = log_capture;
+            g_clockFunctions[i]     = clock_noop;
+            g_spanBeginFunctions[i] = span_begin_noop;
+            g_spanEndFunctions[i]   = span_end_noop;
         } else {
             g_logFunctions[i]       = log_noop;
             g_clockFunctions[i]     = clock_noop;
@@ -162,24 +637,222 @@ void set_level(LogLevel level) {
     }
 }
 
+static void end_process_escalation(LogLevel level);
+
+// Rewires the global tables for level, ending any process escalation.
+void set_level(LogLevel level) {
+    end_process_escalation(level);
+}
+
 LogLevel get_level() {
     return g_currentLevel;
 }
 
-// Validates that all function pointers are non-null, shuts down the current
-// backend, shallow-copies the new one into g_activeBackend, and calls init().
+// ----------------------------------------------------------------------------
+// Per-thread level overrides
+// ----------------------------------------------------------------------------
+
+// A thread's own dispatch tables, which t_dispatch points at while an
+// override is set. capture records whether they were wired with the
+// transaction capture variants. While a thread escalation runs, base is
+// the level before it, and restore_* the override to go back to.
+struct ThreadDispatch {
+    DispatchTable table;
+    LogLevel      level;
+    LogLevel      base;
+    bool          active;
+    bool          capture;
+    bool          escalated;
+    bool          restore_active;
+    LogLevel      restore_level;
+    size_t        budget;
+    int64_t       deadline_ns;
+};
+
+static thread_local ThreadDispatch t_threadDispatch = {};
+
+static void wire_thread(LogLevel level, LogLevel base) {
+    bool capture = g_transactionsUsed.load(std::memory_order_relaxed);
+    wire_table(t_threadDispatch.table, level, base, capture);
+    t_threadDispatch.level = level;
+    t_threadDispatch.base = base;
+    t_threadDispatch.active = true;
+    t_threadDispatch.capture = capture;
+    t_dispatch = &t_threadDispatch.table;
+}
+
+void set_thread_level(LogLevel level) {
+    t_threadDispatch.escalated = false;
+    wire_thread(level, level);
+}
+
+void clear_thread_level() {
+    t_threadDispatch.escalated = false;
+    t_threadDispatch.active = false;
+    t_dispatch = &g_dispatch;
+}
+
+LogLevel get_thread_level() {
+    return t_threadDispatch.active ? t_threadDispatch.level : g_currentLevel;
+}
+
+// A guard opened during a thread escalation restores what the escalation
+// would have.
+ThreadLevelOverride::ThreadLevelOverride(LogLevel level)
+    : m_previous(t_threadDispatch.escalated ? t_threadDispatch.restore_level : t_threadDispatch.level)
+    , m_hadPrevious(t_threadDispatch.escalated ? t_threadDispatch.restore_active : t_threadDispatch.active)
+{
+    set_thread_level(level);
+}
+
+ThreadLevelOverride::~ThreadLevelOverride() {
+    if (m_hadPrevious) {
+        set_thread_level(m_previous);
+    } else {
+        clear_thread_level();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Escalation
+// ----------------------------------------------------------------------------
+
+// g_escalationMutex guards the options and starting or ending a process
+// escalation; the counting variants read the budget and deadline without
+// it.
+static std::mutex g_escalationMutex;
+static EscalationOptions g_escalationOptions;
+static std::atomic<int> g_escalationScope{ESCALATE_PROCESS};
+static std::atomic<bool> g_processEscalated{false};
+static std::atomic<long long> g_processBudget{0};
+static std::atomic<int64_t> g_processDeadline{0};
+static LogLevel g_processBase = LOG_LEVEL_INFO;
+
+// Lowers the global tables back to the level before the escalation.
+// Caller holds g_escalationMutex.
+static void lower_process_locked() {
+    if (!g_processEscalated.load(std::memory_order_relaxed)) return;
+    g_processEscalated.store(false, std::memory_order_relaxed);
+    wire_global(g_processBase, g_processBase);
+}
+
+// Ends any process escalation and wires the global tables for level under
+// the one lock, so that a trigger line on another thread cannot start an
+// escalation in between that nothing would end.
+static void end_process_escalation(LogLevel level) {
+    std::lock_guard<std::mutex> lock(g_escalationMutex);
+    g_processEscalated.store(false, std::memory_order_relaxed);
+    wire_global(level, level);
+}
+
+static void lower_thread() {
+    ThreadDispatch& t = t_threadDispatch;
+    t.escalated = false;
+    if (t.restore_active) {
+        wire_thread(t.restore_level, t.restore_level);
+    } else {
+        clear_thread_level();
+    }
+}
+
+// Starts an escalation for a trigger line, unless one is running.
+static void escalate() {
+    if (g_escalationScope.load(std::memory_order_relaxed) == ESCALATE_THREAD) {
+        ThreadDispatch& t = t_threadDispatch;
+        if (t.escalated) return;
+        LogLevel base = get_thread_level();
+        EscalationOptions options;
+        {
+            std::lock_guard<std::mutex> lock(g_escalationMutex);
+            options = g_escalationOptions;
+        }
+        if (options.level <= base) return;
+        t.restore_active = t.active;
+        t.restore_level = t.level;
+        t.budget = options.max_lines;
+        t.deadline_ns = now_ns() + static_cast<int64_t>(options.window_ms) * 1000000;
+        wire_thread(options.level, base);
+        t.escalated = true;
+        return;
+    }
+
+    if (g_processEscalated.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> lock(g_escalationMutex);
+    if (g_processEscalated.load(std::memory_order_relaxed)) return;
+    const EscalationOptions& options = g_escalationOptions;
+    LogLevel base = g_currentLevel;
+    if (options.level <= base) return;
+    g_processBase = base;
+    g_processBudget.store(static_cast<long long>(options.max_lines), std::memory_order_relaxed);
+    g_processDeadline.store(now_ns() + static_cast<int64_t>(options.window_ms) * 1000000,
+                            std::memory_order_relaxed);
+    g_processEscalated.store(true, std::memory_order_relaxed);
+    wire_global(options.level, base);
+}
+
+// Called by the escalated variants. Returns true if the line may be
+// logged; otherwise the escalation is over and the level lowered.
+static bool spend_escalated_line() {
+    ThreadDispatch& t = t_threadDispatch;
+    if (t.escalated) {
+        if (t.budget > 0 && now_ns() < t.deadline_ns &&
+            g_escalationTrigger.load(std::memory_order_relaxed) != LOG_LEVEL_NONE) {
+            t.budget--;
+            return true;
+        }
+        lower_thread();
+        return false;
+    }
+
+    if (g_processEscalated.load(std::memory_order_relaxed) &&
+        g_processBudget.fetch_sub(1, std::memory_order_relaxed) > 0 &&
+        now_ns() < g_processDeadline.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(g_escalationMutex);
+    lower_process_locked();
+    return false;
+}
+
+void set_escalation(bool enabled, const EscalationOptions& options) {
+    std::lock_guard<std::mutex> lock(g_escalationMutex);
+    g_escalationOptions = options;
+    g_escalationScope.store(options.scope, std::memory_order_relaxed);
+    g_escalationTrigger.store(enabled ? options.trigger_level : LOG_LEVEL_NONE, std::memory_order_relaxed);
+    LogLevel level = g_processEscalated.load(std::memory_order_relaxed) ? g_processBase : g_currentLevel;
+    g_processEscalated.store(false, std::memory_order_relaxed);
+    wire_global(level, level);
+    if (t_threadDispatch.active) wire_thread(t_threadDispatch.level, t_threadDispatch.base);
+}
+
+bool escalated() {
+    if (t_threadDispatch.active) return t_threadDispatch.escalated;
+    return g_processEscalated.load(std::memory_order_relaxed);
+}
+
+// Validates the function pointers, delivers pending batches and shuts down
+// the current backend, shallow-copies the new one into g_activeBackend with
+// adapters for whichever of log_write / log_write_batch it lacks, and calls
+// init().
 void set_backend(LogBackend* backend) {
     if (!backend ||
         !backend->init ||
         !backend->shutdown ||
-        !backend->log_write ||
+        (!backend->log_write && !backend->log_write_batch) ||
         !backend->span_begin ||
         !backend->span_end) {
         return;
     }
 
+    flush_batches();
     g_activeBackend.shutdown();
     g_activeBackend = *backend;
+    if (!g_activeBackend.log_write) g_activeBackend.log_write = adapter_log_write;
+    if (!g_activeBackend.log_write_batch) g_activeBackend.log_write_batch = adapter_log_write_batch;
+    if (!g_batching.load(std::memory_order_relaxed)) {
+        g_deliver = backend->log_write_batch ? deliver_record : deliver_v1;
+    }
+    g_deliverKv = backend->log_write_kv ? deliver_kv_native : deliver_kv_text;
     g_activeBackend.init();
 }
 
@@ -187,6 +860,264 @@ LogBackend* get_backend() {
     return &g_activeBackend;
 }
 
+// ----------------------------------------------------------------------------
+// Global sequence
+// ----------------------------------------------------------------------------
+
+static std::atomic<uint64_t> g_sequence{0};
+
+uint64_t next_sequence() {
+    return g_sequence.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+// Batching
+//
+// Each logging thread owns a ThreadBatch: records plus an arena holding
+// their text. Appending takes the batch's own mutex, which only the
+// flusher thread and flush_batches() contend for. A batch is delivered
+// with one log_write_batch() call under that mutex, so records of one
+// thread stay in order. The thread's BatchOwner delivers what is left and
+// frees the batch when the thread exits.
+// ----------------------------------------------------------------------------
+
+static const size_t MAX_BATCH_RECORDS = 256;
+static const size_t BATCH_ARENA_BYTES = 32 * 1024;
+
+struct ThreadBatch {
+    std::mutex mutex;
+    LogRecord  records[MAX_BATCH_RECORDS];
+    char       arena[BATCH_ARENA_BYTES];
+    size_t     count = 0;
+    size_t     used = 0;
+
+    // Caller holds mutex.
+    void deliver_locked() {
+        if (count == 0) return;
+        g_activeBackend.log_write_batch(records, count);
+        count = 0;
+        used = 0;
+    }
+};
+
+static std::mutex                g_batchesMutex;
+static std::vector<ThreadBatch*> g_batches;
+static std::atomic<size_t>       g_batchRecords{64};
+static std::atomic<int>          g_batchFlushLevel{LOG_LEVEL_ERROR};
+
+static std::mutex                g_batchFlusherMutex;
+static std::condition_variable   g_batchFlusherCv;
+static bool                      g_batchFlusherStop = false;
+static unsigned                  g_batchIntervalMs = 100;
+static std::thread               g_batchFlusher;
+
+struct BatchOwner {
+    ThreadBatch* batch = nullptr;
+
+    ~BatchOwner() {
+        if (!batch) return;
+        {
+            std::lock_guard<std::mutex> lock(g_batchesMutex);
+            for (size_t i = 0; i < g_batches.size(); i++) {
+                if (g_batches[i] == batch) {
+                    g_batches[i] = g_batches.back();
+                    g_batches.pop_back();
+                    break;
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->deliver_locked();
+        }
+        delete batch;
+    }
+};
+
+static thread_local BatchOwner t_batchOwner;
+
+static ThreadBatch* thread_batch() {
+    if (!t_batchOwner.batch) {
+        t_batchOwner.batch = new ThreadBatch();
+        std::lock_guard<std::mutex> lock(g_batchesMutex);
+        g_batches.push_back(t_batchOwner.batch);
+    }
+    return t_batchOwner.batch;
+}
+
+// Delivers the calling thread's pending batch, if it has one.
+static void flush_thread_batch() {
+    ThreadBatch* batch = t_batchOwner.batch;
+    if (!batch) return;
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    batch->deliver_locked();
+}
+
+static void deliver_batch(LogLevel level, const char* file, int line, const char* text, size_t len) {
+    ThreadBatch* batch = thread_batch();
+    size_t limit = g_batchRecords.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    if (batch->count >= limit || batch->used + len + 1 > BATCH_ARENA_BYTES) batch->deliver_locked();
+
+    char* stored = batch->arena + batch->used;
+    memcpy(stored, text, len);
+    stored[len] = '\0';
+    batch->used += len + 1;
+    fill_record(&batch->records[batch->count++], level, file, line, stored, len);
+
+    if (batch->count >= limit || level <= g_batchFlushLevel.load(std::memory_order_relaxed)) {
+        batch->deliver_locked();
+    }
+}
+
+// Delivers batches whose first record is older than the interval.
+static void batch_flusher_main() {
+    std::unique_lock<std::mutex> lock(g_batchFlusherMutex);
+    while (!g_batchFlusherStop) {
+        int64_t interval_ns = static_cast<int64_t>(g_batchIntervalMs) * 1000000;
+        g_batchFlusherCv.wait_for(lock, std::chrono::milliseconds(g_batchIntervalMs / 2 + 1));
+        if (g_batchFlusherStop) break;
+        int64_t cutoff = now_ns() - interval_ns;
+
+        std::lock_guard<std::mutex> batches_lock(g_batchesMutex);
+        for (ThreadBatch* batch : g_batches) {
+            std::lock_guard<std::mutex> batch_lock(batch->mutex);
+            if (batch->count > 0 && batch->records[0].timestamp_ns <= cutoff) batch->deliver_locked();
+        }
+    }
+}
+
+static void batch_flusher_stop() {
+    {
+        std::lock_guard<std::mutex> lock(g_batchFlusherMutex);
+        if (!g_batchFlusher.joinable()) return;
+        g_batchFlusherStop = true;
+    }
+    g_batchFlusherCv.notify_one();
+    g_batchFlusher.join();
+    g_batchFlusherStop = false;
+}
+
+// Stops the flusher before the state above is destroyed at exit.
+static struct BatchAutoStop {
+    ~BatchAutoStop() { batch_flusher_stop(); }
+} g_batchAutoStop;
+
+void set_batching(bool enabled, const BatchOptions& options) {
+    batch_flusher_stop();
+    g_batching.store(false, std::memory_order_relaxed);
+    g_deliver = g_activeBackend.log_write_batch != adapter_log_write_batch ? deliver_record : deliver_v1;
+    flush_batches();
+    if (!enabled) return;
+
+    size_t records = options.records;
+    if (records < 1) records = 1;
+    if (records > MAX_BATCH_RECORDS) records = MAX_BATCH_RECORDS;
+    g_batchRecords.store(records, std::memory_order_relaxed);
+    g_batchFlushLevel.store(options.flush_level, std::memory_order_relaxed);
+    g_batchIntervalMs = options.interval_ms ? options.interval_ms : 1;
+    g_batching.store(true, std::memory_order_relaxed);
+    g_deliver = deliver_batch;
+    g_batchFlusher = std::thread(batch_flusher_main);
+}
+
+void flush_batches() {
+    std::lock_guard<std::mutex> lock(g_batchesMutex);
+    for (ThreadBatch* batch : g_batches) {
+        std::lock_guard<std::mutex> batch_lock(batch->mutex);
+        batch->deliver_locked();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Context
+// ----------------------------------------------------------------------------
+
+RecordContext current_context() {
+    const ThreadContext& context = t_context;
+    return { context.logfmt, context.logfmt_length, context.json, context.json_length };
+}
+
+// Renders the fields onto the end of both prefixes.
+LogContext::LogContext(std::initializer_list<LogField> fields)
+    : m_logfmtLength(t_context.logfmt_length)
+    , m_jsonLength(t_context.json_length)
+{
+    ThreadContext& context = t_context;
+    context.logfmt_length += render_fields(context.logfmt + context.logfmt_length,
+                                           CONTEXT_BYTES - context.logfmt_length,
+                                           OUTPUT_LOGFMT, fields.begin(), fields.size());
+    context.json_length += render_fields(context.json + context.json_length,
+                                         CONTEXT_BYTES - context.json_length,
+                                         OUTPUT_JSON, fields.begin(), fields.size());
+}
+
+// Batched records point into the bytes about to be given up (and later
+// overwritten by the next scope), so they are delivered first.
+LogContext::~LogContext() {
+    if (g_batching.load(std::memory_order_relaxed)) flush_thread_batch();
+    t_context.logfmt_length = m_logfmtLength;
+    t_context.json_length = m_jsonLength;
+}
+
+// ----------------------------------------------------------------------------
+// LogTransaction
+// ----------------------------------------------------------------------------
+
+// Installs the capture functions, once.
+static void use_transactions() {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (g_transactionsUsed.load(std::memory_order_relaxed)) return;
+    g_transactionsUsed.store(true, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> escalation(g_escalationMutex);
+    wire_global(g_currentLevel, g_processEscalated.load(std::memory_order_relaxed) ? g_processBase : g_currentLevel);
+}
+
+// The outermost transaction on a thread takes the thread's state, whose
+// arena is allocated once and reused; nested ones join it.
+LogTransaction::LogTransaction(const TransactionOptions& options)
+    : m_state(t_transaction)
+    , m_owner(t_transaction == nullptr)
+    , m_exceptions(std::uncaught_exceptions())
+    , m_slowUs(options.slow_us)
+    , m_start(options.slow_us > 0 ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+{
+    if (!g_transactionsUsed.load(std::memory_order_relaxed)) use_transactions();
+    if (!m_owner) return;
+    // An override set before the first transaction lacks the capture
+    // variants; set_level() only rewires the global tables.
+    if (t_threadDispatch.active && !t_threadDispatch.capture) wire_thread(t_threadDispatch.level, t_threadDispatch.base);
+
+    static thread_local State state;
+    state.options = options;
+    state.keep = false;
+    state.dropped = 0;
+    state.used = 0;
+    state.records.clear();
+    if (state.arena.size() < options.max_bytes) state.arena.resize(options.max_bytes);
+    m_state = &state;
+    t_transaction = m_state;
+}
+
+LogTransaction::~LogTransaction() {
+    if (std::uncaught_exceptions() > m_exceptions) m_state->keep = true;
+    if (m_slowUs > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_start).count();
+        if (elapsed >= m_slowUs) m_state->keep = true;
+    }
+    if (!m_owner) return;
+
+    t_transaction = nullptr;
+    if (m_state->keep) commit_transaction(*m_state);
+    m_state->records.clear();
+}
+
+void LogTransaction::keep() {
+    m_state->keep = true;
+}
+
 // ----------------------------------------------------------------------------
 // Span implementation
 // ----------------------------------------------------------------------------
@@ -0,0 +1,127 @@
+// crash.cpp — Opt-in fatal signal handler that flushes buffered log output.
+//
+// The handler runs the registered flush hooks once, puts back whatever
+// handlers were installed before it and re-raises the signal. The signal is
+// blocked while the handler runs, so the re-raised one is delivered to the
+// previous disposition as soon as the handler returns.
+//
+// The first thread to crash claims the flush with a compare-exchange. A
+// thread crashing while the hooks run waits for them to finish before it
+// re-raises, so it cannot kill the process halfway through the flush; a
+// hook that crashes its own thread skips the wait and re-raises at once.
+
+#include "lumberjack/lumberjack.h"
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <mutex>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace lumberjack {
+
+// ---------------------------------------------------------------------------
+// State
+// ---------------------------------------------------------------------------
+
+static const int g_crashSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+static const size_t CRASH_SIGNAL_COUNT = sizeof(g_crashSignals) / sizeof(g_crashSignals[0]);
+static const size_t MAX_CRASH_HOOKS = 16;
+
+enum { CRASH_IDLE, CRASH_FLUSHING, CRASH_FLUSHED };
+
+// Hooks are registered from static initializers as well as at runtime, so
+// everything here is constant-initialized.
+static std::mutex                        g_mutex;
+static std::atomic<CrashFlushFunction>   g_hooks[MAX_CRASH_HOOKS];
+static std::atomic<size_t>               g_hookCount{0};
+
+static struct sigaction      g_previous[CRASH_SIGNAL_COUNT];
+static bool                  g_installed = false;
+static std::atomic<int>      g_crashState{0};   // CRASH_*
+static std::atomic<long>     g_crashThread{0};  // kernel thread id running the hooks
+
+// Alternate stack so a stack overflow can still run the hooks. It is only
+// set up for the thread that calls install_crash_handler().
+static char g_altStack[64 * 1024];
+
+// ---------------------------------------------------------------------------
+// Handler
+// ---------------------------------------------------------------------------
+
+static void crash_handler(int signo, siginfo_t*, void*) {
+    long self = syscall(SYS_gettid);
+    int idle = CRASH_IDLE;
+    if (g_crashState.compare_exchange_strong(idle, CRASH_FLUSHING, std::memory_order_acq_rel)) {
+        g_crashThread.store(self, std::memory_order_relaxed);
+        size_t count = g_hookCount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            CrashFlushFunction hook = g_hooks[i].load(std::memory_order_relaxed);
+            if (hook) hook(signo);
+        }
+        g_crashState.store(CRASH_FLUSHED, std::memory_order_release);
+    } else if (g_crashThread.load(std::memory_order_relaxed) != self) {
+        struct timespec interval = { 0, 1000000 };
+        while (g_crashState.load(std::memory_order_acquire) != CRASH_FLUSHED) nanosleep(&interval, nullptr);
+    }
+
+    for (size_t i = 0; i < CRASH_SIGNAL_COUNT; i++) {
+        if (g_crashSignals[i] == signo) sigaction(signo, &g_previous[i], nullptr);
+    }
+    raise(signo);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+bool install_crash_handler() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_installed) return true;
+
+    stack_t stack = {};
+    stack.ss_sp = g_altStack;
+    stack.ss_size = sizeof(g_altStack);
+    sigaltstack(&stack, nullptr);
+
+    struct sigaction action = {};
+    action.sa_sigaction = crash_handler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+
+    for (size_t i = 0; i < CRASH_SIGNAL_COUNT; i++) {
+        if (sigaction(g_crashSignals[i], &action, &g_previous[i]) != 0) {
+            while (i-- > 0) sigaction(g_crashSignals[i], &g_previous[i], nullptr);
+            return false;
+        }
+    }
+    g_crashState.store(CRASH_IDLE, std::memory_order_relaxed);
+    g_crashThread.store(0, std::memory_order_relaxed);
+    g_installed = true;
+    return true;
+}
+
+void uninstall_crash_handler() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_installed) return;
+    for (size_t i = 0; i < CRASH_SIGNAL_COUNT; i++) {
+        sigaction(g_crashSignals[i], &g_previous[i], nullptr);
+    }
+    g_installed = false;
+}
+
+bool register_crash_flush(CrashFlushFunction hook) {
+    if (!hook) return false;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    size_t count = g_hookCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        if (g_hooks[i].load(std::memory_order_relaxed) == hook) return true;
+    }
+    if (count == MAX_CRASH_HOOKS) return false;
+    g_hooks[count].store(hook, std::memory_order_relaxed);
+    g_hookCount.store(count + 1, std::memory_order_release);
+    return true;
+}
+
+} // namespace lumberjack
@@ -0,0 +1,259 @@
+// escape.cpp — Vectorized scanning for JSON / logfmt escaping.
+//
+// Each kernel answers one question: where is the next byte that needs
+// attention? The SIMD versions compare a whole register of bytes against
+// the special characters at once and turn the result into a bit mask; the
+// first set bit is the answer. The escaping itself stays scalar, since the
+// bytes it handles are rare in log messages.
+//
+// The kernel is chosen on first use through the same function pointer
+// rewiring the dispatch tables use: the pointers start at a resolver that
+// checks the CPU, installs the best kernel and forwards the call. The
+// pointers are relaxed atomics, so a call racing with the install takes
+// the resolver or the kernel, both of which give the same answer.
+
+#include "lumberjack/utils.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LUMBERJACK_ESCAPE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace lumberjack {
+
+// ----------------------------------------------------------------------------
+// Scalar kernel
+// ----------------------------------------------------------------------------
+
+static inline bool is_control(unsigned char c) {
+    return c < 0x20 || c == 0x7f;
+}
+
+static inline bool needs_escape(unsigned char c) {
+    return is_control(c) || c == '"' || c == '\\';
+}
+
+static size_t find_escape_scalar(const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (needs_escape(static_cast<unsigned char>(text[i]))) return i;
+    }
+    return length;
+}
+
+static size_t find_control_scalar(const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (is_control(static_cast<unsigned char>(text[i]))) return i;
+    }
+    return length;
+}
+
+// ----------------------------------------------------------------------------
+// SSE2 and AVX2 kernels
+//
+// Bytes below 0x20 are those where min(byte, 0x1f) == byte (unsigned).
+// Quotes selects whether '"' and '\\' count too.
+// ----------------------------------------------------------------------------
+
+#ifdef LUMBERJACK_ESCAPE_X86
+
+// Scans 16 bytes at a time from i, then the scalar tail. Always inlined, so
+// the AVX2 kernel gets it VEX-encoded; calling legacy SSE code with the
+// upper AVX state dirty costs hundreds of cycles on some CPUs.
+template <bool Quotes>
+__attribute__((target("sse2"), always_inline))
+static inline size_t find_from_sse2(const char* text, size_t length, size_t i) {
+    const __m128i limit = _mm_set1_epi8(0x1f);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, limit), v), _mm_cmpeq_epi8(v, del));
+        if (Quotes) {
+            hits = _mm_or_si128(hits, _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+        }
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+    }
+    for (; i < length; i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (Quotes ? needs_escape(c) : is_control(c)) return i;
+    }
+    return length;
+}
+
+template <bool Quotes>
+__attribute__((target("sse2")))
+static size_t find_sse2(const char* text, size_t length) {
+    return find_from_sse2<Quotes>(text, length, 0);
+}
+
+template <bool Quotes>
+__attribute__((target("avx2")))
+static size_t find_avx2(const char* text, size_t length) {
+    const __m256i limit = _mm256_set1_epi8(0x1f);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(v, limit), v),
+                                       _mm256_cmpeq_epi8(v, del));
+        if (Quotes) {
+            hits = _mm256_or_si256(hits, _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                                         _mm256_cmpeq_epi8(v, backslash)));
+        }
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    // The last 0-31 bytes: one 16-byte step and the scalar tail.
+    return find_from_sse2<Quotes>(text, length, i);
+}
+
+#endif // LUMBERJACK_ESCAPE_X86
+
+// ----------------------------------------------------------------------------
+// Dispatch
+// ----------------------------------------------------------------------------
+
+using FindFunction = size_t (*)(const char*, size_t);
+
+static size_t find_escape_resolve(const char* text, size_t length);
+static size_t find_control_resolve(const char* text, size_t length);
+
+static std::atomic<FindFunction> g_findEscape{find_escape_resolve};
+static std::atomic<FindFunction> g_findControl{find_control_resolve};
+static std::atomic<EscapeKernel> g_kernel{ESCAPE_SCALAR};
+static std::mutex                g_kernelMutex;   // serializes installs
+
+static bool kernel_supported(EscapeKernel kernel) {
+    switch (kernel) {
+    case ESCAPE_SCALAR:
+        return true;
+#ifdef LUMBERJACK_ESCAPE_X86
+    case ESCAPE_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case ESCAPE_AVX2:
+        return __builtin_cpu_supports("avx2");
+#else
+    default:
+        return false;
+#endif
+    }
+    return false;
+}
+
+// Points the dispatch at kernel. Caller holds g_kernelMutex.
+static bool install_kernel(EscapeKernel kernel) {
+    if (!kernel_supported(kernel)) return false;
+    FindFunction escape, control;
+    switch (kernel) {
+    case ESCAPE_SCALAR:
+        escape = find_escape_scalar;
+        control = find_control_scalar;
+        break;
+#ifdef LUMBERJACK_ESCAPE_X86
+    case ESCAPE_SSE2:
+        escape = find_sse2<true>;
+        control = find_sse2<false>;
+        break;
+    case ESCAPE_AVX2:
+        escape = find_avx2<true>;
+        control = find_avx2<false>;
+        break;
+#endif
+    default:
+        return false;
+    }
+    g_findEscape.store(escape, std::memory_order_relaxed);
+    g_findControl.store(control, std::memory_order_relaxed);
+    g_kernel.store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+bool set_escape_kernel(EscapeKernel kernel) {
+    std::lock_guard<std::mutex> lock(g_kernelMutex);
+    return install_kernel(kernel);
+}
+
+// Installs the best kernel this CPU supports, unless one is installed.
+static void select_kernel() {
+    std::lock_guard<std::mutex> lock(g_kernelMutex);
+    if (g_findEscape.load(std::memory_order_relaxed) != find_escape_resolve) return;
+    if (!install_kernel(ESCAPE_AVX2) && !install_kernel(ESCAPE_SSE2)) install_kernel(ESCAPE_SCALAR);
+}
+
+static size_t find_escape_resolve(const char* text, size_t length) {
+    select_kernel();
+    return g_findEscape.load(std::memory_order_relaxed)(text, length);
+}
+
+static size_t find_control_resolve(const char* text, size_t length) {
+    select_kernel();
+    return g_findControl.load(std::memory_order_relaxed)(text, length);
+}
+
+EscapeKernel escape_kernel() {
+    if (g_findEscape.load(std::memory_order_relaxed) == find_escape_resolve) select_kernel();
+    return g_kernel.load(std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------------------
+
+size_t find_escape(const char* text, size_t length) {
+    return g_findEscape.load(std::memory_order_relaxed)(text, length);
+}
+
+size_t find_control(const char* text, size_t length) {
+    return g_findControl.load(std::memory_order_relaxed)(text, length);
+}
+
+size_t escape_json(char* out, size_t capacity, const char* text, size_t length, size_t* consumed) {
+    static const char hex[] = "0123456789abcdef";
+    FindFunction find = g_findEscape.load(std::memory_order_relaxed);
+    size_t in = 0, pos = 0;
+    while (in < length) {
+        size_t run = find(text + in, length - in);
+        if (run > capacity - pos) run = capacity - pos;
+        memcpy(out + pos, text + in, run);
+        pos += run;
+        in += run;
+        if (in == length || pos == capacity) break;
+
+        unsigned char c = static_cast<unsigned char>(text[in]);
+        char escape[6] = { '\\', 0, '0', '0', hex[c >> 4], hex[c & 15] };
+        size_t len = 2;
+        switch (c) {
+        case '"':  escape[1] = '"'; break;
+        case '\\': escape[1] = '\\'; break;
+        case '\n': escape[1] = 'n'; break;
+        case '\r': escape[1] = 'r'; break;
+        case '\t': escape[1] = 't'; break;
+        default:   escape[1] = 'u'; len = 6; break;
+        }
+        if (len > capacity - pos) break;
+        memcpy(out + pos, escape, len);
+        pos += len;
+        in++;
+    }
+    if (consumed) *consumed = in;
+    return pos;
+}
+
+size_t sanitize_control(char* text, size_t length) {
+    FindFunction find = g_findControl.load(std::memory_order_relaxed);
+    size_t replaced = 0;
+    for (size_t i = find(text, length); i < length; i += 1 + find(text + i + 1, length - i - 1)) {
+        text[i] = ' ';
+        replaced++;
+    }
+    return replaced;
+}
+
+} // namespace lumberjack
@@ -0,0 +1,187 @@
+// flight_recorder.cpp — MAP_SHARED ring writer and offline recovery.
+
+#include "lumberjack/flight_recorder.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lumberjack {
+
+static const char g_magic[8] = {'L', 'J', 'F', 'L', 'I', 'G', 'H', 'T'};
+
+struct RecordHeader {
+    uint32_t marker;
+    uint32_t length;
+    uint64_t position;
+};
+
+static inline uint64_t align8(uint64_t n) {
+    return (n + 7) & ~static_cast<uint64_t>(7);
+}
+
+// Copies n bytes into the ring at absolute offset pos, wrapping at the end.
+static void ring_write(char* ring, size_t capacity, uint64_t pos, const void* src, size_t n) {
+    size_t at = static_cast<size_t>(pos % capacity);
+    size_t first = n < capacity - at ? n : capacity - at;
+    memcpy(ring + at, src, first);
+    if (first < n) memcpy(ring, static_cast<const char*>(src) + first, n - first);
+}
+
+// Copies n bytes out of the ring at absolute offset pos, wrapping at the end.
+static void ring_read(const char* ring, size_t capacity, uint64_t pos, void* dst, size_t n) {
+    size_t at = static_cast<size_t>(pos % capacity);
+    size_t first = n < capacity - at ? n : capacity - at;
+    memcpy(dst, ring + at, first);
+    if (first < n) memcpy(static_cast<char*>(dst) + first, ring, n - first);
+}
+
+// ---------------------------------------------------------------------------
+// FlightRecorder
+// ---------------------------------------------------------------------------
+
+FlightRecorder::~FlightRecorder() {
+    close();
+}
+
+bool FlightRecorder::open(const char* path, size_t capacity) {
+    close();
+    if (!path || capacity == 0) return false;
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    capacity = (capacity + page - 1) / page * page;
+    size_t map_len = HEADER_SIZE + capacity;
+
+    int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool reuse = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == map_len;
+    if (!reuse) {
+        if (ftruncate(fd, 0) != 0) { ::close(fd); return false; }
+    }
+#ifdef __linux__
+    bool sized = posix_fallocate(fd, 0, static_cast<off_t>(map_len)) == 0;
+#else
+    bool sized = ftruncate(fd, static_cast<off_t>(map_len)) == 0;
+#endif
+    void* base = sized ? mmap(nullptr, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                       : MAP_FAILED;
+    ::close(fd);
+    if (base == MAP_FAILED) return false;
+
+    auto* header = static_cast<FlightRecorderHeader*>(base);
+    if (!reuse || memcmp(header->magic, g_magic, sizeof(g_magic)) != 0 ||
+        header->version != VERSION || header->header_size != HEADER_SIZE ||
+        header->capacity != capacity) {
+        memset(header, 0, sizeof(*header));
+        header->version = VERSION;
+        header->header_size = static_cast<uint32_t>(HEADER_SIZE);
+        header->capacity = capacity;
+        __atomic_store_n(&header->write_pos, 0, __ATOMIC_RELEASE);
+        // Magic last, so a torn initialization is never mistaken for valid.
+        memcpy(header->magic, g_magic, sizeof(g_magic));
+    } else {
+        uint64_t pos = __atomic_load_n(&header->write_pos, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&header->write_pos, align8(pos), __ATOMIC_RELEASE);
+    }
+
+    m_header = header;
+    m_ring = static_cast<char*>(base) + HEADER_SIZE;
+    m_capacity = capacity;
+    m_mapLen = map_len;
+    return true;
+}
+
+void FlightRecorder::close() {
+    if (m_header) munmap(m_header, m_mapLen);
+    m_header = nullptr;
+    m_ring = nullptr;
+    m_capacity = 0;
+    m_mapLen = 0;
+}
+
+void FlightRecorder::append(const char* data, size_t len) {
+    if (!m_ring) return;
+    if (len > m_capacity / 4) len = m_capacity / 4;
+
+    uint64_t size = align8(sizeof(RecordHeader) + len);
+    uint64_t pos = __atomic_fetch_add(&m_header->write_pos, size, __ATOMIC_RELAXED);
+
+    // The slot may still hold a valid marker from the previous lap, so clear
+    // it first. Then length and position, payload, and the marker last:
+    // recovery only accepts a record once its marker is back in place.
+    // pos is 8-aligned and the capacity is a multiple of 8, so the marker
+    // never straddles the end of the ring.
+    auto* marker = reinterpret_cast<uint32_t*>(m_ring + pos % m_capacity);
+    __atomic_store_n(marker, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    RecordHeader rec = {0, static_cast<uint32_t>(len), pos};
+    ring_write(m_ring, m_capacity, pos + sizeof(uint32_t),
+               reinterpret_cast<const char*>(&rec) + sizeof(uint32_t),
+               sizeof(rec) - sizeof(uint32_t));
+    ring_write(m_ring, m_capacity, pos + sizeof(rec), data, len);
+    __atomic_store_n(marker, RECORD_MARKER, __ATOMIC_RELEASE);
+}
+
+void FlightRecorder::sync() {
+    if (m_header) msync(m_header, m_mapLen, MS_SYNC);
+}
+
+// ---------------------------------------------------------------------------
+// Recovery
+// ---------------------------------------------------------------------------
+
+long flight_recorder_recover(const char* path, FILE* out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+
+    FlightRecorderHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        memcmp(header.magic, g_magic, sizeof(g_magic)) != 0 ||
+        header.version != FlightRecorder::VERSION ||
+        header.capacity == 0 || header.capacity % 8 != 0) {
+        fclose(f);
+        return -1;
+    }
+
+    size_t capacity = static_cast<size_t>(header.capacity);
+    std::vector<char> ring(capacity);
+    if (fseek(f, static_cast<long>(header.header_size), SEEK_SET) != 0 ||
+        fread(ring.data(), 1, capacity, f) != capacity) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    uint64_t end = header.write_pos;
+    uint64_t pos = end > capacity ? align8(end - capacity) : 0;
+    std::vector<char> payload;
+    long records = 0;
+
+    // Walk the live window. A slot that does not hold a complete record for
+    // exactly this position (overwritten, torn by the crash, or still being
+    // written) is skipped in 8-byte steps until the next valid record.
+    while (pos + sizeof(RecordHeader) <= end) {
+        RecordHeader rec;
+        ring_read(ring.data(), capacity, pos, &rec, sizeof(rec));
+        uint64_t size = align8(sizeof(rec) + rec.length);
+        if (rec.marker != FlightRecorder::RECORD_MARKER || rec.position != pos ||
+            rec.length > capacity / 4 || pos + size > end) {
+            pos += 8;
+            continue;
+        }
+        payload.resize(rec.length);
+        ring_read(ring.data(), capacity, pos + sizeof(rec), payload.data(), rec.length);
+        fwrite(payload.data(), 1, payload.size(), out);
+        records++;
+        pos += size;
+    }
+    return records;
+}
+
+} // namespace lumberjack
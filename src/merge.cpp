@@ -0,0 +1,193 @@
+// merge.cpp — k-way merge of log files by sequence number or timestamp.
+
+#include "lumberjack/merge.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace lumberjack {
+
+bool parse_line_order(const char* line, size_t len, LineOrder* order) {
+    order->timestamp[0] = '\0';
+    order->has_seq = false;
+    order->seq = 0;
+    if (len == 0 || line[0] != '[') return false;
+
+    const char* end = line + len;
+    const char* close = static_cast<const char*>(memchr(line, ']', len));
+    if (!close) return false;
+    size_t ts_len = static_cast<size_t>(close - line - 1);
+    if (ts_len >= sizeof(order->timestamp)) ts_len = sizeof(order->timestamp) - 1;
+    memcpy(order->timestamp, line + 1, ts_len);
+    order->timestamp[ts_len] = '\0';
+
+    // Skip the remaining bracketed fields ([LEVEL], [pid], ...) to #N.
+    const char* p = close + 1;
+    for (;;) {
+        while (p < end && *p == ' ') p++;
+        if (p >= end || *p != '[') break;
+        const char* field_end = static_cast<const char*>(memchr(p, ']', static_cast<size_t>(end - p)));
+        if (!field_end) break;
+        p = field_end + 1;
+    }
+    if (p + 1 < end && *p == '#' && p[1] >= '0' && p[1] <= '9') {
+        uint64_t seq = 0;
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) seq = seq * 10 + static_cast<uint64_t>(*p - '0');
+        order->has_seq = true;
+        order->seq = seq;
+    }
+    return true;
+}
+
+namespace {
+
+// One input: the record at its head (first line plus continuation lines)
+// and the line read past it.
+struct Cursor {
+    FILE*       file = nullptr;
+    size_t      index = 0;
+    std::string record;
+    LineOrder   order = {};
+    std::string next;
+    bool        has_next = false;
+
+    bool read_line(std::string* line) {
+        line->clear();
+        char buffer[4096];
+        while (fgets(buffer, sizeof(buffer), file)) {
+            line->append(buffer);
+            if (!line->empty() && line->back() == '\n') return true;
+        }
+        return !line->empty();
+    }
+
+    // Starts over from the beginning of the input.
+    void restart() {
+        rewind(file);
+        has_next = false;
+    }
+
+    // Loads the next record. Returns false at the end of the input.
+    bool advance() {
+        if (!has_next) has_next = read_line(&next);
+        if (!has_next) return false;
+        record.swap(next);
+        parse_line_order(record.data(), record.size(), &order);
+        for (;;) {
+            has_next = read_line(&next);
+            if (!has_next || next[0] == '[') break;
+            record += next;
+        }
+        return true;
+    }
+};
+
+// Compares two keys by seq or by timestamp: negative, zero or positive.
+static int compare_order(const LineOrder& a, const LineOrder& b, bool by_seq) {
+    if (by_seq) return a.seq < b.seq ? -1 : a.seq > b.seq ? 1 : 0;
+    return strcmp(a.timestamp, b.timestamp);
+}
+
+// Heap order: true if a goes after b. One key for the whole merge keeps
+// this a strict weak ordering.
+struct Later {
+    bool by_seq;
+
+    bool operator()(const Cursor* a, const Cursor* b) const {
+        int c = compare_order(a->order, b->order, by_seq);
+        if (c != 0) return c > 0;
+        return a->index > b->index;
+    }
+};
+
+// What a first pass over an input found.
+struct InputScan {
+    bool all_seq = true;         // every record carries #N
+    bool seq_ascending = true;
+    bool ts_ascending = true;
+};
+
+static InputScan scan_input(Cursor& cursor) {
+    InputScan scan;
+    LineOrder previous = {};
+    bool first = true;
+    while (cursor.advance()) {
+        if (!cursor.order.has_seq) scan.all_seq = false;
+        if (!first) {
+            if (cursor.order.seq < previous.seq) scan.seq_ascending = false;
+            if (strcmp(cursor.order.timestamp, previous.timestamp) < 0) scan.ts_ascending = false;
+        }
+        previous = cursor.order;
+        first = false;
+    }
+    cursor.restart();
+    return scan;
+}
+
+// Replaces the cursor's input with its records stably sorted by the merge
+// key, in a temporary file. Returns false if that cannot be created.
+static bool sort_input(Cursor& cursor, bool by_seq) {
+    std::vector<std::pair<LineOrder, std::string>> records;
+    while (cursor.advance()) records.emplace_back(cursor.order, cursor.record);
+    std::stable_sort(records.begin(), records.end(), [by_seq](const auto& a, const auto& b) {
+        return compare_order(a.first, b.first, by_seq) < 0;
+    });
+    FILE* sorted = tmpfile();
+    if (!sorted) return false;
+    for (const auto& record : records) fwrite(record.second.data(), 1, record.second.size(), sorted);
+    fclose(cursor.file);
+    cursor.file = sorted;
+    cursor.restart();
+    return true;
+}
+
+} // namespace
+
+long merge_log_files(const char* const* paths, size_t count, FILE* out) {
+    std::vector<Cursor> cursors(count);
+    for (size_t i = 0; i < count; i++) {
+        cursors[i].file = fopen(paths[i], "r");
+        cursors[i].index = i;
+        if (!cursors[i].file) {
+            for (size_t j = 0; j < i; j++) fclose(cursors[j].file);
+            return -1;
+        }
+    }
+
+    // One key for every input: #N only if every record carries one.
+    std::vector<InputScan> scans(count);
+    bool by_seq = count > 0;
+    for (size_t i = 0; i < count; i++) {
+        scans[i] = scan_input(cursors[i]);
+        by_seq &= scans[i].all_seq;
+    }
+    for (size_t i = 0; i < count; i++) {
+        bool ascending = by_seq ? scans[i].seq_ascending : scans[i].ts_ascending;
+        if (!ascending && !sort_input(cursors[i], by_seq)) {
+            for (Cursor& cursor : cursors) fclose(cursor.file);
+            return -1;
+        }
+    }
+
+    std::priority_queue<Cursor*, std::vector<Cursor*>, Later> heap(Later{ by_seq });
+    for (Cursor& cursor : cursors) {
+        if (cursor.advance()) heap.push(&cursor);
+    }
+
+    long records = 0;
+    while (!heap.empty()) {
+        Cursor* cursor = heap.top();
+        heap.pop();
+        fwrite(cursor->record.data(), 1, cursor->record.size(), out);
+        records++;
+        if (cursor->advance()) heap.push(cursor);
+    }
+
+    for (Cursor& cursor : cursors) fclose(cursor.file);
+    return records;
+}
+
+} // namespace lumberjack
@@ -0,0 +1,356 @@
+// mmap_file.cpp — Lock-free memory-mapped segment file sink.
+//
+// Each segment is a preallocated file mapped MAP_SHARED. Producers claim
+// byte ranges with fetch_add on the segment's reserve counter and publish
+// completion by adding to its commit counter. Reservations are contiguous,
+// so exactly one producer's range straddles the segment end; that producer
+// performs the rollover:
+//
+//   1. publish the pre-created spare segment as current,
+//   2. wait until every range below its own offset has been committed,
+//   3. unmap the old segment and truncate the file to the used length.
+//
+// Producers whose reservation starts past the end simply wait for the
+// current-segment pointer to change and retry.
+//
+// A spare thread creates and preallocates the next spare segment after each
+// rollover, so no producer pays for posix_fallocate. If the spare is not
+// ready when it is needed, the rolling producer waits for it; if creating
+// it failed, the sink has no current segment and drops lines (counted)
+// until the spare thread, retrying once a second, installs a new one.
+
+#include "lumberjack/sinks.h"
+#include "lumberjack/utils.h"
+#include "sink_common.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace lumberjack {
+
+namespace {
+
+struct Segment {
+    char*                 base     = nullptr;
+    size_t                capacity = 0;
+    unsigned              index    = 0;
+    int                   fd       = -1;
+    std::atomic<uint64_t> reserved{0};
+    std::atomic<uint64_t> committed{0};
+    std::atomic<uint64_t> crossed{UINT64_MAX};  // offset of the rolling producer
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// State
+// ---------------------------------------------------------------------------
+
+// Current segment, read by producers without locking.
+static std::atomic<Segment*> g_segment{nullptr};
+
+// Rollover / open / close — guarded by g_rollMutex. g_spareCv wakes the
+// spare thread when a spare is wanted, and a rolling producer when one is
+// ready or could not be created.
+static std::mutex              g_rollMutex;
+static std::condition_variable g_spareCv;
+static std::string             g_basePath;
+static size_t                  g_segmentSize = 0;
+static unsigned                g_nextIndex = 0;
+static Segment*                g_spare = nullptr;
+static bool                    g_spareFailed = false;
+static bool                    g_stopping = false;
+static std::thread             g_spareThread;
+
+static std::atomic<bool>     g_open{false};
+static std::atomic<uint64_t> g_segmentsCreated{0};
+static std::atomic<uint64_t> g_segmentFailures{0};
+static std::atomic<uint64_t> g_linesDropped{0};
+
+// Control blocks are never freed while the sink is open: a producer may
+// still hold a stale pointer and bump its reserve counter. Each one is a
+// few dozen bytes, so this is bounded by the number of rollovers.
+static std::vector<std::unique_ptr<Segment>> g_segments;
+
+static std::atomic<unsigned> g_tsInterval{10};
+
+// Stops the spare thread and retires the segments at exit if the
+// application never closed the sink.
+static CloseAtExit<mmap_file_close> g_autoClose;
+
+// ---------------------------------------------------------------------------
+// Segments
+// ---------------------------------------------------------------------------
+
+// Creates, preallocates and maps segment <base>.<index>. Preallocating
+// (rather than a sparse ftruncate) means a full disk is reported here
+// instead of as SIGBUS on a producer's memcpy. Touches no shared state, so
+// the spare thread runs it without g_rollMutex; the caller registers the
+// result with keep_segment().
+static std::unique_ptr<Segment> create_segment(unsigned index) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%06u", index);
+    std::string path = g_basePath + suffix;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return nullptr;
+    bool sized;
+#ifdef __linux__
+    sized = posix_fallocate(fd, 0, static_cast<off_t>(g_segmentSize)) == 0;
+#else
+    sized = ftruncate(fd, static_cast<off_t>(g_segmentSize)) == 0;
+#endif
+    void* base = sized ? mmap(nullptr, g_segmentSize, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, 0)
+                       : MAP_FAILED;
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        unlink(path.c_str());
+        return nullptr;
+    }
+    madvise(base, g_segmentSize, MADV_SEQUENTIAL);
+
+    auto seg = std::make_unique<Segment>();
+    seg->base = static_cast<char*>(base);
+    seg->capacity = g_segmentSize;
+    seg->index = index;
+    seg->fd = fd;
+    return seg;
+}
+
+// Counts a create_segment() result and keeps it in g_segments. Returns the
+// segment, or null if creation failed. Caller holds g_rollMutex.
+static Segment* keep_segment(std::unique_ptr<Segment> seg) {
+    if (!seg) {
+        g_segmentFailures.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    g_segmentsCreated.fetch_add(1, std::memory_order_relaxed);
+    g_segments.push_back(std::move(seg));
+    return g_segments.back().get();
+}
+
+// Waits for all producers below `used` to finish copying, then unmaps the
+// segment and trims the file to the bytes actually written.
+// Caller holds g_rollMutex.
+static void finalize_segment(Segment* seg, uint64_t used) {
+    while (seg->committed.load(std::memory_order_acquire) < used) {
+        std::this_thread::yield();
+    }
+    munmap(seg->base, seg->capacity);
+    if (ftruncate(seg->fd, static_cast<off_t>(used)) != 0) {
+        // Leave the zero-filled tail; readers stop at the first NUL.
+    }
+    ::close(seg->fd);
+    seg->base = nullptr;
+    seg->fd = -1;
+}
+
+// Called by the single producer whose reservation at `used` crossed the end
+// of `seg`. Swaps in the spare segment (waiting for the spare thread if it
+// is still creating it), retires the old one, and asks the spare thread
+// for the next spare, so the following rollover is again a pointer swap.
+static void roll_segment(Segment* seg, uint64_t used) {
+    std::unique_lock<std::mutex> lock(g_rollMutex);
+    if (seg->fd < 0) return;  // already finalized by close_locked()
+    if (g_segment.load(std::memory_order_acquire) == seg) {
+        g_spareCv.wait(lock, [] { return g_spare || g_spareFailed || g_stopping; });
+        Segment* next = g_spare;
+        g_spare = nullptr;
+        g_segment.store(next, std::memory_order_release);
+        g_spareCv.notify_all();
+    }
+    finalize_segment(seg, used);
+}
+
+// Spare thread: keeps one spare segment ready. After a failure it retries
+// once a second; a segment it manages to create while there is no current
+// one (the rollover found no spare) becomes current.
+static void spare_main() {
+    std::unique_lock<std::mutex> lock(g_rollMutex);
+    for (;;) {
+        auto wanted = [] { return g_stopping || !g_spare; };
+        if (g_spareFailed) {
+            g_spareCv.wait_for(lock, std::chrono::seconds(1), [] { return g_stopping; });
+        } else {
+            g_spareCv.wait(lock, wanted);
+        }
+        if (g_stopping) return;
+        if (g_spare) continue;
+
+        unsigned index = g_nextIndex++;
+        lock.unlock();
+        std::unique_ptr<Segment> created = create_segment(index);
+        lock.lock();
+        Segment* seg = keep_segment(std::move(created));
+        g_spareFailed = seg == nullptr;
+        if (!seg) {
+            if (g_nextIndex == index + 1) g_nextIndex = index;
+        } else if (!g_segment.load(std::memory_order_relaxed) && !g_stopping) {
+            g_segment.store(seg, std::memory_order_release);
+        } else {
+            g_spare = seg;
+        }
+        g_spareCv.notify_all();
+    }
+}
+
+// Stops the spare thread, retires the current segment and discards the
+// spare. Caller holds g_rollMutex through lock, which is released while
+// the spare thread is joined.
+static void close_locked(std::unique_lock<std::mutex>& lock) {
+    g_open.store(false, std::memory_order_relaxed);
+    if (g_spareThread.joinable()) {
+        g_stopping = true;
+        g_spareCv.notify_all();
+        lock.unlock();
+        g_spareThread.join();
+        lock.lock();
+    }
+    g_stopping = false;
+    g_spareFailed = false;
+    Segment* seg = g_segment.exchange(nullptr, std::memory_order_acq_rel);
+    if (seg) {
+        // Reserve everything that is left so late producers fail over to
+        // the (now null) current pointer instead of writing into the map.
+        uint64_t used = seg->reserved.fetch_add(seg->capacity + 1,
+                                                std::memory_order_acq_rel);
+        // If a producer already crossed the end, its offset is the used
+        // length; it will find the segment finalized when it gets the lock.
+        if (used > seg->capacity) {
+            while ((used = seg->crossed.load(std::memory_order_acquire)) == UINT64_MAX) {
+                std::this_thread::yield();
+            }
+        }
+        finalize_segment(seg, used);
+    }
+    if (g_spare) {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), ".%06u", g_spare->index);
+        munmap(g_spare->base, g_spare->capacity);
+        ::close(g_spare->fd);
+        unlink((g_basePath + suffix).c_str());
+        g_spare = nullptr;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Backend callbacks
+// ---------------------------------------------------------------------------
+
+static void mmap_init() {}
+
+static void mmap_shutdown() {}
+
+static void mmap_log_write(LogLevel level, const char* message) {
+    // Per-thread timestamp cache — producers share no lock.
+    thread_local TimestampCache ts_cache;
+    thread_local unsigned ts_interval = ~0u;
+    unsigned interval = g_tsInterval.load(std::memory_order_relaxed);
+    if (interval != ts_interval) {
+        ts_cache.set_interval_ms(interval);
+        ts_interval = interval;
+    }
+
+    char line[1280];
+    int len = snprintf(line, sizeof(line), "[%s] [%s] %s\n",
+                       ts_cache.get(), LEVEL_STRINGS[level], message);
+    if (len < 0) return;
+    if (static_cast<size_t>(len) >= sizeof(line)) len = sizeof(line) - 1;
+    uint64_t n = static_cast<uint64_t>(len);
+
+    for (;;) {
+        Segment* seg = g_segment.load(std::memory_order_acquire);
+        if (!seg) {
+            if (g_open.load(std::memory_order_relaxed)) g_linesDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        uint64_t off = seg->reserved.fetch_add(n, std::memory_order_relaxed);
+        if (off + n <= seg->capacity) {
+            memcpy(seg->base + off, line, n);
+            seg->committed.fetch_add(n, std::memory_order_release);
+            return;
+        }
+        if (off <= seg->capacity) {
+            seg->crossed.store(off, std::memory_order_release);
+            roll_segment(seg, off);
+        } else {
+            while (g_segment.load(std::memory_order_acquire) == seg) {
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+LogBackend* mmap_file_backend() {
+    static LogBackend backend = {
+        "mmap_file",
+        mmap_init,
+        mmap_shutdown,
+        mmap_log_write,
+        span_begin_stateless,
+        span_end_as_line<mmap_log_write>
+    };
+    return &backend;
+}
+
+bool mmap_file_open(const char* path, const MmapFileOptions& options) {
+    std::unique_lock<std::mutex> lock(g_rollMutex);
+    close_locked(lock);
+    if (!path || options.segment_size < 4096) return false;
+
+    g_basePath = path;
+    g_segmentSize = options.segment_size;
+    g_nextIndex = 0;
+    g_tsInterval.store(options.timestamp_cache_ms, std::memory_order_relaxed);
+    g_segmentsCreated.store(0, std::memory_order_relaxed);
+    g_segmentFailures.store(0, std::memory_order_relaxed);
+    g_linesDropped.store(0, std::memory_order_relaxed);
+
+    Segment* first = keep_segment(create_segment(g_nextIndex++));
+    if (!first) return false;
+    g_segment.store(first, std::memory_order_release);
+    g_open.store(true, std::memory_order_relaxed);
+    g_spareThread = std::thread(spare_main);
+    return true;
+}
+
+void mmap_file_close() {
+    std::unique_lock<std::mutex> lock(g_rollMutex);
+    close_locked(lock);
+}
+
+void mmap_file_sync() {
+    std::lock_guard<std::mutex> lock(g_rollMutex);
+    Segment* seg = g_segment.load(std::memory_order_acquire);
+    if (seg) msync(seg->base, seg->capacity, MS_SYNC);
+}
+
+MmapFileStats mmap_file_stats() {
+    MmapFileStats stats;
+    stats.segments_created = g_segmentsCreated.load(std::memory_order_relaxed);
+    stats.segment_failures = g_segmentFailures.load(std::memory_order_relaxed);
+    stats.lines_dropped = g_linesDropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+unsigned mmap_file_segment_index() {
+    Segment* seg = g_segment.load(std::memory_order_acquire);
+    return seg ? seg->index : 0;
+}
+
+} // namespace lumberjack
@@ -0,0 +1,493 @@
+// network_sink.cpp — Framed TCP/UDP sink with reconnect and spill file.
+//
+// Producers append framed records to the current frame under a mutex. A
+// full frame goes onto a bounded queue; one sender thread takes frames off
+// the queue and writes them to the socket, or to the spill file while the
+// collector is unreachable. The sender also hands off a partially filled
+// frame when the queue has been idle for flush_interval_ms, and owns all
+// connection state, so reconnecting never involves the logging threads.
+
+#include "lumberjack/sinks.h"
+#include "lumberjack/utils.h"
+#include "sink_common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace lumberjack {
+
+namespace {
+
+struct Frame {
+    char*  data = nullptr;
+    size_t len  = 0;
+};
+
+const size_t   MAX_UDP_FRAME      = 65000;
+const int      CONNECT_TIMEOUT_MS = 1000;
+const int      SEND_TIMEOUT_S     = 5;
+
+using Clock = std::chrono::steady_clock;
+
+bool write_fully(int fd, const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = ::write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// State
+// ---------------------------------------------------------------------------
+
+// Producer side — guarded by g_mutex.
+static std::mutex     g_mutex;
+static TimestampCache g_tsCache;
+static Frame*         g_current = nullptr;
+static size_t         g_frameSize = 0;
+static NetworkFraming g_framing = NETWORK_FRAMING_NEWLINE;
+static bool           g_open = false;
+
+// Queue — guarded by g_queueMutex.
+static std::mutex              g_queueMutex;
+static std::condition_variable g_readyCv;   // sender waits for frames
+static std::condition_variable g_freeCv;    // producers/flushers wait for free frames
+static std::deque<Frame*>      g_ready;
+static std::vector<Frame*>     g_free;
+static std::vector<Frame>      g_frames;
+static bool                    g_stopping = false;
+
+// Owned by the sender while it runs.
+static std::thread             g_sender;
+static int                     g_fd = -1;
+static NetworkProtocol         g_protocol = NETWORK_PROTOCOL_TCP;
+static sockaddr_storage        g_addr;
+static socklen_t               g_addrLen = 0;
+static unsigned                g_intervalMs = 100;
+static unsigned                g_backoffMinMs = 100;
+static unsigned                g_backoffMaxMs = 10000;
+static unsigned                g_backoffMs = 0;
+static Clock::time_point       g_nextAttempt;
+static int                     g_spillFd = -1;
+static uint64_t                g_spillBytes = 0;
+static uint64_t                g_spillMax = 0;
+
+static std::atomic<bool>     g_connected{false};
+static std::atomic<uint64_t> g_statFrames{0};
+static std::atomic<uint64_t> g_statBytes{0};
+static std::atomic<uint64_t> g_statConnects{0};
+static std::atomic<uint64_t> g_statSpilled{0};
+static std::atomic<uint64_t> g_statDropped{0};
+static std::atomic<uint64_t> g_statWaits{0};
+
+// Stops the sender at exit if the application never closed the sink.
+static CloseAtExit<network_sink_close> g_autoClose;
+
+// ---------------------------------------------------------------------------
+// Frame pool
+// ---------------------------------------------------------------------------
+
+// Takes a free frame, waiting for the sender if all are queued.
+// Caller holds g_mutex.
+static Frame* acquire_frame() {
+    std::unique_lock<std::mutex> lock(g_queueMutex);
+    if (g_free.empty()) {
+        g_statWaits.fetch_add(1, std::memory_order_relaxed);
+        g_freeCv.wait(lock, [] { return !g_free.empty(); });
+    }
+    Frame* f = g_free.back();
+    g_free.pop_back();
+    return f;
+}
+
+// Queues the current frame for the sender. Caller holds g_mutex.
+static void hand_off_current() {
+    Frame* f = g_current;
+    g_current = nullptr;
+    if (!f) return;
+    std::lock_guard<std::mutex> lock(g_queueMutex);
+    if (f->len == 0) {
+        g_free.push_back(f);
+        return;
+    }
+    g_ready.push_back(f);
+    g_readyCv.notify_one();
+}
+
+// Waits until every frame is back in the free pool. Caller holds g_mutex
+// and has already handed off the current frame.
+static void wait_idle() {
+    std::unique_lock<std::mutex> lock(g_queueMutex);
+    g_freeCv.wait(lock, [] { return g_free.size() == g_frames.size(); });
+}
+
+// ---------------------------------------------------------------------------
+// Connection
+// ---------------------------------------------------------------------------
+
+static void disconnect() {
+    if (g_fd >= 0) ::close(g_fd);
+    g_fd = -1;
+    g_connected = false;
+}
+
+// Connects to g_addr, giving up after CONNECT_TIMEOUT_MS.
+static int connect_socket() {
+    int type = g_protocol == NETWORK_PROTOCOL_TCP ? SOCK_STREAM : SOCK_DGRAM;
+    int fd = socket(g_addr.ss_family, type | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) return -1;
+    int rc = connect(fd, reinterpret_cast<const sockaddr*>(&g_addr), g_addrLen);
+    if (rc != 0 && errno == EINPROGRESS) {
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        int err = 0;
+        socklen_t len = sizeof(err);
+        rc = poll(&pfd, 1, CONNECT_TIMEOUT_MS) == 1 &&
+             getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0 ? 0 : -1;
+    }
+    if (rc != 0) {
+        ::close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    if (type == SOCK_STREAM) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        // A collector that stops reading counts as down after a while.
+        struct timeval tv = { SEND_TIMEOUT_S, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+    return fd;
+}
+
+static bool send_all(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(g_fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Sends the spill file's contents and empties it. On failure the file is
+// kept whole, to be replayed again after the next connect.
+static bool replay_spill() {
+    if (g_spillFd < 0 || g_spillBytes == 0) return true;
+    char buffer[64 * 1024];
+    off_t offset = 0;
+    for (;;) {
+        ssize_t n = pread(g_spillFd, buffer, sizeof(buffer), offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        if (!send_all(buffer, static_cast<size_t>(n))) {
+            disconnect();
+            return false;
+        }
+        g_statBytes.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+        offset += n;
+    }
+    if (ftruncate(g_spillFd, 0) == 0) g_spillBytes = 0;
+    return true;
+}
+
+// Connects if disconnected and the backoff delay has passed, then replays
+// any spilled data. Returns whether the connection is up.
+static bool ensure_connected() {
+    if (g_fd >= 0) return true;
+    if (Clock::now() < g_nextAttempt) return false;
+    g_fd = connect_socket();
+    if (g_fd < 0) {
+        g_backoffMs = g_backoffMs ? std::min(g_backoffMs * 2, g_backoffMaxMs) : g_backoffMinMs;
+        g_nextAttempt = Clock::now() + std::chrono::milliseconds(g_backoffMs);
+        return false;
+    }
+    g_backoffMs = 0;
+    g_connected = true;
+    g_statConnects.fetch_add(1, std::memory_order_relaxed);
+    return replay_spill();
+}
+
+static void spill(const Frame* f) {
+    if (g_spillFd < 0 || g_spillBytes + f->len > g_spillMax ||
+        !write_fully(g_spillFd, f->data, f->len)) {
+        g_statDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    g_spillBytes += f->len;
+    g_statSpilled.fetch_add(f->len, std::memory_order_relaxed);
+}
+
+static void deliver(const Frame* f) {
+    if (g_protocol == NETWORK_PROTOCOL_UDP) {
+        if (g_fd >= 0 && send(g_fd, f->data, f->len, MSG_NOSIGNAL) == static_cast<ssize_t>(f->len)) {
+            g_statFrames.fetch_add(1, std::memory_order_relaxed);
+            g_statBytes.fetch_add(f->len, std::memory_order_relaxed);
+        } else {
+            g_statDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    // Retry once on a fresh connection if the first attempt fails, since a
+    // collector restart is usually only noticed on the next send.
+    for (int attempt = 0; attempt < 2 && ensure_connected(); attempt++) {
+        if (send_all(f->data, f->len)) {
+            g_statFrames.fetch_add(1, std::memory_order_relaxed);
+            g_statBytes.fetch_add(f->len, std::memory_order_relaxed);
+            return;
+        }
+        disconnect();
+        g_nextAttempt = Clock::now();
+    }
+    spill(f);
+}
+
+// ---------------------------------------------------------------------------
+// Sender thread
+// ---------------------------------------------------------------------------
+
+// Queues the partial frame unless a producer or close() holds the lock;
+// they will hand it off themselves.
+static void flush_partial() {
+    std::unique_lock<std::mutex> lock(g_mutex, std::try_to_lock);
+    if (lock.owns_lock() && g_open && g_current) hand_off_current();
+}
+
+static void sender() {
+    if (g_protocol == NETWORK_PROTOCOL_UDP) {
+        g_fd = connect_socket();
+        g_connected = g_fd >= 0;
+    }
+    for (;;) {
+        Frame* f = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(g_queueMutex);
+            if (g_ready.empty() && !g_stopping) {
+                g_readyCv.wait_for(lock, std::chrono::milliseconds(g_intervalMs));
+            }
+            if (!g_ready.empty()) {
+                f = g_ready.front();
+                g_ready.pop_front();
+            } else if (g_stopping) {
+                break;
+            }
+        }
+        if (!f) {
+            flush_partial();
+            if (g_protocol == NETWORK_PROTOCOL_TCP && g_spillBytes > 0) ensure_connected();
+            continue;
+        }
+
+        deliver(f);
+
+        std::lock_guard<std::mutex> lock(g_queueMutex);
+        f->len = 0;
+        g_free.push_back(f);
+        g_freeCv.notify_all();
+    }
+    // Last chance for spilled data; whatever is left stays for the next open.
+    if (g_protocol == NETWORK_PROTOCOL_TCP && g_spillBytes > 0) {
+        g_nextAttempt = Clock::now();
+        ensure_connected();
+    }
+    disconnect();
+}
+
+// Stops the sender and releases the pool, socket and spill file. Caller
+// holds g_mutex.
+static void close_locked() {
+    if (!g_open) return;
+    hand_off_current();
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(g_queueMutex);
+        g_stopping = true;
+        g_readyCv.notify_all();
+    }
+    g_open = false;
+    g_sender.join();
+    for (auto& f : g_frames) free(f.data);
+    g_frames.clear();
+    g_free.clear();
+    if (g_spillFd >= 0) ::close(g_spillFd);
+    g_spillFd = -1;
+}
+
+// ---------------------------------------------------------------------------
+// Backend callbacks
+// ---------------------------------------------------------------------------
+
+static void network_init() {}
+
+static void network_shutdown() {
+    network_sink_flush();
+}
+
+static void network_log_write(LogLevel level, const char* message) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_open) return;
+
+    // Room for a length prefix in front of the line.
+    char line[4 + 1280];
+    char* text = line + 4;
+    int len = snprintf(text, sizeof(line) - 4, "[%s] [%s] %s\n",
+                       g_tsCache.get(), LEVEL_STRINGS[level], message);
+    if (len < 0) return;
+    if (static_cast<size_t>(len) >= sizeof(line) - 4) {
+        len = sizeof(line) - 5;
+        text[len - 1] = '\n';
+    }
+    const char* record = text;
+    size_t n = static_cast<size_t>(len);
+    if (g_framing == NETWORK_FRAMING_LENGTH_PREFIX) {
+        uint32_t body = static_cast<uint32_t>(n - 1);  // without the newline
+        line[0] = static_cast<char>(body >> 24);
+        line[1] = static_cast<char>(body >> 16);
+        line[2] = static_cast<char>(body >> 8);
+        line[3] = static_cast<char>(body);
+        record = line;
+        n = body + 4;
+    }
+
+    if (g_current && g_current->len + n > g_frameSize) hand_off_current();
+    if (!g_current) g_current = acquire_frame();
+    memcpy(g_current->data + g_current->len, record, n);
+    g_current->len += n;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+LogBackend* network_sink_backend() {
+    static LogBackend backend = {
+        "network",
+        network_init,
+        network_shutdown,
+        network_log_write,
+        span_begin_stateless,
+        span_end_as_line<network_log_write>
+    };
+    return &backend;
+}
+
+bool network_sink_open(const char* host, unsigned port, const NetworkSinkOptions& options) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    close_locked();
+    if (!host || port == 0 || port > 65535) return false;
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = options.protocol == NETWORK_PROTOCOL_TCP ? SOCK_STREAM : SOCK_DGRAM;
+    struct addrinfo* result = nullptr;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host, service.c_str(), &hints, &result) != 0 || !result) return false;
+    memcpy(&g_addr, result->ai_addr, result->ai_addrlen);
+    g_addrLen = result->ai_addrlen;
+    freeaddrinfo(result);
+
+    g_spillFd = -1;
+    g_spillBytes = 0;
+    if (options.spill_path && options.protocol == NETWORK_PROTOCOL_TCP) {
+        g_spillFd = ::open(options.spill_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (g_spillFd < 0) return false;
+        off_t end = lseek(g_spillFd, 0, SEEK_END);
+        g_spillBytes = end > 0 ? static_cast<uint64_t>(end) : 0;
+    }
+
+    size_t frame_size = options.frame_size < 2048 ? 2048 : options.frame_size;
+    if (options.protocol == NETWORK_PROTOCOL_UDP && frame_size > MAX_UDP_FRAME) {
+        frame_size = MAX_UDP_FRAME;
+    }
+    unsigned count = options.queue_depth + 1;  // queued frames plus the one being filled
+    g_frames.resize(count);
+    for (auto& f : g_frames) {
+        f.data = static_cast<char*>(malloc(frame_size));
+        if (!f.data) {
+            for (auto& allocated : g_frames) free(allocated.data);
+            g_frames.clear();
+            if (g_spillFd >= 0) ::close(g_spillFd);
+            g_spillFd = -1;
+            return false;
+        }
+    }
+    g_free.clear();
+    for (auto& f : g_frames) g_free.push_back(&f);
+
+    g_frameSize = frame_size;
+    g_framing = options.framing;
+    g_protocol = options.protocol;
+    g_current = nullptr;
+    g_tsCache.set_interval_ms(options.timestamp_cache_ms);
+    g_intervalMs = options.flush_interval_ms ? options.flush_interval_ms : 1;
+    g_backoffMinMs = options.reconnect_min_ms ? options.reconnect_min_ms : 1;
+    g_backoffMaxMs = std::max(options.reconnect_max_ms, g_backoffMinMs);
+    g_backoffMs = 0;
+    g_nextAttempt = Clock::now();
+    g_spillMax = options.spill_max_bytes;
+    g_statFrames = 0;
+    g_statBytes = 0;
+    g_statConnects = 0;
+    g_statSpilled = 0;
+    g_statDropped = 0;
+    g_statWaits = 0;
+    g_stopping = false;
+    g_open = true;
+    g_sender = std::thread(sender);
+    return true;
+}
+
+void network_sink_close() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    close_locked();
+}
+
+void network_sink_flush() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_open) return;
+    hand_off_current();
+    wait_idle();
+}
+
+bool network_sink_connected() {
+    return g_connected.load(std::memory_order_relaxed);
+}
+
+NetworkSinkStats network_sink_stats() {
+    return {
+        g_statFrames.load(std::memory_order_relaxed),
+        g_statBytes.load(std::memory_order_relaxed),
+        g_statConnects.load(std::memory_order_relaxed),
+        g_statSpilled.load(std::memory_order_relaxed),
+        g_statDropped.load(std::memory_order_relaxed),
+        g_statWaits.load(std::memory_order_relaxed)
+    };
+}
+
+} // namespace lumberjack
@@ -0,0 +1,128 @@
+// pattern.cpp — Pattern compiler and renderer.
+
+#include "lumberjack/pattern.h"
+#include "lumberjack/utils.h"
+#include <cstring>
+
+namespace lumberjack {
+
+PatternLayout::PatternLayout() {
+    compile(DEFAULT_PATTERN);
+}
+
+bool PatternLayout::compile(const char* pattern) {
+    std::vector<Step> steps;
+    std::string literals;
+
+    auto add_literal = [&](const char* text, size_t len) {
+        if (!steps.empty() && steps.back().op == OP_LITERAL) {
+            steps.back().length += static_cast<uint32_t>(len);
+        } else {
+            steps.push_back({ OP_LITERAL, static_cast<uint32_t>(literals.size()), static_cast<uint32_t>(len) });
+        }
+        literals.append(text, len);
+    };
+
+    for (const char* p = pattern; *p; p++) {
+        if (*p != '%') {
+            const char* end = strchr(p, '%');
+            size_t len = end ? static_cast<size_t>(end - p) : strlen(p);
+            add_literal(p, len);
+            p += len - 1;
+            continue;
+        }
+        Op op;
+        switch (*++p) {
+        case 'T': op = OP_TIMESTAMP; break;
+        case 'L': op = OP_LEVEL; break;
+        case 't': op = OP_THREAD; break;
+        case 's': op = OP_FILE; break;
+        case 'l': op = OP_LINE; break;
+        case 'n': op = OP_SEQ; break;
+        case 'X': op = OP_CONTEXT; break;
+        case 'm': op = OP_MESSAGE; break;
+        case '%':
+            add_literal("%", 1);
+            continue;
+        default:
+            return false;   // unknown directive, or '%' at the end
+        }
+        steps.push_back({ op, 0, 0 });
+    }
+
+    m_steps.swap(steps);
+    m_literals.swap(literals);
+    m_pattern = pattern;
+    return true;
+}
+
+size_t PatternLayout::render(char* out, size_t capacity, const PatternFields& fields) const {
+    if (capacity == 0) return 0;
+    size_t limit = capacity - 1;   // room for '\n'
+    size_t pos = 0;
+
+    // Copies len bytes, or as many as still fit.
+    auto copy = [&](const char* data, size_t len) {
+        if (len > limit - pos) len = limit - pos;
+        memcpy(out + pos, data, len);
+        pos += len;
+    };
+    auto number = [&](uint64_t value) {
+        char digits[20];
+        copy(digits, format_uint(digits, value));
+    };
+
+    for (const Step& step : m_steps) {
+        switch (step.op) {
+        case OP_LITERAL:
+            copy(m_literals.data() + step.offset, step.length);
+            break;
+        case OP_TIMESTAMP:
+            copy(fields.timestamp, strlen(fields.timestamp));
+            break;
+        case OP_LEVEL:
+            copy(LEVEL_STRINGS[fields.level], 5);
+            break;
+        case OP_THREAD:
+            number(fields.thread_id);
+            break;
+        case OP_FILE:
+            if (fields.file) {
+                const char* slash = strrchr(fields.file, '/');
+                const char* name = slash ? slash + 1 : fields.file;
+                copy(name, strlen(name));
+            } else {
+                copy("?", 1);
+            }
+            break;
+        case OP_LINE:
+            if (fields.line > 0) {
+                number(static_cast<uint64_t>(fields.line));
+            } else {
+                copy("?", 1);
+            }
+            break;
+        case OP_SEQ:
+            if (fields.seq >= 0) {
+                copy("#", 1);
+                number(static_cast<uint64_t>(fields.seq));
+                copy(" ", 1);
+            }
+            break;
+        case OP_CONTEXT:
+            // " a=1 b=2" becomes "a=1 b=2 ".
+            if (fields.context_len > 0) {
+                copy(fields.context + 1, fields.context_len - 1);
+                copy(" ", 1);
+            }
+            break;
+        case OP_MESSAGE:
+            copy(fields.message, fields.message_len);
+            break;
+        }
+    }
+    out[pos++] = '\n';
+    return pos;
+}
+
+} // namespace lumberjack
@@ -0,0 +1,329 @@
+// pipe_sink.cpp — Pipe sink with zero-copy vmsplice() hand-off.
+//
+// Producers format lines into the current buffer under a mutex. When the
+// next line does not fit, the buffer's whole pages are vmspliced into the
+// pipe and the producer moves on to the next buffer in the pool, carrying
+// over the trailing partial page. Everything happens on the logging thread,
+// like the built-in backend; only the copy into the pipe is avoided.
+
+#include "lumberjack/sinks.h"
+#include "lumberjack/utils.h"
+#include "sink_common.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace lumberjack {
+
+// ---------------------------------------------------------------------------
+// State
+// ---------------------------------------------------------------------------
+
+// All guarded by g_mutex.
+static std::mutex         g_mutex;
+static TimestampCache     g_tsCache;
+static std::vector<char*> g_buffers;
+static size_t             g_bufferSize = 0;
+static size_t             g_pageSize = 4096;
+static size_t             g_current = 0;     // index into g_buffers
+static size_t             g_len = 0;         // bytes used in the current buffer
+static int                g_fd = -1;
+static bool               g_zeroCopy = false;
+static bool               g_broken = false;  // reader gone; drop further lines
+
+static std::atomic<uint64_t> g_statSpliced{0};
+static std::atomic<uint64_t> g_statWritten{0};
+static std::atomic<uint64_t> g_statDroppedBytes{0};
+static std::atomic<uint64_t> g_statDroppedLines{0};
+
+// Writes out pending lines at exit if the application never closed the sink.
+static CloseAtExit<pipe_sink_close> g_autoClose;
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+// Blocks SIGPIPE on the calling thread for its lifetime, so a write to a
+// pipe whose reader has gone fails with EPIPE instead of killing the
+// process. consume() takes the signal that failure left pending, unless
+// one was already pending before.
+class SigpipeBlock {
+public:
+    SigpipeBlock() {
+        sigemptyset(&m_set);
+        sigaddset(&m_set, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &m_set, &m_old);
+        sigset_t pending;
+        sigpending(&pending);
+        m_wasPending = sigismember(&pending, SIGPIPE) == 1;
+    }
+
+    ~SigpipeBlock() {
+        pthread_sigmask(SIG_SETMASK, &m_old, nullptr);
+    }
+
+    void consume() {
+        if (m_wasPending) return;
+        struct timespec zero = { 0, 0 };
+        while (sigtimedwait(&m_set, nullptr, &zero) < 0 && errno == EINTR) {}
+    }
+
+private:
+    sigset_t m_set;
+    sigset_t m_old;
+    bool     m_wasPending;
+};
+
+// Waits until fd is writable, for pipes opened with O_NONBLOCK.
+static bool wait_writable() {
+    struct pollfd pfd = { g_fd, POLLOUT, 0 };
+    int rc;
+    do {
+        rc = poll(&pfd, 1, -1);
+    } while (rc < 0 && errno == EINTR);
+    return rc > 0 && !(pfd.revents & (POLLERR | POLLNVAL));
+}
+
+// Writes [data, data + len) with write(). Once the pipe is broken (EPIPE:
+// the reader has gone) the rest is dropped and counted.
+static void write_out(const char* data, size_t len) {
+    SigpipeBlock block;
+    while (len > 0 && !g_broken) {
+        ssize_t n = ::write(g_fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN && wait_writable()) continue;
+            if (errno == EPIPE) block.consume();
+            g_broken = true;
+            break;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+        g_statWritten.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    }
+    if (len > 0) g_statDroppedBytes.fetch_add(len, std::memory_order_relaxed);
+}
+
+// Hands [data, data + len) to the pipe with vmsplice(). Falls back to
+// write() for the rest if the kernel refuses the call outright.
+static void splice_out(char* data, size_t len) {
+#ifdef __linux__
+    SigpipeBlock block;
+    while (len > 0 && !g_broken) {
+        struct iovec iov = { data, len };
+        ssize_t n = vmsplice(g_fd, &iov, 1, SPLICE_F_GIFT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN && wait_writable()) continue;
+            if (errno == EINVAL || errno == ENOSYS || errno == EBADF) {
+                g_zeroCopy = false;
+                write_out(data, len);
+                return;
+            }
+            if (errno == EPIPE) block.consume();
+            g_broken = true;
+            break;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+        g_statSpliced.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    }
+    if (len > 0) g_statDroppedBytes.fetch_add(len, std::memory_order_relaxed);
+#else
+    write_out(data, len);
+#endif
+}
+
+// Hands the current buffer's full pages to the pipe and switches to the
+// next buffer, moving the partial last page to its start. Caller holds
+// g_mutex.
+static void hand_off_current() {
+    char* buf = g_buffers[g_current];
+    if (!g_zeroCopy) {
+        write_out(buf, g_len);
+        g_len = 0;
+        return;
+    }
+    size_t whole = g_len & ~(g_pageSize - 1);
+    size_t tail = g_len - whole;
+    g_current = (g_current + 1) % g_buffers.size();
+    memcpy(g_buffers[g_current], buf + whole, tail);
+    splice_out(buf, whole);
+    g_len = tail;
+}
+
+// Writes out the current buffer with write(), so it can be refilled at
+// once. Caller holds g_mutex.
+static void flush_locked() {
+    if (g_fd < 0 || g_len == 0) return;
+    write_out(g_buffers[g_current], g_len);
+    g_len = 0;
+}
+
+// Pages handed over with vmsplice() may still be sitting in the pipe, so
+// buffers are anonymous mappings rather than heap memory: after munmap()
+// the pipe keeps its references to the pages, but nothing else can reuse
+// them until the reader has consumed them.
+static char* map_buffer(size_t size) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : static_cast<char*>(p);
+}
+
+static void unmap_buffers() {
+    for (char* buf : g_buffers) munmap(buf, g_bufferSize);
+    g_buffers.clear();
+}
+
+static void close_locked() {
+    if (g_fd < 0) return;
+    flush_locked();
+    unmap_buffers();
+    g_fd = -1;
+}
+
+// ---------------------------------------------------------------------------
+// Backend callbacks
+// ---------------------------------------------------------------------------
+
+static void pipe_init() {}
+
+static void pipe_shutdown() {
+    pipe_sink_flush();
+}
+
+static void pipe_log_write(LogLevel level, const char* message) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_fd < 0) return;
+    if (g_broken) {
+        g_statDroppedLines.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    char line[1280];
+    int len = snprintf(line, sizeof(line), "[%s] [%s] %s\n",
+                       g_tsCache.get(), LEVEL_STRINGS[level], message);
+    if (len < 0) return;
+    if (static_cast<size_t>(len) >= sizeof(line)) len = sizeof(line) - 1;
+    size_t n = static_cast<size_t>(len);
+
+    if (g_len + n > g_bufferSize) hand_off_current();
+    memcpy(g_buffers[g_current] + g_len, line, n);
+    g_len += n;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+LogBackend* pipe_sink_backend() {
+    static LogBackend backend = {
+        "pipe",
+        pipe_init,
+        pipe_shutdown,
+        pipe_log_write,
+        span_begin_stateless,
+        span_end_as_line<pipe_log_write>
+    };
+    return &backend;
+}
+
+bool pipe_sink_open(int fd, const PipeSinkOptions& options) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    close_locked();
+    if (fd < 0) return false;
+
+    long page = sysconf(_SC_PAGESIZE);
+    g_pageSize = page > 0 ? static_cast<size_t>(page) : 4096;
+    // A buffer holds at least one formatted line (1280 bytes) plus a
+    // carried-over partial page.
+    size_t size = options.buffer_size < 2 * g_pageSize ? 2 * g_pageSize : options.buffer_size;
+    size = (size + g_pageSize - 1) & ~(g_pageSize - 1);
+
+    struct stat st;
+    bool is_pipe = fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    bool zero_copy = false;
+#ifdef __linux__
+    zero_copy = is_pipe && !options.force_write;
+#else
+    (void)is_pipe;
+#endif
+
+    size_t count = 1;
+    if (zero_copy) {
+        // A buffer is handed off once it has less room left than a line, so
+        // each hand-off splices at least pages - 1 pages. Size the pool so
+        // that twice the pipe's capacity in pages is spliced between two
+        // uses of the same buffer.
+        size_t capacity = 64 * 1024;
+#ifdef F_GETPIPE_SZ
+        int pipe_size = fcntl(fd, F_GETPIPE_SZ);
+        if (pipe_size > 0) capacity = static_cast<size_t>(pipe_size);
+#endif
+        size_t slots = capacity / g_pageSize;
+        size_t per_buffer = size / g_pageSize - 1;
+        count = (2 * slots + per_buffer - 1) / per_buffer + 2;
+        if (options.buffer_count > count) count = options.buffer_count;
+    }
+
+    g_bufferSize = size;
+    for (size_t i = 0; i < count; i++) {
+        char* buf = map_buffer(size);
+        if (!buf) {
+            unmap_buffers();
+            return false;
+        }
+        g_buffers.push_back(buf);
+    }
+
+    g_fd = fd;
+    g_current = 0;
+    g_len = 0;
+    g_zeroCopy = zero_copy;
+    g_broken = false;
+    g_tsCache.set_interval_ms(options.timestamp_cache_ms);
+    g_statSpliced = 0;
+    g_statWritten = 0;
+    g_statDroppedBytes = 0;
+    g_statDroppedLines = 0;
+    return true;
+}
+
+void pipe_sink_close() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    close_locked();
+}
+
+void pipe_sink_flush() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    flush_locked();
+}
+
+bool pipe_sink_zero_copy() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_fd >= 0 && g_zeroCopy;
+}
+
+PipeSinkStats pipe_sink_stats() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return {
+        g_statSpliced.load(std::memory_order_relaxed),
+        g_statWritten.load(std::memory_order_relaxed),
+        g_buffers.size(),
+        g_statDroppedBytes.load(std::memory_order_relaxed),
+        g_statDroppedLines.load(std::memory_order_relaxed)
+    };
+}
+
+} // namespace lumberjack
@@ -0,0 +1,306 @@
+// rotation.cpp — FileRotator: pre-opened file switch plus background
+// rename, compression and pruning of rotated segments.
+
+#include "lumberjack/rotation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef LUMBERJACK_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace lumberjack {
+
+// ---------------------------------------------------------------------------
+// Segment files
+// ---------------------------------------------------------------------------
+
+// Splits path into its directory ("." if none) and file name.
+static void split_path(const std::string& path, std::string* dir, std::string* name) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        *dir = ".";
+        *name = path;
+    } else {
+        *dir = slash == 0 ? "/" : path.substr(0, slash);
+        *name = path.substr(slash + 1);
+    }
+}
+
+// Returns the indices of all rotated segments of path ("name.NNNNNN" or
+// "name.NNNNNN.gz"), sorted oldest first.
+static std::vector<unsigned> list_segments(const std::string& path) {
+    std::string dir, name;
+    split_path(path, &dir, &name);
+    std::vector<unsigned> indices;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return indices;
+    while (struct dirent* entry = readdir(d)) {
+        const char* file = entry->d_name;
+        if (strncmp(file, name.c_str(), name.size()) != 0 || file[name.size()] != '.') continue;
+        const char* digits = file + name.size() + 1;
+        size_t n = strspn(digits, "0123456789");
+        if (n != 6 || (digits[n] != '\0' && strcmp(digits + n, ".gz") != 0)) continue;
+        indices.push_back(static_cast<unsigned>(strtoul(digits, nullptr, 10)));
+    }
+    closedir(d);
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return indices;
+}
+
+#ifdef LUMBERJACK_HAVE_ZLIB
+
+// Writes path.gz from path and removes path. Leaves path untouched on error.
+static void compress_segment(const std::string& path) {
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) return;
+    std::string gz_path = path + ".gz";
+    gzFile out = gzopen(gz_path.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        return;
+    }
+    std::vector<char> chunk(64 * 1024);
+    bool ok = true;
+    size_t n;
+    while ((n = fread(chunk.data(), 1, chunk.size(), in)) > 0) {
+        if (gzwrite(out, chunk.data(), static_cast<unsigned>(n)) != static_cast<int>(n)) {
+            ok = false;
+            break;
+        }
+    }
+    ok = !ferror(in) && ok;
+    fclose(in);
+    if (gzclose(out) != Z_OK) ok = false;
+    if (ok) {
+        unlink(path.c_str());
+    } else {
+        unlink(gz_path.c_str());
+    }
+}
+
+#endif
+
+std::string FileRotator::segment_path(unsigned index) const {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%06u", index);
+    return m_path + suffix;
+}
+
+// ---------------------------------------------------------------------------
+// FileRotator
+// ---------------------------------------------------------------------------
+
+FileRotator::~FileRotator() {
+    close();
+}
+
+bool FileRotator::compression_supported() {
+#ifdef LUMBERJACK_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool FileRotator::open(const char* path, const RotationOptions& options) {
+    close();
+    if (!path) return false;
+
+    m_path = path;
+    m_nextPath = m_path + ".next";
+    std::vector<unsigned> segments = list_segments(m_path);
+    m_nextIndex = segments.empty() ? 1 : segments.back() + 1;
+
+    // A non-empty leftover next file means a previous process rotated but
+    // died before the background renames; finish them now.
+    struct stat st;
+    if (stat(m_nextPath.c_str(), &st) == 0) {
+        if (st.st_size > 0) {
+            if (rename(m_path.c_str(), segment_path(m_nextIndex).c_str()) == 0) m_nextIndex++;
+            rename(m_nextPath.c_str(), m_path.c_str());
+        } else {
+            unlink(m_nextPath.c_str());
+        }
+    }
+
+    FILE* file = fopen(path, "a");
+    if (!file) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+
+    m_current   = file;
+    m_bytes     = size > 0 ? static_cast<uint64_t>(size) : 0;
+    m_rotations = 0;
+    m_maxBytes  = options.max_bytes;
+    m_interval  = options.interval_s;
+    m_keep      = options.keep;
+    m_compress  = options.compress && compression_supported();
+    m_due.store(false, std::memory_order_relaxed);
+    m_nextFailed = false;
+    m_stopping  = false;
+    m_thread    = std::thread(&FileRotator::run, this);
+    return true;
+}
+
+void FileRotator::close() {
+    if (!m_current) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_cv.notify_all();
+    }
+    m_thread.join();
+
+    fclose(m_current);
+    m_current = nullptr;
+    FILE* next = m_next.exchange(nullptr);
+    if (next) {
+        fclose(next);
+        unlink(m_nextPath.c_str());
+    }
+}
+
+bool FileRotator::should_rotate(size_t len) {
+    if (m_bytes == 0) {
+        // Nothing written since the last switch: an interval that ended
+        // meanwhile does not produce an empty segment.
+        m_due.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    if (!m_next.load(std::memory_order_acquire)) return false;
+    return (m_maxBytes && m_bytes + len > m_maxBytes) ||
+           m_due.load(std::memory_order_relaxed);
+}
+
+bool FileRotator::rotate() {
+    FILE* next = m_next.exchange(nullptr, std::memory_order_acq_rel);
+    if (!next) return false;
+
+    FILE* retired = m_current;
+    m_current = next;
+    m_bytes = 0;
+    m_rotations++;
+    m_due.store(false, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_retired.push_back(retired);
+    m_cv.notify_all();
+    return true;
+}
+
+void FileRotator::wait_idle() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] {
+        return m_stopping || (m_retired.empty() && m_finishing.empty() && !m_busy &&
+                              (m_next.load() || m_nextFailed));
+    });
+}
+
+// Background loop. Retired files are renamed before the next file is
+// opened, because until the retired file is renamed away the current file
+// still lives at m_nextPath. Compression and pruning wait until the next
+// file is open, so the writer can rotate again meanwhile.
+void FileRotator::run() {
+    using SysClock = std::chrono::system_clock;
+    auto next_deadline = [this] {
+        auto secs = std::chrono::duration_cast<std::chrono::seconds>(
+            SysClock::now().time_since_epoch()).count();
+        return SysClock::time_point(std::chrono::seconds((secs / m_interval + 1) * m_interval));
+    };
+    SysClock::time_point deadline = m_interval ? next_deadline() : SysClock::time_point::max();
+
+    SysClock::time_point retry_at = {};
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        if (!m_retired.empty()) {
+            FILE* file = m_retired.front();
+            m_retired.pop_front();
+            m_busy = true;
+            lock.unlock();
+            std::string segment = retire(file);
+            lock.lock();
+            m_finishing.push_back(segment);
+            m_busy = false;
+            m_cv.notify_all();
+            continue;
+        }
+        if (!m_stopping && !m_next.load() && (!m_nextFailed || SysClock::now() >= retry_at)) {
+            m_busy = true;
+            lock.unlock();
+            FILE* next = fopen(m_nextPath.c_str(), "w");
+            lock.lock();
+            m_busy = false;
+            m_nextFailed = next == nullptr;
+            retry_at = SysClock::now() + std::chrono::seconds(1);
+            m_next.store(next, std::memory_order_release);
+            m_cv.notify_all();
+            continue;
+        }
+        if (!m_finishing.empty()) {
+            std::string segment = m_finishing.front();
+            m_finishing.pop_front();
+            m_busy = true;
+            lock.unlock();
+            finish_segment(segment);
+            lock.lock();
+            m_busy = false;
+            m_cv.notify_all();
+            continue;
+        }
+        if (m_stopping) return;
+
+        if (m_interval && SysClock::now() >= deadline) {
+            m_due.store(true, std::memory_order_relaxed);
+            deadline = next_deadline();
+        }
+        SysClock::time_point wake = m_nextFailed ? std::min(deadline, retry_at) : deadline;
+        if (wake == SysClock::time_point::max()) {
+            m_cv.wait(lock);
+        } else {
+            m_cv.wait_until(lock, wake);
+        }
+    }
+}
+
+// Closes a retired file, moves it to the next segment name and puts the
+// pre-opened file in its place. Returns the segment's path.
+std::string FileRotator::retire(FILE* file) {
+    fclose(file);
+    std::string segment = segment_path(m_nextIndex++);
+    rename(m_path.c_str(), segment.c_str());
+    rename(m_nextPath.c_str(), m_path.c_str());
+    return segment;
+}
+
+// Compresses a renamed segment and prunes old ones.
+void FileRotator::finish_segment(const std::string& segment) {
+#ifdef LUMBERJACK_HAVE_ZLIB
+    if (m_compress) compress_segment(segment);
+#else
+    (void)segment;
+#endif
+    prune();
+}
+
+// Deletes the oldest segments beyond m_keep.
+void FileRotator::prune() {
+    if (m_keep == 0) return;
+    std::vector<unsigned> segments = list_segments(m_path);
+    if (segments.size() <= m_keep) return;
+    for (size_t i = 0; i < segments.size() - m_keep; i++) {
+        std::string segment = segment_path(segments[i]);
+        unlink(segment.c_str());
+        unlink((segment + ".gz").c_str());
+    }
+}
+
+} // namespace lumberjack
@@ -0,0 +1,418 @@
+// shm_ring.cpp — Shared-memory sink (producer side) and ShmRingReader.
+//
+// Producers: reserve with a CAS on write_pos bounded by read_pos, write the
+// record body, then publish its size word with a release store. If the
+// record would straddle the end of the ring, the reservation also covers
+// the tail, which is published as a RECORD_PAD record.
+//
+// Wakeup handshake (Dekker-style, both sides use seq_cst fences):
+//   producer: commit record;        fence; if consumer_sleeping: wake
+//   reader:   consumer_sleeping=1;  fence; if nothing ready: futex_wait
+// Either the producer sees the flag, or the reader sees the record.
+
+#include "lumberjack/shm_ring.h"
+#include "lumberjack/sinks.h"
+#include "sink_common.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace lumberjack {
+
+namespace {
+
+const char g_magic[8] = {'L', 'J', 'S', 'H', 'M', 'R', 'N', 'G'};
+
+struct RecordHeader {
+    uint32_t size_flags;
+    uint16_t level;
+    uint16_t length;
+    uint64_t timestamp_ns;
+};
+static_assert(sizeof(RecordHeader) == 16, "record header layout");
+
+const size_t MAX_MESSAGE = 65535;
+
+inline uint64_t align8(uint64_t n) {
+    return (n + 7) & ~static_cast<uint64_t>(7);
+}
+
+inline std::atomic<uint32_t>* size_word(char* ring, uint64_t mask, uint64_t pos) {
+    return reinterpret_cast<std::atomic<uint32_t>*>(ring + (pos & mask));
+}
+
+void futex_wake(std::atomic<uint32_t>* word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+// Waits while *word == value, for at most timeout_ms.
+void futex_wait(std::atomic<uint32_t>* word, uint32_t value, int timeout_ms) {
+#ifdef __linux__
+    struct timespec ts = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, value, &ts, nullptr, 0);
+#else
+    (void)word;
+    (void)value;
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms < 10 ? timeout_ms : 10));
+#endif
+}
+
+uint64_t monotonic_ms() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Maps the shared memory object name. With create, makes or resizes it for
+// a ring of capacity bytes; otherwise the size is taken from the object.
+ShmRingHeader* map_ring(const char* name, bool create, size_t capacity, size_t* map_len) {
+    int fd = shm_open(name, create ? (O_RDWR | O_CREAT) : O_RDWR, 0600);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t len = create ? ShmRingReader::HEADER_SIZE + capacity : static_cast<size_t>(st.st_size);
+    if (len <= ShmRingReader::HEADER_SIZE ||
+        (create && static_cast<size_t>(st.st_size) != len && ftruncate(fd, static_cast<off_t>(len)) != 0)) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* base = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return nullptr;
+    *map_len = len;
+    return static_cast<ShmRingHeader*>(base);
+}
+
+bool header_valid(const ShmRingHeader* header, size_t map_len) {
+    return memcmp(header->magic, g_magic, sizeof(g_magic)) == 0 &&
+           header->version == ShmRingReader::VERSION &&
+           header->header_size == ShmRingReader::HEADER_SIZE &&
+           header->capacity + ShmRingReader::HEADER_SIZE == map_len &&
+           (header->capacity & (header->capacity - 1)) == 0;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Producer state
+// ---------------------------------------------------------------------------
+
+// The ring is read by producers without locking. g_writers counts calls in
+// progress so close() can wait for them before unmapping.
+static std::atomic<ShmRingHeader*> g_header{nullptr};
+static std::atomic<int>            g_writers{0};
+static std::mutex                  g_openMutex;
+static size_t                      g_mapLen = 0;
+
+// ---------------------------------------------------------------------------
+// Backend callbacks
+// ---------------------------------------------------------------------------
+
+static void shm_init() {}
+
+static void shm_shutdown() {}
+
+static void shm_log_write(LogLevel level, const char* message) {
+    g_writers.fetch_add(1, std::memory_order_acquire);
+    ShmRingHeader* header = g_header.load(std::memory_order_acquire);
+    if (!header) {
+        g_writers.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    size_t length = strlen(message);
+    if (length > MAX_MESSAGE) length = MAX_MESSAGE;
+    char* ring = reinterpret_cast<char*>(header) + ShmRingReader::HEADER_SIZE;
+    const uint64_t capacity = header->capacity;
+    const uint64_t mask = capacity - 1;
+    const uint64_t size = align8(sizeof(RecordHeader) + length);
+
+    // Claim size bytes, plus the tail of the ring if the record would
+    // straddle the end.
+    uint64_t pos = header->write_pos.load(std::memory_order_relaxed);
+    uint64_t need;
+    for (;;) {
+        uint64_t to_end = capacity - (pos & mask);
+        need = size <= to_end ? size : to_end + size;
+        uint64_t read = header->read_pos.load(std::memory_order_acquire);
+        if (pos + need - read > capacity) {
+            header->dropped.fetch_add(1, std::memory_order_relaxed);
+            g_writers.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        if (header->write_pos.compare_exchange_weak(pos, pos + need, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (need != size) {
+        uint32_t pad = static_cast<uint32_t>(need - size);
+        size_word(ring, mask, pos)->store(pad | ShmRingReader::RECORD_PAD, std::memory_order_release);
+        pos += pad;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    char* rec = ring + (pos & mask);
+    RecordHeader body = {
+        0, static_cast<uint16_t>(level), static_cast<uint16_t>(length),
+        static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec)
+    };
+    memcpy(rec + sizeof(uint32_t), reinterpret_cast<const char*>(&body) + sizeof(uint32_t),
+           sizeof(body) - sizeof(uint32_t));
+    memcpy(rec + sizeof(body), message, length);
+    size_word(ring, mask, pos)->store(static_cast<uint32_t>(size), std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header->consumer_sleeping.load(std::memory_order_relaxed) &&
+        header->consumer_sleeping.exchange(0, std::memory_order_relaxed)) {
+        futex_wake(&header->consumer_sleeping);
+    }
+    g_writers.fetch_sub(1, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------
+// Producer API
+// ---------------------------------------------------------------------------
+
+LogBackend* shm_ring_backend() {
+    static LogBackend backend = {
+        "shm_ring",
+        shm_init,
+        shm_shutdown,
+        shm_log_write,
+        span_begin_stateless,
+        span_end_as_line<shm_log_write>
+    };
+    return &backend;
+}
+
+bool shm_ring_open(const char* name, const ShmRingOptions& options) {
+    shm_ring_close();
+    if (!name || options.capacity == 0) return false;
+
+    size_t capacity = 4096;
+    while (capacity < options.capacity) capacity <<= 1;
+
+    std::lock_guard<std::mutex> lock(g_openMutex);
+    size_t map_len = 0;
+    ShmRingHeader* header = map_ring(name, true, capacity, &map_len);
+    if (!header) return false;
+
+    if (!header_valid(header, map_len)) {
+        char* ring = reinterpret_cast<char*>(header) + ShmRingReader::HEADER_SIZE;
+        memset(ring, 0, capacity);
+        memset(static_cast<void*>(header), 0, sizeof(*header));
+        header->version = ShmRingReader::VERSION;
+        header->header_size = static_cast<uint32_t>(ShmRingReader::HEADER_SIZE);
+        header->capacity = capacity;
+        // Magic last, so a reader never attaches to a half-initialized ring.
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(header->magic, g_magic, sizeof(g_magic));
+    }
+    header->producer_pid = static_cast<uint32_t>(getpid());
+    header->restart_pos.store(header->write_pos.load(std::memory_order_relaxed),
+                              std::memory_order_release);
+
+    g_mapLen = map_len;
+    g_header.store(header, std::memory_order_release);
+    return true;
+}
+
+void shm_ring_close() {
+    std::lock_guard<std::mutex> lock(g_openMutex);
+    ShmRingHeader* header = g_header.exchange(nullptr, std::memory_order_acq_rel);
+    if (!header) return;
+    while (g_writers.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+    munmap(header, g_mapLen);
+    g_mapLen = 0;
+}
+
+bool shm_ring_remove(const char* name) {
+    return name && shm_unlink(name) == 0;
+}
+
+uint64_t shm_ring_dropped() {
+    g_writers.fetch_add(1, std::memory_order_acquire);
+    ShmRingHeader* header = g_header.load(std::memory_order_acquire);
+    uint64_t dropped = header ? header->dropped.load(std::memory_order_relaxed) : 0;
+    g_writers.fetch_sub(1, std::memory_order_release);
+    return dropped;
+}
+
+// ---------------------------------------------------------------------------
+// ShmRingReader
+// ---------------------------------------------------------------------------
+
+ShmRingReader::~ShmRingReader() {
+    close();
+}
+
+bool ShmRingReader::open(const char* name) {
+    close();
+    size_t map_len = 0;
+    ShmRingHeader* header = name ? map_ring(name, false, 0, &map_len) : nullptr;
+    if (!header) return false;
+    if (!header_valid(header, map_len)) {
+        munmap(header, map_len);
+        return false;
+    }
+    m_header = header;
+    m_ring = reinterpret_cast<char*>(header) + HEADER_SIZE;
+    m_mask = header->capacity - 1;
+    m_mapLen = map_len;
+    m_cursor = header->read_pos.load(std::memory_order_acquire);
+    m_stuckPos = ~0ull;
+    return true;
+}
+
+void ShmRingReader::close() {
+    if (m_header) munmap(m_header, m_mapLen);
+    m_header = nullptr;
+    m_ring = nullptr;
+    m_mapLen = 0;
+}
+
+bool ShmRingReader::ready() const {
+    return size_word(m_ring, m_mask, m_cursor)->load(std::memory_order_acquire) != 0;
+}
+
+bool ShmRingReader::next(ShmRecord* record) {
+    if (!m_header) return false;
+    for (;;) {
+        uint32_t word = size_word(m_ring, m_mask, m_cursor)->load(std::memory_order_acquire);
+        if (word == 0) {
+            // Nothing committed here. If space is reserved but stays
+            // uncommitted, its producer died mid-write: skip to where the
+            // current producer started, or drop the hole if it is gone too.
+            uint64_t write = m_header->write_pos.load(std::memory_order_acquire);
+            if (m_cursor >= write) return false;
+            uint64_t now = monotonic_ms();
+            if (m_stuckPos != m_cursor) {
+                m_stuckPos = m_cursor;
+                m_stuckSince = now;
+                return false;
+            }
+            if (now - m_stuckSince < 1000) return false;
+            uint64_t restart = m_header->restart_pos.load(std::memory_order_acquire);
+            pid_t pid = static_cast<pid_t>(m_header->producer_pid);
+            uint64_t target = restart > m_cursor ? restart
+                            : (kill(pid, 0) != 0 && errno == ESRCH) ? write : m_cursor;
+            if (target == m_cursor) return false;
+            for (uint64_t p = m_cursor; p < target; p += 8) {
+                memset(m_ring + (p & m_mask), 0, 8);
+            }
+            m_cursor = target;
+            m_header->read_pos.store(m_cursor, std::memory_order_release);
+            continue;
+        }
+        m_stuckPos = ~0ull;
+        if (word & RECORD_PAD) {
+            m_cursor += word & ~RECORD_PAD;
+            continue;
+        }
+        RecordHeader rec;
+        memcpy(&rec, m_ring + (m_cursor & m_mask), sizeof(rec));
+        record->level = rec.level < LOG_COUNT ? static_cast<LogLevel>(rec.level) : LOG_LEVEL_NONE;
+        record->timestamp_ns = rec.timestamp_ns;
+        record->text = m_ring + (m_cursor & m_mask) + sizeof(rec);
+        record->length = rec.length;
+        m_cursor += word;
+        return true;
+    }
+}
+
+void ShmRingReader::release() {
+    if (!m_header) return;
+    uint64_t read = m_header->read_pos.load(std::memory_order_relaxed);
+    // Zero consumed bytes so the next lap starts from clean size words.
+    while (read < m_cursor) {
+        uint64_t at = read & m_mask;
+        uint64_t n = m_cursor - read;
+        if (n > m_mask + 1 - at) n = m_mask + 1 - at;
+        memset(m_ring + at, 0, n);
+        read += n;
+    }
+    m_header->read_pos.store(m_cursor, std::memory_order_release);
+}
+
+uint64_t ShmRingReader::dropped() const {
+    return m_header ? m_header->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t ShmRingReader::producer_pid() const {
+    return m_header ? m_header->producer_pid : 0;
+}
+
+void ShmRingReader::wait(ShmRingReader* const* readers, size_t count, int timeout_ms) {
+    if (count == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        readers[i]->m_header->consumer_sleeping.store(1, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (size_t i = 0; i < count; i++) {
+        if (readers[i]->ready()) {
+            for (size_t j = 0; j < count; j++) {
+                readers[j]->m_header->consumer_sleeping.store(0, std::memory_order_relaxed);
+            }
+            return;
+        }
+    }
+
+    if (count == 1) {
+        futex_wait(&readers[0]->m_header->consumer_sleeping, 1, timeout_ms);
+        return;
+    }
+#if defined(__linux__) && defined(SYS_futex_waitv)
+    if (count <= FUTEX_WAITV_MAX) {
+        std::vector<struct futex_waitv> waiters(count);
+        for (size_t i = 0; i < count; i++) {
+            waiters[i].val = 1;
+            waiters[i].uaddr = reinterpret_cast<uintptr_t>(&readers[i]->m_header->consumer_sleeping);
+            waiters[i].flags = FUTEX_32;
+            waiters[i].__reserved = 0;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        if (syscall(SYS_futex_waitv, waiters.data(), static_cast<unsigned>(count), 0,
+                    &deadline, CLOCK_MONOTONIC) >= 0 || errno != ENOSYS) {
+            return;
+        }
+    }
+#endif
+    // No vectored wait: wait on the first ring in short slices so the others
+    // are noticed within a few milliseconds.
+    futex_wait(&readers[0]->m_header->consumer_sleeping, 1, timeout_ms < 5 ? timeout_ms : 5);
+}
+
+} // namespace lumberjack
@@ -0,0 +1,37 @@
+// sink_common.h — Pieces shared by the sink backends (internal).
+//
+// Span callbacks for sinks that report a span as one log line, and the exit
+// hook that closes a sink the application left open. The level tags they
+// write are LEVEL_STRINGS in utils.h.
+
+#ifndef LUMBERJACK_SINK_COMMON_H
+#define LUMBERJACK_SINK_COMMON_H
+
+#include "lumberjack/lumberjack.h"
+#include <cstdio>
+
+namespace lumberjack {
+
+// Span callbacks that keep no state and write the finished span through
+// Write as "SPAN '<name>' took <N> us".
+inline void* span_begin_stateless(LogLevel, const char*) {
+    return nullptr;
+}
+
+template <void (*Write)(LogLevel, const char*)>
+void span_end_as_line(void*, LogLevel level, const char* name, long long elapsed_us) {
+    char message[256];
+    snprintf(message, sizeof(message), "SPAN '%s' took %lld us", name, elapsed_us);
+    Write(level, message);
+}
+
+// Calls Close during static destruction, for a sink the application never
+// closed. Define it after the state Close uses, so it is destroyed first.
+template <void (*Close)()>
+struct CloseAtExit {
+    ~CloseAtExit() { Close(); }
+};
+
+} // namespace lumberjack
+
+#endif // LUMBERJACK_SINK_COMMON_H
@@ -0,0 +1,114 @@
+// structured.cpp — Field and string rendering for structured lines.
+
+#include "lumberjack/structured.h"
+#include "lumberjack/utils.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace lumberjack {
+
+// Bounded output. append() writes all of its bytes or none, so a value is
+// never cut inside an escape or a number; append_some() writes what fits.
+struct Output {
+    char*  out;
+    size_t capacity;
+    size_t pos = 0;
+
+    bool append(const char* data, size_t len) {
+        if (len > capacity - pos) return false;
+        memcpy(out + pos, data, len);
+        pos += len;
+        return true;
+    }
+    bool append(char c) { return append(&c, 1); }
+
+    // Returns false if data was cut.
+    bool append_some(const char* data, size_t len) {
+        bool whole = len <= capacity - pos;
+        if (!whole) len = capacity - pos;
+        memcpy(out + pos, data, len);
+        pos += len;
+        return whole;
+    }
+};
+
+// Writes text quoted and escaped, keeping room for the closing quote.
+// Returns false if text was cut (or nothing fit).
+static bool append_quoted(Output& o, const char* text, size_t length) {
+    if (o.capacity - o.pos < 2) return false;
+    o.out[o.pos++] = '"';
+    size_t consumed;
+    o.pos += escape_json(o.out + o.pos, o.capacity - o.pos - 1, text, length, &consumed);
+    o.out[o.pos++] = '"';
+    return consumed == length;
+}
+
+// logfmt leaves a value bare unless it is empty or contains a space, '=',
+// a quote, a backslash or a control byte.
+static bool needs_quotes(const char* text, size_t length) {
+    return length == 0 || find_escape(text, length) != length ||
+           memchr(text, ' ', length) || memchr(text, '=', length);
+}
+
+// Returns false if text was cut.
+static bool append_string(Output& o, OutputFormat format, const char* text, size_t length) {
+    if (format == OUTPUT_JSON || (format == OUTPUT_LOGFMT && needs_quotes(text, length))) {
+        return append_quoted(o, text, length);
+    }
+    return o.append_some(text, length);
+}
+
+// Appends one field's value; false if it did not fit.
+static bool append_value(Output& o, OutputFormat format, const LogField& field) {
+    char buf[32];
+    switch (field.type) {
+    case FIELD_INT:
+        return o.append(buf, format_int(buf, field.value.i));
+    case FIELD_UINT:
+        return o.append(buf, format_uint(buf, field.value.u));
+    case FIELD_DOUBLE: {
+        double d = field.value.d;
+        if (std::isnan(d)) return o.append(format == OUTPUT_JSON ? "null" : "NaN",
+                                           format == OUTPUT_JSON ? 4 : 3);
+        if (std::isinf(d)) {
+            if (format == OUTPUT_JSON) return o.append("null", 4);
+            return o.append(d > 0 ? "+Inf" : "-Inf", 4);
+        }
+        auto result = std::to_chars(buf, buf + sizeof(buf), d);
+        return o.append(buf, static_cast<size_t>(result.ptr - buf));
+    }
+    case FIELD_BOOL:
+        return field.value.b ? o.append("true", 4) : o.append("false", 5);
+    case FIELD_STRING:
+        return append_string(o, format, field.value.s.data, field.value.s.length);
+    }
+    return false;
+}
+
+size_t render_fields(char* out, size_t capacity, OutputFormat format, const LogField* fields, size_t count) {
+    Output o = { out, capacity };
+    for (size_t i = 0; i < count; i++) {
+        const LogField& field = fields[i];
+        size_t start = o.pos;
+        bool ok;
+        if (format == OUTPUT_JSON) {
+            ok = o.append(",\"", 2) && o.append(field.key, strlen(field.key)) && o.append("\":", 2);
+        } else {
+            ok = o.append(' ') && o.append(field.key, strlen(field.key)) && o.append('=');
+        }
+        if (!ok || !append_value(o, format, field)) {
+            o.pos = start;
+            break;
+        }
+    }
+    return o.pos;
+}
+
+size_t render_string(char* out, size_t capacity, OutputFormat format, const char* text, size_t length) {
+    Output o = { out, capacity };
+    append_string(o, format, text, length);
+    return o.pos;
+}
+
+} // namespace lumberjack
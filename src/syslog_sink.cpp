@@ -0,0 +1,379 @@
+// syslog_sink.cpp — Batched RFC 5424 / journald sink over a Unix socket.
+//
+// Producers copy the message (and, for RFC 5424, a timestamp) into the next
+// slot of a fixed queue under a mutex. Sending builds one mmsghdr per slot
+// whose iovecs point at the preformatted header strings and the slot's
+// text, and hands the batch to sendmmsg(MSG_DONTWAIT). Records the kernel
+// did not take are moved to the front of the queue for the next attempt.
+
+#include "lumberjack/sinks.h"
+#include "sink_common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace lumberjack {
+
+namespace {
+
+const size_t MAX_MESSAGE   = 1024;
+const size_t MAX_IOV       = 6;
+const size_t STAMP_SIZE    = 40;
+
+struct Slot {
+    LogLevel level;
+    uint16_t stamp_len;
+    uint16_t text_len;
+    bool     multiline;          // journald: needs the binary MESSAGE encoding
+    uint64_t length_le;          // journald: little-endian text length
+    char     stamp[STAMP_SIZE];
+    char     text[MAX_MESSAGE];
+};
+
+// syslog severities for LOG_LEVEL_NONE..DEBUG.
+const int SEVERITY[LOG_COUNT] = { 6, 3, 4, 6, 7 };
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// State
+// ---------------------------------------------------------------------------
+
+// All guarded by g_mutex.
+static std::mutex               g_mutex;
+static std::vector<Slot>        g_slots;
+static size_t                   g_pending = 0;     // queued slots, from the front
+static std::vector<mmsghdr>     g_msgs;
+static std::vector<iovec>       g_iovs;
+static int                      g_fd = -1;
+static SyslogFormat             g_format = SYSLOG_FORMAT_RFC5424;
+static std::string              g_socketPath;
+static std::string              g_levelHeaders[LOG_COUNT];  // "<PRI>1 " or "PRIORITY=N\n"
+static std::string              g_header;                   // host/app/pid part
+static time_t                   g_stampSecond = -1;
+static char                     g_stampPrefix[32];          // "YYYY-MM-DDTHH:MM:SS"
+static bool                     g_open = false;
+
+// Flush thread.
+static std::condition_variable  g_cv;
+static std::thread              g_flusher;
+static bool                     g_stopping = false;
+static unsigned                 g_intervalMs = 50;
+
+static std::atomic<uint64_t> g_statSent{0};
+static std::atomic<uint64_t> g_statCalls{0};
+static std::atomic<uint64_t> g_statDropped{0};
+
+// Sends queued records and stops the flush thread at exit if the
+// application never closed the sink.
+static CloseAtExit<syslog_sink_close> g_autoClose;
+
+// ---------------------------------------------------------------------------
+// Socket
+// ---------------------------------------------------------------------------
+
+static int connect_socket(const char* path) {
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        ::close(fd);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Points msg's iovecs at the headers and slot text. Returns the iovec count.
+static size_t build_message(const Slot& slot, iovec* iov) {
+    auto add = [&iov](const void* data, size_t len) {
+        iov->iov_base = const_cast<void*>(data);
+        iov->iov_len = len;
+        iov++;
+    };
+    iovec* start = iov;
+    const std::string& level = g_levelHeaders[slot.level];
+    add(level.data(), level.size());
+    if (g_format == SYSLOG_FORMAT_RFC5424) {
+        add(slot.stamp, slot.stamp_len);
+        add(g_header.data(), g_header.size());
+        add(slot.text, slot.text_len);
+    } else if (!slot.multiline) {
+        add(g_header.data(), g_header.size());
+        add("MESSAGE=", 8);
+        add(slot.text, slot.text_len);
+        add("\n", 1);
+    } else {
+        add(g_header.data(), g_header.size());
+        add("MESSAGE\n", 8);
+        add(&slot.length_le, sizeof(slot.length_le));
+        add(slot.text, slot.text_len);
+        add("\n", 1);
+    }
+    return static_cast<size_t>(iov - start);
+}
+
+// Offers every queued record to the socket without blocking and keeps the
+// ones it did not accept. Caller holds g_mutex.
+static void send_pending() {
+    if (g_pending == 0) return;
+    if (g_fd < 0) {
+        g_fd = connect_socket(g_socketPath.c_str());
+        if (g_fd < 0) {
+            g_statDropped.fetch_add(g_pending, std::memory_order_relaxed);
+            g_pending = 0;
+            return;
+        }
+    }
+
+    size_t sent = 0;
+    bool reconnected = false;
+    while (sent < g_pending) {
+        size_t count = g_pending - sent;
+        for (size_t i = 0; i < count; i++) {
+            iovec* iov = &g_iovs[i * MAX_IOV];
+            mmsghdr& m = g_msgs[i];
+            memset(&m, 0, sizeof(m));
+            m.msg_hdr.msg_iov = iov;
+            m.msg_hdr.msg_iovlen = build_message(g_slots[sent + i], iov);
+        }
+        int n = sendmmsg(g_fd, g_msgs.data(), static_cast<unsigned>(count), MSG_DONTWAIT);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            g_statSent.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            g_statCalls.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || errno == EAGAIN || errno == ENOBUFS) break;
+        // The daemon went away (or rejected a record): reconnect once, then
+        // give up on this batch.
+        ::close(g_fd);
+        g_fd = reconnected ? -1 : connect_socket(g_socketPath.c_str());
+        reconnected = true;
+        if (g_fd < 0) {
+            g_statDropped.fetch_add(g_pending - sent, std::memory_order_relaxed);
+            sent = g_pending;
+        }
+    }
+
+    if (sent > 0 && sent < g_pending) {
+        std::move(g_slots.begin() + static_cast<ptrdiff_t>(sent),
+                  g_slots.begin() + static_cast<ptrdiff_t>(g_pending), g_slots.begin());
+    }
+    g_pending -= sent;
+}
+
+static void flusher() {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    while (!g_stopping) {
+        g_cv.wait_for(lock, std::chrono::milliseconds(g_intervalMs));
+        send_pending();
+    }
+}
+
+// Sends what is queued, waiting up to a second for the socket to accept
+// it, then stops the flush thread and disconnects. Caller holds g_mutex
+// via lock, which is released while joining the thread.
+static void close_locked(std::unique_lock<std::mutex>& lock) {
+    if (!g_open) return;
+    g_open = false;
+    g_stopping = true;
+    g_cv.notify_all();
+    lock.unlock();
+    g_flusher.join();
+    lock.lock();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    send_pending();
+    while (g_pending > 0 && g_fd >= 0 && std::chrono::steady_clock::now() < deadline) {
+        struct pollfd pfd = { g_fd, POLLOUT, 0 };
+        poll(&pfd, 1, 10);
+        send_pending();
+    }
+    g_statDropped.fetch_add(g_pending, std::memory_order_relaxed);
+    g_pending = 0;
+    if (g_fd >= 0) ::close(g_fd);
+    g_fd = -1;
+}
+
+// ---------------------------------------------------------------------------
+// Formatting
+// ---------------------------------------------------------------------------
+
+// Writes "YYYY-MM-DDTHH:MM:SS.uuuuuuZ " into slot. Caller holds g_mutex.
+static void stamp_slot(Slot& slot) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (now.tv_sec != g_stampSecond) {
+        struct tm tm_buf;
+        gmtime_r(&now.tv_sec, &tm_buf);
+        strftime(g_stampPrefix, sizeof(g_stampPrefix), "%Y-%m-%dT%H:%M:%S", &tm_buf);
+        g_stampSecond = now.tv_sec;
+    }
+    int n = snprintf(slot.stamp, sizeof(slot.stamp), "%s.%06ldZ ",
+                     g_stampPrefix, static_cast<long>(now.tv_nsec / 1000));
+    slot.stamp_len = static_cast<uint16_t>(n > 0 ? n : 0);
+}
+
+static void build_headers(const SyslogSinkOptions& options) {
+    char host[256] = "-";
+    gethostname(host, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    std::string app = options.app_name ? options.app_name : "";
+#ifdef __GLIBC__
+    if (app.empty()) app = program_invocation_short_name;
+#endif
+    if (app.empty()) app = "lumberjack";
+    long pid = static_cast<long>(getpid());
+    int facility = options.facility >= 0 && options.facility < 24 ? options.facility : 1;
+
+    char buffer[512];
+    for (int level = 0; level < LOG_COUNT; level++) {
+        if (options.format == SYSLOG_FORMAT_RFC5424) {
+            snprintf(buffer, sizeof(buffer), "<%d>1 ", facility * 8 + SEVERITY[level]);
+        } else {
+            snprintf(buffer, sizeof(buffer), "PRIORITY=%d\n", SEVERITY[level]);
+        }
+        g_levelHeaders[level] = buffer;
+    }
+    if (options.format == SYSLOG_FORMAT_RFC5424) {
+        // RFC 5424 fields are printable ASCII without spaces, at most 48 chars.
+        for (char& c : app) {
+            if (c <= ' ' || c > '~') c = '_';
+        }
+        if (app.size() > 48) app.resize(48);
+        snprintf(buffer, sizeof(buffer), "%s %s %ld - - ", host, app.c_str(), pid);
+    } else {
+        snprintf(buffer, sizeof(buffer), "SYSLOG_IDENTIFIER=%s\nSYSLOG_PID=%ld\nSYSLOG_FACILITY=%d\n",
+                 app.c_str(), pid, facility);
+    }
+    g_header = buffer;
+}
+
+// ---------------------------------------------------------------------------
+// Backend callbacks
+// ---------------------------------------------------------------------------
+
+static void syslog_init() {}
+
+static void syslog_shutdown() {
+    syslog_sink_flush();
+}
+
+static void syslog_log_write(LogLevel level, const char* message) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_open) return;
+    if (g_pending == g_slots.size()) {
+        send_pending();
+        if (g_pending == g_slots.size()) {
+            g_statDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    Slot& slot = g_slots[g_pending];
+    size_t len = strlen(message);
+    if (len > MAX_MESSAGE) len = MAX_MESSAGE;
+    memcpy(slot.text, message, len);
+    slot.level = level;
+    slot.text_len = static_cast<uint16_t>(len);
+    if (g_format == SYSLOG_FORMAT_RFC5424) {
+        stamp_slot(slot);
+    } else {
+        slot.multiline = memchr(message, '\n', len) != nullptr;
+        uint64_t le = 0;
+        for (int i = 0; i < 8; i++) {
+            reinterpret_cast<unsigned char*>(&le)[i] = static_cast<unsigned char>(len >> (8 * i));
+        }
+        slot.length_le = le;
+    }
+    g_pending++;
+    if (g_pending == g_slots.size()) send_pending();
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+LogBackend* syslog_sink_backend() {
+    static LogBackend backend = {
+        "syslog",
+        syslog_init,
+        syslog_shutdown,
+        syslog_log_write,
+        span_begin_stateless,
+        span_end_as_line<syslog_log_write>
+    };
+    return &backend;
+}
+
+bool syslog_sink_open(const SyslogSinkOptions& options) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    close_locked(lock);
+
+    const char* path = options.socket_path;
+    if (!path) {
+        path = options.format == SYSLOG_FORMAT_JOURNALD ? "/run/systemd/journal/socket" : "/dev/log";
+    }
+    int fd = connect_socket(path);
+    if (fd < 0) return false;
+
+    size_t batch = options.batch_size ? options.batch_size : 1;
+    g_slots.assign(batch, Slot());
+    g_msgs.assign(batch, mmsghdr());
+    g_iovs.assign(batch * MAX_IOV, iovec());
+    g_pending = 0;
+    g_fd = fd;
+    g_format = options.format;
+    g_socketPath = path;
+    g_stampSecond = -1;
+    build_headers(options);
+    g_intervalMs = options.flush_interval_ms ? options.flush_interval_ms : 1;
+    g_statSent = 0;
+    g_statCalls = 0;
+    g_statDropped = 0;
+    g_stopping = false;
+    g_open = true;
+    g_flusher = std::thread(flusher);
+    return true;
+}
+
+void syslog_sink_close() {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    close_locked(lock);
+}
+
+void syslog_sink_flush() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_open) send_pending();
+}
+
+SyslogSinkStats syslog_sink_stats() {
+    return {
+        g_statSent.load(std::memory_order_relaxed),
+        g_statCalls.load(std::memory_order_relaxed),
+        g_statDropped.load(std::memory_order_relaxed)
+    };
+}
+
+} // namespace lumberjack
@@ -0,0 +1,63 @@
+// capture_backend.h — In-memory backend for tests that check which lines
+// are delivered.
+//
+// start_capture() installs a batch backend that appends every delivered
+// record to g_records and counts finished spans in g_spans;
+// finish_capture() puts the built-in backend back. Used by
+// test_thread_level, test_escalation, test_log_transaction,
+// test_literal_messages and test_log_context.
+
+#ifndef LUMBERJACK_TESTS_CAPTURE_BACKEND_H
+#define LUMBERJACK_TESTS_CAPTURE_BACKEND_H
+
+#include <lumberjack/lumberjack.h>
+#include "test_support.h"
+#include <string>
+#include <vector>
+
+struct Captured {
+    lumberjack::LogLevel level;
+    std::string message;
+    size_t length;
+    std::string context;   // logfmt context fields
+    std::string json;      // the same fields as JSON members
+    int line;
+};
+
+inline std::vector<Captured> g_records;
+inline int g_spans = 0;
+
+inline void capture_span_end(void*, lumberjack::LogLevel, const char*, long long) { g_spans++; }
+
+inline void capture_batch(const lumberjack::LogRecord* records, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const lumberjack::LogRecord& r = records[i];
+        g_records.push_back({ r.level, std::string(r.message, r.length), r.length,
+                              std::string(r.context.logfmt, r.context.logfmt_length),
+                              std::string(r.context.json, r.context.json_length), r.line });
+    }
+}
+
+inline lumberjack::LogBackend g_capture = {
+    "capture", noop_init, noop_shutdown, nullptr, noop_span_begin, capture_span_end, capture_batch
+};
+
+inline void start_capture() {
+    lumberjack::init();
+    lumberjack::set_backend(&g_capture);
+    g_records.clear();
+    g_spans = 0;
+}
+
+inline void finish_capture() {
+    lumberjack::set_backend(lumberjack::builtin_backend());
+}
+
+// The captured messages joined with '|'.
+inline std::string messages() {
+    std::string all;
+    for (const Captured& r : g_records) all += (all.empty() ? "" : "|") + r.message;
+    return all;
+}
+
+#endif // LUMBERJACK_TESTS_CAPTURE_BACKEND_H
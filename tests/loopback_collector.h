@@ -0,0 +1,134 @@
+// loopback_collector.h — In-process log collector for network sink tests.
+//
+// Listens on 127.0.0.1 (TCP or UDP) and appends everything it receives to
+// one buffer, in arrival order. TCP connections are served one at a time,
+// as the network sink opens only one. Used by test_network_sink and
+// perf_network_sink.
+
+#ifndef LUMBERJACK_TESTS_LOOPBACK_COLLECTOR_H
+#define LUMBERJACK_TESTS_LOOPBACK_COLLECTOR_H
+
+#include <lumberjack/sinks.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class LoopbackCollector {
+public:
+    ~LoopbackCollector() { stop(); }
+
+    // Starts listening on port (0 = any free port). Returns false if the
+    // port cannot be bound.
+    bool start(lumberjack::NetworkProtocol protocol, unsigned port = 0) {
+        stop();
+        m_udp = protocol == lumberjack::NETWORK_PROTOCOL_UDP;
+        m_fd = socket(AF_INET, m_udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        int rcvbuf = 8 << 20;
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            (!m_udp && listen(m_fd, 4) != 0)) {
+            ::close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(m_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+        m_stop = false;
+        m_thread = std::thread([this] { run(); });
+        return true;
+    }
+
+    // Closes the listener and any open connection.
+    void stop() {
+        if (m_fd < 0) return;
+        m_stop = true;
+        m_thread.join();
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    unsigned port() const { return m_port; }
+
+    std::string data() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_data;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_data.size();
+    }
+
+    size_t datagrams() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_datagrams;
+    }
+
+    // Waits until at least bytes have arrived. Returns false on timeout.
+    bool wait_for(size_t bytes, int timeout_ms) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (size() < bytes) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+private:
+    void append(const char* data, size_t len) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_data.append(data, len);
+        m_datagrams++;
+    }
+
+    void run() {
+        std::vector<char> buffer(1 << 16);
+        int conn = -1;
+        while (!m_stop) {
+            pollfd pfd = { conn >= 0 ? conn : m_fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 10) <= 0) continue;
+            if (m_udp) {
+                ssize_t n = recv(m_fd, buffer.data(), buffer.size(), 0);
+                if (n > 0) append(buffer.data(), static_cast<size_t>(n));
+            } else if (conn < 0) {
+                conn = accept(m_fd, nullptr, nullptr);
+            } else {
+                ssize_t n = recv(conn, buffer.data(), buffer.size(), 0);
+                if (n > 0) {
+                    append(buffer.data(), static_cast<size_t>(n));
+                } else {
+                    ::close(conn);
+                    conn = -1;
+                }
+            }
+        }
+        if (conn >= 0) ::close(conn);
+    }
+
+    int               m_fd = -1;
+    bool              m_udp = false;
+    unsigned          m_port = 0;
+    std::atomic<bool> m_stop{false};
+    std::thread       m_thread;
+    std::mutex        m_mutex;
+    std::string       m_data;
+    size_t            m_datagrams = 0;
+};
+
+#endif // LUMBERJACK_TESTS_LOOPBACK_COLLECTOR_H
@@ -0,0 +1,168 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/sinks.h>
+#include "test_support.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+// =========================================================================
+// Async file sink benchmark
+// Compares the builtin stdio path (unbuffered and buffered) against the
+// async file sink with io_uring and with the pwrite() thread fallback, and
+// the lock-free mmap segment sink and the block-compressed sink. Reports producer-side cost per line,
+// end-to-end throughput (including the final flush; compressed bytes for the compressed sink), block
+// completion latency for the async sink and the compression ratio for the compressed sink.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static const int N = 1000000;
+
+struct RunResult {
+    double producer_ns;   // mean time per LOG_INFO call
+    double total_ms;      // logging + final flush
+    double mb_per_s;
+};
+
+static long file_size(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+template <typename Flush>
+static RunResult run(const std::string& path, Flush&& flush) {
+    auto start = Clock::now();
+    for (int i = 0; i < N; ++i) LOG_INFO("Info: %d %s", i, "payload payload payload");
+    auto logged = Clock::now();
+    flush();
+    auto end = Clock::now();
+
+    double producer = std::chrono::duration<double, std::nano>(logged - start).count() / N;
+    double total = std::chrono::duration<double, std::milli>(end - start).count();
+    double mb = file_size(path) / (1024.0 * 1024.0);
+    return {producer, total, mb / (total / 1000.0)};
+}
+
+static void print_run(const char* name, const RunResult& r) {
+    printf("  %-34s %8.1f ns/line  %9.1f ms  %8.1f MB/s\n",
+           name, r.producer_ns, r.total_ms, r.mb_per_s);
+}
+
+static void print_latency(const lumberjack::AsyncFileStats& s) {
+    double mean_us = s.blocks_written ? s.completion_ns_total / 1000.0 / s.blocks_written : 0.0;
+    printf("  %-34s blocks: %llu  completion mean: %.1f us  max: %.1f us  waits: %llu\n",
+           "", static_cast<unsigned long long>(s.blocks_written), mean_us,
+           s.completion_ns_max / 1000.0,
+           static_cast<unsigned long long>(s.producer_waits));
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Async File Sink Benchmark\n");
+    printf("  Lines: %d\n", N);
+    printf("=============================================================\n\n");
+
+    lumberjack::init();
+    lumberjack::builtin_set_timestamp_cache(10);
+
+    // --- builtin, unbuffered stdio ---
+    {
+        std::string path = temp_path();
+        FILE* f = fopen(path.c_str(), "w");
+        lumberjack::builtin_set_output(f);
+        lumberjack::builtin_set_buffered(false);
+        auto r = run(path, [&]() { fflush(f); });
+        lumberjack::builtin_set_output(stderr);
+        fclose(f);
+        print_run("builtin stdio (unbuffered)", r);
+        unlink(path.c_str());
+    }
+
+    // --- builtin, buffered stdio ---
+    {
+        std::string path = temp_path();
+        FILE* f = fopen(path.c_str(), "w");
+        lumberjack::builtin_set_output(f);
+        lumberjack::builtin_set_buffered(true, 64 * 1024);
+        auto r = run(path, [&]() { lumberjack::builtin_flush(); });
+        lumberjack::builtin_set_buffered(false);
+        lumberjack::builtin_set_output(stderr);
+        fclose(f);
+        print_run("builtin stdio (buffered 64 KB)", r);
+        unlink(path.c_str());
+    }
+
+    // --- async sink: io_uring, then thread fallback ---
+    for (int fallback = 0; fallback < 2; ++fallback) {
+        std::string path = temp_path();
+        lumberjack::AsyncFileOptions options;
+        options.block_size = 64 * 1024;
+        options.block_count = 8;
+        options.force_fallback = fallback != 0;
+        options.timestamp_cache_ms = 10;
+        lumberjack::async_file_open(path.c_str(), options);
+        bool uring = lumberjack::async_file_engine() == lumberjack::ASYNC_FILE_ENGINE_IO_URING;
+
+        lumberjack::set_backend(lumberjack::async_file_backend());
+        auto r = run(path, []() { lumberjack::async_file_flush(); });
+        auto stats = lumberjack::async_file_stats();
+        lumberjack::set_backend(lumberjack::builtin_backend());
+        lumberjack::async_file_close();
+
+        print_run(uring ? "async sink (io_uring)" : "async sink (pwrite threads)", r);
+        print_latency(stats);
+        unlink(path.c_str());
+    }
+
+    // --- mmap segment sink (no write syscalls on the logging path) ---
+    {
+        std::string base = temp_path();
+        unlink(base.c_str());
+        std::string segment = base + ".000000";
+        lumberjack::MmapFileOptions options;
+        options.segment_size = 256 * 1024 * 1024;
+        options.timestamp_cache_ms = 10;
+        lumberjack::mmap_file_open(base.c_str(), options);
+
+        lumberjack::set_backend(lumberjack::mmap_file_backend());
+        auto r = run(segment, []() { lumberjack::mmap_file_close(); });
+        lumberjack::set_backend(lumberjack::builtin_backend());
+
+        print_run("mmap segment sink", r);
+        unlink(segment.c_str());
+    }
+
+    // --- compressed sink (codec runs on the worker thread) ---
+    for (int codec = lumberjack::COMPRESSION_CODEC_LZ; codec <= lumberjack::COMPRESSION_CODEC_ZLIB; ++codec) {
+        auto c = static_cast<lumberjack::CompressionCodec>(codec);
+        if (!lumberjack::compressed_file_codec_supported(c)) continue;
+        std::string path = temp_path();
+        lumberjack::CompressedFileOptions options;
+        options.codec = c;
+        lumberjack::compressed_file_open(path.c_str(), options);
+
+        lumberjack::set_backend(lumberjack::compressed_file_backend());
+        auto r = run(path, []() { lumberjack::compressed_file_flush(); });
+        auto stats = lumberjack::compressed_file_stats();
+        lumberjack::set_backend(lumberjack::builtin_backend());
+        lumberjack::compressed_file_close();
+
+        print_run(c == lumberjack::COMPRESSION_CODEC_LZ ? "compressed sink (built-in LZ)"
+                                                        : "compressed sink (zlib)", r);
+        printf("  %-34s %8.2fx ratio  %llu frames  %llu producer waits\n", "",
+               stats.stored_bytes ? static_cast<double>(stats.raw_bytes) / stats.stored_bytes : 0.0,
+               static_cast<unsigned long long>(stats.frames_written),
+               static_cast<unsigned long long>(stats.producer_waits));
+        unlink(path.c_str());
+        unlink((path + ".idx").c_str());
+    }
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/escalation.h>
+#include <chrono>
+#include <cstdio>
+
+// =========================================================================
+// Escalation benchmark
+// Measures what escalation costs when idle and while running, through the
+// built-in backend into a buffered /dev/null: a disabled LOG_DEBUG and an
+// enabled LOG_INFO with escalation off and on, and a LOG_DEBUG at DEBUG
+// against one logged during an escalation, which spends its line budget.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static const int ITERATIONS = 1000000;
+static const int ROUNDS = 3;
+
+// Best of ROUNDS runs, so warm-up and frequency changes do not favour
+// whichever variant runs second.
+template <typename Body>
+static void measure(const char* name, int iterations, Body body) {
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++) body(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+        if (round == 0 || ns < best) best = ns;
+    }
+    printf("  %-44s %8.2f ns/call\n", name, best);
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Escalation Benchmark (best of %d runs)\n", ROUNDS);
+    printf("=============================================================\n");
+
+    FILE* null_out = fopen("/dev/null", "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(null_out);
+    lumberjack::builtin_set_buffered(true, 64 * 1024);
+    lumberjack::builtin_set_timestamp_cache(10);
+
+    printf("\n  Escalation off\n");
+    measure("LOG_DEBUG disabled", ITERATIONS * 10, [](int i) { LOG_DEBUG("cache lookup %d", i); });
+    measure("LOG_INFO enabled", ITERATIONS, [](int i) { LOG_INFO("cache lookup %d", i); });
+
+    printf("\n  Escalation on, idle\n");
+    lumberjack::EscalationOptions options;
+    options.window_ms = 60000;
+    options.max_lines = static_cast<size_t>(ITERATIONS) * ROUNDS;
+    lumberjack::set_escalation(true, options);
+    measure("LOG_DEBUG disabled", ITERATIONS * 10, [](int i) { LOG_DEBUG("cache lookup %d", i); });
+    measure("LOG_INFO enabled", ITERATIONS, [](int i) { LOG_INFO("cache lookup %d", i); });
+
+    printf("\n  DEBUG lines\n");
+    lumberjack::set_escalation(false);
+    lumberjack::set_level(lumberjack::LOG_LEVEL_DEBUG);
+    measure("LOG_DEBUG at DEBUG", ITERATIONS, [](int i) { LOG_DEBUG("cache lookup %d", i); });
+    lumberjack::set_level(lumberjack::LOG_LEVEL_INFO);
+    lumberjack::set_escalation(true, options);
+    LOG_ERROR("escalating");
+    measure("LOG_DEBUG during an escalation", ITERATIONS, [](int i) { LOG_DEBUG("cache lookup %d", i); });
+    measure("LOG_ERROR during an escalation", ITERATIONS, [](int i) { LOG_ERROR("failed %d", i); });
+
+    lumberjack::set_escalation(false);
+    lumberjack::builtin_set_buffered(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(null_out);
+    return 0;
+}
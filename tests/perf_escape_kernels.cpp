@@ -0,0 +1,80 @@
+#include <lumberjack/utils.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// =========================================================================
+// Escaping kernel benchmark
+// Measures escape_json() with each kernel the CPU supports, on clean text
+// and on text with an escape every ~40 bytes, at several message lengths.
+// The scalar kernel is the byte-at-a-time baseline.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static const int ROUNDS = 3;
+static const size_t BYTES_PER_RUN = 64 * 1024 * 1024;
+
+static unsigned long long g_bytes = 0;
+
+static std::string make_text(size_t length, bool escapes) {
+    std::string text;
+    for (size_t i = 0; i < length; i++) {
+        char c = static_cast<char>('a' + i % 26);
+        if (i % 9 == 8) c = ' ';
+        if (escapes && i % 40 == 39) c = (i / 40) % 2 ? '"' : '\n';
+        text += c;
+    }
+    return text;
+}
+
+// Best of ROUNDS runs, in ns per call and GB/s of input.
+static void measure(const std::string& text) {
+    static char out[8192];
+    int iterations = static_cast<int>(BYTES_PER_RUN / text.size());
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            g_bytes += lumberjack::escape_json(out, sizeof(out), text.data(), text.size());
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+        if (round == 0 || ns < best) best = ns;
+    }
+    printf(" %8.1f ns %6.2f GB/s |", best, text.size() / best);
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Escaping Kernel Benchmark (escape_json, best of %d)\n", ROUNDS);
+    printf("=============================================================\n");
+
+    const size_t lengths[] = { 16, 64, 256, 1024 };
+    const lumberjack::EscapeKernel kernels[] = { lumberjack::ESCAPE_SCALAR, lumberjack::ESCAPE_SSE2,
+                                                 lumberjack::ESCAPE_AVX2 };
+    const char* names[] = { "scalar", "SSE2", "AVX2" };
+    lumberjack::EscapeKernel original = lumberjack::escape_kernel();
+
+    for (bool escapes : { false, true }) {
+        printf("\n  %s text\n", escapes ? "With an escape every 40 bytes," : "Clean");
+        printf("  %-8s", "bytes");
+        for (const char* name : names) printf(" %-25s|", name);
+        printf("\n");
+        for (size_t length : lengths) {
+            std::string text = make_text(length, escapes);
+            printf("  %-8zu", length);
+            for (lumberjack::EscapeKernel kernel : kernels) {
+                if (lumberjack::set_escape_kernel(kernel)) {
+                    measure(text);
+                } else {
+                    printf(" %-25s|", "(not supported)");
+                }
+            }
+            printf("\n");
+        }
+    }
+
+    lumberjack::set_escape_kernel(original);
+    printf("\n  (%llu bytes escaped)\n", g_bytes);
+    return 0;
+}
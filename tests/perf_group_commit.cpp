@@ -0,0 +1,94 @@
+#include <lumberjack/lumberjack.h>
+#include "test_support.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// =========================================================================
+// Group commit benchmark
+// Runs log_and_wait_durable() from 1 to 32 threads for one second each
+// with DURABILITY_FDATASYNC, and reports committed records per second and
+// records per fdatasync. The baseline is one fdatasync per line, done by
+// hand with write() + fdatasync() on a single thread.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static const double SECONDS = 1.0;
+
+static void baseline(const char* path) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CREAT, 0644);
+    const char line[] = "[2026-02-24 10:15:03.042] [INFO ] audit record payload payload\n";
+    long records = 0;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration<double>(SECONDS);
+    while (Clock::now() < deadline) {
+        if (write(fd, line, sizeof(line) - 1) < 0) break;
+        fdatasync(fd);
+        records++;
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    close(fd);
+    printf("  %-28s %10.0f records/s  %8.1f records/sync\n",
+           "write + fdatasync per line", records / elapsed, 1.0);
+}
+
+static void run(const char* path, int threads) {
+    FILE* file = fopen(path, "w");
+    lumberjack::builtin_set_output(file);
+    lumberjack::builtin_set_buffered(true, 64 * 1024);
+    lumberjack::builtin_set_durability(lumberjack::DURABILITY_FDATASYNC);
+    lumberjack::DurabilityStats before = lumberjack::builtin_durability_stats();
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&stop, t] {
+            for (int i = 0; !stop.load(std::memory_order_relaxed); i++) {
+                lumberjack::log_and_wait_durable(lumberjack::LOG_LEVEL_INFO,
+                                                 "audit record %d from %d payload", i, t);
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(SECONDS));
+    stop = true;
+    for (auto& worker : workers) worker.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    lumberjack::DurabilityStats after = lumberjack::builtin_durability_stats();
+    lumberjack::builtin_set_durability(lumberjack::DURABILITY_NONE);
+    lumberjack::builtin_set_buffered(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(file);
+
+    uint64_t records = after.records - before.records;
+    uint64_t commits = after.commits - before.commits;
+    char name[48];
+    snprintf(name, sizeof(name), "group commit, %d thread%s", threads, threads == 1 ? "" : "s");
+    printf("  %-28s %10.0f records/s  %8.1f records/sync\n",
+           name, records / elapsed, commits ? static_cast<double>(records) / commits : 0.0);
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Group Commit Benchmark (DURABILITY_FDATASYNC)\n");
+    printf("  %.0f s per configuration\n", SECONDS);
+    printf("=============================================================\n\n");
+
+    std::string path = temp_path();
+
+    lumberjack::init();
+    baseline(path.c_str());
+    for (int threads : {1, 4, 16, 32}) run(path.c_str(), threads);
+    unlink(path.c_str());
+
+    printf("\n");
+    return 0;
+}
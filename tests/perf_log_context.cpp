@@ -0,0 +1,82 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/context.h>
+#include <chrono>
+#include <cstdio>
+
+// =========================================================================
+// Context field benchmark
+// Logs the same line with request ID, tenant and shard attached two ways:
+// passed as format arguments on every call, and set once in a LogContext
+// whose pre-rendered prefix the built-in backend copies into each line.
+// Output goes to a buffered /dev/null in TEXT and JSON format.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+using lumberjack::kv;
+
+static const int ITERATIONS = 1000000;
+static const int ROUNDS = 3;
+
+// Best of ROUNDS runs, so warm-up and frequency changes do not favour
+// whichever variant runs second.
+template <typename Body>
+static void measure(const char* name, Body body) {
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = Clock::now();
+        for (int i = 0; i < ITERATIONS; i++) body(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ITERATIONS;
+        if (round == 0 || ns < best) best = ns;
+    }
+    printf("  %-52s %8.2f ns/line\n", name, best);
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Context Field Benchmark (best of %d x %d lines)\n", ROUNDS, ITERATIONS);
+    printf("=============================================================\n");
+
+    FILE* null_out = fopen("/dev/null", "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(null_out);
+    lumberjack::builtin_set_buffered(true, 64 * 1024);
+    lumberjack::builtin_set_timestamp_cache(10);
+
+    const char* req = "7f3a9c2e-41d0";
+    const char* tenant = "acme";
+    int shard = 17;
+
+    printf("\n  Built-in backend, text lines\n");
+    measure("LOG_INFO(\"req=%s tenant=%s shard=%d cache miss %d\")", [&](int i) {
+        LOG_INFO("req=%s tenant=%s shard=%d cache miss %d", req, tenant, shard, i);
+    });
+    {
+        lumberjack::LogContext ctx({ kv("req", req), kv("tenant", tenant), kv("shard", shard) });
+        measure("LogContext + LOG_INFO(\"cache miss %d\")", [](int i) {
+            LOG_INFO("cache miss %d", i);
+        });
+    }
+
+    lumberjack::builtin_set_output_format(lumberjack::OUTPUT_JSON);
+    printf("\n  Built-in backend, JSON lines\n");
+    measure("LOG_INFO_KV(\"cache miss\", req, tenant, shard, n)", [&](int i) {
+        LOG_INFO_KV("cache miss", kv("req", req), kv("tenant", tenant), kv("shard", shard), kv("n", i));
+    });
+    {
+        lumberjack::LogContext ctx({ kv("req", req), kv("tenant", tenant), kv("shard", shard) });
+        measure("LogContext + LOG_INFO_KV(\"cache miss\", n)", [](int i) {
+            LOG_INFO_KV("cache miss", kv("n", i));
+        });
+    }
+
+    printf("\n  Opening and closing a scope\n");
+    measure("LogContext ctx(\"req\", id)", [&](int i) {
+        lumberjack::LogContext ctx("req", i);
+    });
+
+    lumberjack::builtin_set_output_format(lumberjack::OUTPUT_TEXT);
+    lumberjack::builtin_set_buffered(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(null_out);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/transaction.h>
+#include <chrono>
+#include <cstdio>
+
+// =========================================================================
+// Transaction benchmark
+// Simulates a request that logs 20 DEBUG lines and 2 INFO lines, through
+// the built-in backend into a buffered /dev/null: always at DEBUG, at INFO
+// without diagnostics, and at INFO inside a LogTransaction that is dropped
+// (a successful request) or kept (a failing one).
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static const int REQUESTS = 100000;
+static const int ROUNDS = 3;
+
+static void request(int id) {
+    LOG_INFO("request %d started", id);
+    for (int i = 0; i < 20; i++) LOG_DEBUG("request %d step %d: cache lookup key=user:%d", id, i, i * 7);
+    LOG_INFO("request %d done", id);
+}
+
+// Best of ROUNDS runs, so warm-up and frequency changes do not favour
+// whichever variant runs second.
+template <typename Body>
+static void measure(const char* name, Body body) {
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = Clock::now();
+        for (int i = 0; i < REQUESTS; i++) body(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / REQUESTS;
+        if (round == 0 || ns < best) best = ns;
+    }
+    printf("  %-44s %9.1f ns/request\n", name, best);
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Transaction Benchmark (best of %d x %d requests)\n", ROUNDS, REQUESTS);
+    printf("=============================================================\n\n");
+
+    FILE* null_out = fopen("/dev/null", "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(null_out);
+    lumberjack::builtin_set_buffered(true, 64 * 1024);
+    lumberjack::builtin_set_timestamp_cache(10);
+
+    lumberjack::set_level(lumberjack::LOG_LEVEL_DEBUG);
+    measure("DEBUG always on", [](int i) { request(i); });
+
+    lumberjack::set_level(lumberjack::LOG_LEVEL_INFO);
+    measure("INFO, no transaction", [](int i) { request(i); });
+    measure("INFO, LogTransaction dropped", [](int i) {
+        lumberjack::LogTransaction tx;
+        request(i);
+    });
+    measure("INFO, LogTransaction kept", [](int i) {
+        lumberjack::LogTransaction tx;
+        request(i);
+        tx.keep();
+    });
+
+    lumberjack::builtin_set_buffered(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(null_out);
+    return 0;
+}
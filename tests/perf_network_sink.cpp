@@ -0,0 +1,71 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/sinks.h>
+#include "loopback_collector.h"
+#include <chrono>
+#include <cstdio>
+
+// =========================================================================
+// Network sink benchmark
+// Sends 1,000,000 lines to the loopback collector over TCP (newline and
+// length-prefixed framing, at two frame sizes) and UDP. Reports producer-side
+// cost per line, end-to-end time until the collector has received every byte
+// the sink sent, and the resulting throughput.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static const int N = 1000000;
+
+static void run(const char* name, lumberjack::NetworkProtocol protocol,
+                lumberjack::NetworkFraming framing, size_t frame_size) {
+    LoopbackCollector collector;
+    collector.start(protocol);
+    lumberjack::NetworkSinkOptions options;
+    options.protocol = protocol;
+    options.framing = framing;
+    options.frame_size = frame_size;
+    lumberjack::network_sink_open("127.0.0.1", collector.port(), options);
+    lumberjack::set_backend(lumberjack::network_sink_backend());
+
+    auto start = Clock::now();
+    for (int i = 0; i < N; ++i) LOG_INFO("Info: %d %s", i, "payload payload payload");
+    auto logged = Clock::now();
+    lumberjack::network_sink_flush();
+    auto stats = lumberjack::network_sink_stats();
+    collector.wait_for(stats.bytes_sent, 10000);
+    auto end = Clock::now();
+
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::network_sink_close();
+
+    double producer = std::chrono::duration<double, std::nano>(logged - start).count() / N;
+    double total = std::chrono::duration<double, std::milli>(end - start).count();
+    double mb = collector.size() / (1024.0 * 1024.0);
+    printf("  %-34s %8.1f ns/line  %9.1f ms  %8.1f MB/s\n",
+           name, producer, total, mb / (total / 1000.0));
+    printf("  %-34s frames: %llu  dropped: %llu  producer waits: %llu\n", "",
+           static_cast<unsigned long long>(stats.frames_sent),
+           static_cast<unsigned long long>(stats.dropped_frames),
+           static_cast<unsigned long long>(stats.producer_waits));
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Network Sink Benchmark\n");
+    printf("  Lines: %d\n", N);
+    printf("=============================================================\n\n");
+
+    lumberjack::init();
+
+    run("TCP newline (16 KB frames)", lumberjack::NETWORK_PROTOCOL_TCP,
+        lumberjack::NETWORK_FRAMING_NEWLINE, 16 * 1024);
+    run("TCP newline (64 KB frames)", lumberjack::NETWORK_PROTOCOL_TCP,
+        lumberjack::NETWORK_FRAMING_NEWLINE, 64 * 1024);
+    run("TCP length-prefixed (64 KB frames)", lumberjack::NETWORK_PROTOCOL_TCP,
+        lumberjack::NETWORK_FRAMING_LENGTH_PREFIX, 64 * 1024);
+    run("UDP newline (60 KB datagrams)", lumberjack::NETWORK_PROTOCOL_UDP,
+        lumberjack::NETWORK_FRAMING_NEWLINE, 60 * 1024);
+
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/static_logger.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// =========================================================================
+// Static logger benchmark
+// Compares the runtime path (LOG_INFO -> dispatch table -> LogBackend
+// log_write) with StaticLogger<Backend> (level check, snprintf and
+// Backend::write inlined at the call site). Both write into the same
+// in-memory sink, so the numbers are the cost of dispatch and formatting
+// alone, for enabled and disabled lines, with and without arguments.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static const int ITERATIONS = 2000000;
+static const int ROUNDS = 3;
+
+// In-memory sink: copies the line into a ring and counts bytes, enough
+// work that nothing is optimized away.
+static char g_ring[64 * 1024];
+static size_t g_pos = 0;
+static unsigned long long g_bytes = 0;
+
+static inline void sink(const char* message, size_t length) {
+    if (g_pos + length > sizeof(g_ring)) g_pos = 0;
+    memcpy(g_ring + g_pos, message, length);
+    g_pos += length;
+    g_bytes += length;
+}
+
+// Runtime backend around the sink
+static void runtime_init() {}
+static void runtime_shutdown() {}
+static void runtime_write(lumberjack::LogLevel, const char* message) { sink(message, strlen(message)); }
+static void* runtime_span_begin(lumberjack::LogLevel, const char*) { return nullptr; }
+static void runtime_span_end(void*, lumberjack::LogLevel, const char*, long long) {}
+
+static lumberjack::LogBackend g_runtime = {
+    "memory", runtime_init, runtime_shutdown, runtime_write, runtime_span_begin, runtime_span_end
+};
+
+// Static backend around the same sink
+struct MemoryBackend {
+    static void write(lumberjack::LogLevel, const char* message, size_t length) { sink(message, length); }
+};
+
+using StaticLog = lumberjack::StaticLogger<MemoryBackend>;
+
+// Best of ROUNDS runs, so warm-up and frequency changes do not favour
+// whichever variant runs second.
+template <typename Body>
+static void measure(const char* name, Body body) {
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = Clock::now();
+        for (int i = 0; i < ITERATIONS; i++) body(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ITERATIONS;
+        if (round == 0 || ns < best) best = ns;
+    }
+    printf("  %-44s %8.2f ns/call\n", name, best);
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Static Logger Benchmark (best of %d x %d calls, in-memory sink)\n", ROUNDS, ITERATIONS);
+    printf("=============================================================\n");
+
+    lumberjack::init();
+    lumberjack::set_backend(&g_runtime);
+    lumberjack::set_level(lumberjack::LOG_LEVEL_INFO);
+    StaticLog::set_level(lumberjack::LOG_LEVEL_INFO);
+
+    printf("\n  Enabled, formatted (\"request %%d took %%d us\")\n");
+    measure("runtime LOG_INFO", [](int i) { LOG_INFO("request %d took %d us", i, i & 1023); });
+    measure("StaticLogger SLOG_INFO", [](int i) { SLOG_INFO(StaticLog, "request %d took %d us", i, i & 1023); });
+
+    printf("\n  Enabled, no arguments\n");
+    measure("runtime LOG_INFO", [](int) { LOG_INFO("cache warmed"); });
+    measure("StaticLogger SLOG_INFO", [](int) { SLOG_INFO(StaticLog, "cache warmed"); });
+
+    printf("\n  Disabled (DEBUG at INFO)\n");
+    measure("runtime LOG_DEBUG", [](int i) { LOG_DEBUG("request %d took %d us", i, i & 1023); });
+    measure("StaticLogger SLOG_DEBUG", [](int i) { SLOG_DEBUG(StaticLog, "request %d took %d us", i, i & 1023); });
+
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    printf("\n  (%llu bytes written)\n", g_bytes);
+    return 0;
+}
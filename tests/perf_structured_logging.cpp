@@ -0,0 +1,88 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/structured.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// =========================================================================
+// Structured logging benchmark
+// Compares encoding three fields with a printf format against typed kv()
+// fields: first rendering the fields alone (snprintf vs render_fields),
+// then whole lines through the built-in backend (LOG_INFO vs LOG_INFO_KV)
+// into a buffered /dev/null, as text and as JSON.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+using lumberjack::kv;
+
+static const int ITERATIONS = 1000000;
+static const int ROUNDS = 3;
+
+static unsigned long long g_bytes = 0;
+
+// Best of ROUNDS runs, so warm-up and frequency changes do not favour
+// whichever variant runs second.
+template <typename Body>
+static void measure(const char* name, Body body) {
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = Clock::now();
+        for (int i = 0; i < ITERATIONS; i++) body(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ITERATIONS;
+        if (round == 0 || ns < best) best = ns;
+    }
+    printf("  %-48s %8.2f ns/line\n", name, best);
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Structured Logging Benchmark (best of %d x %d lines)\n", ROUNDS, ITERATIONS);
+    printf("=============================================================\n");
+
+    static char out[1024];
+
+    printf("\n  Fields only: status, latency_us, route\n");
+    measure("snprintf \" status=%d latency_us=%llu route=%s\"", [](int i) {
+        g_bytes += static_cast<size_t>(snprintf(out, sizeof(out), " status=%d latency_us=%llu route=%s",
+                                                200 + (i & 3), static_cast<unsigned long long>(i), "/api/v1"));
+    });
+    measure("render_fields (logfmt)", [](int i) {
+        const lumberjack::LogField fields[] = { kv("status", 200 + (i & 3)), kv("latency_us", i), kv("route", "/api/v1") };
+        g_bytes += lumberjack::render_fields(out, sizeof(out), lumberjack::OUTPUT_LOGFMT, fields, 3);
+    });
+    measure("snprintf JSON members", [](int i) {
+        g_bytes += static_cast<size_t>(snprintf(out, sizeof(out), ",\"status\":%d,\"latency_us\":%llu,\"route\":\"%s\"",
+                                                200 + (i & 3), static_cast<unsigned long long>(i), "/api/v1"));
+    });
+    measure("render_fields (JSON)", [](int i) {
+        const lumberjack::LogField fields[] = { kv("status", 200 + (i & 3)), kv("latency_us", i), kv("route", "/api/v1") };
+        g_bytes += lumberjack::render_fields(out, sizeof(out), lumberjack::OUTPUT_JSON, fields, 3);
+    });
+
+    FILE* null_out = fopen("/dev/null", "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(null_out);
+    lumberjack::builtin_set_buffered(true, 64 * 1024);
+    lumberjack::builtin_set_timestamp_cache(10);
+
+    printf("\n  Built-in backend, text lines\n");
+    measure("LOG_INFO(\"request done status=%d ...\")", [](int i) {
+        LOG_INFO("request done status=%d latency_us=%d route=%s", 200 + (i & 3), i, "/api/v1");
+    });
+    measure("LOG_INFO_KV(\"request done\", kv(...) x3)", [](int i) {
+        LOG_INFO_KV("request done", kv("status", 200 + (i & 3)), kv("latency_us", i), kv("route", "/api/v1"));
+    });
+
+    lumberjack::builtin_set_output_format(lumberjack::OUTPUT_JSON);
+    printf("\n  Built-in backend, JSON lines\n");
+    measure("LOG_INFO_KV(\"request done\", kv(...) x3)", [](int i) {
+        LOG_INFO_KV("request done", kv("status", 200 + (i & 3)), kv("latency_us", i), kv("route", "/api/v1"));
+    });
+
+    lumberjack::builtin_set_output_format(lumberjack::OUTPUT_TEXT);
+    lumberjack::builtin_set_buffered(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(null_out);
+    printf("\n  (%llu bytes rendered)\n", g_bytes);
+    return 0;
+}
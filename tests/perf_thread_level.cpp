@@ -0,0 +1,72 @@
+#include <lumberjack/lumberjack.h>
+#include <chrono>
+#include <cstdio>
+
+// =========================================================================
+// Thread level override benchmark
+// Measures a disabled LOG_DEBUG and an enabled LOG_INFO through the
+// built-in backend into a buffered /dev/null: with the thread following
+// the global tables, and with a ThreadLevelOverride at the same level,
+// whose thread-local tables the macros reach through the same pointer.
+// =========================================================================
+
+using Clock = std::chrono::steady_clock;
+
+static const int ITERATIONS = 10000000;
+static const int ROUNDS = 3;
+
+// Best of ROUNDS runs, so warm-up and frequency changes do not favour
+// whichever variant runs second.
+template <typename Body>
+static void measure(const char* name, int iterations, Body body) {
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++) body(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+        if (round == 0 || ns < best) best = ns;
+    }
+    printf("  %-44s %8.2f ns/call\n", name, best);
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("  Thread Level Override Benchmark (best of %d runs)\n", ROUNDS);
+    printf("=============================================================\n\n");
+
+    FILE* null_out = fopen("/dev/null", "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(null_out);
+    lumberjack::builtin_set_buffered(true, 64 * 1024);
+    lumberjack::builtin_set_timestamp_cache(10);
+
+    measure("LOG_DEBUG disabled, global tables", ITERATIONS, [](int i) {
+        LOG_DEBUG("cache lookup %d", i);
+    });
+    measure("LOG_INFO enabled, global tables", ITERATIONS / 10, [](int i) {
+        LOG_INFO("cache lookup %d", i);
+    });
+    {
+        lumberjack::ThreadLevelOverride same(lumberjack::LOG_LEVEL_INFO);
+        measure("LOG_DEBUG disabled, thread override", ITERATIONS, [](int i) {
+            LOG_DEBUG("cache lookup %d", i);
+        });
+        measure("LOG_INFO enabled, thread override", ITERATIONS / 10, [](int i) {
+            LOG_INFO("cache lookup %d", i);
+        });
+    }
+
+    printf("\n  Switching levels\n");
+    measure("ThreadLevelOverride guard", ITERATIONS / 10, [](int) {
+        lumberjack::ThreadLevelOverride verbose(lumberjack::LOG_LEVEL_DEBUG);
+    });
+    measure("set_level(DEBUG) + set_level(INFO)", ITERATIONS / 10, [](int) {
+        lumberjack::set_level(lumberjack::LOG_LEVEL_DEBUG);
+        lumberjack::set_level(lumberjack::LOG_LEVEL_INFO);
+    });
+
+    lumberjack::builtin_set_buffered(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(null_out);
+    return 0;
+}
@@ -0,0 +1,248 @@
+#include <lumberjack/lumberjack.h>
+#include "test_support.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Unit tests for the v2 backend interface and core batching
+// Tests:
+// - Records carry length, capture time, thread ID and call site
+// - A v2 backend without log_write gets spans' and forwarded lines as
+//   one-record batches
+// - With set_batching(), lines arrive in batches, in order per thread,
+//   and flush_level, the interval flusher and thread exit deliver them
+// - A v1 backend still receives every line while batching
+// - The built-in backend writes batches
+
+struct Captured {
+    lumberjack::LogLevel level;
+    std::string message;
+    size_t length;
+    int64_t timestamp_ns;
+    uint64_t thread_id;
+    std::string file;
+    int line;
+};
+
+static std::mutex g_captureMutex;
+static std::vector<Captured> g_records;
+static std::vector<size_t> g_batchSizes;
+static std::vector<std::string> g_v1Lines;
+
+
+static void v2_write_batch(const lumberjack::LogRecord* records, size_t count) {
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+    g_batchSizes.push_back(count);
+    for (size_t i = 0; i < count; i++) {
+        const lumberjack::LogRecord& r = records[i];
+        g_records.push_back({ r.level, std::string(r.message, r.length), r.length, r.timestamp_ns,
+                              r.thread_id, r.file ? r.file : "", r.line });
+    }
+}
+
+static void v2_span_end(void*, lumberjack::LogLevel level, const char* name, long long) {
+    // Spans of a batch-only backend go through the installed adapter.
+    char message[128];
+    snprintf(message, sizeof(message), "span %s", name);
+    lumberjack::get_backend()->log_write(level, message);
+}
+
+static void v1_write(lumberjack::LogLevel, const char* message) {
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+    g_v1Lines.push_back(message);
+}
+
+static lumberjack::LogBackend g_v2 = {
+    "v2", noop_init, noop_shutdown, nullptr, noop_span_begin, v2_span_end, v2_write_batch
+};
+
+static lumberjack::LogBackend g_v1 = {
+    "v1", noop_init, noop_shutdown, v1_write, noop_span_begin, noop_span_end
+};
+
+static void reset_capture() {
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+    g_records.clear();
+    g_batchSizes.clear();
+    g_v1Lines.clear();
+}
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool test_record_fields() {
+    std::cout << "Testing record fields..." << std::endl;
+
+    lumberjack::init();
+    lumberjack::set_backend(&g_v2);
+    reset_capture();
+    int64_t before = now_ns();
+    int line = __LINE__ + 1;
+    LOG_WARN("disk %d%% full", 91);
+    {
+        LOG_SPAN(lumberjack::LOG_LEVEL_INFO, "load");
+    }
+    int64_t after = now_ns();
+    lumberjack::set_backend(lumberjack::builtin_backend());
+
+    uint64_t tid = static_cast<uint64_t>(syscall(SYS_gettid));
+    if (g_records.size() != 2) {
+        std::cerr << "FAILED: " << g_records.size() << " records" << std::endl;
+        return false;
+    }
+    const Captured& r = g_records[0];
+    bool fields = r.level == lumberjack::LOG_LEVEL_WARN && r.message == "disk 91% full" &&
+                  r.length == 13 && r.timestamp_ns >= before && r.timestamp_ns <= after &&
+                  r.thread_id == tid && r.file == __FILE__ && r.line == line;
+    const Captured& span = g_records[1];
+    bool adapted = span.message == "span load" && span.file.empty() && span.line == 0;
+    if (!fields || !adapted) {
+        std::cerr << "FAILED: '" << r.message << "' len " << r.length << " at " << r.file << ":" << r.line
+                  << ", thread " << r.thread_id << "; span '" << span.message << "'" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: level, text, length, time, thread and call site delivered" << std::endl;
+    return true;
+}
+
+bool test_batching() {
+    std::cout << "Testing batched delivery..." << std::endl;
+
+    lumberjack::init();
+    lumberjack::set_backend(&g_v2);
+    lumberjack::BatchOptions options;
+    options.records = 16;
+    options.interval_ms = 20;
+    lumberjack::set_batching(true, options);
+    reset_capture();
+
+    const int threads = 4, per_thread = 1000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < per_thread; i++) LOG_INFO("thread %d line %d", t, i);
+            LOG_INFO("thread %d tail", t);   // left for thread exit to deliver
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    // A lone line waits for the interval; an ERROR goes at once.
+    LOG_INFO("lonely");
+    size_t waiting;
+    {
+        std::lock_guard<std::mutex> lock(g_captureMutex);
+        waiting = g_records.size();
+    }
+    bool delivered_late = false;
+    for (int i = 0; i < 100 && !delivered_late; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        std::lock_guard<std::mutex> lock(g_captureMutex);
+        delivered_late = g_records.size() == waiting + 1;
+    }
+    LOG_INFO("before error");
+    LOG_ERROR("urgent");
+    size_t after_error;
+    {
+        std::lock_guard<std::mutex> lock(g_captureMutex);
+        after_error = g_records.size();
+    }
+    lumberjack::set_batching(false);
+    lumberjack::set_backend(lumberjack::builtin_backend());
+
+    std::vector<int> next(threads, 0);
+    bool ordered = true;
+    size_t largest = 0;
+    for (size_t n : g_batchSizes) largest = n > largest ? n : largest;
+    for (const Captured& r : g_records) {
+        int t, i;
+        if (sscanf(r.message.c_str(), "thread %d line %d", &t, &i) == 2) {
+            ordered &= i == next[t]++;
+        }
+    }
+    for (int t = 0; t < threads; t++) ordered &= next[t] == per_thread;
+    size_t tails = 0;
+    for (const Captured& r : g_records) tails += r.message.find(" tail") != std::string::npos;
+
+    if (!ordered || tails != threads || largest != 16 || !delivered_late || after_error != waiting + 3) {
+        std::cerr << "FAILED: ordered " << ordered << ", tails " << tails << ", largest batch " << largest
+                  << ", interval " << delivered_late << ", after error " << after_error - waiting << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << g_records.size() << " records in " << g_batchSizes.size() << " batches" << std::endl;
+    return true;
+}
+
+bool test_v1_adapter() {
+    std::cout << "Testing v1 backends while batching..." << std::endl;
+
+    lumberjack::init();
+    lumberjack::set_backend(&g_v1);
+    lumberjack::set_batching(true);
+    reset_capture();
+    for (int i = 0; i < 100; i++) LOG_INFO("v1 line %d", i);
+    lumberjack::flush_batches();
+    bool batch_pointer = lumberjack::get_backend()->log_write_batch != nullptr;
+    lumberjack::set_batching(false);
+    lumberjack::set_backend(lumberjack::builtin_backend());
+
+    bool ok = g_v1Lines.size() == 100 && batch_pointer;
+    for (int i = 0; ok && i < 100; i++) ok = g_v1Lines[i] == "v1 line " + std::to_string(i);
+    if (!ok) {
+        std::cerr << "FAILED: " << g_v1Lines.size() << " lines" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: every batched line reached log_write" << std::endl;
+    return true;
+}
+
+bool test_builtin_batches() {
+    std::cout << "Testing built-in backend batches..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* file = fopen(path.c_str(), "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(file);
+    lumberjack::set_batching(true);
+    for (int i = 0; i < 200; i++) LOG_INFO("batched %d", i);
+    lumberjack::set_batching(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(file);
+
+    std::string data = read_file(path);
+    unlink(path.c_str());
+
+    size_t lines = 0;
+    for (char c : data) lines += c == '\n';
+    if (lines != 200 || data.find("[INFO ] batched 199\n") == std::string::npos) {
+        std::cerr << "FAILED: " << lines << " lines" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: 200 lines written" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_record_fields();
+    success &= test_batching();
+    success &= test_v1_adapter();
+    success &= test_builtin_batches();
+
+    if (success) {
+        std::cout << "\nAll backend batch tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome backend batch tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,386 @@
+#include <lumberjack/lumberjack.h>
+#include "test_support.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Unit tests for the built-in backend's queued mode and overload policies.
+// The output is a pipe nobody reads until the test says so, which stalls
+// the writer thread and lets the queue fill deterministically.
+// Tests:
+// - Lines from several threads all arrive, each thread's in order
+// - DROP_BY_LEVEL sheds DEBUG and keeps every ERROR, and reports the
+//   drops in-band
+// - DROP_NEWEST keeps the first lines, DROP_OLDEST the last ones
+// - BLOCK waits for room instead of dropping, and drops after the timeout
+// - SPILL writes the overflow to the spill file
+// - Priority lanes write a queued ERROR ahead of earlier DEBUG lines and
+//   number every line with its queue position
+// - builtin_set_flush_level() flushes ERROR lines immediately while INFO
+//   stays buffered, with and without the queue
+
+// Builtin output into a pipe with a small kernel buffer.
+class PipeOutput {
+public:
+    PipeOutput() {
+        int fds[2];
+        if (pipe(fds) != 0) abort();
+        fcntl(fds[1], F_SETPIPE_SZ, 4096);
+        m_read = fds[0];
+        m_write = fdopen(fds[1], "w");
+        lumberjack::builtin_set_output(m_write);
+    }
+
+    // Starts draining the pipe; slow reads 256 bytes per millisecond.
+    void start_reading(bool slow = false) {
+        m_reader = std::thread([this, slow] {
+            char buffer[4096];
+            for (;;) {
+                ssize_t n = read(m_read, buffer, slow ? 256 : sizeof(buffer));
+                if (n <= 0) break;
+                m_data.append(buffer, static_cast<size_t>(n));
+                if (slow) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+
+    // Drains the queue, restores stderr and returns everything written.
+    std::string finish() {
+        if (!m_reader.joinable()) start_reading();
+        lumberjack::builtin_flush();
+        lumberjack::builtin_set_output(stderr);
+        fclose(m_write);
+        m_reader.join();
+        close(m_read);
+        return m_data;
+    }
+
+private:
+    int         m_read = -1;
+    FILE*       m_write = nullptr;
+    std::thread m_reader;
+    std::string m_data;
+};
+
+static void start(const lumberjack::QueueOptions& options) {
+    lumberjack::init();
+    lumberjack::set_level(lumberjack::LOG_LEVEL_DEBUG);
+    lumberjack::builtin_set_queued(true, options);
+}
+
+static void start(lumberjack::BackpressurePolicy policy, size_t capacity,
+                  unsigned block_timeout_ms = 10, const char* spill_path = nullptr) {
+    lumberjack::QueueOptions options;
+    options.policy = policy;
+    options.capacity = capacity;
+    options.block_timeout_ms = block_timeout_ms;
+    options.spill_path = spill_path;
+    start(options);
+}
+
+static size_t count(const std::string& data, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = data.find(needle); pos != std::string::npos; pos = data.find(needle, pos + 1)) n++;
+    return n;
+}
+
+static bool has_line(const std::string& data, const char* fmt, int i) {
+    char needle[64];
+    snprintf(needle, sizeof(needle), fmt, i);
+    return data.find(std::string(needle) + "\n") != std::string::npos;
+}
+
+// Sums N over the "dropped N <level> messages" lines.
+static uint64_t reported_drops(const std::string& data, const char* level) {
+    uint64_t total = 0;
+    std::string tail = std::string(" ") + level + " messages\n";
+    for (size_t pos = data.find("dropped "); pos != std::string::npos; pos = data.find("dropped ", pos + 1)) {
+        char* end = nullptr;
+        unsigned long long n = strtoull(data.c_str() + pos + 8, &end, 10);
+        if (data.compare(end - data.c_str(), tail.size(), tail) == 0) total += n;
+    }
+    return total;
+}
+
+bool test_threads_in_order() {
+    std::cout << "Testing queued lines from several threads..." << std::endl;
+
+    start(lumberjack::BACKPRESSURE_BLOCK, 256, 5000);
+    PipeOutput output;
+    output.start_reading();
+    const int threads = 4, per_thread = 5000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < per_thread; i++) LOG_INFO("thread %d line %d", t, i);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    std::string data = output.finish();
+    lumberjack::QueueStats stats = lumberjack::builtin_queue_stats();
+    lumberjack::builtin_set_queued(false);
+
+    for (int t = 0; t < threads; t++) {
+        char needle[48];
+        size_t last = 0;
+        for (int i = 0; i < per_thread; i++) {
+            snprintf(needle, sizeof(needle), "thread %d line %d\n", t, i);
+            size_t pos = data.find(needle, last);
+            if (pos == std::string::npos) {
+                std::cerr << "FAILED: '" << needle << "' missing or out of order" << std::endl;
+                return false;
+            }
+            last = pos;
+        }
+    }
+    if (stats.enqueued != threads * per_thread || stats.dropped[lumberjack::LOG_LEVEL_INFO] != 0) {
+        std::cerr << "FAILED: enqueued " << stats.enqueued << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << stats.enqueued << " lines, " << stats.blocked << " producer waits" << std::endl;
+    return true;
+}
+
+bool test_drop_by_level() {
+    std::cout << "Testing DROP_BY_LEVEL sheds DEBUG first..." << std::endl;
+
+    start(lumberjack::BACKPRESSURE_DROP_BY_LEVEL, 100);
+    PipeOutput output;
+    const int debug_lines = 5000, error_lines = 50;
+    for (int i = 0; i < debug_lines; i++) LOG_DEBUG("debug line %d", i);
+    for (int i = 0; i < error_lines; i++) LOG_ERROR("error line %d", i);
+    lumberjack::QueueStats stalled = lumberjack::builtin_queue_stats();
+    std::string data = output.finish();
+    lumberjack::QueueStats stats = lumberjack::builtin_queue_stats();
+    lumberjack::builtin_set_queued(false);
+
+    for (int i = 0; i < error_lines; i++) {
+        if (!has_line(data, "[ERROR] error line %d", i)) {
+            std::cerr << "FAILED: error line " << i << " was lost" << std::endl;
+            return false;
+        }
+    }
+    uint64_t debug_dropped = stats.dropped[lumberjack::LOG_LEVEL_DEBUG];
+    size_t debug_written = count(data, "[DEBUG] debug line ");
+    if (stalled.dropped[lumberjack::LOG_LEVEL_DEBUG] == 0 ||
+        stats.dropped[lumberjack::LOG_LEVEL_ERROR] != 0 ||
+        debug_written + debug_dropped != debug_lines ||
+        reported_drops(data, "DEBUG") != debug_dropped ||
+        data.find("[WARN ] dropped ") == std::string::npos) {
+        std::cerr << "FAILED: " << debug_written << " DEBUG written, " << debug_dropped
+                  << " dropped, " << reported_drops(data, "DEBUG") << " reported" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: all ERROR lines kept, " << debug_dropped << " DEBUG dropped and reported" << std::endl;
+    return true;
+}
+
+bool test_drop_newest_and_oldest() {
+    std::cout << "Testing DROP_NEWEST and DROP_OLDEST..." << std::endl;
+
+    const int lines = 3000;
+    bool ok = true;
+    for (lumberjack::BackpressurePolicy policy :
+         {lumberjack::BACKPRESSURE_DROP_NEWEST, lumberjack::BACKPRESSURE_DROP_OLDEST}) {
+        start(policy, 100);
+        PipeOutput output;
+        for (int i = 0; i < lines; i++) LOG_INFO("info line %d", i);
+        std::string data = output.finish();
+        lumberjack::QueueStats stats = lumberjack::builtin_queue_stats();
+        lumberjack::builtin_set_queued(false);
+
+        bool newest = policy == lumberjack::BACKPRESSURE_DROP_NEWEST;
+        size_t written = count(data, "[INFO ] info line ");
+        uint64_t dropped = stats.dropped[lumberjack::LOG_LEVEL_INFO];
+        // Line 0 may itself be evicted under DROP_OLDEST if the writer has
+        // not woken before the queue fills.
+        bool kept_first = has_line(data, "info line %d", 0);
+        bool kept_last = has_line(data, "info line %d", lines - 1);
+        if (dropped == 0 || written + dropped != lines ||
+            (newest && (!kept_first || kept_last)) || (!newest && !kept_last)) {
+            std::cerr << "FAILED: " << (newest ? "DROP_NEWEST" : "DROP_OLDEST") << " wrote "
+                      << written << ", dropped " << dropped << std::endl;
+            ok = false;
+        }
+    }
+    if (ok) std::cout << "PASSED: newest keeps the head, oldest keeps the tail" << std::endl;
+    return ok;
+}
+
+bool test_block() {
+    std::cout << "Testing BLOCK waits, then times out..." << std::endl;
+
+    // A slow reader: producers wait for room and nothing is lost.
+    start(lumberjack::BACKPRESSURE_BLOCK, 16, 5000);
+    PipeOutput slow;
+    slow.start_reading(true);
+    const int lines = 2000;
+    for (int i = 0; i < lines; i++) LOG_INFO("block line %d", i);
+    std::string data = slow.finish();
+    lumberjack::QueueStats waited = lumberjack::builtin_queue_stats();
+    lumberjack::builtin_set_queued(false);
+
+    // No reader: each producer gives up after the timeout.
+    start(lumberjack::BACKPRESSURE_BLOCK, 16, 5);
+    PipeOutput stalled;
+    auto begin = std::chrono::steady_clock::now();
+    int logged = 0;
+    while (lumberjack::builtin_queue_stats().dropped[lumberjack::LOG_LEVEL_INFO] < 5 && logged < 10000) {
+        LOG_INFO("stall line %d", logged++);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    stalled.finish();
+    lumberjack::QueueStats timed_out = lumberjack::builtin_queue_stats();
+    lumberjack::builtin_set_queued(false);
+
+    if (waited.blocked == 0 || waited.dropped[lumberjack::LOG_LEVEL_INFO] != 0 ||
+        count(data, "[INFO ] block line ") != lines) {
+        std::cerr << "FAILED: slow reader lost lines (" << waited.blocked << " waits)" << std::endl;
+        return false;
+    }
+    if (timed_out.dropped[lumberjack::LOG_LEVEL_INFO] < 5 || elapsed > std::chrono::seconds(2)) {
+        std::cerr << "FAILED: stalled writer dropped " << timed_out.dropped[lumberjack::LOG_LEVEL_INFO] << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << waited.blocked << " waits without loss, drops after the timeout" << std::endl;
+    return true;
+}
+
+bool test_spill() {
+    std::cout << "Testing SPILL writes the overflow to disk..." << std::endl;
+
+    std::string spill_path = temp_path();
+
+    start(lumberjack::BACKPRESSURE_SPILL, 100, 10, spill_path.c_str());
+    PipeOutput output;
+    const int lines = 3000;
+    for (int i = 0; i < lines; i++) LOG_WARN("warn line %d", i);
+    std::string data = output.finish();
+    lumberjack::QueueStats stats = lumberjack::builtin_queue_stats();
+    lumberjack::builtin_set_queued(false);
+
+    std::string spilled = read_file(spill_path);
+    unlink(spill_path.c_str());
+
+    size_t written = count(data, "[WARN ] warn line ");
+    size_t in_spill = count(spilled, "[WARN ] warn line ");
+    if (stats.spilled == 0 || in_spill != stats.spilled || written + in_spill != lines ||
+        !has_line(spilled, "warn line %d", lines - 1)) {
+        std::cerr << "FAILED: " << written << " written, " << in_spill << " in the spill file, "
+                  << stats.spilled << " counted" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << in_spill << " lines spilled" << std::endl;
+    return true;
+}
+
+bool test_priority_lanes() {
+    std::cout << "Testing priority lanes put ERROR ahead of queued DEBUG..." << std::endl;
+
+    lumberjack::QueueOptions options;
+    options.policy = lumberjack::BACKPRESSURE_BLOCK;
+    options.capacity = 10000;
+    options.priority_lanes = true;
+    start(options);
+    PipeOutput output;
+    const int debug_lines = 3000;
+    for (int i = 0; i < debug_lines; i++) LOG_DEBUG("debug line %d", i);
+    LOG_ERROR("priority error");
+    std::string data = output.finish();
+    lumberjack::builtin_set_queued(false);
+
+    // The writer was stalled on its first batch; the ERROR goes next.
+    size_t error_pos = data.find("[ERROR] #3000 priority error\n");
+    size_t late_debug = data.find("[DEBUG] #500 debug line 500\n");
+    if (error_pos == std::string::npos || late_debug == std::string::npos || error_pos > late_debug ||
+        count(data, "[DEBUG] #") != debug_lines) {
+        std::cerr << "FAILED: ERROR at " << error_pos << ", DEBUG #500 at " << late_debug << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: ERROR written after " << count(data.substr(0, error_pos), "\n")
+              << " of " << debug_lines << " earlier DEBUG lines" << std::endl;
+    return true;
+}
+
+static bool wait_for_text(const char* path, const char* text, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (read_file(path).find(text) == std::string::npos) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+bool test_flush_level() {
+    std::cout << "Testing ERROR lines flush the write buffer..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* file = fopen(path.c_str(), "w");
+
+    lumberjack::init();
+    lumberjack::builtin_set_output(file);
+    lumberjack::builtin_set_buffered(true, 64 * 1024);
+    lumberjack::builtin_set_flush_level(lumberjack::LOG_LEVEL_ERROR);
+
+    LOG_INFO("direct info");
+    bool info_buffered = read_file(path).empty();
+    LOG_ERROR("direct error");
+    std::string direct = read_file(path);
+
+    lumberjack::builtin_set_queued(true);
+    LOG_INFO("queued info");
+    LOG_ERROR("queued error");
+    bool queued_error = wait_for_text(path.c_str(), "queued error\n", 1000);
+    LOG_INFO("trailing info");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool trailing_buffered = read_file(path).find("trailing info") == std::string::npos;
+
+    lumberjack::builtin_set_queued(false);
+    lumberjack::builtin_set_flush_level(lumberjack::LOG_LEVEL_NONE);
+    lumberjack::builtin_set_buffered(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(file);
+    std::string all = read_file(path);
+    unlink(path.c_str());
+
+    if (!info_buffered || direct.find("direct info\n") == std::string::npos ||
+        direct.find("direct error\n") == std::string::npos) {
+        std::cerr << "FAILED: direct ERROR did not flush the buffer" << std::endl;
+        return false;
+    }
+    if (!queued_error || !trailing_buffered || all.find("trailing info\n") == std::string::npos) {
+        std::cerr << "FAILED: queued ERROR flush " << queued_error << ", INFO buffered "
+                  << trailing_buffered << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: ERROR flushed, INFO buffered" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_threads_in_order();
+    success &= test_drop_by_level();
+    success &= test_drop_newest_and_oldest();
+    success &= test_block();
+    success &= test_spill();
+    success &= test_priority_lanes();
+    success &= test_flush_level();
+
+    if (success) {
+        std::cout << "\nAll backpressure tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome backpressure tests FAILED" << std::endl;
+        return 1;
+    }
+}
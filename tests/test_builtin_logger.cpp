@@ -0,0 +1,224 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/builtin_logger.h>
+#include "test_support.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for independent BuiltinLogger instances
+// Tests:
+// - Two instances write to their own outputs with their own buffers
+// - Concurrent logging to separate instances loses and mixes nothing
+// - An instance works as the active backend, and LOG_* reaches only it
+// - log() / LOG_TO() are gated by the instance's level
+// - The default instance is the one builtin_set_*() configures
+
+static size_t count_lines(const std::string& data, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = data.find(needle); pos != std::string::npos; pos = data.find(needle, pos + 1)) count++;
+    return count;
+}
+
+bool test_independent_outputs() {
+    std::cout << "Testing instances keep separate outputs and buffers..." << std::endl;
+
+    std::string access_path = temp_path(), audit_path = temp_path();
+    FILE* access_file = fopen(access_path.c_str(), "w");
+    FILE* audit_file = fopen(audit_path.c_str(), "w");
+    bool buffered_held, flushed, separate;
+    {
+        lumberjack::BuiltinLogger access("access");
+        lumberjack::BuiltinLogger audit("audit");
+        access.set_output(access_file);
+        audit.set_output(audit_file);
+        access.set_buffered(true, 64 * 1024);
+
+        access.log(lumberjack::LOG_LEVEL_INFO, "GET /index.html");
+        audit.log(lumberjack::LOG_LEVEL_INFO, "user %s logged in", "alice");
+
+        // Unbuffered audit is on disk; buffered access is not yet.
+        buffered_held = read_file(access_path).empty() &&
+                        read_file(audit_path).find("user alice logged in\n") != std::string::npos;
+        access.flush();
+        std::string access_data = read_file(access_path);
+        std::string audit_data = read_file(audit_path);
+        flushed = access_data.find("GET /index.html\n") != std::string::npos;
+        separate = access_data.find("alice") == std::string::npos &&
+                   audit_data.find("GET") == std::string::npos;
+    }
+    fclose(access_file);
+    fclose(audit_file);
+    unlink(access_path.c_str());
+    unlink(audit_path.c_str());
+
+    if (!buffered_held || !flushed || !separate) {
+        std::cerr << "FAILED: buffered " << buffered_held << ", flushed " << flushed
+                  << ", separate " << separate << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: each instance wrote only its own lines" << std::endl;
+    return true;
+}
+
+bool test_concurrent_instances() {
+    std::cout << "Testing concurrent logging to separate instances..." << std::endl;
+
+    const int instances = 4, per_thread = 5000;
+    std::vector<std::string> paths;
+    std::vector<FILE*> files;
+    {
+        std::vector<std::unique_ptr<lumberjack::BuiltinLogger>> loggers;
+        for (int i = 0; i < instances; i++) {
+            paths.push_back(temp_path());
+            files.push_back(fopen(paths.back().c_str(), "w"));
+            loggers.emplace_back(new lumberjack::BuiltinLogger("worker"));
+            loggers.back()->set_output(files.back());
+            loggers.back()->set_buffered(true);
+        }
+        std::vector<std::thread> workers;
+        for (int i = 0; i < instances; i++) {
+            lumberjack::BuiltinLogger* logger = loggers[i].get();
+            workers.emplace_back([logger, i] {
+                for (int n = 0; n < per_thread; n++) LOG_TO(*logger, lumberjack::LOG_LEVEL_INFO, "instance %d line %d", i, n);
+            });
+        }
+        for (auto& worker : workers) worker.join();
+    }   // destructors flush
+
+    bool ok = true;
+    for (int i = 0; i < instances; i++) {
+        fclose(files[i]);
+        std::string data = read_file(paths[i]);
+        unlink(paths[i].c_str());
+        std::string own = "instance " + std::to_string(i) + " line";
+        if (count_lines(data, own) != per_thread || count_lines(data, "instance ") != per_thread) {
+            std::cerr << "FAILED: instance " << i << " has " << count_lines(data, own) << " own lines of "
+                      << count_lines(data, "instance ") << std::endl;
+            ok = false;
+        }
+    }
+    if (ok) std::cout << "PASSED: " << instances << " x " << per_thread << " lines, none lost or mixed" << std::endl;
+    return ok;
+}
+
+bool test_instance_as_backend() {
+    std::cout << "Testing an instance as the active backend..." << std::endl;
+
+    std::string path = temp_path(), default_path = temp_path();
+    FILE* file = fopen(path.c_str(), "w");
+    FILE* default_file = fopen(default_path.c_str(), "w");
+    lumberjack::builtin_set_output(default_file);
+    bool distinct, durable;
+    {
+        lumberjack::BuiltinLogger logger("instance");
+        logger.set_output(file);
+        logger.set_buffered(true, 64 * 1024);
+        logger.set_durability(lumberjack::DURABILITY_FLUSH);
+        distinct = logger.backend() && logger.backend() != lumberjack::builtin_backend() &&
+                   std::string(logger.backend()->name) == "instance";
+
+        lumberjack::init();
+        lumberjack::set_backend(logger.backend());
+        LOG_INFO("through the backend");
+        {
+            LOG_SPAN(lumberjack::LOG_LEVEL_INFO, "instance_span");
+        }
+        durable = lumberjack::log_and_wait_durable(lumberjack::LOG_LEVEL_WARN, "committed") &&
+                  read_file(path).find("committed\n") != std::string::npos;
+        lumberjack::set_backend(lumberjack::builtin_backend());
+    }
+    lumberjack::builtin_set_output(stderr);
+    fclose(file);
+    fclose(default_file);
+    std::string data = read_file(path);
+    std::string default_data = read_file(default_path);
+    unlink(path.c_str());
+    unlink(default_path.c_str());
+
+    bool routed = data.find("through the backend\n") != std::string::npos &&
+                  data.find("SPAN 'instance_span' took") != std::string::npos &&
+                  default_data.empty();
+    if (!distinct || !durable || !routed) {
+        std::cerr << "FAILED: distinct " << distinct << ", durable " << durable << ", routed " << routed << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: lines, spans and durable lines reached the instance only" << std::endl;
+    return true;
+}
+
+bool test_instance_level() {
+    std::cout << "Testing instance level gating..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* file = fopen(path.c_str(), "w");
+    bool default_info;
+    {
+        lumberjack::BuiltinLogger logger("gated");
+        logger.set_output(file);
+        default_info = logger.level() == lumberjack::LOG_LEVEL_INFO;
+        LOG_TO(logger, lumberjack::LOG_LEVEL_DEBUG, "hidden debug");
+        logger.set_level(lumberjack::LOG_LEVEL_DEBUG);
+        LOG_TO(logger, lumberjack::LOG_LEVEL_DEBUG, "shown debug %d", 1);
+        logger.set_level(lumberjack::LOG_LEVEL_ERROR);
+        LOG_TO(logger, lumberjack::LOG_LEVEL_WARN, "hidden warn");
+        LOG_TO(logger, lumberjack::LOG_LEVEL_ERROR, "shown error");
+    }
+    fclose(file);
+    std::string data = read_file(path);
+    unlink(path.c_str());
+
+    if (!default_info || data.find("hidden") != std::string::npos ||
+        data.find("shown debug 1\n") == std::string::npos || data.find("shown error\n") == std::string::npos) {
+        std::cerr << "FAILED: unexpected output:\n" << data << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: only lines within the instance level written" << std::endl;
+    return true;
+}
+
+bool test_default_instance() {
+    std::cout << "Testing builtin_set_*() configure the default instance..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* file = fopen(path.c_str(), "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(file);
+    lumberjack::builtin_logger().log(lumberjack::LOG_LEVEL_WARN, "via the default instance");
+    LOG_INFO("via the macros");
+    lumberjack::builtin_set_output(stderr);
+    fclose(file);
+    std::string data = read_file(path);
+    unlink(path.c_str());
+
+    bool same = lumberjack::builtin_logger().backend() == lumberjack::builtin_backend();
+    if (!same || data.find("via the default instance\n") == std::string::npos ||
+        data.find("via the macros\n") == std::string::npos) {
+        std::cerr << "FAILED: same backend " << same << ", output:\n" << data << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: default instance is the built-in backend" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_independent_outputs();
+    success &= test_concurrent_instances();
+    success &= test_instance_as_backend();
+    success &= test_instance_level();
+    success &= test_default_instance();
+
+    if (success) {
+        std::cout << "\nAll builtin logger tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome builtin logger tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,254 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/sinks.h>
+#include "test_support.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Unit tests for the compressed file sink
+// Tests:
+// - Lines round-trip through the built-in LZ codec (compressible and random text)
+// - Lines round-trip through zlib when available
+// - Decoding from a time seeks past older frames using the index
+// - A damaged tail stops decoding without losing earlier frames
+// - A frame whose write fails part-way is truncated away, so frames
+//   appended later still decode
+
+static void remove_files(const std::string& path) {
+    unlink(path.c_str());
+    unlink((path + ".idx").c_str());
+}
+
+static uint64_t now_us() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// Decodes path into memory and splits it into lines.
+static std::vector<std::string> decode_lines(const std::string& path, long* frames,
+                                             uint64_t from_us = 0) {
+    std::vector<std::string> lines;
+    FILE* out = tmpfile();
+    *frames = lumberjack::compressed_file_decode(path.c_str(), out, from_us);
+    rewind(out);
+    char buffer[2048];
+    while (fgets(buffer, sizeof(buffer), out)) lines.push_back(buffer);
+    fclose(out);
+    return lines;
+}
+
+// Message i: mostly repetitive, with every seventh line random hex that
+// the codec cannot shrink.
+static std::string message(int i) {
+    char buffer[256];
+    if (i % 7 == 0) {
+        int n = snprintf(buffer, sizeof(buffer), "blob %d ", i);
+        for (int j = 0; j < 64; j++) n += snprintf(buffer + n, sizeof(buffer) - n, "%x", rand() % 16);
+    } else {
+        snprintf(buffer, sizeof(buffer), "request %d handled by worker %d in %d us", i, i % 8, i * 3);
+    }
+    return buffer;
+}
+
+static bool roundtrip(lumberjack::CompressionCodec codec, const char* name) {
+    std::string path = temp_path();
+    lumberjack::CompressedFileOptions options;
+    options.block_size = 8192;
+    options.queue_depth = 2;
+    options.codec = codec;
+    lumberjack::compressed_file_open(path.c_str(), options);
+    lumberjack::init();
+    lumberjack::set_backend(lumberjack::compressed_file_backend());
+
+    std::vector<std::string> expected;
+    for (int i = 0; i < 3000; i++) {
+        expected.push_back(message(i));
+        LOG_INFO("%s", expected.back().c_str());
+    }
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::compressed_file_close();
+    auto stats = lumberjack::compressed_file_stats();
+
+    long frames = 0;
+    std::vector<std::string> lines = decode_lines(path, &frames);
+    remove_files(path);
+
+    if (lines.size() != expected.size() || frames != static_cast<long>(stats.frames_written)) {
+        std::cerr << "FAILED: " << name << " decoded " << lines.size() << " lines in "
+                  << frames << " frames" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].find("[INFO ] " + expected[i] + "\n") == std::string::npos) {
+            std::cerr << "FAILED: " << name << " line " << i << " is '" << lines[i] << "'" << std::endl;
+            return false;
+        }
+    }
+    if (stats.stored_bytes * 2 > stats.raw_bytes) {
+        std::cerr << "FAILED: " << name << " barely compressed: " << stats.raw_bytes
+                  << " -> " << stats.stored_bytes << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: " << name << " " << lines.size() << " lines, "
+              << stats.raw_bytes << " -> " << stats.stored_bytes << " bytes" << std::endl;
+    return true;
+}
+
+bool test_lz_roundtrip() {
+    std::cout << "Testing built-in LZ round trip..." << std::endl;
+    return roundtrip(lumberjack::COMPRESSION_CODEC_LZ, "LZ");
+}
+
+bool test_zlib_roundtrip() {
+    std::cout << "Testing zlib round trip..." << std::endl;
+    if (!lumberjack::compressed_file_codec_supported(lumberjack::COMPRESSION_CODEC_ZLIB)) {
+        std::cout << "PASSED: skipped (built without zlib)" << std::endl;
+        return true;
+    }
+    return roundtrip(lumberjack::COMPRESSION_CODEC_ZLIB, "zlib");
+}
+
+bool test_seek_by_time() {
+    std::cout << "Testing decode from a point in time..." << std::endl;
+
+    std::string path = temp_path();
+    lumberjack::compressed_file_open(path.c_str());
+    lumberjack::init();
+    lumberjack::set_backend(lumberjack::compressed_file_backend());
+
+    for (int i = 0; i < 100; i++) LOG_INFO("old %d", i);
+    lumberjack::compressed_file_flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t middle = now_us();
+    for (int i = 0; i < 100; i++) LOG_INFO("new %d", i);
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::compressed_file_close();
+
+    long frames = 0;
+    std::vector<std::string> lines = decode_lines(path, &frames, middle);
+    remove_files(path);
+
+    if (frames != 1 || lines.size() != 100 || lines[0].find("new 0") == std::string::npos) {
+        std::cerr << "FAILED: expected only the 100 new lines, got " << lines.size() << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: older frame skipped" << std::endl;
+    return true;
+}
+
+bool test_damaged_tail() {
+    std::cout << "Testing decode stops at a damaged frame..." << std::endl;
+
+    std::string path = temp_path();
+    lumberjack::CompressedFileOptions options;
+    options.block_size = 1024;
+    lumberjack::compressed_file_open(path.c_str(), options);
+    lumberjack::init();
+    lumberjack::set_backend(lumberjack::compressed_file_backend());
+    for (int i = 0; i < 200; i++) LOG_INFO("line %d", i);
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::compressed_file_close();
+    long complete = lumberjack::compressed_file_stats().frames_written;
+
+    // Simulate a frame torn by a crash: a complete 40-byte header claiming
+    // 2048 payload bytes, followed by only 10 of them.
+    unsigned char torn[50] = { 'L', 'J', 'Z', 'F', 1 };
+    torn[9] = 0x10;   // raw_size 4096
+    torn[13] = 0x08;  // stored_size 2048
+    FILE* f = fopen(path.c_str(), "ab");
+    fwrite(torn, 1, sizeof(torn), f);
+    fclose(f);
+
+    long frames = 0;
+    std::vector<std::string> lines = decode_lines(path, &frames);
+    remove_files(path);
+
+    if (frames != complete || lines.size() != 200) {
+        std::cerr << "FAILED: expected " << complete << " frames and 200 lines, got "
+                  << frames << " and " << lines.size() << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: " << frames << " intact frames decoded" << std::endl;
+    return true;
+}
+
+bool test_failed_write_truncated() {
+    std::cout << "Testing a failed frame write is truncated away..." << std::endl;
+
+    // A child hits a file size limit part-way through a frame.
+    std::string path = temp_path();
+    pid_t pid = fork();
+    if (pid == 0) {
+        signal(SIGXFSZ, SIG_IGN);
+        struct rlimit limit = { 6000, 6000 };
+        setrlimit(RLIMIT_FSIZE, &limit);
+        lumberjack::CompressedFileOptions options;
+        options.block_size = 1024;
+        options.codec = lumberjack::COMPRESSION_CODEC_NONE;
+        lumberjack::compressed_file_open(path.c_str(), options);
+        lumberjack::init();
+        lumberjack::set_backend(lumberjack::compressed_file_backend());
+        for (int i = 0; i < 200; i++) LOG_INFO("limited line %d", i);
+        lumberjack::set_backend(lumberjack::builtin_backend());
+        lumberjack::compressed_file_close();
+        _exit(lumberjack::compressed_file_stats().frames_dropped > 0 ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    struct stat st;
+    bool truncated = stat(path.c_str(), &st) == 0 && st.st_size < 6000;
+
+    // Frames appended without the limit follow the last complete one.
+    long before = 0;
+    size_t kept = decode_lines(path, &before).size();
+    lumberjack::compressed_file_open(path.c_str());
+    lumberjack::init();
+    lumberjack::set_backend(lumberjack::compressed_file_backend());
+    for (int i = 0; i < 10; i++) LOG_INFO("appended line %d", i);
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::compressed_file_close();
+    long frames = 0;
+    std::vector<std::string> lines = decode_lines(path, &frames);
+    remove_files(path);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !truncated || kept == 0 ||
+        frames != before + 1 || lines.size() != kept + 10) {
+        std::cerr << "FAILED: status " << status << ", " << frames << " frames and " << lines.size()
+                  << " lines after appending to " << before << " frames" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: " << kept << " lines kept, appended frame decodes" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_lz_roundtrip();
+    success &= test_zlib_roundtrip();
+    success &= test_seek_by_time();
+    success &= test_damaged_tail();
+    success &= test_failed_write_truncated();
+
+    if (success) {
+        std::cout << "\nAll compressed file tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome compressed file tests FAILED" << std::endl;
+        return 1;
+    }
+}
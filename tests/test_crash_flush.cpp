@@ -0,0 +1,292 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/sinks.h>
+#include "test_support.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Unit tests for the crash handler
+// Tests:
+// - Buffered builtin output is written out on SIGABRT, followed by the crash line
+// - The previously installed handler still runs after the flush
+// - Queued async file sink blocks reach the file on a crash
+// - Records still in the built-in backend's queue are written on a crash
+// - A second thread crashing while the hooks run waits for them
+// - After uninstall_crash_handler() nothing is flushed
+
+static int count_lines_with(const std::string& text, const char* needle) {
+    int count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos;
+         pos = text.find(needle, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+// Runs body in a child process and returns its wait status.
+template <typename Body>
+static int run_child(Body body) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        body();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return status;
+}
+
+bool test_buffered_output_flushed_on_abort() {
+    std::cout << "Testing buffered output is flushed on SIGABRT..." << std::endl;
+
+    std::string path = temp_path();
+    int status = run_child([&] {
+        FILE* out = fopen(path.c_str(), "w");
+        lumberjack::init();
+        lumberjack::builtin_set_output(out);
+        lumberjack::builtin_set_buffered(true, 1 << 20);
+        lumberjack::install_crash_handler();
+        for (int i = 0; i < 100; i++) LOG_INFO("line %d", i);
+        abort();
+    });
+    std::string text = read_file(path);
+    unlink(path.c_str());
+
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT) {
+        std::cerr << "FAILED: child did not die from SIGABRT" << std::endl;
+        return false;
+    }
+    if (count_lines_with(text, "[INFO ] line ") != 100 ||
+        text.find("[INFO ] line 99\n") == std::string::npos) {
+        std::cerr << "FAILED: buffered lines missing:\n" << text << std::endl;
+        return false;
+    }
+    char expected[64];
+    snprintf(expected, sizeof(expected), "[ERROR] crashed with signal %d\n", SIGABRT);
+    size_t crash = text.find(expected);
+    if (crash == std::string::npos || crash + strlen(expected) != text.size()) {
+        std::cerr << "FAILED: crash line missing or not last" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: 100 buffered lines and crash line written" << std::endl;
+    return true;
+}
+
+static int g_markerFd = -1;
+
+static void previous_handler(int) {
+    const char marker[] = "previous handler ran\n";
+    ssize_t n = write(g_markerFd, marker, sizeof(marker) - 1);
+    (void)n;
+    _exit(42);
+}
+
+bool test_chains_to_previous_handler() {
+    std::cout << "Testing the previous handler runs after the flush..." << std::endl;
+
+    std::string path = temp_path();
+    int status = run_child([&] {
+        FILE* out = fopen(path.c_str(), "w");
+        g_markerFd = fileno(out);
+        signal(SIGSEGV, previous_handler);
+        lumberjack::init();
+        lumberjack::builtin_set_output(out);
+        lumberjack::builtin_set_buffered(true, 1 << 16);
+        lumberjack::install_crash_handler();
+        LOG_ERROR("about to crash");
+        raise(SIGSEGV);
+    });
+    std::string text = read_file(path);
+    unlink(path.c_str());
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 42) {
+        std::cerr << "FAILED: previous handler did not run" << std::endl;
+        return false;
+    }
+    size_t line = text.find("about to crash\n");
+    size_t crash = text.find("crashed with signal");
+    size_t marker = text.find("previous handler ran\n");
+    if (line == std::string::npos || crash == std::string::npos ||
+        marker == std::string::npos || !(line < crash && crash < marker)) {
+        std::cerr << "FAILED: unexpected output:\n" << text << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: flush, crash line, then previous handler" << std::endl;
+    return true;
+}
+
+bool test_async_file_blocks_flushed() {
+    std::cout << "Testing async file sink blocks are flushed on crash..." << std::endl;
+
+    std::string path = temp_path();
+    int status = run_child([&] {
+        lumberjack::AsyncFileOptions options;
+        options.block_size = 4096;
+        options.block_count = 4;
+        lumberjack::async_file_open(path.c_str(), options);
+        lumberjack::init();
+        lumberjack::set_backend(lumberjack::async_file_backend());
+        lumberjack::install_crash_handler();
+        for (int i = 0; i < 500; i++) LOG_INFO("async line %d", i);
+        abort();
+    });
+    std::string text = read_file(path);
+    unlink(path.c_str());
+
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT) {
+        std::cerr << "FAILED: child did not die from SIGABRT" << std::endl;
+        return false;
+    }
+    if (count_lines_with(text, "async line ") != 500 ||
+        text.find("async line 499\n") == std::string::npos ||
+        text.find("crashed with signal") == std::string::npos) {
+        std::cerr << "FAILED: expected 500 lines and the crash line, got "
+                  << count_lines_with(text, "async line ") << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: all 500 lines and crash line in file" << std::endl;
+    return true;
+}
+
+bool test_queued_records_flushed() {
+    std::cout << "Testing queued records are flushed on crash..." << std::endl;
+
+    // The output is a pipe nobody reads until the child has crashed, so the
+    // writer thread stalls on the fill lines and the queued lines stay in
+    // the queue; the parent then drains the pipe.
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    fcntl(fds[1], F_SETPIPE_SZ, 4096);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        lumberjack::init();
+        lumberjack::builtin_set_output(fdopen(fds[1], "w"));
+        lumberjack::builtin_set_queued(true);
+        lumberjack::install_crash_handler();
+        for (int i = 0; i < 400; i++) LOG_INFO("fill line %d", i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        for (int i = 0; i < 50; i++) LOG_WARN("queued line %d", i);
+        abort();
+    }
+    close(fds[1]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::string text;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) text.append(buffer, static_cast<size_t>(n));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT) {
+        std::cerr << "FAILED: child did not die from SIGABRT" << std::endl;
+        return false;
+    }
+    // A line the writer had in hand when the handler ran may appear twice.
+    for (int i = 0; i < 50; i++) {
+        std::string line = "[WARN ] queued line " + std::to_string(i) + "\n";
+        if (text.find(line) == std::string::npos) {
+            std::cerr << "FAILED: missing queued line " << i << "\n" << text.substr(text.size() > 400 ? text.size() - 400 : 0) << std::endl;
+            return false;
+        }
+    }
+    if (text.find("crashed with signal") == std::string::npos) {
+        std::cerr << "FAILED: crash line missing" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: all 50 queued lines and crash line written" << std::endl;
+    return true;
+}
+
+static void slow_hook(int) {
+    struct timespec delay = { 0, 200 * 1000000 };
+    nanosleep(&delay, nullptr);
+    const char marker[] = "slow hook done\n";
+    ssize_t n = write(g_markerFd, marker, sizeof(marker) - 1);
+    (void)n;
+}
+
+bool test_concurrent_crash_waits() {
+    std::cout << "Testing a second crashing thread waits for the hooks..." << std::endl;
+
+    std::string path = temp_path();
+    int status = run_child([&] {
+        FILE* out = fopen(path.c_str(), "w");
+        g_markerFd = fileno(out);
+        lumberjack::install_crash_handler();
+        lumberjack::register_crash_flush(slow_hook);
+        std::thread second([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            raise(SIGSEGV);
+        });
+        abort();
+    });
+    std::string text = read_file(path);
+    unlink(path.c_str());
+
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT || text != "slow hook done\n") {
+        std::cerr << "FAILED: status " << status << ", output '" << text << "'" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: hooks finished, first signal delivered" << std::endl;
+    return true;
+}
+
+bool test_uninstall_restores_default() {
+    std::cout << "Testing uninstall restores the previous handlers..." << std::endl;
+
+    std::string path = temp_path();
+    int status = run_child([&] {
+        FILE* out = fopen(path.c_str(), "w");
+        lumberjack::init();
+        lumberjack::builtin_set_output(out);
+        lumberjack::builtin_set_buffered(true, 1 << 16);
+        lumberjack::install_crash_handler();
+        lumberjack::uninstall_crash_handler();
+        LOG_INFO("never flushed");
+        abort();
+    });
+    std::string text = read_file(path);
+    unlink(path.c_str());
+
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT || !text.empty()) {
+        std::cerr << "FAILED: expected plain abort with nothing written" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: handler removed" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_buffered_output_flushed_on_abort();
+    success &= test_chains_to_previous_handler();
+    success &= test_async_file_blocks_flushed();
+    success &= test_queued_records_flushed();
+    success &= test_concurrent_crash_waits();
+    success &= test_uninstall_restores_default();
+
+    if (success) {
+        std::cout << "\nAll crash flush tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome crash flush tests FAILED" << std::endl;
+        return 1;
+    }
+}
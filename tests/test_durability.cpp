@@ -0,0 +1,166 @@
+#include <lumberjack/lumberjack.h>
+#include "test_support.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for durability levels and group commit
+// Tests:
+// - With FLUSH and FDATASYNC, a line is in the file by the time
+//   log_and_wait_durable() returns, even with a large write buffer
+// - With NONE the call does not wait and the line stays buffered
+// - Concurrent waiters are committed in groups, not one fdatasync each
+// - Disabled levels and other backends do not wait
+
+// Builtin output into a fresh file with a 64 KB write buffer.
+static FILE* start(const std::string& path, lumberjack::Durability durability) {
+    FILE* file = fopen(path.c_str(), "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(file);
+    lumberjack::builtin_set_buffered(true, 64 * 1024);
+    lumberjack::builtin_set_durability(durability);
+    return file;
+}
+
+static void stop(FILE* file, const std::string& path) {
+    lumberjack::builtin_set_durability(lumberjack::DURABILITY_NONE);
+    lumberjack::builtin_set_buffered(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(file);
+    unlink(path.c_str());
+}
+
+bool test_visible_on_return() {
+    std::cout << "Testing durable lines are written before the call returns..." << std::endl;
+
+    for (lumberjack::Durability durability : {lumberjack::DURABILITY_FLUSH, lumberjack::DURABILITY_FDATASYNC}) {
+        std::string path = temp_path();
+        FILE* file = start(path, durability);
+        LOG_INFO("plain line before");
+        for (int i = 0; i < 20; i++) {
+            char text[32];
+            snprintf(text, sizeof(text), "audit record %d\n", i);
+            bool ok = lumberjack::log_and_wait_durable(lumberjack::LOG_LEVEL_INFO, "audit record %d", i);
+            std::string data = read_file(path);
+            if (!ok || data.find(text) == std::string::npos || data.find("plain line before\n") == std::string::npos) {
+                std::cerr << "FAILED: durability " << durability << " record " << i
+                          << " not in the file (ok=" << ok << ")" << std::endl;
+                stop(file, path);
+                return false;
+            }
+        }
+        lumberjack::DurabilityStats stats = lumberjack::builtin_durability_stats();
+        stop(file, path);
+        if (stats.errors != 0) {
+            std::cerr << "FAILED: " << stats.errors << " commit errors" << std::endl;
+            return false;
+        }
+    }
+    std::cout << "PASSED: every record readable on return" << std::endl;
+    return true;
+}
+
+bool test_none_does_not_wait() {
+    std::cout << "Testing DURABILITY_NONE leaves the line buffered..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* file = start(path, lumberjack::DURABILITY_NONE);
+    bool ok = lumberjack::log_and_wait_durable(lumberjack::LOG_LEVEL_INFO, "not committed");
+    bool buffered = read_file(path).empty();
+    lumberjack::builtin_flush();
+    bool flushed = read_file(path).find("not committed\n") != std::string::npos;
+    stop(file, path);
+
+    if (!ok || !buffered || !flushed) {
+        std::cerr << "FAILED: ok " << ok << ", buffered " << buffered << ", flushed " << flushed << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: returned at once, line written on flush" << std::endl;
+    return true;
+}
+
+bool test_group_commit() {
+    std::cout << "Testing concurrent waiters share fdatasyncs..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* file = start(path, lumberjack::DURABILITY_FDATASYNC);
+    lumberjack::DurabilityStats before = lumberjack::builtin_durability_stats();
+    const int threads = 8, per_thread = 100;
+    std::vector<std::thread> workers;
+    std::vector<int> failures(threads, 0);
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&failures, t] {
+            for (int i = 0; i < per_thread; i++) {
+                if (!lumberjack::log_and_wait_durable(lumberjack::LOG_LEVEL_WARN, "thread %d record %d", t, i)) {
+                    failures[t]++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    lumberjack::DurabilityStats after = lumberjack::builtin_durability_stats();
+    std::string data = read_file(path);
+    stop(file, path);
+
+    uint64_t records = after.records - before.records;
+    uint64_t commits = after.commits - before.commits;
+    size_t lines = 0;
+    for (char c : data) lines += c == '\n';
+    int failed = 0;
+    for (int f : failures) failed += f;
+    if (failed != 0 || lines != threads * per_thread || records != lines || commits >= records) {
+        std::cerr << "FAILED: " << lines << " lines, " << records << " records in "
+                  << commits << " commits, " << failed << " failures" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << records << " records in " << commits << " commits" << std::endl;
+    return true;
+}
+
+static int g_captured = 0;
+static void capture_write(lumberjack::LogLevel, const char*) { g_captured++; }
+
+bool test_not_waiting() {
+    std::cout << "Testing disabled levels and other backends..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* file = start(path, lumberjack::DURABILITY_FDATASYNC);
+    bool disabled = lumberjack::log_and_wait_durable(lumberjack::LOG_LEVEL_DEBUG, "filtered");
+
+    lumberjack::LogBackend capture = {
+        "capture", noop_init, noop_shutdown, capture_write, noop_span_begin, noop_span_end
+    };
+    lumberjack::set_backend(&capture);
+    bool other = lumberjack::log_and_wait_durable(lumberjack::LOG_LEVEL_ERROR, "elsewhere");
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    std::string data = read_file(path);
+    stop(file, path);
+
+    if (!disabled || other || g_captured != 1 || !data.empty()) {
+        std::cerr << "FAILED: disabled " << disabled << ", other backend " << other << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: nothing waited on" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_visible_on_return();
+    success &= test_none_does_not_wait();
+    success &= test_group_commit();
+    success &= test_not_waiting();
+
+    if (success) {
+        std::cout << "\nAll durability tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome durability tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,165 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/escalation.h>
+#include <lumberjack/structured.h>
+#include "capture_backend.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+// Unit tests for verbosity escalation after errors
+// Tests:
+// - Escalation is off until enabled; an ERROR then turns DEBUG on for all
+//   threads, and the line budget turns it off again; spans stay off
+// - The window ends an escalation; triggers while it runs do not extend it
+// - set_level() and set_escalation(false) end a process escalation
+// - Thread scope escalates the logging thread only and restores its
+//   previous override
+
+using lumberjack::kv;
+
+static void finish() {
+    lumberjack::set_escalation(false);
+    lumberjack::clear_thread_level();
+    lumberjack::set_level(lumberjack::LOG_LEVEL_INFO);
+    finish_capture();
+}
+
+bool test_process_budget() {
+    std::cout << "Testing process escalation and its line budget..." << std::endl;
+
+    start_capture();
+    LOG_ERROR("error while off");
+    LOG_DEBUG("debug while off");
+
+    lumberjack::EscalationOptions options;
+    options.max_lines = 3;
+    lumberjack::set_escalation(true, options);
+    LOG_DEBUG("debug before");
+    LOG_ERROR("failed %d", 1);
+    bool raised = lumberjack::escalated() && lumberjack::get_level() == lumberjack::LOG_LEVEL_DEBUG;
+    LOG_DEBUG("debug %d", 1);
+    { DEBUG_SPAN("escalated span"); }
+    std::thread other([] { LOG_DEBUG_KV("debug", kv("n", 2)); });
+    other.join();
+    LOG_INFO("info");
+    LOG_DEBUG("debug 3");
+    LOG_DEBUG("debug 4");
+    bool lowered = !lumberjack::escalated() && lumberjack::get_level() == lumberjack::LOG_LEVEL_INFO;
+    LOG_DEBUG("debug 5");
+    finish();
+
+    std::string expected = "error while off|failed 1|debug 1|debug n=2|info|debug 3";
+    if (messages() != expected || !raised || !lowered || g_spans != 0) {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+bool test_window() {
+    std::cout << "Testing the escalation window..." << std::endl;
+
+    start_capture();
+    lumberjack::EscalationOptions options;
+    options.window_ms = 50;
+    lumberjack::set_escalation(true, options);
+    LOG_ERROR("first");
+    LOG_DEBUG("inside");
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    LOG_ERROR("second");
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    LOG_DEBUG("after the window");
+    bool lowered = !lumberjack::escalated();
+    LOG_ERROR("third");
+    LOG_DEBUG("escalated again");
+    finish();
+
+    if (messages() != "first|inside|second|third|escalated again" || !lowered) {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+bool test_ending() {
+    std::cout << "Testing set_level() and disabling during an escalation..." << std::endl;
+
+    start_capture();
+    lumberjack::set_escalation(true);
+    LOG_ERROR("one");
+    lumberjack::set_level(lumberjack::LOG_LEVEL_WARN);
+    LOG_DEBUG("after set_level");
+    LOG_INFO("info after set_level");
+    bool ended = !lumberjack::escalated();
+
+    LOG_ERROR("two");
+    lumberjack::set_escalation(false);
+    LOG_DEBUG("after disabling");
+    bool restored = lumberjack::get_level() == lumberjack::LOG_LEVEL_WARN;
+    finish();
+
+    if (messages() != "one|two" || !ended || !restored) {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+bool test_thread_scope() {
+    std::cout << "Testing thread escalation..." << std::endl;
+
+    start_capture();
+    lumberjack::EscalationOptions options;
+    options.scope = lumberjack::ESCALATE_THREAD;
+    options.max_lines = 2;
+    lumberjack::set_escalation(true, options);
+    {
+        lumberjack::ThreadLevelOverride quiet(lumberjack::LOG_LEVEL_WARN);
+        LOG_INFO("quiet info");
+        LOG_ERROR("failed");
+        std::thread other([] {
+            LOG_DEBUG("other debug");
+            LOG_INFO("other info");
+        });
+        other.join();
+        LOG_DEBUG("debug 1");
+        LOG_INFO("info 2");
+        LOG_DEBUG("debug 3");
+        LOG_INFO("quiet again");
+        if (lumberjack::get_thread_level() != lumberjack::LOG_LEVEL_WARN || lumberjack::get_level() != lumberjack::LOG_LEVEL_INFO) {
+            std::cerr << "FAILED: override not restored" << std::endl;
+            return false;
+        }
+    }
+    LOG_INFO("global info");
+    finish();
+
+    if (messages() != "failed|other info|debug 1|info 2|global info") {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_process_budget();
+    success &= test_window();
+    success &= test_ending();
+    success &= test_thread_scope();
+
+    if (success) {
+        std::cout << "\nAll escalation tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome escalation tests FAILED" << std::endl;
+        return 1;
+    }
+}
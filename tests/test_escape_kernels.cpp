@@ -0,0 +1,170 @@
+#include <lumberjack/utils.h>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Unit tests for the escaping kernels
+// Tests:
+// - escape_json writes the expected sequences and never cuts one in half
+// - Every kernel the CPU supports agrees with the scalar kernel on
+//   find_escape, find_control, escape_json and sanitize_control, over
+//   random lengths, alignments and sparse special bytes
+// - Kernels the CPU lacks are refused
+
+struct Results {
+    std::vector<size_t> escape_at;
+    std::vector<size_t> control_at;
+    std::vector<std::string> escaped;
+    std::vector<std::string> sanitized;
+};
+
+// Random text that is mostly clean, with a special byte (or a high byte,
+// which must be left alone) roughly every `spacing` bytes.
+static std::string random_text(std::mt19937& rng, size_t length, unsigned spacing) {
+    static const char special[] = { '"', '\\', '\n', '\r', '\t', '\0', '\x01', '\x1f', '\x7f', '\x80', '\xff', ' ' };
+    std::string text(length, 'x');
+    for (size_t i = 0; i < length; i++) {
+        text[i] = static_cast<char>(0x20 + rng() % 0x5e);   // printable, no DEL
+        if (rng() % spacing == 0) text[i] = special[rng() % sizeof(special)];
+    }
+    return text;
+}
+
+// Runs every operation over the same inputs with the current kernel.
+static Results run_all(const std::vector<std::string>& inputs, const std::vector<size_t>& offsets) {
+    Results r;
+    char buffer[4096 + 64];
+    for (size_t n = 0; n < inputs.size(); n++) {
+        // Copy to an odd offset so the vector loads start unaligned.
+        std::string storage(offsets[n], ' ');
+        storage += inputs[n];
+        const char* text = storage.data() + offsets[n];
+        size_t length = inputs[n].size();
+
+        r.escape_at.push_back(lumberjack::find_escape(text, length));
+        r.control_at.push_back(lumberjack::find_control(text, length));
+
+        size_t consumed = 0;
+        size_t capacity = length ? (length * 3) % (sizeof(buffer) - 1) : 0;
+        size_t written = lumberjack::escape_json(buffer, capacity, text, length, &consumed);
+        r.escaped.push_back(std::string(buffer, written) + "|" + std::to_string(consumed));
+
+        std::string copy(text, length);
+        size_t replaced = lumberjack::sanitize_control(&copy[0], copy.size());
+        r.sanitized.push_back(copy + "|" + std::to_string(replaced));
+    }
+    return r;
+}
+
+bool test_escape_sequences() {
+    std::cout << "Testing escape_json output..." << std::endl;
+
+    const std::string text = std::string("a\"b\\c\nd\re\tf") + '\0' + "\x1f\x7f" + "\xc3\xa9";
+    char out[64];
+    size_t consumed = 0;
+    std::string full(out, lumberjack::escape_json(out, sizeof(out), text.data(), text.size(), &consumed));
+    const std::string expected = "a\\\"b\\\\c\\nd\\re\\tf\\u0000\\u001f\\u007f\xc3\xa9";
+    bool ok = full == expected && consumed == text.size();
+
+    // With room for "a" and half of \" the escape is left out whole.
+    std::string cut(out, lumberjack::escape_json(out, 2, text.data(), text.size(), &consumed));
+    ok = ok && cut == "a" && consumed == 1;
+
+    std::string line = "one\ntwo\x7f";
+    ok = ok && lumberjack::sanitize_control(&line[0], line.size()) == 2 && line == "one two ";
+
+    if (!ok) {
+        std::cerr << "FAILED: '" << full << "' / '" << cut << "' / '" << line << "'" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: escapes, truncation and sanitizing" << std::endl;
+    return true;
+}
+
+bool test_kernels_match_scalar() {
+    std::cout << "Testing SIMD kernels against the scalar kernel..." << std::endl;
+
+    std::mt19937 rng(1234);
+    std::vector<std::string> inputs;
+    std::vector<size_t> offsets;
+    for (size_t length = 0; length <= 130; length++) {
+        for (unsigned spacing : { 1u, 7u, 40u, 1000u }) {
+            inputs.push_back(random_text(rng, length, spacing));
+            offsets.push_back(rng() % 31);
+        }
+    }
+    for (int i = 0; i < 200; i++) {
+        inputs.push_back(random_text(rng, 200 + rng() % 3800, 1 + rng() % 500));
+        offsets.push_back(rng() % 31);
+    }
+
+    lumberjack::EscapeKernel original = lumberjack::escape_kernel();
+    lumberjack::set_escape_kernel(lumberjack::ESCAPE_SCALAR);
+    Results scalar = run_all(inputs, offsets);
+
+    bool ok = true;
+    int tested = 0;
+    const lumberjack::EscapeKernel kernels[] = { lumberjack::ESCAPE_SSE2, lumberjack::ESCAPE_AVX2 };
+    const char* names[] = { "SSE2", "AVX2" };
+    for (int k = 0; k < 2; k++) {
+        if (!lumberjack::set_escape_kernel(kernels[k])) {
+            std::cout << "  " << names[k] << " not supported here, skipped" << std::endl;
+            continue;
+        }
+        Results simd = run_all(inputs, offsets);
+        tested++;
+        for (size_t n = 0; n < inputs.size(); n++) {
+            if (simd.escape_at[n] != scalar.escape_at[n] || simd.control_at[n] != scalar.control_at[n] ||
+                simd.escaped[n] != scalar.escaped[n] || simd.sanitized[n] != scalar.sanitized[n]) {
+                std::cerr << "FAILED: " << names[k] << " differs on input " << n
+                          << " (length " << inputs[n].size() << ")" << std::endl;
+                ok = false;
+                break;
+            }
+        }
+    }
+    lumberjack::set_escape_kernel(original);
+
+    if (!ok) return false;
+    std::cout << "PASSED: " << tested << " SIMD kernel(s) match on " << inputs.size() << " inputs" << std::endl;
+    return true;
+}
+
+bool test_kernel_selection() {
+    std::cout << "Testing kernel selection..." << std::endl;
+
+    lumberjack::EscapeKernel original = lumberjack::escape_kernel();
+    bool ok = lumberjack::set_escape_kernel(lumberjack::ESCAPE_SCALAR) &&
+              lumberjack::escape_kernel() == lumberjack::ESCAPE_SCALAR;
+#if !defined(__x86_64__) && !defined(__i386__)
+    ok = ok && !lumberjack::set_escape_kernel(lumberjack::ESCAPE_AVX2) &&
+         lumberjack::escape_kernel() == lumberjack::ESCAPE_SCALAR;
+#endif
+    ok = ok && lumberjack::set_escape_kernel(original) && lumberjack::escape_kernel() == original;
+
+    if (!ok) {
+        std::cerr << "FAILED: kernel selection" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: default kernel " << static_cast<int>(original) << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_escape_sequences();
+    success &= test_kernels_match_scalar();
+    success &= test_kernel_selection();
+
+    if (success) {
+        std::cout << "\nAll escape kernel tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome escape kernel tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,187 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/flight_recorder.h>
+#include "test_support.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Unit tests for the flight recorder
+// Tests:
+// - Records survive SIGKILL while the builtin write buffer still holds them
+// - DEBUG lines are recorded while the output level filters them out
+// - After wraparound only the newest records are recovered, in order
+// - Reopening an existing recorder file continues the stream
+// - Recovery rejects files that are not recorder files
+
+// Recovers path into memory and splits it into lines.
+static std::vector<std::string> recover_lines(const std::string& path, long* records) {
+    std::vector<std::string> lines;
+    FILE* out = tmpfile();
+    *records = lumberjack::flight_recorder_recover(path.c_str(), out);
+    rewind(out);
+    char buffer[2048];
+    while (fgets(buffer, sizeof(buffer), out)) lines.push_back(buffer);
+    fclose(out);
+    return lines;
+}
+
+bool test_survives_sigkill() {
+    std::cout << "Testing recovery after SIGKILL with buffered output..." << std::endl;
+
+    std::string path = temp_path();
+    unlink(path.c_str());
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        FILE* devnull = fopen("/dev/null", "w");
+        lumberjack::init();
+        lumberjack::builtin_set_output(devnull);
+        lumberjack::builtin_set_buffered(true, 1 << 20);
+        lumberjack::builtin_set_flight_recorder(path.c_str(), 1 << 20);
+        lumberjack::set_level(lumberjack::LOG_LEVEL_DEBUG);
+        lumberjack::builtin_set_output_level(lumberjack::LOG_LEVEL_INFO);
+        for (int i = 0; i < 200; i++) {
+            if (i % 2) LOG_DEBUG("record %d", i);
+            else       LOG_INFO("record %d", i);
+        }
+        raise(SIGKILL);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGKILL) {
+        std::cerr << "FAILED: child did not die from SIGKILL" << std::endl;
+        return false;
+    }
+
+    long records = 0;
+    std::vector<std::string> lines = recover_lines(path, &records);
+    unlink(path.c_str());
+
+    if (records != 200 || lines.size() != 200) {
+        std::cerr << "FAILED: expected 200 records, got " << records << std::endl;
+        return false;
+    }
+    for (int i = 0; i < 200; i++) {
+        char expected[64];
+        snprintf(expected, sizeof(expected), "[%s] record %d\n",
+                 i % 2 ? "DEBUG" : "INFO ", i);
+        if (lines[i].find(expected) == std::string::npos) {
+            std::cerr << "FAILED: line " << i << " is '" << lines[i] << "'" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "PASSED: all 200 records recovered in order" << std::endl;
+    return true;
+}
+
+bool test_wraparound_keeps_newest() {
+    std::cout << "Testing wraparound keeps the newest records..." << std::endl;
+
+    std::string path = temp_path();
+    lumberjack::FlightRecorder recorder;
+    if (!recorder.open(path.c_str(), 8192)) {
+        std::cerr << "FAILED: could not open recorder" << std::endl;
+        return false;
+    }
+    for (int i = 0; i < 1000; i++) {
+        char line[64];
+        int n = snprintf(line, sizeof(line), "entry %d\n", i);
+        recorder.append(line, static_cast<size_t>(n));
+    }
+    recorder.close();
+
+    long records = 0;
+    std::vector<std::string> lines = recover_lines(path, &records);
+    unlink(path.c_str());
+
+    if (records < 100 || records >= 1000) {
+        std::cerr << "FAILED: unexpected record count " << records << std::endl;
+        return false;
+    }
+    int first = 1000 - static_cast<int>(lines.size());
+    for (size_t i = 0; i < lines.size(); i++) {
+        int value = -1;
+        if (sscanf(lines[i].c_str(), "entry %d", &value) != 1 ||
+            value != first + static_cast<int>(i)) {
+            std::cerr << "FAILED: expected entry " << first + static_cast<int>(i)
+                      << ", got '" << lines[i] << "'" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "PASSED: recovered entries " << first << "..999" << std::endl;
+    return true;
+}
+
+bool test_reopen_continues() {
+    std::cout << "Testing that reopening continues the stream..." << std::endl;
+
+    std::string path = temp_path();
+    {
+        lumberjack::FlightRecorder recorder;
+        recorder.open(path.c_str(), 16384);
+        recorder.append("first run\n", 10);
+    }
+    {
+        lumberjack::FlightRecorder recorder;
+        recorder.open(path.c_str(), 16384);
+        recorder.append("second run\n", 11);
+    }
+
+    long records = 0;
+    std::vector<std::string> lines = recover_lines(path, &records);
+    unlink(path.c_str());
+
+    if (records != 2 || lines[0] != "first run\n" || lines[1] != "second run\n") {
+        std::cerr << "FAILED: expected both runs, got " << records << " records" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: records from both runs recovered" << std::endl;
+    return true;
+}
+
+bool test_rejects_foreign_file() {
+    std::cout << "Testing that non-recorder files are rejected..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* f = fopen(path.c_str(), "w");
+    fputs("just a regular log file\n", f);
+    fclose(f);
+
+    long records = 0;
+    recover_lines(path, &records);
+    unlink(path.c_str());
+    if (records != -1) {
+        std::cerr << "FAILED: expected -1, got " << records << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: foreign file rejected" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_survives_sigkill();
+    success &= test_wraparound_keeps_newest();
+    success &= test_reopen_continues();
+    success &= test_rejects_foreign_file();
+
+    if (success) {
+        std::cout << "\nAll flight recorder tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome flight recorder tests FAILED" << std::endl;
+        return 1;
+    }
+}
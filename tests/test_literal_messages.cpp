@@ -0,0 +1,116 @@
+#include <lumberjack/lumberjack.h>
+#include "capture_backend.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Unit tests for the argument-less message fast path
+// Tests:
+// - An argument-less literal arrives unchanged, with its length and call
+//   site, through the literal dispatch table
+// - Literals containing '%' are still formatted ("%%" prints "%")
+// - Runtime strings without arguments print the same as before, through
+//   the formatting path
+// - Disabled levels write nothing; overlong literals are cut to 1023 bytes
+
+// The literal path needs the compiler to see the string, which only an
+// optimized build does; otherwise every call goes through site[].
+#if defined(__OPTIMIZE__)
+static const int LITERAL_CALLS = 1;
+#else
+static const int LITERAL_CALLS = 0;
+#endif
+
+// Counts calls through the literal table by wrapping its entry.
+static int g_literalCalls = 0;
+static lumberjack::LogLiteralFunction g_literalEntry = nullptr;
+static void counting_literal(lumberjack::LogLevel level, const char* file, int line, const char* text, size_t len) {
+    g_literalCalls++;
+    g_literalEntry(level, file, line, text, len);
+}
+
+static void start() {
+    start_capture();
+    g_literalEntry = lumberjack::g_logLiteralFunctions[lumberjack::LOG_LEVEL_INFO];
+    lumberjack::g_logLiteralFunctions[lumberjack::LOG_LEVEL_INFO] = counting_literal;
+    g_literalCalls = 0;
+}
+
+static void stop() {
+    lumberjack::set_level(lumberjack::LOG_LEVEL_INFO);   // rewires the tables
+    finish_capture();
+}
+
+bool test_plain_literal() {
+    std::cout << "Testing argument-less literals..." << std::endl;
+
+    start();
+    int line = __LINE__ + 1;
+    LOG_INFO("server started");
+    stop();
+
+    if (g_literalCalls != LITERAL_CALLS || g_records.size() != 1 || g_records[0].message != "server started" ||
+        g_records[0].length != 14 || g_records[0].line != line) {
+        std::cerr << "FAILED: " << g_literalCalls << " literal calls, " << g_records.size() << " records" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: delivered unformatted with length and call site" << std::endl;
+    return true;
+}
+
+bool test_percent_literals() {
+    std::cout << "Testing literals with '%'..." << std::endl;
+
+    start();
+    LOG_INFO("100%% done");
+    LOG_INFO("rate %d%%", 50);
+    std::string runtime = "no placeholders here";
+    LOG_INFO(runtime.c_str());   // unknown at compile time: formatted
+    stop();
+
+    std::vector<std::string> expected = { "100% done", "rate 50%", "no placeholders here" };
+    bool ok = g_records.size() == expected.size() && g_literalCalls == 0;
+    for (size_t i = 0; ok && i < expected.size(); i++) ok = g_records[i].message == expected[i];
+    if (!ok) {
+        std::cerr << "FAILED: " << g_literalCalls << " literal calls" << std::endl;
+        for (auto& r : g_records) std::cerr << "  '" << r.message << "'" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: '%' literals formatted, others passed through" << std::endl;
+    return true;
+}
+
+bool test_disabled_and_long() {
+    std::cout << "Testing disabled levels and long literals..." << std::endl;
+
+    start();
+    LOG_DEBUG("not at INFO");
+    std::string long_text(2000, 'x');
+    lumberjack::g_logLiteralFunctions[lumberjack::LOG_LEVEL_INFO](
+        lumberjack::LOG_LEVEL_INFO, __FILE__, __LINE__, long_text.c_str(), long_text.size());
+    stop();
+
+    if (g_records.size() != 1 || g_records[0].length != 1023 || g_records[0].message != std::string(1023, 'x')) {
+        std::cerr << "FAILED: " << g_records.size() << " records" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: debug dropped, long message cut to 1023 bytes" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_plain_literal();
+    success &= test_percent_literals();
+    success &= test_disabled_and_long();
+
+    if (success) {
+        std::cout << "\nAll literal message tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome literal message tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,208 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/context.h>
+#include "capture_backend.h"
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for thread-local context fields (LogContext)
+// Tests:
+// - Nested scopes append to the prefix and unwind it on exit
+// - Records carry the context in logfmt and JSON form
+// - Each thread has its own context
+// - Batched records keep the context they were logged under
+// - The built-in backend writes the context in TEXT, LOGFMT and JSON, and
+//   queued lines keep it after the scope has closed
+
+using lumberjack::kv;
+using lumberjack::LogContext;
+
+// Splits data into lines with the timestamp replaced by T: the leading
+// [...] field, or the time value of a logfmt or JSON line.
+static std::vector<std::string> stripped_lines(const std::string& data) {
+    std::vector<std::string> lines;
+    for (size_t start = 0, end; (end = data.find('\n', start)) != std::string::npos; start = end + 1) {
+        std::string line = data.substr(start, end - start);
+        size_t from = std::string::npos, to = std::string::npos;
+        if (line.compare(0, 1, "[") == 0) {
+            from = 1;
+            to = line.find(']');
+        } else if (line.compare(0, 6, "time=\"") == 0) {
+            from = 6;
+            to = line.find('"', from);
+        } else if (line.compare(0, 9, "{\"time\":\"") == 0) {
+            from = 9;
+            to = line.find('"', from);
+        }
+        if (to != std::string::npos) line.replace(from, to - from, "T");
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static std::string logfmt_of(const lumberjack::RecordContext& context) {
+    return std::string(context.logfmt, context.logfmt_length);
+}
+
+static std::string json_of(const lumberjack::RecordContext& context) {
+    return std::string(context.json, context.json_length);
+}
+
+bool test_nested_scopes() {
+    std::cout << "Testing nested context scopes..." << std::endl;
+
+    std::vector<std::string> seen;
+    seen.push_back(logfmt_of(lumberjack::current_context()));
+    {
+        LogContext req("req", 42);
+        seen.push_back(logfmt_of(lumberjack::current_context()));
+        {
+            LogContext more({ kv("tenant", "acme corp"), kv("shard", 7u) });
+            seen.push_back(logfmt_of(lumberjack::current_context()));
+            seen.push_back(json_of(lumberjack::current_context()));
+        }
+        seen.push_back(logfmt_of(lumberjack::current_context()));
+        LogContext user("user", std::string("bob"));
+        seen.push_back(logfmt_of(lumberjack::current_context()));
+    }
+    seen.push_back(logfmt_of(lumberjack::current_context()));
+
+    std::vector<std::string> expected = {
+        "",
+        " req=42",
+        " req=42 tenant=\"acme corp\" shard=7",
+        ",\"req\":42,\"tenant\":\"acme corp\",\"shard\":7",
+        " req=42",
+        " req=42 user=bob",
+        "",
+    };
+    if (seen != expected) {
+        std::cerr << "FAILED:" << std::endl;
+        for (const std::string& s : seen) std::cerr << "  '" << s << "'" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: prefixes append and unwind" << std::endl;
+    return true;
+}
+
+bool test_records_and_threads() {
+    std::cout << "Testing context on records and per thread..." << std::endl;
+
+    start_capture();
+    {
+        LogContext ctx("req", 1);
+        LOG_INFO("main %d", 1);
+        std::thread other([] { LOG_INFO("other"); });
+        other.join();
+        LOG_INFO("main %d", 2);
+    }
+    LOG_INFO("after");
+    finish_capture();
+
+    bool ok = g_records.size() == 4 &&
+              g_records[0].context == " req=1" && g_records[0].json == ",\"req\":1" &&
+              g_records[1].message == "other" && g_records[1].context.empty() &&
+              g_records[2].context == " req=1" && g_records[3].context.empty();
+    if (!ok) {
+        std::cerr << "FAILED: " << g_records.size() << " records" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: context stamped on the logging thread only" << std::endl;
+    return true;
+}
+
+bool test_batched_records() {
+    std::cout << "Testing batched records across scopes..." << std::endl;
+
+    start_capture();
+    lumberjack::BatchOptions options;
+    options.interval_ms = 10000;
+    lumberjack::set_batching(true, options);
+    {
+        LogContext ctx("req", 1);
+        LOG_INFO("first");
+    }
+    {
+        LogContext ctx("job", 22);
+        LOG_INFO("second");
+    }
+    lumberjack::flush_batches();
+    lumberjack::set_batching(false);
+    finish_capture();
+
+    bool ok = g_records.size() == 2 && g_records[0].context == " req=1" && g_records[1].context == " job=22";
+    if (!ok) {
+        std::cerr << "FAILED: " << g_records.size() << " records";
+        for (const Captured& r : g_records) std::cerr << " '" << r.context << "'";
+        std::cerr << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: each record keeps its own context" << std::endl;
+    return true;
+}
+
+bool test_builtin_output() {
+    std::cout << "Testing built-in output with context..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* f = fopen(path.c_str(), "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(f);
+    {
+        LogContext ctx({ kv("req", 42), kv("tenant", "acme") });
+        LOG_INFO("handled");
+        lumberjack::builtin_set_output_format(lumberjack::OUTPUT_LOGFMT);
+        LOG_INFO("handled");
+        lumberjack::builtin_set_output_format(lumberjack::OUTPUT_JSON);
+        LOG_INFO_KV("handled", kv("status", 200));
+        lumberjack::builtin_set_output_format(lumberjack::OUTPUT_TEXT);
+        lumberjack::builtin_set_pattern("%L %m");
+        LOG_INFO("no %s", "context");
+        lumberjack::builtin_set_pattern(nullptr);
+
+        lumberjack::builtin_set_queued(true);
+        LOG_WARN("queued");
+    }
+    LOG_WARN("outside");
+    lumberjack::builtin_set_queued(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(f);
+
+    std::string data = read_file(path);
+    unlink(path.c_str());
+    std::vector<std::string> lines = stripped_lines(data);
+    std::vector<std::string> expected = {
+        "[T] [INFO ] req=42 tenant=acme handled",
+        "time=\"T\" level=info req=42 tenant=acme msg=handled",
+        "{\"time\":\"T\",\"level\":\"info\",\"req\":42,\"tenant\":\"acme\",\"msg\":\"handled\",\"status\":200}",
+        "INFO  no context",
+        "[T] [WARN ] req=42 tenant=acme queued",
+        "[T] [WARN ] outside",
+    };
+    if (lines != expected) {
+        std::cerr << "FAILED:\n" << data << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << lines[0] << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_nested_scopes();
+    success &= test_records_and_threads();
+    success &= test_batched_records();
+    success &= test_builtin_output();
+
+    if (success) {
+        std::cout << "\nAll log context tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome log context tests FAILED" << std::endl;
+        return 1;
+    }
+}
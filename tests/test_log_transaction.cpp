@@ -0,0 +1,196 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/transaction.h>
+#include <lumberjack/context.h>
+#include <lumberjack/structured.h>
+#include "capture_backend.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+// Unit tests for request-scoped buffering (LogTransaction)
+// Tests:
+// - A transaction that ends normally drops its lines, DEBUG included
+// - An ERROR line keeps the transaction: every held line is delivered at
+//   scope end with its level, call site and context
+// - keep(), a slow scope and an exception also keep it
+// - Lines beyond max_bytes are dropped and reported
+// - Nested transactions join the outer one; other threads are unaffected
+
+using lumberjack::kv;
+
+bool test_discard_on_success() {
+    std::cout << "Testing transactions that end normally..." << std::endl;
+
+    start_capture();
+    {
+        lumberjack::LogTransaction tx;
+        LOG_DEBUG("debug %d", 1);
+        LOG_INFO("info");
+        LOG_WARN_KV("warn", kv("n", 1));
+    }
+    LOG_DEBUG("debug outside");
+    LOG_INFO("info outside");
+    finish_capture();
+
+    if (messages() != "info outside") {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: held lines dropped, logging unchanged outside" << std::endl;
+    return true;
+}
+
+bool test_keep_on_error() {
+    std::cout << "Testing transactions kept by an ERROR line..." << std::endl;
+
+    start_capture();
+    int line;
+    {
+        lumberjack::LogContext ctx("req", 7);
+        lumberjack::LogTransaction tx;
+        line = __LINE__ + 1;
+        LOG_DEBUG("parsed %d headers", 12);
+        LOG_INFO_KV("routed", kv("route", "/api"));
+        {
+            lumberjack::LogContext inner("step", 2);
+            LOG_ERROR("denied");
+        }
+        if (!g_records.empty()) {
+            std::cerr << "FAILED: delivered before the scope ended" << std::endl;
+            return false;
+        }
+    }
+    finish_capture();
+
+    bool ok = messages() == "parsed 12 headers|routed route=/api|denied" &&
+              g_records[0].level == lumberjack::LOG_LEVEL_DEBUG && g_records[0].line == line &&
+              g_records[0].context == " req=7" && g_records[2].context == " req=7 step=2" &&
+              g_records[2].level == lumberjack::LOG_LEVEL_ERROR;
+    if (!ok) {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+bool test_keep_conditions() {
+    std::cout << "Testing keep(), slow scopes and exceptions..." << std::endl;
+
+    start_capture();
+    {
+        lumberjack::LogTransaction tx;
+        LOG_DEBUG("kept explicitly");
+        tx.keep();
+    }
+    {
+        lumberjack::TransactionOptions options;
+        options.slow_us = 1000;
+        lumberjack::LogTransaction tx(options);
+        LOG_DEBUG("kept as slow");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    {
+        lumberjack::TransactionOptions options;
+        options.slow_us = 10000000;
+        lumberjack::LogTransaction tx(options);
+        LOG_DEBUG("fast, dropped");
+    }
+    try {
+        lumberjack::LogTransaction tx;
+        LOG_DEBUG("kept by exception");
+        throw std::runtime_error("boom");
+    } catch (const std::exception&) {
+    }
+    {
+        lumberjack::TransactionOptions options;
+        options.keep_level = lumberjack::LOG_LEVEL_WARN;
+        options.capture_level = lumberjack::LOG_LEVEL_INFO;
+        lumberjack::LogTransaction tx(options);
+        LOG_DEBUG("not captured");
+        LOG_WARN("kept at WARN");
+    }
+    finish_capture();
+
+    if (messages() != "kept explicitly|kept as slow|kept by exception|kept at WARN") {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+bool test_buffer_full() {
+    std::cout << "Testing a full transaction buffer..." << std::endl;
+
+    start_capture();
+    {
+        lumberjack::TransactionOptions options;
+        options.max_bytes = 64;
+        lumberjack::LogTransaction tx(options);
+        for (int i = 0; i < 10; i++) LOG_DEBUG("line %d of ten", i);
+        tx.keep();
+    }
+    finish_capture();
+
+    // Each line takes 15 bytes with its NUL: four fit in 64.
+    bool ok = g_records.size() == 5 && g_records[3].message == "line 3 of ten" &&
+              g_records[4].level == lumberjack::LOG_LEVEL_WARN &&
+              g_records[4].message == "transaction buffer full, 6 lines dropped";
+    if (!ok) {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << g_records[4].message << std::endl;
+    return true;
+}
+
+bool test_nesting_and_threads() {
+    std::cout << "Testing nested transactions and other threads..." << std::endl;
+
+    start_capture();
+    {
+        lumberjack::LogTransaction outer;
+        LOG_DEBUG("outer");
+        {
+            lumberjack::LogTransaction inner;
+            LOG_DEBUG("inner");
+            inner.keep();
+        }
+        std::thread other([] { LOG_INFO("other thread"); });
+        other.join();
+        if (messages() != "other thread") {
+            std::cerr << "FAILED: inside the scope: " << messages() << std::endl;
+            return false;
+        }
+    }
+    finish_capture();
+
+    if (messages() != "other thread|outer|inner") {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: inner keep() kept the outer transaction" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_discard_on_success();
+    success &= test_keep_on_error();
+    success &= test_keep_conditions();
+    success &= test_buffer_full();
+    success &= test_nesting_and_threads();
+
+    if (success) {
+        std::cout << "\nAll log transaction tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome log transaction tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,276 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/merge.h>
+#include "test_support.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for global sequence numbers and the k-way log merge
+// Tests:
+// - next_sequence() hands out unique numbers across threads
+// - builtin_set_global_sequence() numbers lines, ascending within the file
+// - parse_line_order() finds the timestamp and #N behind any tag fields
+// - Per-thread files merge back into one ascending sequence
+// - Files without numbers merge by timestamp, keeping continuation lines
+//   with their record
+// - A file without numbers makes the whole merge use timestamps, and an
+//   input out of order in the merge key is sorted first
+
+static void write_file(const std::string& path, const std::string& data) {
+    FILE* f = fopen(path.c_str(), "w");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+static std::vector<uint64_t> sequence_numbers(const std::string& data) {
+    std::vector<uint64_t> seqs;
+    size_t start = 0;
+    while (start < data.size()) {
+        size_t end = data.find('\n', start);
+        if (end == std::string::npos) end = data.size();
+        lumberjack::LineOrder order;
+        if (lumberjack::parse_line_order(data.data() + start, end - start, &order) && order.has_seq) {
+            seqs.push_back(order.seq);
+        }
+        start = end + 1;
+    }
+    return seqs;
+}
+
+bool test_unique_sequence() {
+    std::cout << "Testing next_sequence() across threads..." << std::endl;
+
+    const int threads = 4, per_thread = 100000;
+    std::vector<std::vector<uint64_t>> taken(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&taken, t] {
+            for (int i = 0; i < per_thread; i++) taken[t].push_back(lumberjack::next_sequence());
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    std::vector<uint64_t> all;
+    for (auto& list : taken) {
+        for (size_t i = 1; i < list.size(); i++) {
+            if (list[i] <= list[i - 1]) {
+                std::cerr << "FAILED: numbers not increasing within a thread" << std::endl;
+                return false;
+            }
+        }
+        all.insert(all.end(), list.begin(), list.end());
+    }
+    std::sort(all.begin(), all.end());
+    for (size_t i = 1; i < all.size(); i++) {
+        if (all[i] != all[i - 1] + 1) {
+            std::cerr << "FAILED: gap or duplicate at " << all[i] << std::endl;
+            return false;
+        }
+    }
+    std::cout << "PASSED: " << all.size() << " unique, contiguous numbers" << std::endl;
+    return true;
+}
+
+bool test_builtin_global_sequence() {
+    std::cout << "Testing builtin lines carry the global sequence..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* file = fopen(path.c_str(), "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(file);
+    lumberjack::builtin_set_global_sequence(true);
+    const int threads = 4, per_thread = 2000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < per_thread; i++) LOG_INFO("thread %d line %d", t, i);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    lumberjack::builtin_set_global_sequence(false);
+    lumberjack::builtin_set_output(stderr);
+    fclose(file);
+    std::string data = read_file(path);
+    unlink(path.c_str());
+
+    std::vector<uint64_t> seqs = sequence_numbers(data);
+    if (seqs.size() != threads * per_thread) {
+        std::cerr << "FAILED: " << seqs.size() << " numbered lines" << std::endl;
+        return false;
+    }
+    for (size_t i = 1; i < seqs.size(); i++) {
+        if (seqs[i] <= seqs[i - 1]) {
+            std::cerr << "FAILED: #" << seqs[i] << " after #" << seqs[i - 1] << std::endl;
+            return false;
+        }
+    }
+    std::cout << "PASSED: " << seqs.size() << " lines in ascending order" << std::endl;
+    return true;
+}
+
+bool test_parse_line_order() {
+    std::cout << "Testing line order parsing..." << std::endl;
+
+    const char* plain = "[2026-02-24 10:15:03.042] [INFO ] started\n";
+    const char* numbered = "[2026-02-24 10:15:03.042] [1234] [WARN ] #98765 low disk\n";
+    const char* continuation = "  at frame 3\n";
+    lumberjack::LineOrder a, b, c;
+    bool ok = lumberjack::parse_line_order(plain, strlen(plain), &a) &&
+              lumberjack::parse_line_order(numbered, strlen(numbered), &b) &&
+              !lumberjack::parse_line_order(continuation, strlen(continuation), &c);
+    if (!ok || strcmp(a.timestamp, "2026-02-24 10:15:03.042") != 0 || a.has_seq ||
+        !b.has_seq || b.seq != 98765) {
+        std::cerr << "FAILED: parsed '" << a.timestamp << "', #" << b.seq << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: timestamp and #N found" << std::endl;
+    return true;
+}
+
+bool test_merge_by_sequence() {
+    std::cout << "Testing per-thread files merge by sequence..." << std::endl;
+
+    // Each thread formats into its own buffer, as a per-thread sink would.
+    const int threads = 4, per_thread = 5000;
+    std::vector<std::string> buffers(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&buffers, t] {
+            char line[96];
+            for (int i = 0; i < per_thread; i++) {
+                snprintf(line, sizeof(line), "[2026-02-24 10:15:03.042] [INFO ] #%llu thread %d line %d\n",
+                         static_cast<unsigned long long>(lumberjack::next_sequence()), t, i);
+                buffers[t] += line;
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    std::vector<std::string> paths;
+    std::vector<const char*> inputs;
+    for (int t = 0; t < threads; t++) {
+        paths.push_back(temp_path());
+        write_file(paths.back(), buffers[t]);
+    }
+    for (auto& path : paths) inputs.push_back(path.c_str());
+    std::string out_path = temp_path();
+    FILE* out = fopen(out_path.c_str(), "w");
+    long records = lumberjack::merge_log_files(inputs.data(), inputs.size(), out);
+    fclose(out);
+    std::string merged = read_file(out_path);
+    for (auto& path : paths) unlink(path.c_str());
+    unlink(out_path.c_str());
+
+    std::vector<uint64_t> seqs = sequence_numbers(merged);
+    bool ascending = seqs.size() == threads * per_thread;
+    for (size_t i = 1; ascending && i < seqs.size(); i++) ascending = seqs[i] == seqs[i - 1] + 1;
+    if (records != threads * per_thread || !ascending) {
+        std::cerr << "FAILED: " << records << " records, ascending " << ascending << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << records << " records in one sequence" << std::endl;
+    return true;
+}
+
+bool test_merge_by_timestamp() {
+    std::cout << "Testing merge by timestamp with continuation lines..." << std::endl;
+
+    std::string a = temp_path(), b = temp_path(), missing = "/nonexistent/lumberjack.log";
+    write_file(a, "[2026-02-24 10:15:03.001] [INFO ] a1\n"
+                  "[2026-02-24 10:15:03.005] [ERROR] a2\n"
+                  "  stack line 1\n"
+                  "  stack line 2\n"
+                  "[2026-02-24 10:15:03.009] [INFO ] a3\n");
+    write_file(b, "[2026-02-24 10:15:03.001] [INFO ] b1\n"
+                  "[2026-02-24 10:15:03.006] [INFO ] b2\n");
+    std::string out_path = temp_path();
+    const char* inputs[] = { a.c_str(), b.c_str() };
+    const char* with_missing[] = { a.c_str(), missing.c_str() };
+    FILE* out = fopen(out_path.c_str(), "w");
+    long records = lumberjack::merge_log_files(inputs, 2, out);
+    long failed = lumberjack::merge_log_files(with_missing, 2, out);
+    fclose(out);
+    std::string merged = read_file(out_path);
+    unlink(a.c_str());
+    unlink(b.c_str());
+    unlink(out_path.c_str());
+
+    const std::string expected =
+        "[2026-02-24 10:15:03.001] [INFO ] a1\n"
+        "[2026-02-24 10:15:03.001] [INFO ] b1\n"
+        "[2026-02-24 10:15:03.005] [ERROR] a2\n"
+        "  stack line 1\n"
+        "  stack line 2\n"
+        "[2026-02-24 10:15:03.006] [INFO ] b2\n"
+        "[2026-02-24 10:15:03.009] [INFO ] a3\n";
+    if (records != 5 || failed != -1 || merged != expected) {
+        std::cerr << "FAILED: " << records << " records:\n" << merged << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: interleaved by timestamp, ties in input order" << std::endl;
+    return true;
+}
+
+bool test_merge_mixed_and_unordered() {
+    std::cout << "Testing merge with mixed and unordered inputs..." << std::endl;
+
+    // Priority-lane files hold queue positions out of order.
+    std::string lanes = temp_path(), plain = temp_path(), out_path = temp_path();
+    write_file(lanes, "[2026-02-24 10:15:03.004] [ERROR] #3 error\n"
+                      "[2026-02-24 10:15:03.001] [INFO ] #1 first\n"
+                      "  detail\n"
+                      "[2026-02-24 10:15:03.003] [INFO ] #2 second\n");
+    write_file(plain, "[2026-02-24 10:15:03.002] [INFO ] plain\n");
+    const char* one[] = { lanes.c_str() };
+    const char* both[] = { lanes.c_str(), plain.c_str() };
+    FILE* out = fopen(out_path.c_str(), "w");
+    long sorted = lumberjack::merge_log_files(one, 1, out);
+    long mixed = lumberjack::merge_log_files(both, 2, out);
+    fclose(out);
+    std::string merged = read_file(out_path);
+    unlink(lanes.c_str());
+    unlink(plain.c_str());
+    unlink(out_path.c_str());
+
+    const std::string expected =
+        "[2026-02-24 10:15:03.001] [INFO ] #1 first\n"
+        "  detail\n"
+        "[2026-02-24 10:15:03.003] [INFO ] #2 second\n"
+        "[2026-02-24 10:15:03.004] [ERROR] #3 error\n"
+        "[2026-02-24 10:15:03.001] [INFO ] #1 first\n"
+        "  detail\n"
+        "[2026-02-24 10:15:03.002] [INFO ] plain\n"
+        "[2026-02-24 10:15:03.003] [INFO ] #2 second\n"
+        "[2026-02-24 10:15:03.004] [ERROR] #3 error\n";
+    if (sorted != 3 || mixed != 4 || merged != expected) {
+        std::cerr << "FAILED: " << sorted << "/" << mixed << " records:\n" << merged << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: sorted by #N alone, by timestamp when mixed" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_unique_sequence();
+    success &= test_builtin_global_sequence();
+    success &= test_parse_line_order();
+    success &= test_merge_by_sequence();
+    success &= test_merge_by_timestamp();
+    success &= test_merge_mixed_and_unordered();
+
+    if (success) {
+        std::cout << "\nAll merge tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome merge tests FAILED" << std::endl;
+        return 1;
+    }
+}
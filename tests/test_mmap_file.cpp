@@ -0,0 +1,238 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/sinks.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Unit tests for the memory-mapped file sink
+// Tests:
+// - Concurrent producers across many segment rollovers lose no lines
+// - Per-thread ordering is preserved across segments
+// - Finished segments are truncated to their used length (no NUL padding)
+// - Closing stops accepting lines
+// - A process that exits without closing the sink stops the spare thread
+//   and leaves only the used, truncated segment
+// - A segment that cannot be created is counted, and lines are dropped and
+//   counted until one can
+
+static std::string make_temp_base() {
+    char path[] = "/tmp/lumberjack_mmap_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    unlink(path);
+    return path;
+}
+
+static std::string segment_path(const std::string& base, unsigned index) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%06u", index);
+    return base + suffix;
+}
+
+// Concatenates all segment files in order and removes them.
+static std::string read_segments(const std::string& base, unsigned* count) {
+    std::string content;
+    unsigned index = 0;
+    for (;; index++) {
+        std::string path = segment_path(base, index);
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) break;
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) content.append(buffer, n);
+        fclose(f);
+        unlink(path.c_str());
+    }
+    *count = index;
+    return content;
+}
+
+bool test_concurrent_rollover() {
+    std::cout << "Testing concurrent writes across segment rollovers..." << std::endl;
+
+    std::string base = make_temp_base();
+    lumberjack::MmapFileOptions options;
+    options.segment_size = 16 * 1024;
+    if (!lumberjack::mmap_file_open(base.c_str(), options)) {
+        std::cerr << "FAILED: mmap_file_open returned false" << std::endl;
+        return false;
+    }
+    lumberjack::set_backend(lumberjack::mmap_file_backend());
+    lumberjack::set_level(lumberjack::LOG_LEVEL_DEBUG);
+
+    const int threads = 4;
+    const int per_thread = 3000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t]() {
+            for (int i = 0; i < per_thread; i++) LOG_DEBUG("thread %d line %d", t, i);
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    unsigned last_index = lumberjack::mmap_file_segment_index();
+    lumberjack::MmapFileStats stats = lumberjack::mmap_file_stats();
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::mmap_file_close();
+
+    unsigned segments = 0;
+    std::string content = read_segments(base, &segments);
+
+    if (last_index == 0 || segments != last_index + 1) {
+        std::cerr << "FAILED: expected rollovers, current index " << last_index
+                  << ", found " << segments << " segment files" << std::endl;
+        return false;
+    }
+    if (stats.segment_failures != 0 || stats.lines_dropped != 0 || stats.segments_created < segments) {
+        std::cerr << "FAILED: stats " << stats.segments_created << " created, " << stats.segment_failures
+                  << " failures, " << stats.lines_dropped << " dropped" << std::endl;
+        return false;
+    }
+    if (content.find('\0') != std::string::npos) {
+        std::cerr << "FAILED: output contains NUL padding" << std::endl;
+        return false;
+    }
+
+    std::vector<int> next(threads, 0);
+    size_t lines = 0;
+    size_t pos = 0;
+    while (pos < content.size()) {
+        size_t eol = content.find('\n', pos);
+        if (eol == std::string::npos) {
+            std::cerr << "FAILED: unterminated final line" << std::endl;
+            return false;
+        }
+        std::string line = content.substr(pos, eol - pos);
+        pos = eol + 1;
+        int t = -1, i = -1;
+        const char* body = strstr(line.c_str(), "[DEBUG] ");
+        if (!body || sscanf(body, "[DEBUG] thread %d line %d", &t, &i) != 2 ||
+            t < 0 || t >= threads || i != next[t]) {
+            std::cerr << "FAILED: unexpected line: " << line << std::endl;
+            return false;
+        }
+        next[t]++;
+        lines++;
+    }
+    if (lines != static_cast<size_t>(threads * per_thread)) {
+        std::cerr << "FAILED: expected " << threads * per_thread << " lines, got "
+                  << lines << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: " << lines << " lines across " << segments << " segments" << std::endl;
+    return true;
+}
+
+bool test_close_stops_writes() {
+    std::cout << "Testing that close stops accepting lines..." << std::endl;
+
+    std::string base = make_temp_base();
+    lumberjack::mmap_file_open(base.c_str());
+    lumberjack::set_backend(lumberjack::mmap_file_backend());
+    LOG_ERROR("kept");
+    lumberjack::mmap_file_sync();
+    lumberjack::mmap_file_close();
+    LOG_ERROR("dropped");
+    lumberjack::set_backend(lumberjack::builtin_backend());
+
+    unsigned segments = 0;
+    std::string content = read_segments(base, &segments);
+    if (segments != 1 || content.find("kept") == std::string::npos ||
+        content.find("dropped") != std::string::npos) {
+        std::cerr << "FAILED: unexpected content: '" << content << "'" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: close stops accepting lines" << std::endl;
+    return true;
+}
+
+bool test_exit_without_close() {
+    std::cout << "Testing exit without closing the sink..." << std::endl;
+
+    std::string base = make_temp_base();
+    pid_t pid = fork();
+    if (pid == 0) {
+        lumberjack::mmap_file_open(base.c_str());
+        lumberjack::set_backend(lumberjack::mmap_file_backend());
+        LOG_ERROR("logged before exit");
+        exit(0);   // runs static destructors, unlike _exit()
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    unsigned segments = 0;
+    std::string content = read_segments(base, &segments);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || segments != 1 ||
+        content.find("logged before exit\n") == std::string::npos || content.find('\0') != std::string::npos) {
+        std::cerr << "FAILED: status " << status << ", " << segments << " segments, "
+                  << content.size() << " bytes" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: clean exit, one truncated segment" << std::endl;
+    return true;
+}
+
+bool test_segment_failure() {
+    std::cout << "Testing a segment that cannot be created..." << std::endl;
+
+    char dir[] = "/tmp/lumberjack_mmapdir_XXXXXX";
+    if (!mkdtemp(dir)) return false;
+    std::string base = std::string(dir) + "/log";
+    std::string moved = std::string(dir) + ".moved";
+    lumberjack::MmapFileOptions options;
+    options.segment_size = 4096;
+    lumberjack::mmap_file_open(base.c_str(), options);
+    lumberjack::set_backend(lumberjack::mmap_file_backend());
+    for (int i = 0; i < 100 && lumberjack::mmap_file_stats().segments_created < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // With the directory gone, the ready spare takes the first rollover
+    // and the next one finds no spare.
+    rename(dir, moved.c_str());
+    for (int i = 0; i < 400; i++) LOG_ERROR("filling segment line %d", i);
+    lumberjack::MmapFileStats stats = lumberjack::mmap_file_stats();
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::mmap_file_close();
+
+    unsigned segments = 0;
+    read_segments(moved + "/log", &segments);
+    rmdir(moved.c_str());
+
+    if (stats.segments_created != 2 || stats.segment_failures == 0 || stats.lines_dropped == 0) {
+        std::cerr << "FAILED: stats " << stats.segments_created << " created, " << stats.segment_failures
+                  << " failures, " << stats.lines_dropped << " dropped" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << stats.segment_failures << " failures, " << stats.lines_dropped
+              << " lines dropped" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    lumberjack::init();
+
+    success &= test_concurrent_rollover();
+    success &= test_close_stops_writes();
+    success &= test_exit_without_close();
+    success &= test_segment_failure();
+
+    if (success) {
+        std::cout << "\nAll mmap file sink tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome mmap file sink tests FAILED" << std::endl;
+        return 1;
+    }
+}
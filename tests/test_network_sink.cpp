@@ -0,0 +1,252 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/sinks.h>
+#include "loopback_collector.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for the network sink, against the loopback collector
+// Tests:
+// - Newline-framed lines arrive over TCP complete and in order
+// - Length-prefixed records parse back to the same lines
+// - UDP datagrams each carry whole lines
+// - A partial frame is sent after flush_interval_ms without a flush
+// - Lines logged while the collector is down are spilled to disk and
+//   replayed, in order, once it comes up
+
+static std::string expected_line(int i) {
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "[INFO ] network line %d with a payload", i);
+    return buffer;
+}
+
+static void log_lines(int from, int to) {
+    for (int i = from; i < to; i++) LOG_INFO("network line %d with a payload", i);
+}
+
+static std::vector<std::string> split_lines(const std::string& data) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] == '\n') {
+            lines.push_back(data.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    return lines;
+}
+
+static std::vector<std::string> split_records(const std::string& data, bool* ok) {
+    std::vector<std::string> records;
+    size_t pos = 0;
+    *ok = true;
+    while (pos + 4 <= data.size()) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data() + pos);
+        size_t len = (size_t(p[0]) << 24) | (size_t(p[1]) << 16) | (size_t(p[2]) << 8) | p[3];
+        if (pos + 4 + len > data.size()) break;
+        records.push_back(data.substr(pos + 4, len));
+        pos += 4 + len;
+    }
+    if (pos != data.size()) *ok = false;
+    return records;
+}
+
+static bool check_sequence(const std::vector<std::string>& lines, int count, const char* name) {
+    if (lines.size() != static_cast<size_t>(count)) {
+        std::cerr << "FAILED: " << name << " got " << lines.size() << " of " << count << " lines" << std::endl;
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (lines[i].find(expected_line(i)) == std::string::npos) {
+            std::cerr << "FAILED: " << name << " line " << i << " is '" << lines[i] << "'" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void start(unsigned port, const lumberjack::NetworkSinkOptions& options) {
+    lumberjack::network_sink_open("127.0.0.1", port, options);
+    lumberjack::init();
+    lumberjack::set_backend(lumberjack::network_sink_backend());
+}
+
+static void stop() {
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::network_sink_close();
+}
+
+bool test_tcp_newline() {
+    std::cout << "Testing TCP with newline framing..." << std::endl;
+
+    LoopbackCollector collector;
+    collector.start(lumberjack::NETWORK_PROTOCOL_TCP);
+    lumberjack::NetworkSinkOptions options;
+    options.frame_size = 4096;
+    start(collector.port(), options);
+    const int count = 20000;
+    log_lines(0, count);
+    lumberjack::network_sink_flush();
+    lumberjack::NetworkSinkStats stats = lumberjack::network_sink_stats();
+    stop();
+    collector.wait_for(stats.bytes_sent, 2000);
+
+    if (!check_sequence(split_lines(collector.data()), count, "TCP")) return false;
+    std::cout << "PASSED: " << count << " lines in " << stats.frames_sent << " frames" << std::endl;
+    return true;
+}
+
+bool test_tcp_length_prefix() {
+    std::cout << "Testing TCP with length-prefixed framing..." << std::endl;
+
+    LoopbackCollector collector;
+    collector.start(lumberjack::NETWORK_PROTOCOL_TCP);
+    lumberjack::NetworkSinkOptions options;
+    options.framing = lumberjack::NETWORK_FRAMING_LENGTH_PREFIX;
+    options.frame_size = 4096;
+    start(collector.port(), options);
+    const int count = 5000;
+    log_lines(0, count);
+    lumberjack::network_sink_flush();
+    lumberjack::NetworkSinkStats stats = lumberjack::network_sink_stats();
+    stop();
+    collector.wait_for(stats.bytes_sent, 2000);
+
+    bool whole = false;
+    std::vector<std::string> records = split_records(collector.data(), &whole);
+    if (!whole) {
+        std::cerr << "FAILED: trailing bytes after the last record" << std::endl;
+        return false;
+    }
+    if (!check_sequence(records, count, "length-prefixed")) return false;
+    std::cout << "PASSED: " << records.size() << " records parsed" << std::endl;
+    return true;
+}
+
+bool test_udp() {
+    std::cout << "Testing UDP datagrams..." << std::endl;
+
+    LoopbackCollector collector;
+    collector.start(lumberjack::NETWORK_PROTOCOL_UDP);
+    lumberjack::NetworkSinkOptions options;
+    options.protocol = lumberjack::NETWORK_PROTOCOL_UDP;
+    options.frame_size = 8192;
+    start(collector.port(), options);
+    const int count = 2000;
+    log_lines(0, count);
+    lumberjack::network_sink_flush();
+    lumberjack::NetworkSinkStats stats = lumberjack::network_sink_stats();
+    stop();
+    collector.wait_for(stats.bytes_sent, 2000);
+
+    std::string data = collector.data();
+    if (collector.datagrams() != stats.frames_sent || stats.dropped_frames != 0 ||
+        (!data.empty() && data.back() != '\n')) {
+        std::cerr << "FAILED: " << collector.datagrams() << " datagrams received, "
+                  << stats.frames_sent << " sent" << std::endl;
+        return false;
+    }
+    if (!check_sequence(split_lines(data), count, "UDP")) return false;
+    std::cout << "PASSED: " << count << " lines in " << stats.frames_sent << " datagrams" << std::endl;
+    return true;
+}
+
+bool test_flush_interval() {
+    std::cout << "Testing a partial frame goes out on the timer..." << std::endl;
+
+    LoopbackCollector collector;
+    collector.start(lumberjack::NETWORK_PROTOCOL_TCP);
+    lumberjack::NetworkSinkOptions options;
+    options.flush_interval_ms = 20;
+    start(collector.port(), options);
+    log_lines(0, 1);
+    bool arrived = collector.wait_for(1, 1000);
+    stop();
+
+    if (!arrived || !check_sequence(split_lines(collector.data()), 1, "timer")) {
+        std::cerr << "FAILED: line was not sent without a flush" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: line arrived without a flush" << std::endl;
+    return true;
+}
+
+bool test_spill_and_replay() {
+    std::cout << "Testing spill while the collector is down..." << std::endl;
+
+    // Reserve a port, then leave it closed until the collector starts.
+    LoopbackCollector collector;
+    collector.start(lumberjack::NETWORK_PROTOCOL_TCP);
+    unsigned port = collector.port();
+    collector.stop();
+
+    char spill_path[] = "/tmp/lumberjack_spill_XXXXXX";
+    int fd = mkstemp(spill_path);
+    if (fd >= 0) close(fd);
+
+    lumberjack::NetworkSinkOptions options;
+    options.frame_size = 4096;
+    options.spill_path = spill_path;
+    options.reconnect_min_ms = 10;
+    options.reconnect_max_ms = 50;
+    start(port, options);
+    const int count = 3000;
+    log_lines(0, count / 2);
+    lumberjack::network_sink_flush();
+    lumberjack::NetworkSinkStats down = lumberjack::network_sink_stats();
+    bool connected_while_down = lumberjack::network_sink_connected();
+
+    collector.start(lumberjack::NETWORK_PROTOCOL_TCP, port);
+    log_lines(count / 2, count);
+    lumberjack::network_sink_flush();
+    std::string expected_tail = expected_line(count - 1) + "\n";
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::string data = collector.data();
+        if (data.size() >= expected_tail.size() &&
+            data.compare(data.size() - expected_tail.size(), expected_tail.size(), expected_tail) == 0) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    lumberjack::NetworkSinkStats up = lumberjack::network_sink_stats();
+    stop();
+    FILE* spill = fopen(spill_path, "rb");
+    fseek(spill, 0, SEEK_END);
+    long left = ftell(spill);
+    fclose(spill);
+    unlink(spill_path);
+
+    if (down.spilled_bytes == 0 || down.frames_sent != 0 || connected_while_down ||
+        up.connects != 1 || left != 0) {
+        std::cerr << "FAILED: spilled " << down.spilled_bytes << ", connects " << up.connects
+                  << ", " << left << " bytes left in the spill file" << std::endl;
+        return false;
+    }
+    if (!check_sequence(split_lines(collector.data()), count, "replay")) return false;
+    std::cout << "PASSED: " << down.spilled_bytes << " bytes spilled and replayed" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_tcp_newline();
+    success &= test_tcp_length_prefix();
+    success &= test_udp();
+    success &= test_flush_interval();
+    success &= test_spill_and_replay();
+
+    if (success) {
+        std::cout << "\nAll network sink tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome network sink tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,150 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/builtin_logger.h>
+#include <lumberjack/pattern.h>
+#include "test_support.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for compiled pattern layouts
+// Tests:
+// - Unknown directives and a trailing '%' are rejected, keeping the layout
+// - The default pattern renders exactly the old "[ts] [LEVEL] #N message"
+// - Thread, file:line and "%%" directives; "?" without a call site
+// - Lines that do not fit are cut but keep their newline
+// - builtin_set_pattern() applies to LOG_* lines end to end, with call site
+
+static const char* TS = "2024-05-01 12:00:00.123";
+
+static std::string render(const lumberjack::PatternLayout& layout, const lumberjack::PatternFields& fields,
+                          size_t capacity = 1280) {
+    char line[1280];
+    size_t len = layout.render(line, capacity, fields);
+    return std::string(line, len);
+}
+
+static lumberjack::PatternFields fields_for(const char* message, long long seq = -1) {
+    return { TS, lumberjack::LOG_LEVEL_INFO, message, strlen(message), 4242, "src/net/server.cpp", 87, seq };
+}
+
+bool test_compile_errors() {
+    std::cout << "Testing pattern compile errors..." << std::endl;
+
+    lumberjack::PatternLayout layout;
+    bool ok = layout.compile("%m") && !layout.compile("%T %q %m") && !layout.compile("%m %");
+    ok = ok && std::string(layout.pattern()) == "%m" && render(layout, fields_for("hello")) == "hello\n";
+    if (!ok) {
+        std::cerr << "FAILED: bad patterns not rejected, or layout changed" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: rejected, previous layout kept" << std::endl;
+    return true;
+}
+
+bool test_default_pattern() {
+    std::cout << "Testing the default pattern..." << std::endl;
+
+    lumberjack::PatternLayout layout;
+    std::string plain = render(layout, fields_for("server started"));
+    std::string numbered = render(layout, fields_for("server started", 17));
+
+    char expected_plain[256], expected_numbered[256];
+    snprintf(expected_plain, sizeof(expected_plain), "[%s] [%s] %s\n", TS, "INFO ", "server started");
+    snprintf(expected_numbered, sizeof(expected_numbered), "[%s] [%s] #%lld %s\n", TS, "INFO ", 17LL, "server started");
+    if (plain != expected_plain || numbered != expected_numbered) {
+        std::cerr << "FAILED: '" << plain << "' / '" << numbered << "'" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: byte-identical to the snprintf layout" << std::endl;
+    return true;
+}
+
+bool test_rich_pattern() {
+    std::cout << "Testing thread, call site and literal directives..." << std::endl;
+
+    lumberjack::PatternLayout layout;
+    layout.compile("%T %L [%t] %s:%l 100%% %m");
+    std::string line = render(layout, fields_for("accepted"));
+
+    lumberjack::PatternFields no_site = fields_for("accepted");
+    no_site.file = nullptr;
+    no_site.line = 0;
+    no_site.level = lumberjack::LOG_LEVEL_ERROR;
+    std::string anonymous = render(layout, no_site);
+
+    std::string expected = std::string(TS) + " INFO  [4242] server.cpp:87 100% accepted\n";
+    std::string expected_anonymous = std::string(TS) + " ERROR [4242] ?:? 100% accepted\n";
+    if (line != expected || anonymous != expected_anonymous) {
+        std::cerr << "FAILED: '" << line << "' / '" << anonymous << "'" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << line;
+    return true;
+}
+
+bool test_truncation() {
+    std::cout << "Testing lines that do not fit..." << std::endl;
+
+    lumberjack::PatternLayout layout;
+    std::string message(100, 'x');
+    std::string line = render(layout, fields_for(message.c_str()), 40);
+    if (line.size() != 40 || line.back() != '\n' || line.compare(0, 27, std::string("[") + TS + "] [") != 0) {
+        std::cerr << "FAILED: " << line.size() << " bytes" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: cut to capacity, newline kept" << std::endl;
+    return true;
+}
+
+bool test_builtin_end_to_end() {
+    std::cout << "Testing builtin_set_pattern() end to end..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* f = fopen(path.c_str(), "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(f);
+    bool rejected = !lumberjack::builtin_set_pattern("%Q");
+    lumberjack::builtin_set_pattern("%L %s:%l [%t] %m");
+    int line = __LINE__ + 1;
+    LOG_WARN("disk %d%% full", 91);
+    lumberjack::builtin_logger().write(lumberjack::LOG_LEVEL_INFO, "plain string");
+    lumberjack::builtin_set_pattern(nullptr);
+    LOG_INFO("back to default");
+    lumberjack::builtin_set_output(stderr);
+    fclose(f);
+
+    std::string data = read_file(path);
+    unlink(path.c_str());
+    std::string tid = std::to_string(lumberjack::current_thread_id());
+    std::string expected = "WARN  test_pattern_layout.cpp:" + std::to_string(line) + " [" + tid + "] disk 91% full\n"
+                           "INFO  ?:? [" + tid + "] plain string\n";
+    bool ok = rejected && data.compare(0, expected.size(), expected) == 0 &&
+              data.find("] [INFO ] back to default\n") != std::string::npos;
+    if (!ok) {
+        std::cerr << "FAILED:\n" << data << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: call site and thread reach the builtin output" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_compile_errors();
+    success &= test_default_pattern();
+    success &= test_rich_pattern();
+    success &= test_truncation();
+    success &= test_builtin_end_to_end();
+
+    if (success) {
+        std::cout << "\nAll pattern layout tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome pattern layout tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,196 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/sinks.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <signal.h>
+#include <unistd.h>
+
+// Unit tests for the pipe sink
+// Tests:
+// - Lines reach a slow pipe reader intact and in order while buffers are
+//   recycled many times over (catches reuse of pages still in the pipe)
+// - force_write uses write() only
+// - A non-pipe descriptor falls back to write()
+// - A pipe whose reader has gone drops and counts lines without SIGPIPE
+//   killing the process or staying pending
+
+// Reads fd until EOF and splits the data into lines.
+static std::vector<std::string> read_lines(int fd, bool slow) {
+    std::vector<std::string> lines;
+    std::string data;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        data.append(buffer, static_cast<size_t>(n));
+        if (slow) std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    size_t start = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] == '\n') {
+            lines.push_back(data.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    return lines;
+}
+
+static bool check_lines(const std::vector<std::string>& lines, int count, const char* name) {
+    if (lines.size() != static_cast<size_t>(count)) {
+        std::cerr << "FAILED: " << name << " read " << lines.size() << " of " << count << " lines" << std::endl;
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        char want[128];
+        snprintf(want, sizeof(want), "[INFO ] line %d of the pipe test with some padding", i);
+        if (lines[i].find(want) == std::string::npos) {
+            std::cerr << "FAILED: " << name << " line " << i << " is '" << lines[i] << "'" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool run_pipe(const lumberjack::PipeSinkOptions& options, const char* name,
+                     lumberjack::PipeSinkStats* stats, bool* zero_copy) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    std::vector<std::string> lines;
+    std::thread reader([&] { lines = read_lines(fds[0], true); });
+
+    const int count = 20000;
+    lumberjack::pipe_sink_open(fds[1], options);
+    *zero_copy = lumberjack::pipe_sink_zero_copy();
+    lumberjack::init();
+    lumberjack::set_backend(lumberjack::pipe_sink_backend());
+    for (int i = 0; i < count; i++) LOG_INFO("line %d of the pipe test with some padding", i);
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::pipe_sink_close();
+    *stats = lumberjack::pipe_sink_stats();
+    close(fds[1]);
+    reader.join();
+    close(fds[0]);
+
+    return check_lines(lines, count, name);
+}
+
+bool test_zero_copy() {
+    std::cout << "Testing vmsplice hand-off to a slow reader..." << std::endl;
+
+    lumberjack::PipeSinkOptions options;
+    options.buffer_size = 8192;
+    lumberjack::PipeSinkStats stats;
+    bool zero_copy = false;
+    if (!run_pipe(options, "zero-copy", &stats, &zero_copy)) return false;
+
+#ifdef __linux__
+    if (zero_copy && stats.spliced_bytes == 0) {
+        std::cerr << "FAILED: nothing was spliced" << std::endl;
+        return false;
+    }
+#endif
+    std::cout << "PASSED: " << stats.spliced_bytes << " bytes spliced, "
+              << stats.written_bytes << " written" << (zero_copy ? "" : " (vmsplice unavailable)")
+              << std::endl;
+    return true;
+}
+
+bool test_force_write() {
+    std::cout << "Testing force_write..." << std::endl;
+
+    lumberjack::PipeSinkOptions options;
+    options.force_write = true;
+    lumberjack::PipeSinkStats stats;
+    bool zero_copy = true;
+    if (!run_pipe(options, "force_write", &stats, &zero_copy)) return false;
+
+    if (zero_copy || stats.spliced_bytes != 0) {
+        std::cerr << "FAILED: vmsplice used despite force_write" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << stats.written_bytes << " bytes written" << std::endl;
+    return true;
+}
+
+bool test_regular_file_fallback() {
+    std::cout << "Testing a regular file falls back to write()..." << std::endl;
+
+    FILE* file = tmpfile();
+    lumberjack::pipe_sink_open(fileno(file));
+    bool zero_copy = lumberjack::pipe_sink_zero_copy();
+    lumberjack::init();
+    lumberjack::set_backend(lumberjack::pipe_sink_backend());
+    const int count = 500;
+    for (int i = 0; i < count; i++) LOG_INFO("line %d of the pipe test with some padding", i);
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::pipe_sink_close();
+
+    lseek(fileno(file), 0, SEEK_SET);
+    std::vector<std::string> lines = read_lines(fileno(file), false);
+    fclose(file);
+
+    if (zero_copy) {
+        std::cerr << "FAILED: zero copy reported for a regular file" << std::endl;
+        return false;
+    }
+    if (!check_lines(lines, count, "regular file")) return false;
+    std::cout << "PASSED: " << lines.size() << " lines written" << std::endl;
+    return true;
+}
+
+bool test_reader_gone() {
+    std::cout << "Testing a pipe whose reader has gone..." << std::endl;
+
+    for (bool force_write : { false, true }) {
+        int fds[2];
+        if (pipe(fds) != 0) return false;
+        close(fds[0]);
+
+        lumberjack::PipeSinkOptions options;
+        options.force_write = force_write;
+        lumberjack::pipe_sink_open(fds[1], options);
+        lumberjack::init();
+        lumberjack::set_backend(lumberjack::pipe_sink_backend());
+        const int count = 2000;
+        for (int i = 0; i < count; i++) LOG_INFO("line %d of the pipe test with some padding", i);
+        lumberjack::pipe_sink_flush();
+        LOG_INFO("after the flush");
+        lumberjack::set_backend(lumberjack::builtin_backend());
+        lumberjack::PipeSinkStats stats = lumberjack::pipe_sink_stats();
+        lumberjack::pipe_sink_close();
+        close(fds[1]);
+
+        sigset_t pending;
+        sigpending(&pending);
+        if (stats.dropped_bytes == 0 || stats.dropped_lines == 0 || stats.spliced_bytes + stats.written_bytes != 0 ||
+            sigismember(&pending, SIGPIPE)) {
+            std::cerr << "FAILED: force_write " << force_write << ", dropped " << stats.dropped_bytes
+                      << " bytes and " << stats.dropped_lines << " lines" << std::endl;
+            return false;
+        }
+    }
+    std::cout << "PASSED: lines dropped and counted, no SIGPIPE" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_zero_copy();
+    success &= test_force_write();
+    success &= test_regular_file_fallback();
+    success &= test_reader_gone();
+
+    if (success) {
+        std::cout << "\nAll pipe sink tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome pipe sink tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,261 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/rotation.h>
+#include "test_support.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Unit tests for log rotation
+// Tests:
+// - Size-based rotation keeps every segment within max_bytes and loses no lines
+// - Old segments beyond `keep` are pruned; numbering continues across reopen
+// - Rotated segments are gzipped when zlib is available
+// - The builtin backend rotates on a wall-clock interval
+// - Returning from main with builtin rotation on finishes the pending
+//   rename and compression
+
+static std::string make_temp_dir() {
+    char path[] = "/tmp/lumberjack_rotation_XXXXXX";
+    return mkdtemp(path) ? path : "";
+}
+
+static void remove_dir(const std::string& dir) {
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    while (struct dirent* entry = readdir(d)) {
+        if (entry->d_name[0] == '.') continue;
+        unlink((dir + "/" + entry->d_name).c_str());
+    }
+    closedir(d);
+    rmdir(dir.c_str());
+}
+
+static bool exists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+static std::string segment(const std::string& path, unsigned index) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%06u", index);
+    return path + suffix;
+}
+
+// Writes one line through the rotator the way the builtin backend does,
+// waiting for the background thread after each switch so sizes are exact.
+static void write_line(lumberjack::FileRotator& rot, const char* line) {
+    size_t len = strlen(line);
+    if (rot.should_rotate(len) && rot.rotate()) rot.wait_idle();
+    fwrite(line, 1, len, rot.file());
+    fflush(rot.file());
+    rot.add_bytes(len);
+}
+
+bool test_size_rotation() {
+    std::cout << "Testing size-based rotation..." << std::endl;
+
+    std::string dir = make_temp_dir();
+    std::string path = dir + "/app.log";
+    lumberjack::RotationOptions options;
+    options.max_bytes = 1000;
+    options.keep = 0;
+    options.compress = false;
+
+    lumberjack::FileRotator rot;
+    rot.open(path.c_str(), options);
+    rot.wait_idle();
+    std::string expected;
+    for (int i = 0; i < 100; i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "line %03d padded to fifty bytes ...................\n", i);
+        write_line(rot, line);
+        expected += line;
+    }
+    uint64_t rotations = rot.rotations();
+    rot.close();
+
+    std::string actual;
+    bool sizes_ok = true;
+    for (unsigned i = 1; i <= rotations; i++) {
+        std::string text = read_file(segment(path, i));
+        sizes_ok &= !text.empty() && text.size() <= options.max_bytes;
+        actual += text;
+    }
+    actual += read_file(path);
+    bool next_removed = !exists(path + ".next");
+    remove_dir(dir);
+
+    if (rotations < 4 || !sizes_ok || actual != expected || !next_removed) {
+        std::cerr << "FAILED: rotations=" << rotations << " sizes_ok=" << sizes_ok
+                  << " content_ok=" << (actual == expected) << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: " << rotations << " segments, all lines in order" << std::endl;
+    return true;
+}
+
+bool test_keep_prunes_oldest() {
+    std::cout << "Testing pruning and numbering across reopen..." << std::endl;
+
+    std::string dir = make_temp_dir();
+    std::string path = dir + "/app.log";
+    lumberjack::RotationOptions options;
+    options.max_bytes = 10;
+    options.keep = 2;
+    options.compress = false;
+
+    for (int run = 0; run < 2; run++) {
+        lumberjack::FileRotator rot;
+        rot.open(path.c_str(), options);
+        rot.wait_idle();
+        for (int i = 0; i < 3; i++) write_line(rot, "0123456789\n");
+        rot.close();
+    }
+
+    // The first run rotates twice. The second starts with the first run's
+    // leftover line counting toward the limit, so it rotates before each of
+    // its three lines: 5 segments, of which only the newest two remain.
+    bool ok = !exists(segment(path, 3)) && exists(segment(path, 4)) &&
+              exists(segment(path, 5)) && !exists(segment(path, 6));
+    remove_dir(dir);
+
+    if (!ok) {
+        std::cerr << "FAILED: expected only segments 4 and 5" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: oldest segments pruned, numbering continued" << std::endl;
+    return true;
+}
+
+bool test_compression() {
+    std::cout << "Testing compression of rotated segments..." << std::endl;
+
+    if (!lumberjack::FileRotator::compression_supported()) {
+        std::cout << "PASSED: skipped (built without zlib)" << std::endl;
+        return true;
+    }
+
+    std::string dir = make_temp_dir();
+    std::string path = dir + "/app.log";
+    lumberjack::RotationOptions options;
+    options.max_bytes = 4096;
+    options.keep = 0;
+
+    lumberjack::FileRotator rot;
+    rot.open(path.c_str(), options);
+    rot.wait_idle();
+    for (int i = 0; i < 200; i++) write_line(rot, "a very repetitive log line\n");
+    rot.close();
+
+    std::string gz = read_file(segment(path, 1) + ".gz");
+    bool plain_removed = !exists(segment(path, 1));
+    remove_dir(dir);
+
+    if (gz.size() < 2 || static_cast<unsigned char>(gz[0]) != 0x1f ||
+        static_cast<unsigned char>(gz[1]) != 0x8b || gz.size() >= 4096 || !plain_removed) {
+        std::cerr << "FAILED: segment not gzipped (" << gz.size() << " bytes)" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: segment gzipped to " << gz.size() << " bytes" << std::endl;
+    return true;
+}
+
+bool test_builtin_interval_rotation() {
+    std::cout << "Testing builtin interval rotation..." << std::endl;
+
+    std::string dir = make_temp_dir();
+    std::string path = dir + "/app.log";
+    lumberjack::RotationOptions options;
+    options.interval_s = 1;
+    options.compress = false;
+
+    lumberjack::init();
+    lumberjack::builtin_set_buffered(true, 4096);
+    if (!lumberjack::builtin_set_rotation(path.c_str(), options)) {
+        std::cerr << "FAILED: could not start rotation" << std::endl;
+        remove_dir(dir);
+        return false;
+    }
+    LOG_INFO("before the boundary");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1300));
+    LOG_INFO("after the boundary");
+    lumberjack::builtin_set_rotation(nullptr);
+    lumberjack::builtin_set_buffered(false);
+
+    std::string first = read_file(segment(path, 1));
+    std::string current = read_file(path);
+    remove_dir(dir);
+
+    if (first.find("before the boundary") == std::string::npos ||
+        first.find("after the boundary") != std::string::npos ||
+        current.find("after the boundary") == std::string::npos) {
+        std::cerr << "FAILED: segment='" << first << "' current='" << current << "'" << std::endl;
+        return false;
+    }
+
+    std::cout << "PASSED: lines split at the interval boundary" << std::endl;
+    return true;
+}
+
+bool test_builtin_rotation_at_exit() {
+    std::cout << "Testing builtin rotation finishes at exit..." << std::endl;
+
+    std::string dir = make_temp_dir();
+    std::string path = dir + "/app.log";
+    pid_t pid = fork();
+    if (pid == 0) {
+        lumberjack::RotationOptions options;
+        options.max_bytes = 64 * 1024;
+        lumberjack::init();
+        lumberjack::builtin_set_buffered(true, 4096);
+        lumberjack::builtin_set_rotation(path.c_str(), options);
+        for (int i = 0; i < 5000; i++) LOG_INFO("line %d before exit", i);
+        exit(0);   // runs static destructors, unlike _exit()
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    bool compressed = lumberjack::FileRotator::compression_supported();
+    std::string first = segment(path, 1) + (compressed ? ".gz" : "");
+    std::string current = read_file(path);
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && exists(first) &&
+              !exists(path + ".next") && current.find("line 4999 before exit\n") != std::string::npos &&
+              (!compressed || !exists(segment(path, 1)));
+    remove_dir(dir);
+
+    if (!ok) {
+        std::cerr << "FAILED: status " << status << ", current file " << current.size() << " bytes" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: segments renamed" << (compressed ? " and gzipped" : "") << " at exit" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_size_rotation();
+    success &= test_keep_prunes_oldest();
+    success &= test_compression();
+    success &= test_builtin_interval_rotation();
+    success &= test_builtin_rotation_at_exit();
+
+    if (success) {
+        std::cout << "\nAll rotation tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome rotation tests FAILED" << std::endl;
+        return 1;
+    }
+}
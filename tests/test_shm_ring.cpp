@@ -0,0 +1,204 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/shm_ring.h>
+#include <lumberjack/sinks.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for the shared-memory sink
+// Tests:
+// - Records round-trip through the ring with level, timestamp and text
+// - A full ring drops records instead of blocking the producer
+// - A waiting reader is woken by a producer and keeps up across many laps
+// - Reopening the ring keeps records the drain has not read yet
+
+static std::string ring_name(const char* tag) {
+    char name[64];
+    snprintf(name, sizeof(name), "/lumberjack_test_%s_%d", tag, static_cast<int>(getpid()));
+    return name;
+}
+
+static void start(const std::string& name, size_t capacity) {
+    lumberjack::ShmRingOptions options;
+    options.capacity = capacity;
+    lumberjack::shm_ring_open(name.c_str(), options);
+    lumberjack::init();
+    lumberjack::set_backend(lumberjack::shm_ring_backend());
+}
+
+static void stop(const std::string& name) {
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::shm_ring_close();
+    lumberjack::shm_ring_remove(name.c_str());
+}
+
+bool test_roundtrip() {
+    std::cout << "Testing records round-trip through the ring..." << std::endl;
+
+    std::string name = ring_name("roundtrip");
+    start(name, 64 * 1024);
+    lumberjack::ShmRingReader reader;
+    if (!reader.open(name.c_str())) {
+        stop(name);
+        std::cerr << "FAILED: reader could not attach" << std::endl;
+        return false;
+    }
+
+    uint64_t before = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    LOG_ERROR("disk %s is full", "/var");
+    LOG_INFO("request %d done", 42);
+
+    lumberjack::ShmRecord rec;
+    bool ok = reader.next(&rec) && rec.level == lumberjack::LOG_LEVEL_ERROR &&
+              std::string(rec.text, rec.length) == "disk /var is full" &&
+              rec.timestamp_ns >= before &&
+              reader.next(&rec) && rec.level == lumberjack::LOG_LEVEL_INFO &&
+              std::string(rec.text, rec.length) == "request 42 done" &&
+              !reader.next(&rec) &&
+              reader.producer_pid() == static_cast<uint32_t>(getpid());
+    reader.release();
+    reader.close();
+    stop(name);
+
+    if (!ok) {
+        std::cerr << "FAILED: records did not match" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: both records read back" << std::endl;
+    return true;
+}
+
+bool test_full_ring_drops() {
+    std::cout << "Testing a full ring drops instead of blocking..." << std::endl;
+
+    std::string name = ring_name("full");
+    start(name, 4096);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; i++) LOG_INFO("message number %d with some padding text", i);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    uint64_t dropped = lumberjack::shm_ring_dropped();
+
+    lumberjack::ShmRingReader reader;
+    reader.open(name.c_str());
+    uint64_t read = 0;
+    lumberjack::ShmRecord rec;
+    while (reader.next(&rec)) read++;
+    reader.release();
+    reader.close();
+    stop(name);
+
+    if (dropped == 0 || read + dropped != 1000 ||
+        elapsed > std::chrono::seconds(1)) {
+        std::cerr << "FAILED: read " << read << ", dropped " << dropped << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << read << " kept, " << dropped << " dropped" << std::endl;
+    return true;
+}
+
+bool test_wakeup_and_wrap() {
+    std::cout << "Testing a waiting reader keeps up across laps..." << std::endl;
+
+    std::string name = ring_name("wake");
+    start(name, 4096);
+    lumberjack::ShmRingReader reader;
+    reader.open(name.c_str());
+
+    const int total = 20000;
+    std::atomic<int> received{0};
+    std::atomic<bool> in_order{true};
+    std::thread drain([&] {
+        lumberjack::ShmRingReader* readers[] = { &reader };
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        int expected = 0;
+        while (expected < total && std::chrono::steady_clock::now() < deadline) {
+            lumberjack::ShmRecord rec;
+            bool any = false;
+            while (reader.next(&rec)) {
+                char want[32];
+                int n = snprintf(want, sizeof(want), "seq %d", expected);
+                if (rec.length != static_cast<size_t>(n) || memcmp(rec.text, want, n) != 0) {
+                    in_order = false;
+                }
+                expected++;
+                any = true;
+            }
+            reader.release();
+            received = expected;
+            if (!any) lumberjack::ShmRingReader::wait(readers, 1, 100);
+        }
+    });
+
+    // Produce in bursts smaller than the ring, waiting for each to drain, so
+    // nothing is dropped and every record relies on a wakeup.
+    for (int i = 0; i < total; ) {
+        for (int j = 0; j < 50 && i < total; j++, i++) LOG_INFO("seq %d", i);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (received < i && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+    }
+    drain.join();
+    uint64_t dropped = lumberjack::shm_ring_dropped();
+    reader.close();
+    stop(name);
+
+    if (received != total || !in_order || dropped != 0) {
+        std::cerr << "FAILED: received " << received << " of " << total
+                  << (in_order ? "" : " out of order") << ", dropped " << dropped << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << total << " records through a 4 KB ring" << std::endl;
+    return true;
+}
+
+bool test_reopen_keeps_unread() {
+    std::cout << "Testing reopening keeps unread records..." << std::endl;
+
+    std::string name = ring_name("reopen");
+    start(name, 8192);
+    LOG_WARN("before restart");
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::shm_ring_close();
+
+    start(name, 8192);
+    LOG_WARN("after restart");
+
+    lumberjack::ShmRingReader reader;
+    reader.open(name.c_str());
+    lumberjack::ShmRecord rec;
+    std::vector<std::string> texts;
+    while (reader.next(&rec)) texts.emplace_back(rec.text, rec.length);
+    reader.release();
+    reader.close();
+    stop(name);
+
+    if (texts.size() != 2 || texts[0] != "before restart" || texts[1] != "after restart") {
+        std::cerr << "FAILED: read " << texts.size() << " records" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: records from both producers read" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_roundtrip();
+    success &= test_full_ring_drops();
+    success &= test_wakeup_and_wrap();
+    success &= test_reopen_keeps_unread();
+
+    if (success) {
+        std::cout << "\nAll shared-memory sink tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome shared-memory sink tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,133 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/static_logger.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for compile-time bound loggers
+// Tests:
+// - Lines reach Backend::write formatted, with their length
+// - Each logger type has its own level, and disabled SLOG_* calls do not
+//   evaluate their arguments
+// - BuiltinStaticBackend and ActiveStaticBackend forward to the library
+
+struct CaptureBackend {
+    static std::vector<std::string> lines;
+    static void write(lumberjack::LogLevel level, const char* message, size_t length) {
+        lines.push_back(std::string(level == lumberjack::LOG_LEVEL_ERROR ? "E " : "- ") +
+                        std::string(message, length));
+    }
+};
+std::vector<std::string> CaptureBackend::lines;
+
+struct OtherBackend {
+    static int count;
+    static void write(lumberjack::LogLevel, const char*, size_t) { count++; }
+};
+int OtherBackend::count = 0;
+
+using CaptureLog = lumberjack::StaticLogger<CaptureBackend>;
+using OtherLog = lumberjack::StaticLogger<OtherBackend>;
+
+static int g_evaluated = 0;
+static int counted(int value) {
+    g_evaluated++;
+    return value;
+}
+
+bool test_formatting() {
+    std::cout << "Testing static logger formatting..." << std::endl;
+
+    CaptureBackend::lines.clear();
+    SLOG_ERROR(CaptureLog, "code %d: %s", 42, "broken");
+    SLOG_INFO(CaptureLog, "100%% done");
+    CaptureLog::log(lumberjack::LOG_LEVEL_WARN, "direct %u", 7u);
+
+    std::vector<std::string> expected = { "E code 42: broken", "- 100% done", "- direct 7" };
+    if (CaptureBackend::lines != expected) {
+        std::cerr << "FAILED: got " << CaptureBackend::lines.size() << " lines" << std::endl;
+        for (auto& line : CaptureBackend::lines) std::cerr << "  '" << line << "'" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: lines formatted and delivered" << std::endl;
+    return true;
+}
+
+bool test_level_gating() {
+    std::cout << "Testing per-logger levels..." << std::endl;
+
+    CaptureBackend::lines.clear();
+    OtherBackend::count = 0;
+    g_evaluated = 0;
+    CaptureLog::set_level(lumberjack::LOG_LEVEL_WARN);
+    OtherLog::set_level(lumberjack::LOG_LEVEL_DEBUG);
+
+    SLOG_INFO(CaptureLog, "hidden %d", counted(1));
+    SLOG_WARN(CaptureLog, "shown %d", counted(2));
+    SLOG_DEBUG(OtherLog, "other %d", counted(3));
+    SLOG_AT(CaptureLog, lumberjack::LOG_LEVEL_NONE, "never");
+    bool levels = CaptureLog::level() == lumberjack::LOG_LEVEL_WARN &&
+                  OtherLog::level() == lumberjack::LOG_LEVEL_DEBUG;
+    CaptureLog::set_level(lumberjack::LOG_LEVEL_INFO);
+
+    if (!levels || CaptureBackend::lines.size() != 1 || CaptureBackend::lines[0] != "- shown 2" ||
+        OtherBackend::count != 1 || g_evaluated != 2) {
+        std::cerr << "FAILED: " << CaptureBackend::lines.size() << " lines, " << OtherBackend::count
+                  << " other, " << g_evaluated << " arguments evaluated" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: levels independent, disabled arguments not evaluated" << std::endl;
+    return true;
+}
+
+bool test_forwarding_backends() {
+    std::cout << "Testing forwarding backends..." << std::endl;
+
+    char path[] = "/tmp/lumberjack_static_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    FILE* file = fopen(path, "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(file);
+    using BuiltinLog = lumberjack::StaticLogger<lumberjack::BuiltinStaticBackend>;
+    using ActiveLog = lumberjack::StaticLogger<lumberjack::ActiveStaticBackend>;
+    SLOG_INFO(BuiltinLog, "builtin %d", 1);
+    SLOG_ERROR(ActiveLog, "active %d", 2);
+    lumberjack::builtin_set_output(stderr);
+    fclose(file);
+
+    std::string data;
+    FILE* f = fopen(path, "r");
+    char buffer[4096];
+    size_t n;
+    while (f && (n = fread(buffer, 1, sizeof(buffer), f)) > 0) data.append(buffer, n);
+    if (f) fclose(f);
+    unlink(path);
+
+    if (data.find("[INFO ] builtin 1\n") == std::string::npos ||
+        data.find("[ERROR] active 2\n") == std::string::npos) {
+        std::cerr << "FAILED: output:\n" << data << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: both reached the built-in backend" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_formatting();
+    success &= test_level_gating();
+    success &= test_forwarding_backends();
+
+    if (success) {
+        std::cout << "\nAll static logger tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome static logger tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,218 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/structured.h>
+#include "test_support.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+// Unit tests for structured key-value logging
+// Tests:
+// - Typed fields render as logfmt and JSON, including integer limits,
+//   doubles, NaN, booleans and strings that need quoting or escaping
+// - Fields that do not fit are left out whole
+// - A backend with log_write_kv receives the typed fields and call site
+// - Other backends receive "message key=value ..." text
+// - The built-in backend writes TEXT, LOGFMT and JSON lines
+
+using lumberjack::kv;
+
+static std::string fields_as(lumberjack::OutputFormat format, const std::vector<lumberjack::LogField>& fields,
+                             size_t capacity = 512) {
+    char out[512];
+    size_t len = lumberjack::render_fields(out, capacity, format, fields.data(), fields.size());
+    return std::string(out, len);
+}
+
+bool test_render_fields() {
+    std::cout << "Testing field rendering..." << std::endl;
+
+    const std::string path = "/a b";
+    std::vector<lumberjack::LogField> fields = {
+        kv("min", std::numeric_limits<int64_t>::min()),
+        kv("max", std::numeric_limits<uint64_t>::max()),
+        kv("ratio", 0.1),
+        kv("big", 1e21),
+        kv("nan", std::nan("")),
+        kv("ok", true),
+        kv("user", "alice"),
+        kv("path", path),
+        kv("quote", "say \"hi\"\n"),
+        kv("empty", ""),
+    };
+    std::string logfmt = fields_as(lumberjack::OUTPUT_LOGFMT, fields);
+    std::string json = fields_as(lumberjack::OUTPUT_JSON, fields);
+
+    std::string expected_logfmt =
+        " min=-9223372036854775808 max=18446744073709551615 ratio=0.1 big=1e+21 nan=NaN ok=true"
+        " user=alice path=\"/a b\" quote=\"say \\\"hi\\\"\\n\" empty=\"\"";
+    std::string expected_json =
+        ",\"min\":-9223372036854775808,\"max\":18446744073709551615,\"ratio\":0.1,\"big\":1e+21,\"nan\":null,"
+        "\"ok\":true,\"user\":\"alice\",\"path\":\"/a b\",\"quote\":\"say \\\"hi\\\"\\n\",\"empty\":\"\"";
+    if (logfmt != expected_logfmt || json != expected_json) {
+        std::cerr << "FAILED:\n  " << logfmt << "\n  " << json << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: logfmt and JSON values" << std::endl;
+    return true;
+}
+
+bool test_fields_that_do_not_fit() {
+    std::cout << "Testing fields that do not fit..." << std::endl;
+
+    const std::string path = "/a b";
+    std::vector<lumberjack::LogField> fields = { kv("a", 1), kv("name", "a long value"), kv("b", 2) };
+    std::string cut = fields_as(lumberjack::OUTPUT_LOGFMT, fields, 12);
+    std::string control = fields_as(lumberjack::OUTPUT_JSON, { kv("c", "\x01") });
+    if (cut != " a=1" || control != ",\"c\":\"\\u0001\"") {
+        std::cerr << "FAILED: '" << cut << "' / '" << control << "'" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: partial fields left out" << std::endl;
+    return true;
+}
+
+// Backend with log_write_kv
+struct CapturedKv {
+    std::string message;
+    std::vector<lumberjack::LogField> fields;
+    std::vector<std::string> strings;
+    int line;
+};
+static std::vector<CapturedKv> g_kvRecords;
+static std::vector<std::string> g_lines;
+
+static void capture_write(lumberjack::LogLevel, const char* message) { g_lines.push_back(message); }
+
+static void capture_kv(const lumberjack::LogRecord* record, const lumberjack::LogField* fields, size_t count) {
+    CapturedKv captured = { std::string(record->message, record->length), {}, {}, record->line };
+    for (size_t i = 0; i < count; i++) {
+        captured.fields.push_back(fields[i]);
+        if (fields[i].type == lumberjack::FIELD_STRING) {
+            captured.strings.emplace_back(fields[i].value.s.data, fields[i].value.s.length);
+        }
+    }
+    g_kvRecords.push_back(captured);
+}
+
+static lumberjack::LogBackend g_native = {
+    "native", noop_init, noop_shutdown, capture_write, noop_span_begin, noop_span_end, nullptr, capture_kv
+};
+
+static lumberjack::LogBackend g_plain = {
+    "plain", noop_init, noop_shutdown, capture_write, noop_span_begin, noop_span_end
+};
+
+bool test_native_backend() {
+    std::cout << "Testing backends with log_write_kv..." << std::endl;
+
+    lumberjack::init();
+    lumberjack::set_backend(&g_native);
+    g_kvRecords.clear();
+    g_lines.clear();
+    int line = __LINE__ + 1;
+    LOG_INFO_KV("request done", kv("status", 200), kv("latency_us", 17u), kv("route", "/api"));
+    LOG_DEBUG_KV("not at INFO", kv("n", 1));
+    LOG_WARN_KV("no fields");
+    lumberjack::set_backend(lumberjack::builtin_backend());
+
+    bool ok = g_kvRecords.size() == 2 && g_lines.empty();
+    if (ok) {
+        const CapturedKv& r = g_kvRecords[0];
+        ok = r.message == "request done" && r.line == line && r.fields.size() == 3 &&
+             r.fields[0].type == lumberjack::FIELD_INT && r.fields[0].value.i == 200 &&
+             r.fields[1].type == lumberjack::FIELD_UINT && r.fields[1].value.u == 17 &&
+             r.strings.size() == 1 && r.strings[0] == "/api" &&
+             g_kvRecords[1].message == "no fields" && g_kvRecords[1].fields.empty();
+    }
+    if (!ok) {
+        std::cerr << "FAILED: " << g_kvRecords.size() << " records, " << g_lines.size() << " lines" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: typed fields and call site delivered unformatted" << std::endl;
+    return true;
+}
+
+bool test_text_fallback() {
+    std::cout << "Testing backends without log_write_kv..." << std::endl;
+
+    lumberjack::init();
+    lumberjack::set_backend(&g_plain);
+    g_lines.clear();
+    LOG_INFO_KV("request done", kv("status", 200), kv("latency_us", 17), kv("user", "bob smith"));
+    lumberjack::set_backend(lumberjack::builtin_backend());
+
+    if (g_lines.size() != 1 || g_lines[0] != "request done status=200 latency_us=17 user=\"bob smith\"") {
+        std::cerr << "FAILED: " << (g_lines.empty() ? "no line" : g_lines[0]) << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << g_lines[0] << std::endl;
+    return true;
+}
+
+bool test_builtin_formats() {
+    std::cout << "Testing built-in TEXT, LOGFMT and JSON output..." << std::endl;
+
+    std::string path = temp_path();
+    FILE* f = fopen(path.c_str(), "w");
+    lumberjack::init();
+    lumberjack::builtin_set_output(f);
+    LOG_INFO_KV("request done", kv("status", 200));
+    lumberjack::builtin_set_output_format(lumberjack::OUTPUT_LOGFMT);
+    LOG_INFO_KV("request done", kv("status", 200), kv("ok", true));
+    LOG_WARN("disk \"%s\" full", "sda");
+    lumberjack::builtin_set_output_format(lumberjack::OUTPUT_JSON);
+    LOG_INFO_KV("request done", kv("status", 200), kv("user", "bob"));
+    LOG_ERROR("line\nbreak");
+    lumberjack::builtin_set_output_format(lumberjack::OUTPUT_TEXT);
+    lumberjack::builtin_set_output(stderr);
+    fclose(f);
+
+    std::string data = read_file(path);
+    unlink(path.c_str());
+    std::vector<std::string> lines;
+    for (size_t start = 0, end; (end = data.find('\n', start)) != std::string::npos; start = end + 1) {
+        std::string line = data.substr(start, end - start);
+        // Drop the timestamp, the only part that varies
+        size_t ts = line.find("2");
+        if (ts != std::string::npos && ts < 10) line.replace(ts, 23, "T");
+        lines.push_back(line);
+    }
+
+    std::vector<std::string> expected = {
+        "[T] [INFO ] request done status=200",
+        "time=\"T\" level=info msg=\"request done\" status=200 ok=true",
+        "time=\"T\" level=warn msg=\"disk \\\"sda\\\" full\"",
+        "{\"time\":\"T\",\"level\":\"info\",\"msg\":\"request done\",\"status\":200,\"user\":\"bob\"}",
+        "{\"time\":\"T\",\"level\":\"error\",\"msg\":\"line\\nbreak\"}",
+    };
+    if (lines != expected) {
+        std::cerr << "FAILED:\n" << data << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << lines[3] << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_render_fields();
+    success &= test_fields_that_do_not_fit();
+    success &= test_native_backend();
+    success &= test_text_fallback();
+    success &= test_builtin_formats();
+
+    if (success) {
+        std::cout << "\nAll structured logging tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome structured logging tests FAILED" << std::endl;
+        return 1;
+    }
+}
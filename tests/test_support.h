@@ -0,0 +1,40 @@
+// test_support.h — Helpers shared by the tests.
+//
+// temp_path() creates an empty file to log into and read_file() reads one
+// back; the noop_* callbacks fill the LogBackend slots a test backend does
+// not use. capture_backend.h builds on them.
+
+#ifndef LUMBERJACK_TESTS_TEST_SUPPORT_H
+#define LUMBERJACK_TESTS_TEST_SUPPORT_H
+
+#include <lumberjack/lumberjack.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+// Creates an empty file under /tmp and returns its path.
+inline std::string temp_path() {
+    char path[] = "/tmp/lumberjack_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    return path;
+}
+
+// The file's contents, or "" if it cannot be opened.
+inline std::string read_file(const std::string& path) {
+    std::string data;
+    FILE* f = fopen(path.c_str(), "rb");
+    char buffer[4096];
+    size_t n;
+    while (f && (n = fread(buffer, 1, sizeof(buffer), f)) > 0) data.append(buffer, n);
+    if (f) fclose(f);
+    return data;
+}
+
+inline void noop_init() {}
+inline void noop_shutdown() {}
+inline void* noop_span_begin(lumberjack::LogLevel, const char*) { return nullptr; }
+inline void noop_span_end(void*, lumberjack::LogLevel, const char*, long long) {}
+
+#endif // LUMBERJACK_TESTS_TEST_SUPPORT_H
@@ -0,0 +1,222 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/sinks.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Unit tests for the syslog sink, against a datagram socket the test binds
+// in place of /dev/log or the journald socket.
+// Tests:
+// - RFC 5424 datagrams carry the right PRI, timestamp, pid and message
+// - journald datagrams carry the native fields, binary-encoded when the
+//   message spans lines
+// - Records are sent in batches, and flushed by the background thread
+// - A daemon that stops reading causes drops, not a blocked logger
+
+static std::string socket_path(const char* tag) {
+    char path[108];
+    snprintf(path, sizeof(path), "/tmp/lumberjack_syslog_%s_%d", tag, static_cast<int>(getpid()));
+    return path;
+}
+
+// Binds a datagram socket at path, standing in for the daemon.
+static int bind_daemon(const std::string& path) {
+    unlink(path.c_str());
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    struct timeval tv = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+static std::vector<std::string> receive_all(int fd, bool wait_first) {
+    std::vector<std::string> out;
+    char buffer[4096];
+    for (;;) {
+        int flags = (wait_first && out.empty()) ? 0 : MSG_DONTWAIT;
+        ssize_t n = recv(fd, buffer, sizeof(buffer), flags);
+        if (n < 0) break;
+        out.emplace_back(buffer, static_cast<size_t>(n));
+    }
+    return out;
+}
+
+static void start(const lumberjack::SyslogSinkOptions& options) {
+    lumberjack::syslog_sink_open(options);
+    lumberjack::init();
+    lumberjack::set_level(lumberjack::LOG_LEVEL_DEBUG);
+    lumberjack::set_backend(lumberjack::syslog_sink_backend());
+}
+
+static void stop() {
+    lumberjack::set_backend(lumberjack::builtin_backend());
+    lumberjack::syslog_sink_close();
+}
+
+bool test_rfc5424() {
+    std::cout << "Testing RFC 5424 datagrams..." << std::endl;
+
+    std::string path = socket_path("rfc");
+    int daemon = bind_daemon(path);
+    lumberjack::SyslogSinkOptions options;
+    options.socket_path = path.c_str();
+    options.app_name = "my app";
+    options.facility = 16;
+    start(options);
+    LOG_ERROR("disk %s is full", "/var");
+    LOG_DEBUG("cache miss");
+    stop();
+
+    std::vector<std::string> got = receive_all(daemon, true);
+    close(daemon);
+    unlink(path.c_str());
+
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    char tail[512];
+    snprintf(tail, sizeof(tail), "Z %s my_app %d - - disk /var is full", host, static_cast<int>(getpid()));
+    if (got.size() != 2 || got[0].compare(0, 8, "<131>1 2") != 0 ||
+        got[0].find(tail) == std::string::npos ||
+        got[1].compare(0, 7, "<135>1 ") != 0 || got[1].find(" - - cache miss") == std::string::npos) {
+        std::cerr << "FAILED: got " << got.size() << " datagrams";
+        if (!got.empty()) std::cerr << ", first '" << got[0] << "'";
+        std::cerr << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << got[0] << std::endl;
+    return true;
+}
+
+bool test_journald() {
+    std::cout << "Testing journald native datagrams..." << std::endl;
+
+    std::string path = socket_path("journal");
+    int daemon = bind_daemon(path);
+    lumberjack::SyslogSinkOptions options;
+    options.format = lumberjack::SYSLOG_FORMAT_JOURNALD;
+    options.socket_path = path.c_str();
+    options.app_name = "svc";
+    start(options);
+    LOG_WARN("low memory");
+    LOG_INFO("line one\nline two");
+    stop();
+
+    std::vector<std::string> got = receive_all(daemon, true);
+    close(daemon);
+    unlink(path.c_str());
+
+    char pid_field[32];
+    snprintf(pid_field, sizeof(pid_field), "SYSLOG_PID=%d\n", static_cast<int>(getpid()));
+    const std::string text = "line one\nline two";
+    std::string binary = std::string("MESSAGE\n") + static_cast<char>(text.size()) +
+                         std::string(7, '\0') + text + "\n";
+    if (got.size() != 2 ||
+        got[0].compare(0, 11, "PRIORITY=4\n") != 0 ||
+        got[0].find("SYSLOG_IDENTIFIER=svc\n") == std::string::npos ||
+        got[0].find(pid_field) == std::string::npos ||
+        got[0].find("MESSAGE=low memory\n") == std::string::npos ||
+        got[1].compare(0, 11, "PRIORITY=6\n") != 0 ||
+        got[1].size() < binary.size() ||
+        got[1].compare(got[1].size() - binary.size(), binary.size(), binary) != 0) {
+        std::cerr << "FAILED: got " << got.size() << " datagrams" << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: fields and binary MESSAGE encoding" << std::endl;
+    return true;
+}
+
+bool test_batching() {
+    std::cout << "Testing batched and timed sends..." << std::endl;
+
+    std::string path = socket_path("batch");
+    int daemon = bind_daemon(path);
+    int size = 1 << 20;
+    setsockopt(daemon, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    lumberjack::SyslogSinkOptions options;
+    options.socket_path = path.c_str();
+    options.batch_size = 8;
+    options.flush_interval_ms = 200;
+    start(options);
+
+    // 8 records fill the batch and go out together (the test socket's
+    // queue holds at least 10 datagrams); the 9th waits for the timer.
+    for (int i = 0; i < 8; i++) LOG_INFO("batched %d", i);
+    lumberjack::SyslogSinkStats after_batch = lumberjack::syslog_sink_stats();
+    std::vector<std::string> got = receive_all(daemon, true);
+    LOG_INFO("timed");
+    std::vector<std::string> timed = receive_all(daemon, true);
+    stop();
+    close(daemon);
+    unlink(path.c_str());
+
+    if (after_batch.records_sent != 8 || after_batch.send_calls != 1 || got.size() != 8 ||
+        timed.size() != 1 || timed[0].find("timed") == std::string::npos) {
+        std::cerr << "FAILED: sent " << after_batch.records_sent << " in "
+                  << after_batch.send_calls << " calls, received " << got.size()
+                  << " then " << timed.size() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: 8 records in one sendmmsg, 1 by the flush thread" << std::endl;
+    return true;
+}
+
+bool test_backpressure() {
+    std::cout << "Testing a stalled daemon drops instead of blocking..." << std::endl;
+
+    std::string path = socket_path("stall");
+    int daemon = bind_daemon(path);
+    lumberjack::SyslogSinkOptions options;
+    options.socket_path = path.c_str();
+    options.batch_size = 16;
+    start(options);
+
+    const int total = 5000;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < total; i++) LOG_INFO("record %d", i);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    uint64_t dropped_while_stalled = lumberjack::syslog_sink_stats().dropped;
+
+    std::vector<std::string> got = receive_all(daemon, false);
+    stop();
+    std::vector<std::string> rest = receive_all(daemon, false);
+    got.insert(got.end(), rest.begin(), rest.end());
+    lumberjack::SyslogSinkStats stats = lumberjack::syslog_sink_stats();
+    close(daemon);
+    unlink(path.c_str());
+
+    if (elapsed > std::chrono::seconds(1) || dropped_while_stalled == 0 ||
+        got.size() != stats.records_sent || stats.records_sent + stats.dropped != total) {
+        std::cerr << "FAILED: received " << got.size() << ", sent " << stats.records_sent
+                  << ", dropped " << stats.dropped << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << stats.records_sent << " delivered, " << stats.dropped
+              << " dropped" << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_rfc5424();
+    success &= test_journald();
+    success &= test_batching();
+    success &= test_backpressure();
+
+    if (success) {
+        std::cout << "\nAll syslog sink tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome syslog sink tests FAILED" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,142 @@
+#include <lumberjack/lumberjack.h>
+#include <lumberjack/structured.h>
+#include <lumberjack/transaction.h>
+#include "capture_backend.h"
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+// Unit tests for per-thread level overrides
+// Tests:
+// - An override changes the calling thread's LOG_* and LOG_*_KV gating only
+// - set_level() leaves a thread with an override alone
+// - ThreadLevelOverride guards nest and restore the previous state
+// - An override set before the first transaction still captures
+
+using lumberjack::kv;
+using lumberjack::LogLevel;
+
+static void finish() {
+    lumberjack::clear_thread_level();
+    finish_capture();
+}
+
+bool test_thread_only() {
+    std::cout << "Testing an override on one thread..." << std::endl;
+
+    start_capture();
+    lumberjack::set_thread_level(lumberjack::LOG_LEVEL_DEBUG);
+    LOG_DEBUG("main %s", "debug");
+    LOG_DEBUG("main literal");
+    LOG_DEBUG_KV("main kv", kv("n", 1));
+    std::thread other([] {
+        LOG_DEBUG("other debug");
+        LOG_INFO("other info");
+    });
+    other.join();
+    bool levels = lumberjack::get_thread_level() == lumberjack::LOG_LEVEL_DEBUG &&
+                  lumberjack::get_level() == lumberjack::LOG_LEVEL_INFO;
+    lumberjack::clear_thread_level();
+    LOG_DEBUG("cleared");
+    bool cleared = lumberjack::get_thread_level() == lumberjack::LOG_LEVEL_INFO;
+    finish();
+
+    if (messages() != "main debug|main literal|main kv n=1|other info" || !levels || !cleared) {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+bool test_set_level_ignored() {
+    std::cout << "Testing set_level() with an override in place..." << std::endl;
+
+    start_capture();
+    lumberjack::set_thread_level(lumberjack::LOG_LEVEL_ERROR);
+    lumberjack::set_level(lumberjack::LOG_LEVEL_DEBUG);
+    LOG_WARN("overridden warn");
+    LOG_ERROR("overridden error");
+    std::thread other([] { LOG_DEBUG("other debug"); });
+    other.join();
+    lumberjack::clear_thread_level();
+    LOG_DEBUG("global debug");
+    finish();
+
+    if (messages() != "overridden error|other debug|global debug") {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+bool test_guard_nesting() {
+    std::cout << "Testing nested ThreadLevelOverride guards..." << std::endl;
+
+    start_capture();
+    std::vector<LogLevel> seen;
+    {
+        lumberjack::ThreadLevelOverride outer(lumberjack::LOG_LEVEL_DEBUG);
+        seen.push_back(lumberjack::get_thread_level());
+        {
+            lumberjack::ThreadLevelOverride inner(lumberjack::LOG_LEVEL_NONE);
+            seen.push_back(lumberjack::get_thread_level());
+            LOG_ERROR("silenced");
+        }
+        seen.push_back(lumberjack::get_thread_level());
+        LOG_DEBUG("outer debug");
+    }
+    lumberjack::set_level(lumberjack::LOG_LEVEL_WARN);
+    seen.push_back(lumberjack::get_thread_level());
+    LOG_INFO("after");
+    finish();
+
+    std::vector<LogLevel> expected = { lumberjack::LOG_LEVEL_DEBUG, lumberjack::LOG_LEVEL_NONE,
+                                       lumberjack::LOG_LEVEL_DEBUG, lumberjack::LOG_LEVEL_WARN };
+    if (messages() != "outer debug" || seen != expected) {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: guards restore the previous override" << std::endl;
+    return true;
+}
+
+bool test_transaction_capture() {
+    std::cout << "Testing an override with a transaction..." << std::endl;
+
+    start_capture();
+    {
+        lumberjack::ThreadLevelOverride quiet(lumberjack::LOG_LEVEL_WARN);
+        lumberjack::LogTransaction tx;
+        LOG_INFO("held info");
+        LOG_WARN("held warn");
+        tx.keep();
+    }
+    finish();
+
+    if (messages() != "held info|held warn") {
+        std::cerr << "FAILED: " << messages() << std::endl;
+        return false;
+    }
+    std::cout << "PASSED: " << messages() << std::endl;
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    success &= test_thread_only();
+    success &= test_set_level_ignored();
+    success &= test_guard_nesting();
+    success &= test_transaction_capture();
+
+    if (success) {
+        std::cout << "\nAll thread level tests PASSED" << std::endl;
+        return 0;
+    } else {
+        std::cout << "\nSome thread level tests FAILED" << std::endl;
+        return 1;
+    }
+}
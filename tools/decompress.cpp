@@ -0,0 +1,33 @@
+// lumberjack-decompress — Decodes a file written by the compressed file sink.
+//
+// Usage:
+//   lumberjack-decompress <file> [from-unix-seconds [to-unix-seconds]]
+//
+// Writes the log text to stdout. With a time range, only frames that
+// overlap it are decoded; the <file>.idx index is used to seek to the
+// first one.
+
+#include <lumberjack/sinks.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 4) {
+        fprintf(stderr, "usage: %s <file> [from-unix-seconds [to-unix-seconds]]\n", argv[0]);
+        return 2;
+    }
+
+    uint64_t from_us = 0;
+    uint64_t to_us = UINT64_MAX;
+    if (argc >= 3) from_us = strtoull(argv[2], nullptr, 10) * 1000000ull;
+    if (argc == 4) to_us = strtoull(argv[3], nullptr, 10) * 1000000ull + 999999ull;
+
+    long frames = lumberjack::compressed_file_decode(argv[1], stdout, from_us, to_us);
+    if (frames < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "decoded %ld frames\n", frames);
+    return 0;
+}
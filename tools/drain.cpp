@@ -0,0 +1,146 @@
+// lumberjack-drain — Formats and writes records from shared-memory sinks.
+//
+// Usage:
+//   lumberjack-drain [-o file] [-r max-bytes] [-i interval-s] [-k keep] [-z]
+//                    <name> [<name>...]
+//
+// Attaches to each ring created by shm_ring_open(name) — waiting for it to
+// appear if necessary — and writes its records as
+//   [YYYY-MM-DD HH:MM:SS.mmm] [LEVEL] message
+// to stdout, or to the -o file with optional size (-r) and interval (-i)
+// rotation, keeping -k segments, gzipped with -z. With several rings each
+// line is tagged with the producer's PID. Records are written in the order
+// they are drained, ring by ring.
+//
+// Runs until SIGINT or SIGTERM, then drains what is left and exits.
+
+#include <lumberjack/rotation.h>
+#include <lumberjack/shm_ring.h>
+#include <lumberjack/utils.h>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <vector>
+#include <unistd.h>
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int) {
+    g_stop = 1;
+}
+
+// Formats one record into out; returns the line length.
+static size_t format_record(char* out, size_t size, const lumberjack::ShmRecord& rec,
+                            uint32_t pid, bool tag_pid) {
+    time_t seconds = static_cast<time_t>(rec.timestamp_ns / 1000000000ull);
+    unsigned millis = static_cast<unsigned>(rec.timestamp_ns / 1000000ull % 1000);
+    struct tm tm_buf;
+    localtime_r(&seconds, &tm_buf);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm_buf);
+
+    int n = tag_pid
+        ? snprintf(out, size, "[%s.%03u] [%u] [%s] %.*s\n", stamp, millis, pid,
+                   lumberjack::LEVEL_STRINGS[rec.level], static_cast<int>(rec.length), rec.text)
+        : snprintf(out, size, "[%s.%03u] [%s] %.*s\n", stamp, millis,
+                   lumberjack::LEVEL_STRINGS[rec.level], static_cast<int>(rec.length), rec.text);
+    if (n < 0) return 0;
+    return static_cast<size_t>(n) < size ? static_cast<size_t>(n) : size - 1;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [-o file] [-r max-bytes] [-i interval-s] [-k keep] [-z] <name>...\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    const char* output = nullptr;
+    lumberjack::RotationOptions rotation;
+    rotation.compress = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:r:i:k:z")) != -1) {
+        switch (opt) {
+            case 'o': output = optarg; break;
+            case 'r': rotation.max_bytes = strtoull(optarg, nullptr, 10); break;
+            case 'i': rotation.interval_s = static_cast<unsigned>(strtoul(optarg, nullptr, 10)); break;
+            case 'k': rotation.keep = static_cast<unsigned>(strtoul(optarg, nullptr, 10)); break;
+            case 'z': rotation.compress = true; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    lumberjack::FileRotator rotator;
+    if (output && !rotator.open(output, rotation)) {
+        perror(output);
+        return 1;
+    }
+
+    struct sigaction sa = {};
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    std::vector<const char*> names(argv + optind, argv + argc);
+    std::vector<std::unique_ptr<lumberjack::ShmRingReader>> readers;
+    for (size_t i = 0; i < names.size(); i++) {
+        readers.emplace_back(new lumberjack::ShmRingReader());
+    }
+    std::vector<lumberjack::ShmRingReader*> open;
+    const bool tag_pid = names.size() > 1;
+    char line[65536 + 128];
+
+    for (;;) {
+        bool stopping = g_stop != 0;
+
+        // Attach to rings whose producers have started since the last pass.
+        if (open.size() < readers.size()) {
+            open.clear();
+            for (size_t i = 0; i < readers.size(); i++) {
+                if (readers[i]->is_open() || readers[i]->open(names[i])) {
+                    open.push_back(readers[i].get());
+                }
+            }
+        }
+
+        size_t written = 0;
+        for (lumberjack::ShmRingReader* reader : open) {
+            lumberjack::ShmRecord rec;
+            while (reader->next(&rec)) {
+                size_t len = format_record(line, sizeof(line), rec, reader->producer_pid(), tag_pid);
+                if (output) {
+                    if (rotator.should_rotate(len)) {
+                        fflush(rotator.file());
+                        rotator.rotate();
+                    }
+                    fwrite(line, 1, len, rotator.file());
+                    rotator.add_bytes(len);
+                } else {
+                    fwrite(line, 1, len, stdout);
+                }
+                written++;
+            }
+            reader->release();
+        }
+        if (written) fflush(output ? rotator.file() : stdout);
+
+        if (stopping) break;
+        if (written == 0) {
+            lumberjack::ShmRingReader::wait(open.data(), open.size(), 200);
+        }
+    }
+
+    uint64_t dropped = 0;
+    for (lumberjack::ShmRingReader* reader : open) dropped += reader->dropped();
+    if (dropped) fprintf(stderr, "producers dropped %llu records\n",
+                         static_cast<unsigned long long>(dropped));
+    rotator.close();
+    return 0;
+}
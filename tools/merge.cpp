@@ -0,0 +1,50 @@
+// lumberjack-merge — Merges log files into one total order.
+//
+// Usage:
+//   lumberjack-merge [-o output-file] <file> [<file>...]
+//
+// Inputs are usually in order on their own (a per-thread or per-logger
+// file, a drained ring, recovered flight recorder records); one that is not
+// is sorted first. Records are merged by their #N sequence number when every
+// record carries one, otherwise by timestamp, and written to stdout unless
+// -o is given. See merge.h.
+
+#include <lumberjack/merge.h>
+#include <cstdio>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    const char* output = nullptr;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:")) != -1) {
+        switch (opt) {
+            case 'o': output = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-o output-file] <file>...\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-o output-file] <file>...\n", argv[0]);
+        return 2;
+    }
+
+    FILE* out = stdout;
+    if (output) {
+        out = fopen(output, "w");
+        if (!out) {
+            perror(output);
+            return 1;
+        }
+    }
+
+    long records = lumberjack::merge_log_files(argv + optind, static_cast<size_t>(argc - optind), out);
+    if (out != stdout) fclose(out);
+
+    if (records < 0) {
+        fprintf(stderr, "%s: cannot open an input file\n", argv[0]);
+        return 1;
+    }
+    fprintf(stderr, "merged %ld records\n", records);
+    return 0;
+}
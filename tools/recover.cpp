@@ -0,0 +1,37 @@
+// lumberjack-recover — Extracts log records from a flight recorder file.
+//
+// Usage:
+//   lumberjack-recover <recorder-file> [output-file]
+//
+// Records are written oldest first, to stdout unless an output file is
+// given. Works on the file of a live or killed process; records that were
+// mid-write at the time are skipped.
+
+#include <lumberjack/flight_recorder.h>
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <recorder-file> [output-file]\n", argv[0]);
+        return 2;
+    }
+
+    FILE* out = stdout;
+    if (argc == 3) {
+        out = fopen(argv[2], "w");
+        if (!out) {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+
+    long records = lumberjack::flight_recorder_recover(argv[1], out);
+    if (out != stdout) fclose(out);
+
+    if (records < 0) {
+        fprintf(stderr, "%s: not a lumberjack flight recorder file\n", argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "recovered %ld records\n", records);
+    return 0;
+}